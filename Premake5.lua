@@ -21,6 +21,7 @@ local rootDir = path.getabsolute(_WORKING_DIR)
 local projects = os.matchdirs(rootDir .. "/projects/*")
 local modules = os.matchdirs(rootDir .. "/modules/*")
 local sampleGroups = os.matchdirs(rootDir .. "/samples/*")
+local testGroups = os.matchdirs(rootDir .. "/tests/*")
 
 -- Select the last item in the project directory to be our startup project 
 -- (this is easily changed in VS, this is just to be handy)
@@ -245,7 +246,9 @@ end
 -- This function will create projects for all the paths in a table, and set the group name to the given value
 -- @param groupName The name to group the projects under in the workspace
 -- @param folders   The table of folders that contain the projects to add
-function AddProjects(groupName, folders)
+-- @param sharedDir (Optional) A project whose source and resources are built into each of these projects as well,
+--                  minus its main.cpp. This lets tests and benchmarks run against a project's code without copying it
+function AddProjects(groupName, folders, sharedDir)
 
 	premake.info("Building Group: " .. groupName)
 	group(groupName)
@@ -299,9 +302,7 @@ function AddProjects(groupName, folders)
 		  		"(xcopy /Q /E /Y /I /C \"%{wks.location}dependencies\\dll\" \"%{absdir}\")",
 		  		-- This step ensures that the project has a resource directory
 		  		"(IF NOT EXIST \"%{resdir}\" mkdir \"%{resdir}\")",
-		  		"(xcopy /Q /E /Y /I /C \"%{wks.location}shared_assets\\res\" \"%{absdir}\")",
-		  		-- This step copies all the resources to the output directory
-		  		"(xcopy /Q /E /Y /I /C \"%{resdir}\" \"%{absdir}\")"
+		  		"(xcopy /Q /E /Y /I /C \"%{wks.location}shared_assets\\res\" \"%{absdir}\")"
 			} 
 
 			-- Our source files are everything in the src folder
@@ -322,6 +323,29 @@ function AddProjects(groupName, folders)
 			-- Defines what directories we want to include
 			includedirs(ProjIncludes)
 
+			-- Pull in the shared project's code and resources, everything but its entry point. Its resources are
+			-- copied before our own, so that ours take precedence
+			if sharedDir then
+				local sharedRel = path.getrelative(rootDir, sharedDir)
+				local sharedSrc = path.join(sharedRel, "src")
+				files {
+					sharedSrc .. "/**.h",
+					sharedSrc .. "/**.cpp",
+					sharedSrc .. "/**.c",
+					sharedSrc .. "/**.hpp"
+				}
+				removefiles { sharedSrc .. "/main.cpp" }
+				includedirs { sharedSrc }
+				postbuildcommands {
+					"(xcopy /Q /E /Y /I /C \"%{wks.location}" .. path.translate(sharedRel, "\\") .. "\\res\" \"%{absdir}\")"
+				}
+			end
+
+			postbuildcommands {
+				-- This step copies all the resources to the output directory
+				"(xcopy /Q /E /Y /I /C \"%{resdir}\" \"%{absdir}\")"
+			}
+
 			-- Link to the dependencies and modules
 			links(ProjLinks)
 
@@ -355,4 +379,16 @@ for k, proj in pairs(sampleGroups) do
 	local name = path.getbasename(proj);
     local samples = os.matchdirs(proj .. "/*")
     AddProjects("Samples - " .. name, samples)
-end
\ No newline at end of file
+end
+
+-- Add the tests and benchmarks. Each group in the tests folder is named after the project it tests (if any),
+-- and every project in the group is built with that project's code
+for k, proj in pairs(testGroups) do
+	local name = path.getbasename(proj);
+	local tests = os.matchdirs(proj .. "/*")
+	local target = path.join(rootDir, "projects", name)
+	if not os.isdir(path.join(target, "src")) then
+		target = nil
+	end
+	AddProjects("Tests - " .. name, tests, target)
+end
@@ -51,5 +51,7 @@ namespace nou
 		static GLFWwindow* m_window;
 		static float m_prevTime;
 		static float m_deltaTime;
+		//Whether we started the toolkit's logger (so we should shut it down).
+		static bool m_ownsLogger;
 	};
 }
\ No newline at end of file
@@ -44,7 +44,16 @@ namespace nou
 		CMeshRenderer& operator=(CMeshRenderer&&) = default;
 
 		void SetMesh(const Mesh& mesh);
-		virtual void Draw();
+
+		//Draws from the current camera (see CCamera::current).
+		void Draw();
+		//Draws with the given view-projection matrix. This is what the
+		//World's render system uses, since each world has its own camera.
+		virtual void Draw(const glm::mat4& viewProj);
+
+		//Gets the mesh's bounding sphere in world space (xyz is the center,
+		//w is the radius), using the owner's current global transform.
+		glm::vec4 GetWorldBounds() const;
 
 		protected:
 
@@ -52,6 +61,10 @@ namespace nou
 		Material* m_mat;
 		std::unique_ptr<VertexArray> m_vao;
 
+		//The bounding sphere of our mesh, in its local space.
+		glm::vec3 m_boundsCenter;
+		float m_boundsRadius;
+
 		//Having a default constructor makes it easier for us to inherit from
 		//this class later on (e.g., for a mesh renderer with skeletal animation).
 		//However, it does not make sense to instantiate this class on its own
@@ -9,6 +9,7 @@ Minimal and lightly OOP wrapper for the ENTT framework.
 #pragma once
 
 #include "Transform.h"
+#include "World.h"
 
 #include "entt.hpp"
 
@@ -26,35 +27,43 @@ namespace nou
 		//By putting the transform here and managing our own Entity objects carefully,
 		//we make sure that our pointers will be stable - which is important
 		//in a hierarchy with transforms storing pointers to parent/child objects.
+		//The transform lives in the world's hierarchy, so it can only be
+		//parented to other entities in the same world.
 		Transform transform;
 
+		//Creates an entity in the default world.
 		static Entity Create();
+		//Creates an entity in the given world.
+		static Entity Create(World& world);
 		
 		virtual ~Entity();
 
 		template<typename T, typename... Args>
 		T& Add(Args&&... args)
 		{
-			return ecs.emplace<T>(m_id, std::forward<Args>(args)...);
+			return m_world->Registry().emplace<T>(m_id, std::forward<Args>(args)...);
 		}
 
 		template<typename T>
 		T& Get()
 		{
-			return ecs.get<T>(m_id);
+			return m_world->Registry().get<T>(m_id);
 		}
 
 		template<typename T>
 		void Remove()
 		{
-			ecs.remove<T>(m_id);
+			m_world->Registry().remove<T>(m_id);
 		}
 
+		World& GetWorld() const { return *m_world; }
+		entt::entity GetID() const { return m_id; }
+
 		protected:
 
-		static entt::registry ecs;
+		World* m_world;
 		entt::entity m_id;
 
-		Entity(entt::entity id);	
+		Entity(World& world, entt::entity id);	
 	};
 }
\ No newline at end of file
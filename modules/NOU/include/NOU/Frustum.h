@@ -0,0 +1,58 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+Frustum.h
+View frustum for skipping objects that are off screen.
+*/
+
+#pragma once
+
+#include "GLM/glm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nou
+{
+	//The six planes that bound what a camera can see.
+	//Each plane is stored as (normal, distance), with the normal pointing
+	//into the frustum, so a point p is inside the plane if
+	//dot(normal, p) + distance >= 0.
+	class Frustum
+	{
+		public:
+
+		enum Plane
+		{
+			PLANE_LEFT = 0,
+			PLANE_RIGHT,
+			PLANE_BOTTOM,
+			PLANE_TOP,
+			PLANE_NEAR,
+			PLANE_FAR,
+			PLANE_COUNT
+		};
+
+		glm::vec4 m_planes[PLANE_COUNT];
+
+		//Pulls the planes straight out of a view-projection matrix
+		//(e.g., CCamera::GetVP()). The planes are in world space.
+		explicit Frustum(const glm::mat4& viewProj);
+
+		//Whether a sphere is at least partly inside the frustum.
+		//This can be a little generous near the corners, but it never
+		//says a visible sphere is outside.
+		bool ContainsSphere(const glm::vec3& center, float radius) const;
+
+		//Tests a whole array of spheres at once (xyz is the center, w is the
+		//radius). Writes 1 to visible for each sphere that passes and 0 for each
+		//one that doesn't, and returns how many passed.
+		//With SSE we test 4 spheres against each plane at a time.
+		size_t CullSpheres(const glm::vec4* spheres, size_t count, uint8_t* visible) const;
+	};
+
+	//Takes a bounding sphere in an object's local space to world space.
+	//Non-uniform scale stretches a sphere into an ellipsoid, so we use the
+	//largest scale to make sure the result still covers the object.
+	glm::vec4 TransformSphere(const glm::mat4& transform, const glm::vec3& center, float radius);
+}
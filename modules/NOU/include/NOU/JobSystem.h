@@ -0,0 +1,129 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+JobSystem.h
+Small work-stealing job scheduler for spreading work across cores.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nou
+{
+	//Runs jobs (small functions) on a set of worker threads.
+	//
+	//Every worker has its own queue. Workers take jobs from the back of their
+	//own queue, and when that runs dry they "steal" from the front of someone
+	//else's. Jobs started from inside a job go on the current worker's queue,
+	//so related work tends to stay on the same core.
+	//
+	//Threads that wait on jobs (see Wait) run queued jobs while they wait,
+	//so it is safe to start and wait on jobs from inside another job.
+	//
+	//With 0 threads, every job runs immediately on the thread that started
+	//it, in the order it was started. This is handy for debugging, since
+	//everything happens in the same order every time.
+	class JobSystem
+	{
+		public:
+
+		typedef std::function<void()> Job;
+
+		//Keeps track of how many jobs in a group are still running, and the
+		//first exception any of them threw.
+		class Counter
+		{
+			public:
+
+			Counter() : m_remaining(0), m_error(nullptr) {}
+
+			bool IsDone() const { return m_remaining.load(std::memory_order_acquire) == 0; }
+
+			protected:
+
+			friend class JobSystem;
+
+			std::atomic<size_t> m_remaining;
+			std::mutex m_errorMutex;
+			std::exception_ptr m_error;
+
+			//Keeps the exception currently being handled, unless we already
+			//have one.
+			void CaptureException();
+		};
+
+		//Gets a job system with one worker for each core except the one
+		//we're running on (since the main thread helps out while waiting).
+		static JobSystem& Default();
+
+		//threadCount is the number of worker threads to start.
+		JobSystem(unsigned threadCount);
+		~JobSystem();
+
+		JobSystem(const JobSystem& other) = delete;
+		JobSystem& operator=(const JobSystem& other) = delete;
+
+		unsigned GetThreadCount() const { return static_cast<unsigned>(m_threads.size()); }
+
+		//Queues up a job. The counter goes up by one now, and back down
+		//once the job has finished (or thrown).
+		void Run(const Job& job, Counter& counter);
+
+		//Runs queued jobs until every job on the counter has finished. If any
+		//of them threw, the first exception is rethrown from here once they
+		//are all done.
+		void Wait(Counter& counter);
+
+		//Runs a single queued job, if there is one. Returns false if there was
+		//nothing to do.
+		bool RunPending();
+
+		//Calls body(begin, end) over [0, count), in chunks of grainSize
+		//(or an even split across the threads if grainSize is 0), and
+		//waits for all of them to finish. Every chunk runs even if one
+		//throws, then the first exception is rethrown.
+		void ParallelFor(size_t count, const std::function<void(size_t, size_t)>& body, size_t grainSize = 0);
+
+		protected:
+
+		struct QueuedJob
+		{
+			Job job;
+			Counter* counter;
+		};
+
+		struct Queue
+		{
+			std::mutex mutex;
+			std::deque<QueuedJob> jobs;
+		};
+
+		std::vector<std::thread> m_threads;
+		//One queue per worker, plus one at the end shared by every thread
+		//that isn't one of our workers (e.g., the main thread).
+		std::vector<std::unique_ptr<Queue>> m_queues;
+
+		//Sleeping workers wait on this until there are jobs to do.
+		std::mutex m_sleepMutex;
+		std::condition_variable m_wake;
+		std::atomic<size_t> m_pending;
+		std::atomic<bool> m_quit;
+
+		void WorkerLoop(unsigned index);
+		//Gets the queue that the calling thread should push to and pop from.
+		unsigned GetQueueIndex() const;
+		bool TryPop(unsigned index, QueuedJob& out);
+		bool TrySteal(unsigned thief, QueuedJob& out);
+		void Execute(QueuedJob& job);
+	};
+}
@@ -46,8 +46,21 @@ namespace nou
 		//associated with this model in OpenGL.
 		const VertexBuffer* GetVBO(Attrib attrib) const;
 
+		//The bounds of the mesh in its local space, worked out in SetVerts.
+		//The box fits the vertices exactly, and the sphere is centered on the
+		//box and just big enough to hold every vertex.
+		const glm::vec3& GetBoundsMin() const { return m_boundsMin; }
+		const glm::vec3& GetBoundsMax() const { return m_boundsMax; }
+		const glm::vec3& GetBoundsCenter() const { return m_boundsCenter; }
+		float GetBoundsRadius() const { return m_boundsRadius; }
+
 		protected:
 
+		glm::vec3 m_boundsMin = glm::vec3(0.0f);
+		glm::vec3 m_boundsMax = glm::vec3(0.0f);
+		glm::vec3 m_boundsCenter = glm::vec3(0.0f);
+		float m_boundsRadius = 0.0f;
+
 		std::vector<glm::vec3> m_verts;
 		std::vector<glm::vec3> m_normals;
 		std::vector<glm::vec2> m_uvs;
@@ -33,6 +33,8 @@ namespace nou
 	//compiling shaders and linking shader programs.
 	void PrintGLInfoLog(const std::string& preamble, GLInfoLogType logType, GLuint objID, GLint buflen);
 
+	//A shader is only compiled the first time its ID is needed, since a
+	//program that comes out of the binary cache never needs it compiled.
 	class Shader
 	{
 		public:
@@ -40,12 +42,19 @@ namespace nou
 		Shader(const std::string& file, GLenum shaderType);
 		~Shader();
 
+		//Compiles the shader if it hasn't been compiled yet.
 		GLuint GetID();
+		const std::string& GetSource() const { return m_source; }
 
 		protected:
 
-		//The OpenGL ID of our shader object.
+		//The OpenGL ID of our shader object (0 until it's compiled).
 		GLuint m_id;
+		GLenum m_type;
+		std::string m_source;
+		bool m_compiled;
+
+		void Compile();
 	};
 
 	class ShaderProgram
@@ -80,6 +89,9 @@ namespace nou
 		//The shader program currently in use.
 		static const ShaderProgram* m_current;
 
-		void Link();
+		//Loads the program from TTK's program binary cache if these shaders
+		//have been linked before, otherwise compiles and links them (and
+		//stores the result for next time).
+		void Link(const std::vector<Shader*>& shaders);
 	};
 }
\ No newline at end of file
@@ -13,22 +13,68 @@ Simple class for managing object transforms with basic hierarchy support.
 #include "GLM/glm.hpp"
 #include "GLM/gtx/quaternion.hpp"
 
-#include <vector>
+#include "TransformHierarchy.h"
 
 //Simple implementation of a transform component.
 
 namespace nou
 {
+	class Transform;
+
+	//Stands in for one of a transform's local position, rotation or scale.
+	//The actual value lives in the TransformHierarchy - this just forwards
+	//reads and writes there, and marks the transform as changed whenever
+	//it is written to.
+	//It converts to the underlying type, so you can mostly use it like the
+	//value itself. Use Get() if you need to call a function or operator
+	//on the value (e.g., m_pos.Get().x, or m_pos.Get() + offset).
+	template<typename T, T& (TransformHierarchy::*Field)(uint32_t)>
+	class TransformField
+	{
+		public:
+
+		operator const T&() const { return Get(); }
+		const T& Get() const;
+
+		TransformField& operator=(const T& value);
+		TransformField& operator=(const TransformField& other) { return *this = other.Get(); }
+
+		template<typename U>
+		TransformField& operator+=(const U& value) { return *this = Get() + value; }
+		template<typename U>
+		TransformField& operator-=(const U& value) { return *this = Get() - value; }
+		template<typename U>
+		TransformField& operator*=(const U& value) { return *this = Get() * value; }
+
+		protected:
+
+		friend class Transform;
+
+		TransformField(Transform* owner) : m_owner(owner) {}
+		TransformField(const TransformField& other) = delete;
+
+		Transform* m_owner;
+	};
+
+	//A handle to a node in a TransformHierarchy.
+	//The transforms themselves are stored in flat arrays in the hierarchy, so
+	//that the whole scene can be updated in one pass - see TransformHierarchy.h.
 	class Transform
 	{
 		public:
 
-		glm::vec3 m_pos;
-		glm::vec3 m_scale;
-		glm::quat m_rotation;
+		TransformField<glm::vec3, &TransformHierarchy::Position> m_pos;
+		TransformField<glm::vec3, &TransformHierarchy::Scale> m_scale;
+		TransformField<glm::quat, &TransformHierarchy::Rotation> m_rotation;
 
 		Transform();
-		Transform(const Transform& other) = default;
+		//Makes a transform in the given hierarchy rather than the default one.
+		//Transforms can only be parented to others in the same hierarchy.
+		explicit Transform(TransformHierarchy& hierarchy);
+		//Copying a transform makes a new node with the same local transform
+		//and the same parent (but not the same children), in the same hierarchy.
+		Transform(const Transform& other);
+		Transform& operator=(const Transform& other);
 		virtual ~Transform();
 
 		//This will update the transform on the object
@@ -37,10 +83,15 @@ namespace nou
 		//call this once per frame before making all of your draw
 		//calls on the root node of your Scene.
 		//(FK stands for "forward kinematics", by the way.)
+		//Since every transform lives in the same hierarchy, this updates
+		//everything that has changed, not just this object's children.
 		void DoFK();
 
 		//This will recompute and return the global transform
 		//of this object.
+		//This updates the whole hierarchy, but only if something has changed
+		//since the last update - so calling this on every object in a frame
+		//only does the work once.
 		const glm::mat4& RecomputeGlobal();
 
 		//This will return the current global transform of the
@@ -53,22 +104,37 @@ namespace nou
 		//the appropriate update first.
 		glm::mat3 GetNormal() const;
 
-		//Sets a pointer to the parent object and updates child references
-		//for the old and new parent objects accordingly.
+		//Sets the parent object.
 		//Pass in nullptr if you wish for the object to not have a parent.
+		//Does nothing if the parent is in a different hierarchy.
 		void SetParent(Transform* parent);
 
-		protected:
+		//Gets the hierarchy this transform lives in.
+		TransformHierarchy& GetHierarchy() const { return *m_hierarchy; }
 
-		Transform* m_parent;
-		std::vector<Transform*> m_children;
+		//Gets the node this transform refers to in the hierarchy.
+		uint32_t GetHandle() const { return m_handle; }
+
+		protected:
 
-		glm::mat4 m_global;
+		template<typename T, T& (TransformHierarchy::*Field)(uint32_t)>
+		friend class TransformField;
 
-		//These functions are protected since they will be handled
-		//by SetParent - we don't want to have to manually update this ourselves
-		//whenever we switch an object's parent!
-		void AddChild(Transform* child);
-		void RemoveChild(Transform* child);
+		TransformHierarchy* m_hierarchy;
+		uint32_t m_handle;
 	};
-}
\ No newline at end of file
+
+	template<typename T, T& (TransformHierarchy::*Field)(uint32_t)>
+	const T& TransformField<T, Field>::Get() const
+	{
+		return (m_owner->m_hierarchy->*Field)(m_owner->m_handle);
+	}
+
+	template<typename T, T& (TransformHierarchy::*Field)(uint32_t)>
+	TransformField<T, Field>& TransformField<T, Field>::operator=(const T& value)
+	{
+		(m_owner->m_hierarchy->*Field)(m_owner->m_handle) = value;
+		m_owner->m_hierarchy->MarkDirty(m_owner->m_handle);
+		return *this;
+	}
+}
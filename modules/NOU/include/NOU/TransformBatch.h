@@ -0,0 +1,37 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+TransformBatch.h
+Builds transform and normal matrices for many objects at once.
+*/
+
+#pragma once
+
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include "GLM/glm.hpp"
+#include "GLM/gtx/quaternion.hpp"
+
+#include <cstddef>
+
+namespace nou
+{
+	//Builds the matrix translate(position) * rotate(rotation) * scale(scale)
+	//for every object in the arrays.
+	//Rather than multiplying three 4x4 matrices together, we write the
+	//rotation matrix straight out of the quaternion, scale its columns, and
+	//drop the position into the last column. With SSE we do 4 objects at a time.
+	//
+	//Rotations don't need to be normalized - the result is the same as
+	//normalizing them first.
+	//
+	//If normals is not nullptr, the normal matrix (the inverse transpose of the
+	//top 3x3) of each object is written there too. For a TRS matrix this is
+	//just the rotation with each column divided by its scale instead of
+	//multiplied, so we never need a general matrix inverse. Like the
+	//inverse, this is undefined for a scale of 0.
+	//
+	//Any of the outputs may be nullptr if you don't need them.
+	void ComposeTransforms(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+		glm::mat4* transforms, glm::mat3* normals, size_t count);
+}
@@ -0,0 +1,128 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+TransformHierarchy.h
+Flat, data-oriented storage for every transform in a scene.
+*/
+
+#pragma once
+
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include "GLM/glm.hpp"
+#include "GLM/gtx/quaternion.hpp"
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+namespace nou
+{
+	//Stores the local position, rotation and scale, and the global matrix,
+	//of every node in its own array (structure of arrays).
+	//The arrays are kept sorted so that every parent comes before its children.
+	//That means we can update the whole hierarchy with a single loop from
+	//the front to the back - by the time we get to a node, its parent's
+	//global matrix is already up to date.
+	//
+	//Nodes are referred to by a handle, which stays the same for the life of
+	//the node even as the arrays get reordered.
+	//
+	//Changing a node marks it as dirty. During Update, a node is recomputed
+	//if it or any of its ancestors are dirty, so we only ever touch the
+	//subtrees that actually changed.
+	class TransformHierarchy
+	{
+		public:
+
+		static constexpr uint32_t InvalidHandle = 0xFFFFFFFF;
+
+		//Gets the hierarchy that Transforms live in unless they are given another
+		//one (e.g., by a World).
+		static TransformHierarchy& Default();
+
+		TransformHierarchy();
+		~TransformHierarchy() = default;
+
+		TransformHierarchy(const TransformHierarchy& other) = delete;
+		TransformHierarchy& operator=(const TransformHierarchy& other) = delete;
+
+		//Creates a new root node with an identity transform.
+		uint32_t Create();
+		//Destroys a node. Any children it had become roots, keeping
+		//their local transforms.
+		void Destroy(uint32_t handle);
+
+		//Sets the parent of a node, or makes it a root if parent is InvalidHandle.
+		//Returns false (and changes nothing) if this would create a cycle.
+		bool SetParent(uint32_t handle, uint32_t parent);
+		uint32_t GetParent(uint32_t handle) const;
+
+		//Recomputes the global matrix of every node that is dirty, or has a
+		//dirty ancestor, then clears the dirty flags.
+		//This does nothing if no node has changed since the last update.
+		void Update();
+
+		//Whether any node has changed since the last update.
+		bool IsDirty() const { return m_dirtyCount > 0 || m_orderDirty; }
+
+		//Marks a node as changed, so that it (and its subtree) are recomputed
+		//on the next update.
+		//This is safe to call from several threads at once, as long as they
+		//are marking different nodes (e.g., a system running in parallel).
+		void MarkDirty(uint32_t handle)
+		{
+			uint8_t& flag = m_dirty[m_dense[handle]];
+			if (flag == 0)
+			{
+				flag = 1;
+				m_dirtyCount.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		//Direct access to a node's local transform. These do NOT mark the node
+		//as dirty, call MarkDirty after changing them.
+		glm::vec3& Position(uint32_t handle) { return m_position[m_dense[handle]]; }
+		glm::quat& Rotation(uint32_t handle) { return m_rotation[m_dense[handle]]; }
+		glm::vec3& Scale(uint32_t handle) { return m_scale[m_dense[handle]]; }
+
+		//The global matrix of a node, as of the last update.
+		const glm::mat4& GetGlobal(uint32_t handle) const { return m_global[m_dense[handle]]; }
+
+		size_t GetCount() const { return m_handle.size(); }
+
+		protected:
+
+		//Everything below here is indexed by a node's position in the sorted
+		//order (its dense index), except for m_dense and m_free which are
+		//indexed by handle.
+		std::vector<glm::vec3> m_position;
+		std::vector<glm::quat> m_rotation;
+		std::vector<glm::vec3> m_scale;
+		std::vector<glm::mat4> m_global;
+		//The dense index of each node's parent, or InvalidHandle for roots.
+		std::vector<uint32_t> m_parent;
+		std::vector<uint32_t> m_childCount;
+		std::vector<uint8_t> m_dirty;
+		//The handle of the node at each dense index.
+		std::vector<uint32_t> m_handle;
+
+		//The dense index of each handle, or InvalidHandle if the handle is free.
+		std::vector<uint32_t> m_dense;
+		std::vector<uint32_t> m_free;
+
+		std::atomic<size_t> m_dirtyCount;
+		//Set when a parent may have ended up after one of its children.
+		bool m_orderDirty;
+
+		//Scratch space for sorting.
+		std::vector<uint32_t> m_depth;
+		std::vector<uint32_t> m_order;
+
+		//Re-sorts the nodes by their depth in the hierarchy, which puts every
+		//parent before its children.
+		void SortByDepth();
+		//Moves the node at dense index "from" to dense index "to", overwriting it.
+		void MoveNode(uint32_t from, uint32_t to);
+	};
+}
@@ -0,0 +1,271 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+World.h
+Owns the ENTT registry and transforms for one scene, plus the systems
+that update and draw it.
+*/
+
+#pragma once
+
+#include "Transform.h"
+#include "JobSystem.h"
+
+#include "entt.hpp"
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace nou
+{
+	class Entity;
+
+	//Describes which components a system reads and writes, so that the
+	//world knows which systems are safe to run at the same time.
+	//Use Transform for anything that reads or moves transforms.
+	//
+	//e.g., SystemAccess().Read<CCamera>().Write<Transform, CAnimator>()
+	//
+	//A system that doesn't declare anything might touch anything, so it
+	//runs on its own, on the main thread.
+	class SystemAccess
+	{
+		public:
+
+		SystemAccess() : m_declared(false), m_mainThread(false) {}
+
+		template<typename... T>
+		SystemAccess& Read()
+		{
+			(Add<T>(m_reads), ...);
+			return *this;
+		}
+
+		template<typename... T>
+		SystemAccess& Write()
+		{
+			(Add<T>(m_writes), ...);
+			return *this;
+		}
+
+		//The system has to run on the main thread (e.g., it makes OpenGL calls).
+		SystemAccess& MainThread()
+		{
+			m_mainThread = true;
+			return *this;
+		}
+
+		//Whether two systems could step on each other's toes if they ran at
+		//the same time (i.e., either one writes something the other uses).
+		bool ConflictsWith(const SystemAccess& other) const;
+		bool IsMainThread() const { return m_mainThread || !m_declared; }
+
+		protected:
+
+		friend class World;
+
+		std::vector<entt::id_type> m_reads;
+		std::vector<entt::id_type> m_writes;
+		//Makes sure the storage for each component exists before any
+		//systems run - ENTT creates it the first time it's used, which isn't
+		//safe to do from several threads at once.
+		std::vector<void(*)(entt::registry&)> m_prepare;
+		bool m_declared;
+		bool m_mainThread;
+
+		template<typename T>
+		void Add(std::vector<entt::id_type>& list)
+		{
+			m_declared = true;
+			list.push_back(entt::type_info<T>::id());
+
+			//Transforms live in the hierarchy, not the registry.
+			if constexpr (!std::is_same<T, Transform>::value)
+				m_prepare.push_back(&Prepare<T>);
+		}
+
+		template<typename T>
+		static void Prepare(entt::registry& registry)
+		{
+			(void)registry.view<T>();
+		}
+	};
+
+	//A world is a self-contained scene - it has its own ENTT registry (so
+	//its own components) and its own transform hierarchy. Entities in one
+	//world can't see or be parented to entities in another, so you can have
+	//e.g. the game in one world and a model preview in another.
+	//
+	//Rather than updating and drawing every entity by hand each frame,
+	//you register systems. A system is just a function that runs over the
+	//world - usually by looping over an ENTT view, which walks each
+	//component's storage from front to back instead of looking up
+	//entities one at a time.
+	//
+	//If systems say what they read and write (see SystemAccess), the world
+	//runs the ones that don't conflict at the same time on its JobSystem.
+	//Systems that do conflict always run in the order they were added.
+	class World
+	{
+		public:
+
+		//A system gets the world it's running on and the frame's delta time.
+		typedef std::function<void(World&, float)> System;
+
+		//Gets the world that Entity::Create() puts entities into.
+		//It shares its transforms with TransformHierarchy::Default().
+		static World& Default();
+
+		World();
+		~World() = default;
+
+		World(const World& other) = delete;
+		World& operator=(const World& other) = delete;
+
+		entt::registry& Registry() { return m_registry; }
+		TransformHierarchy& Transforms() { return *m_transforms; }
+
+		//Adds a system to the end of the list. Conflicting systems run in the
+		//order they were added, so add anything that moves objects around
+		//before the transform system, and the render system last.
+		void AddSystem(const std::string& name, const System& system, const SystemAccess& access = SystemAccess());
+		//Returns false if there was no system with that name.
+		bool RemoveSystem(const std::string& name);
+
+		//Adds the transform, camera and render systems below, in that order.
+		void AddDefaultSystems();
+
+		//Runs every system once. If a system throws, the systems that haven't
+		//started yet are skipped, and the first exception is rethrown from
+		//here once the rest have finished (whatever the thread count).
+		void Update(float deltaTime);
+
+		//Sets the job system used to run systems (and ParallelEach) on.
+		//Passing nullptr, or a job system with no threads, runs everything
+		//on the calling thread in the order it was added - useful for debugging.
+		void SetJobSystem(JobSystem* jobs) { m_jobs = jobs; }
+		JobSystem* GetJobSystem() const { return m_jobs; }
+
+		//Calls func(Component&...) for every entity that has all of the given
+		//components, split into chunks across the job system.
+		//func must be safe to call for different entities at the same time.
+		template<typename... Component, typename Func>
+		void ParallelEach(Func func, size_t grainSize = 0);
+
+		//The camera the render system draws from. The first camera created in
+		//a world becomes its camera automatically.
+		void SetCamera(Entity* camera) { m_camera = camera; }
+		Entity* GetCamera() const { return m_camera; }
+
+		//Recomputes the global transform of everything that has changed.
+		static void UpdateTransforms(World& world, float deltaTime);
+		//Calls Update on every CCamera. Cameras bring their own transforms up
+		//to date, so this counts as writing Transform.
+		static void UpdateCameras(World& world, float deltaTime);
+		//Draws every CMeshRenderer from the world's camera, skipping any
+		//whose bounds are outside the camera's view.
+		static void Render(World& world, float deltaTime);
+
+		//What happened the last time the render system ran.
+		struct RenderStats
+		{
+			size_t drawn;
+			size_t culled;
+		};
+
+		const RenderStats& GetRenderStats() const { return m_renderStats; }
+
+		protected:
+
+		struct NamedSystem
+		{
+			std::string name;
+			System system;
+			SystemAccess access;
+			//Systems that have to wait for this one.
+			std::vector<size_t> dependents;
+			//How many systems this one has to wait for.
+			size_t dependencyCount;
+		};
+
+		entt::registry m_registry;
+		std::unique_ptr<TransformHierarchy> m_ownTransforms;
+		TransformHierarchy* m_transforms;
+		std::vector<NamedSystem> m_systems;
+		Entity* m_camera;
+
+		JobSystem* m_jobs;
+		bool m_graphDirty;
+
+		//Scratch space for culling, so we aren't allocating every frame.
+		std::vector<glm::vec4> m_bounds;
+		std::vector<uint8_t> m_visible;
+		RenderStats m_renderStats;
+
+		//State for the current Update.
+		float m_deltaTime;
+		std::unique_ptr<std::atomic<size_t>[]> m_waitingOn;
+		std::atomic<size_t> m_systemsLeft;
+		//Set once a system has thrown, so the rest of the frame is skipped.
+		std::atomic<bool> m_aborted;
+		std::mutex m_errorMutex;
+		std::exception_ptr m_error;
+		JobSystem::Counter m_counter;
+		std::mutex m_mainMutex;
+		std::vector<size_t> m_mainReady;
+
+		World(TransformHierarchy& transforms);
+
+		//Works out which systems have to wait for which.
+		void BuildGraph();
+		//Queues a system whose dependencies have all finished.
+		void Schedule(size_t index);
+		void RunSystem(size_t index);
+		//Runs a ready main thread system, if there is one.
+		bool RunMainThreadSystem();
+	};
+
+	template<typename... Component, typename Func>
+	void World::ParallelEach(Func func, size_t grainSize)
+	{
+		auto view = m_registry.view<Component...>();
+
+		if constexpr (sizeof...(Component) == 1)
+		{
+			//A single component view is just its array of components, so we
+			//can split that up directly.
+			auto* components = view.raw();
+			auto body = [&func, components](size_t begin, size_t end)
+			{
+				for (size_t ix = begin; ix < end; ++ix)
+					func(components[ix]);
+			};
+
+			if (m_jobs != nullptr)
+				m_jobs->ParallelFor(view.size(), body, grainSize);
+			else
+				body(0, view.size());
+		}
+		else
+		{
+			//Otherwise, we have to find the entities with everything first.
+			std::vector<entt::entity> entities(view.begin(), view.end());
+			auto body = [&func, &view, &entities](size_t begin, size_t end)
+			{
+				for (size_t ix = begin; ix < end; ++ix)
+					func(view.template get<Component>(entities[ix])...);
+			};
+
+			if (m_jobs != nullptr)
+				m_jobs->ParallelFor(entities.size(), body, grainSize);
+			else
+				body(0, entities.size());
+		}
+	}
+}
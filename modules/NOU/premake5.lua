@@ -0,0 +1,57 @@
+-- NOU is built the same way as a generated module (see CreateDefaultModule in the root premake file),
+-- except that it also needs the toolkit's headers, so that shader programs can go through
+-- TTK::ProgramBinaryCache. Every project links against every module, so the toolkit itself gets
+-- linked in by whatever uses NOU
+project "NOU"
+    kind "StaticLib"
+    language "C++"
+    cppdialect "C++17"
+    -- Sets RuntimLibrary to MultiThreaded (non DLL version for static linking)
+    staticruntime "on"
+
+    targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("obj/" .. outputdir .. "/%{prj.name}")
+
+    files
+    {
+        "src\\**.c",
+        "src\\**.cpp",
+        "include\\**.h",
+        "include\\**.hpp"
+    }
+
+    -- Modules should only link to dependencies by default. Entries that are paths to libraries (like fmod's) are
+    -- relative to the root, but premake resolves paths relative to this file, so we root them at the workspace
+    for k, v in pairs(Dependencies) do
+        if string.find(v, "/") then
+            links { "%{wks.location}\\" .. v }
+        else
+            links { v }
+        end
+    end
+
+    includedirs {
+        "%{prj.location}\\include",
+        "%{wks.location}\\modules\\toolkit\\include"
+    }
+
+    -- Along with the dependency include directories every module gets. The first entry is reserved for the
+    -- project's own source, and the others are relative to the root rather than to this file
+    for ix = 2, #ProjIncludes do
+        includedirs { "%{wks.location}\\" .. ProjIncludes[ix] }
+    end
+
+    filter "system:windows"
+        systemversion "latest"
+
+        defines {
+            "WINDOWS",
+        }
+
+    filter "configurations:Debug"
+        runtime "Debug"
+        symbols "on"
+
+    filter "configurations:Release"
+        runtime "Release"
+        optimize "on"
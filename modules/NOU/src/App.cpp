@@ -10,6 +10,7 @@ Minimal utility class for GLFW window management.
 #include "NOU/Input.h"
 
 #include "glad/glad.h"
+#include "Logging.h"
 
 #include <iostream>
 
@@ -18,10 +19,19 @@ namespace nou
 	GLFWwindow* App::m_window = nullptr;
 	float App::m_prevTime = 0.0f;
 	float App::m_deltaTime = 0.0f;
+	bool App::m_ownsLogger = false;
 
 	//Creates our GLFW window.
 	void App::Init(const std::string& name, int width, int height)
 	{
+		//We borrow the toolkit's logger (e.g., the program binary cache that
+		//our shaders go through reports to it), so make sure it's running.
+		if (Logger::GetLogger() == nullptr)
+		{
+			Logger::Init();
+			m_ownsLogger = true;
+		}
+
 		if (glfwInit() == GLFW_FALSE)
 		{
 			std::cout << "GLFW init failed!" << std::endl;
@@ -87,6 +97,12 @@ namespace nou
 	{
 		glfwDestroyWindow(m_window);
 		glfwTerminate();
+
+		if (m_ownsLogger)
+		{
+			Logger::Uninitialize();
+			m_ownsLogger = false;
+		}
 	}
 
 	void App::Tick()
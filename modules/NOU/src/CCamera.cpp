@@ -24,6 +24,10 @@ namespace nou
 		if (current == nullptr)
 			current = &owner;
 
+		//Same goes for the camera our world renders from.
+		if (owner.GetWorld().GetCamera() == nullptr)
+			owner.GetWorld().SetCamera(&owner);
+
 		m_owner = &owner;
 
 		//Initialize our projection and view matrices to identity.
@@ -36,6 +40,9 @@ namespace nou
 		//If we are being destroyed, then make sure we're not registered as the current camera!
 		if (current == m_owner)
 			current = nullptr;
+
+		if (m_owner->GetWorld().GetCamera() == m_owner)
+			m_owner->GetWorld().SetCamera(nullptr);
 	}
 
 	void CCamera::Update()
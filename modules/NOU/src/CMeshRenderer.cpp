@@ -12,6 +12,7 @@ that we intend the class for use as a component with the ENTT framework.
 
 #include "NOU/CMeshRenderer.h"
 #include "NOU/CCamera.h"
+#include "NOU/Frustum.h"
 
 namespace nou
 {
@@ -20,6 +21,8 @@ namespace nou
 		m_owner = nullptr;
 		m_mat = nullptr;
 		m_vao = nullptr;
+		m_boundsCenter = glm::vec3(0.0f);
+		m_boundsRadius = 0.0f;
 	}
 
 	CMeshRenderer::CMeshRenderer(Entity& owner, 
@@ -40,6 +43,9 @@ namespace nou
 	{
 		const VertexBuffer* vbo;
 
+		m_boundsCenter = mesh.GetBoundsCenter();
+		m_boundsRadius = mesh.GetBoundsRadius();
+
 		if ((vbo = mesh.GetVBO(Mesh::Attrib::POSITION)) != nullptr)
 			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::POSITION);
 
@@ -51,6 +57,11 @@ namespace nou
 	}
 
 	void CMeshRenderer::Draw()
+	{
+		Draw(CCamera::current->Get<CCamera>().GetVP());
+	}
+
+	void CMeshRenderer::Draw(const glm::mat4& viewProj)
 	{
 		m_mat->Use();
 
@@ -59,10 +70,15 @@ namespace nou
 		//We are assuming the names used by uniform shader variables as a convention here.
 		//In a larger project, we would have a more elegant system for registering
 		//or even automatically detecting uniform names.
-		ShaderProgram::Current()->SetUniform("viewproj", CCamera::current->Get<CCamera>().GetVP());
+		ShaderProgram::Current()->SetUniform("viewproj", viewProj);
 		ShaderProgram::Current()->SetUniform("model", transform.GetGlobal());
 		ShaderProgram::Current()->SetUniform("normal", transform.GetNormal());
 		
 		m_vao->Draw();
 	}
+
+	glm::vec4 CMeshRenderer::GetWorldBounds() const
+	{
+		return TransformSphere(m_owner->transform.GetGlobal(), m_boundsCenter, m_boundsRadius);
+	}
 }
\ No newline at end of file
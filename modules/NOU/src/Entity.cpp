@@ -10,21 +10,26 @@ Minimal and lightly OOP wrapper for the ENTT framework.
 
 namespace nou
 {
-	entt::registry Entity::ecs;
-
 	Entity Entity::Create()
 	{
-		entt::entity id = ecs.create();
-		return Entity(id);
+		return Create(World::Default());
+	}
+
+	Entity Entity::Create(World& world)
+	{
+		entt::entity id = world.Registry().create();
+		return Entity(world, id);
 	}
 
-	Entity::Entity(entt::entity id)
+	Entity::Entity(World& world, entt::entity id)
+		: transform(world.Transforms())
 	{
+		m_world = &world;
 		m_id = id;
 	}
 
 	Entity::~Entity()
 	{
-		ecs.destroy(m_id);
+		m_world->Registry().destroy(m_id);
 	}
 }
\ No newline at end of file
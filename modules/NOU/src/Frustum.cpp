@@ -0,0 +1,111 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+Frustum.cpp
+View frustum for skipping objects that are off screen.
+*/
+
+#include "NOU/Frustum.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_SSE
+#include <emmintrin.h>
+#endif
+
+namespace nou
+{
+	Frustum::Frustum(const glm::mat4& viewProj)
+	{
+		//A point is on screen if -w <= x, y, z <= w after the view-projection,
+		//which gives us one plane per inequality (e.g., w + x >= 0 for the
+		//left plane). GLM matrices are stored by column, so pull out the rows.
+		glm::vec4 rows[4];
+		for (int ix = 0; ix < 4; ++ix)
+			rows[ix] = glm::vec4(viewProj[0][ix], viewProj[1][ix], viewProj[2][ix], viewProj[3][ix]);
+
+		m_planes[PLANE_LEFT] = rows[3] + rows[0];
+		m_planes[PLANE_RIGHT] = rows[3] - rows[0];
+		m_planes[PLANE_BOTTOM] = rows[3] + rows[1];
+		m_planes[PLANE_TOP] = rows[3] - rows[1];
+		m_planes[PLANE_NEAR] = rows[3] + rows[2];
+		m_planes[PLANE_FAR] = rows[3] - rows[2];
+
+		//Normalize the planes, so that plane tests give us actual distances
+		//we can compare to a radius.
+		for (auto& plane : m_planes)
+			plane /= glm::length(glm::vec3(plane));
+	}
+
+	bool Frustum::ContainsSphere(const glm::vec3& center, float radius) const
+	{
+		for (const auto& plane : m_planes)
+		{
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+				return false;
+		}
+
+		return true;
+	}
+
+	size_t Frustum::CullSpheres(const glm::vec4* spheres, size_t count, uint8_t* visible) const
+	{
+		size_t ix = 0;
+		size_t visibleCount = 0;
+
+		#ifdef FRUSTUM_SSE
+		__m128 planes[PLANE_COUNT][4];
+		for (int p = 0; p < PLANE_COUNT; ++p)
+		{
+			for (int c = 0; c < 4; ++c)
+				planes[p][c] = _mm_set1_ps(m_planes[p][c]);
+		}
+
+		for (; ix + 4 <= count; ix += 4)
+		{
+			//Turn 4 spheres into one register each of x, y, z and radius.
+			__m128 x = _mm_loadu_ps(&spheres[ix].x);
+			__m128 y = _mm_loadu_ps(&spheres[ix + 1].x);
+			__m128 z = _mm_loadu_ps(&spheres[ix + 2].x);
+			__m128 r = _mm_loadu_ps(&spheres[ix + 3].x);
+			_MM_TRANSPOSE4_PS(x, y, z, r);
+			__m128 negR = _mm_sub_ps(_mm_setzero_ps(), r);
+
+			//A sphere survives a plane if its distance is at least -radius.
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int p = 0; p < PLANE_COUNT; ++p)
+			{
+				__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planes[p][0], x), _mm_mul_ps(planes[p][1], y)),
+					_mm_add_ps(_mm_mul_ps(planes[p][2], z), planes[p][3]));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, negR));
+			}
+
+			int mask = _mm_movemask_ps(inside);
+			visible[ix] = mask & 1;
+			visible[ix + 1] = (mask >> 1) & 1;
+			visible[ix + 2] = (mask >> 2) & 1;
+			visible[ix + 3] = (mask >> 3) & 1;
+			visibleCount += visible[ix] + visible[ix + 1] + visible[ix + 2] + visible[ix + 3];
+		}
+		#endif
+
+		for (; ix < count; ++ix)
+		{
+			visible[ix] = ContainsSphere(glm::vec3(spheres[ix]), spheres[ix].w) ? 1 : 0;
+			visibleCount += visible[ix];
+		}
+
+		return visibleCount;
+	}
+
+	glm::vec4 TransformSphere(const glm::mat4& transform, const glm::vec3& center, float radius)
+	{
+		float scaleSq = std::max(glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+			std::max(glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])),
+				glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2]))));
+
+		return glm::vec4(glm::vec3(transform * glm::vec4(center, 1.0f)), radius * sqrtf(scaleSq));
+	}
+}
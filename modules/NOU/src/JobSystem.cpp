@@ -0,0 +1,255 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+JobSystem.cpp
+Small work-stealing job scheduler for spreading work across cores.
+*/
+
+#include "NOU/JobSystem.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace nou
+{
+	//Which job system (if any) the current thread is a worker for, and
+	//which queue belongs to it.
+	static thread_local const JobSystem* t_owner = nullptr;
+	static thread_local unsigned t_queue = 0;
+
+	JobSystem& JobSystem::Default()
+	{
+		static JobSystem jobs(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+		return jobs;
+	}
+
+	JobSystem::JobSystem(unsigned threadCount)
+		: m_pending(0), m_quit(false)
+	{
+		for (unsigned ix = 0; ix <= threadCount; ++ix)
+			m_queues.push_back(std::make_unique<Queue>());
+
+		for (unsigned ix = 0; ix < threadCount; ++ix)
+			m_threads.emplace_back(&JobSystem::WorkerLoop, this, ix);
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_quit = true;
+		}
+		m_wake.notify_all();
+
+		for (auto& thread : m_threads)
+			thread.join();
+	}
+
+	void JobSystem::Run(const Job& job, Counter& counter)
+	{
+		//No workers - just do it now. Any exception still waits for Wait,
+		//so callers see the same thing whatever the thread count.
+		if (m_threads.empty())
+		{
+			try
+			{
+				job();
+			}
+			catch (...)
+			{
+				counter.CaptureException();
+			}
+			return;
+		}
+
+		counter.m_remaining.fetch_add(1, std::memory_order_relaxed);
+
+		Queue& queue = *m_queues[GetQueueIndex()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.jobs.push_back({ job, &counter });
+		}
+		m_pending.fetch_add(1, std::memory_order_release);
+
+		//Taking the lock (even for nothing) makes sure a worker that is just
+		//about to go to sleep sees the new job, rather than missing the wakeup.
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+		}
+		m_wake.notify_one();
+	}
+
+	void JobSystem::Wait(Counter& counter)
+	{
+		while (!counter.IsDone())
+		{
+			if (!RunPending())
+				std::this_thread::yield();
+		}
+
+		//Hand the exception over, so the counter can be used again.
+		std::exception_ptr error = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(counter.m_errorMutex);
+			std::swap(error, counter.m_error);
+		}
+
+		if (error != nullptr)
+			std::rethrow_exception(error);
+	}
+
+	bool JobSystem::RunPending()
+	{
+		unsigned index = GetQueueIndex();
+		QueuedJob job;
+
+		if (TryPop(index, job) || TrySteal(index, job))
+		{
+			Execute(job);
+			return true;
+		}
+
+		return false;
+	}
+
+	void JobSystem::ParallelFor(size_t count, const std::function<void(size_t, size_t)>& body, size_t grainSize)
+	{
+		if (count == 0)
+			return;
+
+		//A few chunks per thread gives the faster threads something to
+		//steal if the work isn't spread evenly.
+		if (grainSize == 0)
+		{
+			size_t chunks = (m_threads.size() + 1) * 4;
+			grainSize = std::max<size_t>((count + chunks - 1) / chunks, 1);
+		}
+
+		//Without workers, run the chunks in order so that every run does
+		//the same thing.
+		if (m_threads.empty() || count <= grainSize)
+		{
+			std::exception_ptr error = nullptr;
+			for (size_t begin = 0; begin < count; begin += grainSize)
+			{
+				try
+				{
+					body(begin, std::min(begin + grainSize, count));
+				}
+				catch (...)
+				{
+					if (error == nullptr)
+						error = std::current_exception();
+				}
+			}
+
+			if (error != nullptr)
+				std::rethrow_exception(error);
+			return;
+		}
+
+		//Queue up everything but the first chunk, and do that one ourselves.
+		Counter counter;
+		for (size_t begin = grainSize; begin < count; begin += grainSize)
+		{
+			size_t end = std::min(begin + grainSize, count);
+			Run([&body, begin, end]() { body(begin, end); }, counter);
+		}
+
+		//The queued chunks point at body and counter, so we have to wait for
+		//them even if our own chunk throws.
+		try
+		{
+			body(0, grainSize);
+		}
+		catch (...)
+		{
+			counter.CaptureException();
+		}
+
+		Wait(counter);
+	}
+
+	void JobSystem::WorkerLoop(unsigned index)
+	{
+		t_owner = this;
+		t_queue = index;
+
+		while (!m_quit)
+		{
+			if (RunPending())
+				continue;
+
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_wake.wait(lock, [this]() { return m_pending.load(std::memory_order_acquire) > 0 || m_quit; });
+		}
+	}
+
+	unsigned JobSystem::GetQueueIndex() const
+	{
+		return t_owner == this ? t_queue : static_cast<unsigned>(m_queues.size() - 1);
+	}
+
+	bool JobSystem::TryPop(unsigned index, QueuedJob& out)
+	{
+		Queue& queue = *m_queues[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (queue.jobs.empty())
+			return false;
+
+		//Newest first - it's the one most likely to still be in our cache.
+		out = std::move(queue.jobs.back());
+		queue.jobs.pop_back();
+		m_pending.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	bool JobSystem::TrySteal(unsigned thief, QueuedJob& out)
+	{
+		const unsigned count = static_cast<unsigned>(m_queues.size());
+
+		for (unsigned offset = 1; offset < count; ++offset)
+		{
+			Queue& queue = *m_queues[(thief + offset) % count];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+
+			if (queue.jobs.empty())
+				continue;
+
+			//Oldest first - the owner works from the other end, so we're less
+			//likely to be after the same job.
+			out = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			m_pending.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		return false;
+	}
+
+	void JobSystem::Execute(QueuedJob& job)
+	{
+		//An exception can't be allowed out of a worker (it would end the
+		//program), and the counter has to come down either way or Wait
+		//would never return.
+		try
+		{
+			job.job();
+		}
+		catch (...)
+		{
+			job.counter->CaptureException();
+		}
+
+		job.counter->m_remaining.fetch_sub(1, std::memory_order_release);
+	}
+
+	void JobSystem::Counter::CaptureException()
+	{
+		std::lock_guard<std::mutex> lock(m_errorMutex);
+
+		if (m_error == nullptr)
+			m_error = std::current_exception();
+	}
+}
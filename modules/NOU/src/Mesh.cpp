@@ -8,12 +8,32 @@ Very basic class for managing the data associated with a 3D model.
 
 #include "NOU/Mesh.h"
 
+#include <cmath>
+
 namespace nou
 {
 	void Mesh::SetVerts(const std::vector<glm::vec3>& verts)
 	{
 		m_verts = verts;
 		SetVBO(Attrib::POSITION, 3, m_verts);
+
+		//Work out our bounds now, so we don't have to look at every vertex
+		//each time we want to know if the mesh is on screen.
+		m_boundsMin = m_boundsMax = m_verts.empty() ? glm::vec3(0.0f) : m_verts[0];
+		for (const auto& v : m_verts)
+		{
+			m_boundsMin = glm::min(m_boundsMin, v);
+			m_boundsMax = glm::max(m_boundsMax, v);
+		}
+
+		m_boundsCenter = (m_boundsMin + m_boundsMax) * 0.5f;
+		float radiusSq = 0.0f;
+		for (const auto& v : m_verts)
+		{
+			glm::vec3 offset = v - m_boundsCenter;
+			radiusSq = glm::max(radiusSq, glm::dot(offset, offset));
+		}
+		m_boundsRadius = sqrtf(radiusSq);
 	}
 
 	void Mesh::SetNormals(const std::vector<glm::vec3>& normals)
@@ -9,6 +9,7 @@ Utility classes for managing OpenGL shaders and shader programs.
 #include "NOU/Shader.h"
 
 #include "GLM/glm.hpp"
+#include "TTK/ProgramBinaryCache.h"
 
 #include <iostream>
 #include <fstream>
@@ -81,39 +82,15 @@ namespace nou
 		GLint len = 0;
 
 		m_id = 0;
+		m_type = shaderType;
+		m_compiled = false;
 
 		printf("Loading shader: %s\n", file.c_str());
 
+		//We hang on to the source rather than compiling it right away - if
+		//the program using it is in the binary cache, we never have to.
 		if (LoadFileGLChar(file, data, len))
-		{
-			//Create a new shader object in OpenGL.
-			m_id = glCreateShader(shaderType);
-
-			const GLint* glLen = (const GLint*)(&len);
-			const GLchar** glData = (const GLchar**)(&data);
-
-			//Specify the source code (read from our file by LoadFileGLChar)
-			//and ask OpenGL to compile our shader.
-			glShaderSource(m_id, 1, glData, glLen);
-			glCompileShader(m_id);
-
-			//Check for any issues.
-			GLint result;
-			glGetShaderiv(m_id, GL_COMPILE_STATUS, &result);
-
-			//Print some feedback on shader compilation.
-			if (result)
-				printf("Shader compiled successfully.\n");
-			else
-			{
-				GLint buflen = 0;
-
-				glGetShaderiv(m_id, GL_INFO_LOG_LENGTH, &buflen);
-				PrintGLInfoLog("Shader compilation failed", GLInfoLogType::SHADER, m_id, buflen);
-
-				glDeleteShader(m_id);
-			}
-		}
+			m_source = data;
 
 		delete[] data;
 	}
@@ -125,21 +102,86 @@ namespace nou
 
 	GLuint Shader::GetID()
 	{
+		if (!m_compiled)
+			Compile();
+
 		return m_id;
 	}
 
+	void Shader::Compile()
+	{
+		m_compiled = true;
+
+		if (m_source.empty())
+			return;
+
+		//Create a new shader object in OpenGL.
+		m_id = glCreateShader(m_type);
+
+		const GLchar* glData = m_source.c_str();
+		const GLint glLen = (GLint)m_source.length();
+
+		//Specify the source code (read from our file by LoadFileGLChar)
+		//and ask OpenGL to compile our shader.
+		glShaderSource(m_id, 1, &glData, &glLen);
+		glCompileShader(m_id);
+
+		//Check for any issues.
+		GLint result;
+		glGetShaderiv(m_id, GL_COMPILE_STATUS, &result);
+
+		//Print some feedback on shader compilation.
+		if (result)
+			printf("Shader compiled successfully.\n");
+		else
+		{
+			GLint buflen = 0;
+
+			glGetShaderiv(m_id, GL_INFO_LOG_LENGTH, &buflen);
+			PrintGLInfoLog("Shader compilation failed", GLInfoLogType::SHADER, m_id, buflen);
+
+			glDeleteShader(m_id);
+			m_id = 0;
+		}
+	}
+
 	ShaderProgram::ShaderProgram(const std::vector<Shader*>& shaders)
 	{
 		//Create a new shader program object.
 		m_id = glCreateProgram();
 
+		Link(shaders);
+	}
+
+	void ShaderProgram::Link(const std::vector<Shader*>& shaders)
+	{
+		//The cache keys programs on the source of every shader (and the
+		//driver), so changing any of them means compiling from scratch.
+		TTK::ProgramBinaryCache& cache = TTK::ProgramBinaryCache::Instance();
+
+		std::vector<const char*> sources;
+		for (auto* shader : shaders)
+		{
+			sources.push_back(shader->GetSource().c_str());
+		}
+
+		uint64_t key = cache.MakeKey(sources.data(), sources.size());
+
+		if (cache.TryLoad(m_id, key))
+		{
+			printf("Loaded shader program from the binary cache.\n");
+			return;
+		}
+
 		//Attach our shadders to the new program.
 		for (auto* shader : shaders)
 		{
 			glAttachShader(m_id, shader->GetID());
 		}
 
-		//Attempt to link the new program.
+		//Attempt to link the new program, asking the driver to keep the
+		//binary around so we can store it.
+		TTK::ProgramBinaryCache::PrepareForLink(m_id);
 		glLinkProgram(m_id);
 
 		//Find out if linking was successful.
@@ -148,7 +190,10 @@ namespace nou
 
 		//Provide feedback on the program's linking.
 		if (result)
+		{
 			printf("Linked shader program successfully.\n");
+			cache.Store(m_id, key);
+		}
 		else
 		{
 			GLint buflen = 0;
@@ -8,76 +8,71 @@ Simple class for managing object transforms with basic hierarchy support.
 
 #include "NOU/Transform.h"
 
-#include "GLM/gtx/transform.hpp"
-
 namespace nou
 {
 	Transform::Transform()
+		: Transform(TransformHierarchy::Default())
+	{
+	}
+
+	Transform::Transform(TransformHierarchy& hierarchy)
+		: m_pos(this), m_scale(this), m_rotation(this)
 	{
-		m_parent = nullptr;
+		//New nodes start out at the origin, with no rotation and a scale of 1.
+		m_hierarchy = &hierarchy;
+		m_handle = m_hierarchy->Create();
+	}
+
+	Transform::Transform(const Transform& other)
+		: Transform(*other.m_hierarchy)
+	{
+		*this = other;
+	}
+
+	Transform& Transform::operator=(const Transform& other)
+	{
+		if (&other == this)
+			return *this;
+
+		m_pos = other.m_pos.Get();
+		m_scale = other.m_scale.Get();
+		m_rotation = other.m_rotation.Get();
 
-		m_pos = glm::vec3(0.0f);
-		m_scale = glm::vec3(1.0f);
-		m_rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		//Handles only mean something inside their own hierarchy.
+		if (other.m_hierarchy == m_hierarchy)
+			m_hierarchy->SetParent(m_handle, m_hierarchy->GetParent(other.m_handle));
 
-		m_global = glm::mat4(1.0f);
+		return *this;
 	}
 
 	Transform::~Transform()
 	{
-		SetParent(nullptr);
+		m_hierarchy->Destroy(m_handle);
 	}
 
 	void Transform::DoFK()
 	{
-		//First, grab our local transform...
-		glm::mat4 local = glm::translate(m_pos) *
-						  glm::toMat4(glm::normalize(m_rotation)) *
-						  glm::scale(m_scale);
-
-		//If we have a parent, we need to multiply by our parent's
-		//global transform.
-		if (m_parent != nullptr)
-			m_global = m_parent->m_global * local;
-
-		//If we have no parent object, our global transform is our
-		//local transform!
-		else
-			m_global = local;
-
-		//FK is recursive - we now repeat this process on our child nodes.
-		//Eventually, we'll be at the bottom of the hierarchy and this will
-		//return.
-		for (auto* child : m_children)
-		{
-			child->DoFK();
-		}
+		//The hierarchy is stored parent-first, so one pass over it updates
+		//every object after its parent - no recursion needed.
+		m_hierarchy->Update();
 	}
 
 	const glm::mat4& Transform::RecomputeGlobal()
 	{
-		//Just as with FK, compute our local, then multiply with
-		//our parent's transform if applicable.
-
-		glm::mat4 local = glm::translate(m_pos) *
-						  glm::toMat4(m_rotation) *
-						  glm::scale(m_scale);
-
-		if (m_parent != nullptr)
-			m_global = m_parent->RecomputeGlobal() * local;
-		else
-			m_global = local;
-
-		return m_global;
+		m_hierarchy->Update();
+		return GetGlobal();
 	}
 
 	const glm::mat4& Transform::GetGlobal() const
 	{
-		return m_global;
+		return m_hierarchy->GetGlobal(m_handle);
 	}
 
 	glm::mat3 Transform::GetNormal() const
 	{
+		const glm::vec3& scale = m_scale.Get();
+		const glm::mat4& global = GetGlobal();
+
 		//The normal matrix is used to transform the normals of our mesh
 		//for correct lighting.
 		//Basically, we need to orient the normals and undo any non-uniform scaling
@@ -85,48 +80,35 @@ namespace nou
 		//If we're using a uniform scale, then we can just pass the top 3x3 of our
 		//transform matrix (the rotation/scale bit) - since we'll re-normalize
 		//the normals in our shader anyways.
-		if(m_scale.x == m_scale.y && m_scale.x == m_scale.z)
-			return glm::mat3(m_global);
+		if(scale.x == scale.y && scale.x == scale.z)
+			return glm::mat3(global);
 
-		//If we do have a non-uniform scale, then we need to undo that scale, 
+		//If we do have a non-uniform scale, then we need to undo that scale,
 		//hence the inverse. However, we want to preserve our rotation.
 		//Since the inverse of a rotation matrix IS its transpose, by adding
 		//in the transpose we can effectively spit our rotation matrix with
 		//the inverse of our scale applied.
-		//You could also do some trickery here with the reciprocal of your
-		//scale vector and your rotation quaternion, but this is a bit more
-		//"bulletproof" and straightforward if you're doing oddball transformations.
-		return glm::inverse(glm::transpose(glm::mat3(m_global)));
+		//Our global matrix includes our parents' rotations and scales, so we
+		//can't just use the reciprocal of our own scale. Instead we use the
+		//cofactor matrix - the inverse transpose is the cofactor matrix divided
+		//by the determinant, and for a 3x3 the cofactors are just cross products
+		//of the columns. This gives the same result as
+		//glm::inverse(glm::transpose(m)) for a lot less work.
+		glm::vec3 c0 = glm::vec3(global[0]);
+		glm::vec3 c1 = glm::vec3(global[1]);
+		glm::vec3 c2 = glm::vec3(global[2]);
+		glm::mat3 cofactors = glm::mat3(glm::cross(c1, c2), glm::cross(c2, c0), glm::cross(c0, c1));
+		float determinant = glm::dot(c0, cofactors[0]);
+		return cofactors * (1.0f / determinant);
 	}
 
 	void Transform::SetParent(Transform* parent)
 	{
-		//If we had a parent before, remove this as a child from that object.
-		if(m_parent != nullptr)
-			m_parent->RemoveChild(this);
-
-		m_parent = parent;
+		if (parent != nullptr && parent->m_hierarchy != m_hierarchy)
+			return;
 
-		//If we have a parent now, add this as a child to that object.
-		if(m_parent != nullptr)
-			m_parent->AddChild(this);			
-	}
-
-	void Transform::AddChild(Transform* child)
-	{
-		m_children.push_back(child);
-	}
-
-	void Transform::RemoveChild(Transform* child)
-	{
-		for (auto it = m_children.begin(); it != m_children.end(); ++it)
-		{
-			if (*it == child)
-			{
-				m_children.erase(it);
-				break;
-			}
-
-		}
+		//The hierarchy takes care of keeping parents ahead of their children,
+		//and refuses to make an object its own ancestor.
+		m_hierarchy->SetParent(m_handle, parent != nullptr ? parent->m_handle : TransformHierarchy::InvalidHandle);
 	}
-}
\ No newline at end of file
+}
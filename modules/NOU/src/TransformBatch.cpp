@@ -0,0 +1,173 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+TransformBatch.cpp
+Builds transform and normal matrices for many objects at once.
+*/
+
+#include "NOU/TransformBatch.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRANSFORM_BATCH_SSE
+#include <emmintrin.h>
+#endif
+
+//We read quaternions straight out of memory as x, y, z, w.
+static_assert(sizeof(glm::quat) == 4 * sizeof(float), "Expected glm::quat to be 4 tightly packed floats");
+
+namespace nou
+{
+	//Does one object at a time - this handles whatever is left over after
+	//the SIMD loop, or everything if we don't have SSE.
+	static void ComposeOne(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale,
+		glm::mat4* transform, glm::mat3* normal)
+	{
+		//Dividing by the squared length here is the same as normalizing
+		//the quaternion first (the 2 comes from the rotation formula).
+		float s = 2.0f / (rotation.x * rotation.x + rotation.y * rotation.y + rotation.z * rotation.z + rotation.w * rotation.w);
+		float xs = rotation.x * s, ys = rotation.y * s, zs = rotation.z * s;
+		float xx = rotation.x * xs, yy = rotation.y * ys, zz = rotation.z * zs;
+		float xy = rotation.x * ys, xz = rotation.x * zs, yz = rotation.y * zs;
+		float wx = rotation.w * xs, wy = rotation.w * ys, wz = rotation.w * zs;
+
+		glm::vec3 c0(1.0f - (yy + zz), xy + wz, xz - wy);
+		glm::vec3 c1(xy - wz, 1.0f - (xx + zz), yz + wx);
+		glm::vec3 c2(xz + wy, yz - wx, 1.0f - (xx + yy));
+
+		if (transform != nullptr)
+		{
+			(*transform)[0] = glm::vec4(c0 * scale.x, 0.0f);
+			(*transform)[1] = glm::vec4(c1 * scale.y, 0.0f);
+			(*transform)[2] = glm::vec4(c2 * scale.z, 0.0f);
+			(*transform)[3] = glm::vec4(position, 1.0f);
+		}
+		if (normal != nullptr)
+		{
+			(*normal)[0] = c0 / scale.x;
+			(*normal)[1] = c1 / scale.y;
+			(*normal)[2] = c2 / scale.z;
+		}
+	}
+
+	#ifdef TRANSFORM_BATCH_SSE
+	//Loads 4 tightly packed vec3s (x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3)
+	//and splits them into one register per component.
+	static inline void LoadVec3x4(const float* src, __m128& x, __m128& y, __m128& z)
+	{
+		__m128 a = _mm_loadu_ps(src);
+		__m128 b = _mm_loadu_ps(src + 4);
+		__m128 c = _mm_loadu_ps(src + 8);
+		__m128 bc = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+		x = _mm_shuffle_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 0)), bc, _MM_SHUFFLE(2, 0, 1, 0));
+		y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+		z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+	}
+
+	//Takes one matrix column for 4 objects (one register per row), and
+	//writes it out to each of the 4 matrices.
+	static inline void StoreColumn4(__m128 x, __m128 y, __m128 z, __m128 w, glm::mat4* transforms, int column)
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(&transforms[0][column][0], x);
+		_mm_storeu_ps(&transforms[1][column][0], y);
+		_mm_storeu_ps(&transforms[2][column][0], z);
+		_mm_storeu_ps(&transforms[3][column][0], w);
+	}
+
+	//As above, but for mat3s. A mat3 column is only 3 floats, so the 4th
+	//float of the first two columns spills into the next column, which we
+	//then write over. The last column is written exactly, so we never go
+	//past the end of the last object.
+	static inline void StoreNormals4(__m128 c0[3], __m128 c1[3], __m128 c2[3], glm::mat3* normals)
+	{
+		__m128 w = _mm_setzero_ps();
+		__m128 a0 = c0[0], a1 = c0[1], a2 = c0[2], a3 = w;
+		__m128 b0 = c1[0], b1 = c1[1], b2 = c1[2], b3 = w;
+		__m128 d0 = c2[0], d1 = c2[1], d2 = c2[2], d3 = w;
+		_MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+		_MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+		_MM_TRANSPOSE4_PS(d0, d1, d2, d3);
+		__m128 columns[4][3] = { { a0, b0, d0 }, { a1, b1, d1 }, { a2, b2, d2 }, { a3, b3, d3 } };
+		for (int obj = 0; obj < 4; ++obj)
+		{
+			float* normal = &normals[obj][0][0];
+			_mm_storeu_ps(normal, columns[obj][0]);
+			_mm_storeu_ps(normal + 3, columns[obj][1]);
+			_mm_storel_pi(reinterpret_cast<__m64*>(normal + 6), columns[obj][2]);
+			_mm_store_ss(normal + 8, _mm_movehl_ps(columns[obj][2], columns[obj][2]));
+		}
+	}
+	#endif
+
+	void ComposeTransforms(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales,
+		glm::mat4* transforms, glm::mat3* normals, size_t count)
+	{
+		size_t ix = 0;
+
+		#ifdef TRANSFORM_BATCH_SSE
+		//Each register holds one component for 4 objects (x of the first
+		//column for objects 0-3, and so on), so all the math is the same as
+		//the scalar version. We only have to shuffle things around on the
+		//way in and out.
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 zero = _mm_setzero_ps();
+		for (; ix + 4 <= count; ix += 4)
+		{
+			__m128 qx = _mm_loadu_ps(&rotations[ix].x);
+			__m128 qy = _mm_loadu_ps(&rotations[ix + 1].x);
+			__m128 qz = _mm_loadu_ps(&rotations[ix + 2].x);
+			__m128 qw = _mm_loadu_ps(&rotations[ix + 3].x);
+			_MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+			__m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)),
+				_mm_add_ps(_mm_mul_ps(qz, qz), _mm_mul_ps(qw, qw)));
+			__m128 s = _mm_div_ps(two, lengthSq);
+			__m128 xs = _mm_mul_ps(qx, s), ys = _mm_mul_ps(qy, s), zs = _mm_mul_ps(qz, s);
+			__m128 xx = _mm_mul_ps(qx, xs), yy = _mm_mul_ps(qy, ys), zz = _mm_mul_ps(qz, zs);
+			__m128 xy = _mm_mul_ps(qx, ys), xz = _mm_mul_ps(qx, zs), yz = _mm_mul_ps(qy, zs);
+			__m128 wx = _mm_mul_ps(qw, xs), wy = _mm_mul_ps(qw, ys), wz = _mm_mul_ps(qw, zs);
+
+			//The unscaled rotation, cRC is row R of column C.
+			__m128 c00 = _mm_sub_ps(one, _mm_add_ps(yy, zz));
+			__m128 c01 = _mm_add_ps(xy, wz);
+			__m128 c02 = _mm_sub_ps(xz, wy);
+			__m128 c10 = _mm_sub_ps(xy, wz);
+			__m128 c11 = _mm_sub_ps(one, _mm_add_ps(xx, zz));
+			__m128 c12 = _mm_add_ps(yz, wx);
+			__m128 c20 = _mm_add_ps(xz, wy);
+			__m128 c21 = _mm_sub_ps(yz, wx);
+			__m128 c22 = _mm_sub_ps(one, _mm_add_ps(xx, yy));
+
+			__m128 sx, sy, sz;
+			LoadVec3x4(&scales[ix].x, sx, sy, sz);
+
+			if (transforms != nullptr)
+			{
+				__m128 px, py, pz;
+				LoadVec3x4(&positions[ix].x, px, py, pz);
+				StoreColumn4(_mm_mul_ps(c00, sx), _mm_mul_ps(c01, sx), _mm_mul_ps(c02, sx), zero, &transforms[ix], 0);
+				StoreColumn4(_mm_mul_ps(c10, sy), _mm_mul_ps(c11, sy), _mm_mul_ps(c12, sy), zero, &transforms[ix], 1);
+				StoreColumn4(_mm_mul_ps(c20, sz), _mm_mul_ps(c21, sz), _mm_mul_ps(c22, sz), zero, &transforms[ix], 2);
+				StoreColumn4(px, py, pz, one, &transforms[ix], 3);
+			}
+
+			if (normals != nullptr)
+			{
+				__m128 isx = _mm_div_ps(one, sx), isy = _mm_div_ps(one, sy), isz = _mm_div_ps(one, sz);
+				__m128 n0[3] = { _mm_mul_ps(c00, isx), _mm_mul_ps(c01, isx), _mm_mul_ps(c02, isx) };
+				__m128 n1[3] = { _mm_mul_ps(c10, isy), _mm_mul_ps(c11, isy), _mm_mul_ps(c12, isy) };
+				__m128 n2[3] = { _mm_mul_ps(c20, isz), _mm_mul_ps(c21, isz), _mm_mul_ps(c22, isz) };
+				StoreNormals4(n0, n1, n2, &normals[ix]);
+			}
+		}
+		#endif
+
+		for (; ix < count; ++ix)
+		{
+			ComposeOne(positions[ix], rotations[ix], scales[ix],
+				transforms != nullptr ? &transforms[ix] : nullptr,
+				normals != nullptr ? &normals[ix] : nullptr);
+		}
+	}
+}
@@ -0,0 +1,276 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+TransformHierarchy.cpp
+Flat, data-oriented storage for every transform in a scene.
+*/
+
+#include "NOU/TransformHierarchy.h"
+#include "NOU/TransformBatch.h"
+
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+namespace nou
+{
+	TransformHierarchy& TransformHierarchy::Default()
+	{
+		static TransformHierarchy hierarchy;
+		return hierarchy;
+	}
+
+	TransformHierarchy::TransformHierarchy()
+	{
+		m_dirtyCount = 0;
+		m_orderDirty = false;
+	}
+
+	uint32_t TransformHierarchy::Create()
+	{
+		uint32_t handle;
+		if (!m_free.empty())
+		{
+			handle = m_free.back();
+			m_free.pop_back();
+		}
+		else
+		{
+			handle = static_cast<uint32_t>(m_dense.size());
+			m_dense.push_back(InvalidHandle);
+		}
+
+		//New nodes are roots, so they can always go at the end.
+		m_dense[handle] = static_cast<uint32_t>(m_handle.size());
+		m_position.push_back(glm::vec3(0.0f));
+		m_rotation.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+		m_scale.push_back(glm::vec3(1.0f));
+		m_global.push_back(glm::mat4(1.0f));
+		m_parent.push_back(InvalidHandle);
+		m_childCount.push_back(0);
+		m_dirty.push_back(0);
+		m_handle.push_back(handle);
+
+		return handle;
+	}
+
+	void TransformHierarchy::Destroy(uint32_t handle)
+	{
+		uint32_t index = m_dense[handle];
+
+		//Our children become roots. Most nodes are leaves, so we only
+		//go looking for children if we know there are some.
+		if (m_childCount[index] > 0)
+		{
+			for (size_t ix = 0; ix < m_parent.size(); ++ix)
+			{
+				if (m_parent[ix] == index)
+				{
+					m_parent[ix] = InvalidHandle;
+					MarkDirty(m_handle[ix]);
+				}
+			}
+		}
+		if (m_parent[index] != InvalidHandle)
+			m_childCount[m_parent[index]]--;
+		if (m_dirty[index])
+			m_dirtyCount--;
+
+		//Fill the hole with the last node. That node may be a child of
+		//something that now comes after it, so we'll have to re-sort.
+		uint32_t last = static_cast<uint32_t>(m_handle.size() - 1);
+		if (index != last)
+		{
+			MoveNode(last, index);
+			m_orderDirty = true;
+		}
+
+		m_position.pop_back();
+		m_rotation.pop_back();
+		m_scale.pop_back();
+		m_global.pop_back();
+		m_parent.pop_back();
+		m_childCount.pop_back();
+		m_dirty.pop_back();
+		m_handle.pop_back();
+
+		m_dense[handle] = InvalidHandle;
+		m_free.push_back(handle);
+	}
+
+	bool TransformHierarchy::SetParent(uint32_t handle, uint32_t parent)
+	{
+		uint32_t index = m_dense[handle];
+		uint32_t parentIndex = parent == InvalidHandle ? InvalidHandle : m_dense[parent];
+
+		//Make sure we aren't becoming our own ancestor.
+		for (uint32_t ix = parentIndex; ix != InvalidHandle; ix = m_parent[ix])
+		{
+			if (ix == index)
+				return false;
+		}
+
+		if (m_parent[index] != InvalidHandle)
+			m_childCount[m_parent[index]]--;
+		m_parent[index] = parentIndex;
+		if (parentIndex != InvalidHandle)
+		{
+			m_childCount[parentIndex]++;
+			if (parentIndex > index)
+				m_orderDirty = true;
+		}
+
+		MarkDirty(handle);
+		return true;
+	}
+
+	uint32_t TransformHierarchy::GetParent(uint32_t handle) const
+	{
+		uint32_t parentIndex = m_parent[m_dense[handle]];
+		return parentIndex == InvalidHandle ? InvalidHandle : m_handle[parentIndex];
+	}
+
+	void TransformHierarchy::Update()
+	{
+		if (m_orderDirty)
+			SortByDepth();
+		if (m_dirtyCount == 0)
+			return;
+
+		//Parents come first, so by the time we reach a node we know whether
+		//anything above it changed this frame - the flag "flows" down to
+		//every child of a dirty node.
+		const size_t count = m_handle.size();
+		for (size_t ix = 0; ix < count; ++ix)
+		{
+			uint32_t parent = m_parent[ix];
+			if (parent != InvalidHandle)
+				m_dirty[ix] |= m_dirty[parent];
+		}
+
+		//Build the local transform of every dirty node, straight into its
+		//global matrix. Dirty nodes tend to come in runs (a whole rig, or
+		//everything on the first frame), so we hand each run to the batch
+		//kernel in one go.
+		for (size_t ix = 0; ix < count;)
+		{
+			if (!m_dirty[ix])
+			{
+				++ix;
+				continue;
+			}
+			size_t end = ix + 1;
+			while (end < count && m_dirty[end])
+				++end;
+			ComposeTransforms(&m_position[ix], &m_rotation[ix], &m_scale[ix], &m_global[ix], nullptr, end - ix);
+			ix = end;
+		}
+
+		//Finally, put each dirty node into its parent's space. The parent
+		//is always done before the child, so its global matrix is final.
+		for (size_t ix = 0; ix < count; ++ix)
+		{
+			uint32_t parent = m_parent[ix];
+			if (m_dirty[ix] && parent != InvalidHandle)
+				m_global[ix] = m_global[parent] * m_global[ix];
+		}
+
+		memset(m_dirty.data(), 0, m_dirty.size());
+		m_dirtyCount = 0;
+	}
+
+	void TransformHierarchy::SortByDepth()
+	{
+		const uint32_t count = static_cast<uint32_t>(m_handle.size());
+
+		//Work out how deep each node is. A node's parent may come after it,
+		//so we walk up until we find an ancestor we already know the depth of.
+		m_depth.assign(count, InvalidHandle);
+		uint32_t maxDepth = 0;
+		for (uint32_t ix = 0; ix < count; ++ix)
+		{
+			uint32_t depth = 0;
+			uint32_t node = ix;
+			while (node != InvalidHandle && m_depth[node] == InvalidHandle)
+			{
+				node = m_parent[node];
+				depth++;
+			}
+			depth += node == InvalidHandle ? 0 : m_depth[node] + 1;
+
+			//Walk up again, filling in the depths on the way.
+			node = ix;
+			while (node != InvalidHandle && m_depth[node] == InvalidHandle)
+			{
+				m_depth[node] = --depth;
+				node = m_parent[node];
+			}
+			maxDepth = std::max(maxDepth, m_depth[ix]);
+		}
+
+		//Counting sort by depth. This is stable, so nodes at the same depth
+		//stay in the order they were in.
+		std::vector<uint32_t> offsets(maxDepth + 2, 0);
+		for (uint32_t ix = 0; ix < count; ++ix)
+			offsets[m_depth[ix] + 1]++;
+		for (uint32_t ix = 1; ix < offsets.size(); ++ix)
+			offsets[ix] += offsets[ix - 1];
+		m_order.resize(count);
+		for (uint32_t ix = 0; ix < count; ++ix)
+			m_order[offsets[m_depth[ix]]++] = ix;
+
+		//m_order[new] = old, we also need the reverse to fix up parent indices.
+		std::vector<uint32_t> newIndex(count);
+		for (uint32_t ix = 0; ix < count; ++ix)
+			newIndex[m_order[ix]] = ix;
+
+		auto permute = [this, count](auto& array)
+		{
+			typename std::remove_reference<decltype(array)>::type sorted;
+			sorted.reserve(count);
+			for (uint32_t ix = 0; ix < count; ++ix)
+				sorted.push_back(array[m_order[ix]]);
+			array.swap(sorted);
+		};
+		permute(m_position);
+		permute(m_rotation);
+		permute(m_scale);
+		permute(m_global);
+		permute(m_parent);
+		permute(m_childCount);
+		permute(m_dirty);
+		permute(m_handle);
+
+		for (uint32_t ix = 0; ix < count; ++ix)
+		{
+			if (m_parent[ix] != InvalidHandle)
+				m_parent[ix] = newIndex[m_parent[ix]];
+			m_dense[m_handle[ix]] = ix;
+		}
+
+		m_orderDirty = false;
+	}
+
+	void TransformHierarchy::MoveNode(uint32_t from, uint32_t to)
+	{
+		//Anything parented to the node we're moving needs to point at its new home.
+		if (m_childCount[from] > 0)
+		{
+			for (size_t ix = 0; ix < m_parent.size(); ++ix)
+			{
+				if (m_parent[ix] == from)
+					m_parent[ix] = to;
+			}
+		}
+
+		m_position[to] = m_position[from];
+		m_rotation[to] = m_rotation[from];
+		m_scale[to] = m_scale[from];
+		m_global[to] = m_global[from];
+		m_parent[to] = m_parent[from];
+		m_childCount[to] = m_childCount[from];
+		m_dirty[to] = m_dirty[from];
+		m_handle[to] = m_handle[from];
+		m_dense[m_handle[to]] = to;
+	}
+}
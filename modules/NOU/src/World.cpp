@@ -0,0 +1,290 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+World.cpp
+Owns the ENTT registry and transforms for one scene, plus the systems
+that update and draw it.
+*/
+
+#include "NOU/World.h"
+#include "NOU/Entity.h"
+#include "NOU/CCamera.h"
+#include "NOU/CMeshRenderer.h"
+#include "NOU/Frustum.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace nou
+{
+	bool SystemAccess::ConflictsWith(const SystemAccess& other) const
+	{
+		//If we don't know what a system does, we have to assume the worst.
+		if (!m_declared || !other.m_declared)
+			return true;
+
+		auto overlaps = [](const std::vector<entt::id_type>& a, const std::vector<entt::id_type>& b)
+		{
+			for (auto id : a)
+			{
+				if (std::find(b.begin(), b.end(), id) != b.end())
+					return true;
+			}
+			return false;
+		};
+
+		return overlaps(m_writes, other.m_writes) ||
+			   overlaps(m_writes, other.m_reads) ||
+			   overlaps(m_reads, other.m_writes);
+	}
+
+	World& World::Default()
+	{
+		static World world(TransformHierarchy::Default());
+		return world;
+	}
+
+	World::World()
+	{
+		m_ownTransforms = std::make_unique<TransformHierarchy>();
+		m_transforms = m_ownTransforms.get();
+		m_camera = nullptr;
+		m_jobs = &JobSystem::Default();
+		m_graphDirty = true;
+		m_deltaTime = 0.0f;
+		m_systemsLeft = 0;
+		m_aborted = false;
+		m_error = nullptr;
+		m_renderStats = { 0, 0 };
+	}
+
+	World::World(TransformHierarchy& transforms)
+	{
+		m_transforms = &transforms;
+		m_camera = nullptr;
+		m_jobs = &JobSystem::Default();
+		m_graphDirty = true;
+		m_deltaTime = 0.0f;
+		m_systemsLeft = 0;
+		m_aborted = false;
+		m_error = nullptr;
+		m_renderStats = { 0, 0 };
+	}
+
+	void World::AddSystem(const std::string& name, const System& system, const SystemAccess& access)
+	{
+		m_systems.push_back({ name, system, access, {}, 0 });
+		m_graphDirty = true;
+	}
+
+	bool World::RemoveSystem(const std::string& name)
+	{
+		auto it = std::find_if(m_systems.begin(), m_systems.end(),
+			[&name](const NamedSystem& s) { return s.name == name; });
+
+		if (it == m_systems.end())
+			return false;
+
+		m_systems.erase(it);
+		m_graphDirty = true;
+		return true;
+	}
+
+	void World::AddDefaultSystems()
+	{
+		AddSystem("Transforms", &World::UpdateTransforms, SystemAccess().Write<Transform>());
+		AddSystem("Cameras", &World::UpdateCameras, SystemAccess().Write<Transform, CCamera>());
+		AddSystem("Render", &World::Render, SystemAccess().Read<Transform, CCamera, CMeshRenderer>().MainThread());
+	}
+
+	void World::Update(float deltaTime)
+	{
+		//Without any workers, just run everything in order. A system that
+		//throws ends the frame, the same as it does with workers.
+		if (m_jobs == nullptr || m_jobs->GetThreadCount() == 0)
+		{
+			for (auto& s : m_systems)
+				s.system(*this, deltaTime);
+			return;
+		}
+
+		if (m_systems.empty())
+			return;
+		if (m_graphDirty)
+			BuildGraph();
+
+		for (auto& s : m_systems)
+		{
+			for (auto prepare : s.access.m_prepare)
+				prepare(m_registry);
+		}
+
+		m_deltaTime = deltaTime;
+		m_aborted = false;
+		m_systemsLeft = m_systems.size();
+		for (size_t ix = 0; ix < m_systems.size(); ++ix)
+			m_waitingOn[ix] = m_systems[ix].dependencyCount;
+
+		//Kick off everything that doesn't have to wait. Each system queues
+		//up its dependents as it finishes.
+		for (size_t ix = 0; ix < m_systems.size(); ++ix)
+		{
+			if (m_systems[ix].dependencyCount == 0)
+				Schedule(ix);
+		}
+
+		//We're the main thread, so we run the main thread systems, and
+		//help out with everything else while we wait.
+		while (m_systemsLeft.load(std::memory_order_acquire) > 0)
+		{
+			if (RunMainThreadSystem())
+				continue;
+			if (!m_jobs->RunPending())
+				std::this_thread::yield();
+		}
+
+		m_jobs->Wait(m_counter);
+
+		//Hand the exception over, so the next Update starts clean.
+		std::exception_ptr error = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(m_errorMutex);
+			std::swap(error, m_error);
+		}
+
+		if (error != nullptr)
+			std::rethrow_exception(error);
+	}
+
+	void World::BuildGraph()
+	{
+		//A system waits for every earlier system it conflicts with, so
+		//conflicting systems still run in the order they were added.
+		for (auto& s : m_systems)
+		{
+			s.dependents.clear();
+			s.dependencyCount = 0;
+		}
+
+		for (size_t ix = 0; ix < m_systems.size(); ++ix)
+		{
+			for (size_t before = 0; before < ix; ++before)
+			{
+				if (m_systems[before].access.ConflictsWith(m_systems[ix].access))
+				{
+					m_systems[before].dependents.push_back(ix);
+					m_systems[ix].dependencyCount++;
+				}
+			}
+		}
+
+		m_waitingOn = std::make_unique<std::atomic<size_t>[]>(m_systems.size());
+		m_graphDirty = false;
+	}
+
+	void World::Schedule(size_t index)
+	{
+		if (m_systems[index].access.IsMainThread())
+		{
+			std::lock_guard<std::mutex> lock(m_mainMutex);
+			m_mainReady.push_back(index);
+		}
+		else
+			m_jobs->Run([this, index]() { RunSystem(index); }, m_counter);
+	}
+
+	void World::RunSystem(size_t index)
+	{
+		//Once something has thrown, the rest of the frame is skipped, but
+		//every system still has to count itself off and release its
+		//dependents, or Update would wait forever.
+		if (!m_aborted.load(std::memory_order_acquire))
+		{
+			try
+			{
+				m_systems[index].system(*this, m_deltaTime);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(m_errorMutex);
+				if (m_error == nullptr)
+					m_error = std::current_exception();
+				m_aborted.store(true, std::memory_order_release);
+			}
+		}
+
+		for (size_t dependent : m_systems[index].dependents)
+		{
+			if (m_waitingOn[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+				Schedule(dependent);
+		}
+
+		m_systemsLeft.fetch_sub(1, std::memory_order_release);
+	}
+
+	bool World::RunMainThreadSystem()
+	{
+		size_t index;
+		{
+			std::lock_guard<std::mutex> lock(m_mainMutex);
+			if (m_mainReady.empty())
+				return false;
+
+			//Go in the order the systems were added.
+			auto it = std::min_element(m_mainReady.begin(), m_mainReady.end());
+			index = *it;
+			m_mainReady.erase(it);
+		}
+
+		RunSystem(index);
+		return true;
+	}
+
+	void World::UpdateTransforms(World& world, float /*deltaTime*/)
+	{
+		//Every transform in the world is in one hierarchy, which updates
+		//everything that changed in a single pass.
+		world.Transforms().Update();
+	}
+
+	void World::UpdateCameras(World& world, float /*deltaTime*/)
+	{
+		world.Registry().view<CCamera>().each([](CCamera& cam)
+		{
+			cam.Update();
+		});
+	}
+
+	void World::Render(World& world, float /*deltaTime*/)
+	{
+		Entity* camera = world.GetCamera();
+		if (camera == nullptr)
+			return;
+
+		//Every renderer uses the same view-projection, so only fetch it once.
+		const glm::mat4& viewProj = camera->Get<CCamera>().GetVP();
+
+		//Work out which renderers are on screen first, all in one go, then
+		//only draw those. A single component view walks the renderers in the
+		//same order every time, so the results line up.
+		auto view = world.Registry().view<CMeshRenderer>();
+		const size_t count = view.size();
+		CMeshRenderer* renderers = view.raw();
+
+		world.m_bounds.resize(count);
+		world.m_visible.resize(count);
+		for (size_t ix = 0; ix < count; ++ix)
+			world.m_bounds[ix] = renderers[ix].GetWorldBounds();
+
+		Frustum frustum(viewProj);
+		size_t drawn = frustum.CullSpheres(world.m_bounds.data(), count, world.m_visible.data());
+
+		for (size_t ix = 0; ix < count; ++ix)
+		{
+			if (world.m_visible[ix])
+				renderers[ix].Draw(viewProj);
+		}
+
+		world.m_renderStats = { drawn, count - drawn };
+	}
+}
@@ -1,44 +1,41 @@
 #pragma once
 /*
- * This is a cube, defined in the worst possible format ever.
- * This is literally just every single position and normal in the model, written out in a float
- * array. Do not do this. This is really dumb. Just don't. Please.
+ * This is a unit cube, centered on the origin. Each face gets its own 4 vertices so that the
+ * normals stay flat, stored as position followed by normal
  */
-const float CubeData[] = {
--0.50000f, 0.50000f, 0.50000f, 0.00000f, 1.00000f, 0.00000f,
-0.50000f, 0.50000f, -0.50000f, 0.00000f, 1.00000f, 0.00000f,
--0.50000f, 0.50000f, -0.50000f, 0.00000f, 1.00000f, 0.00000f,
-0.50000f, 0.50000f, 0.50000f, 1.00000f, 0.00000f, 0.00000f,
-0.50000f, -0.50000f, -0.50000f, 1.00000f, 0.00000f, 0.00000f,
-0.50000f, 0.50000f, -0.50000f, 1.00000f, 0.00000f, 0.00000f,
-0.50000f, -0.50000f, 0.50000f, 0.00000f, -1.00000f, 0.00000f,
--0.50000f, -0.50000f, -0.50000f, 0.00000f, -1.00000f, 0.00000f,
-0.50000f, -0.50000f, -0.50000f, 0.00000f, -1.00000f, 0.00000f,
--0.50000f, -0.50000f, 0.50000f, -1.00000f, 0.00000f, 0.00000f,
--0.50000f, 0.50000f, -0.50000f, -1.00000f, 0.00000f, 0.00000f,
--0.50000f, -0.50000f, -0.50000f, -1.00000f, 0.00000f, 0.00000f,
-0.50000f, -0.50000f, -0.50000f, 0.00000f, 0.00000f, -1.00000f,
--0.50000f, 0.50000f, -0.50000f, 0.00000f, 0.00000f, -1.00000f,
-0.50000f, 0.50000f, -0.50000f, 0.00000f, 0.00000f, -1.00000f,
-0.50000f, 0.50000f, 0.50000f, 0.00000f, 0.00000f, 1.00000f,
--0.50000f, -0.50000f, 0.50000f, 0.00000f, 0.00000f, 1.00000f,
-0.50000f, -0.50000f, 0.50000f, 0.00000f, 0.00000f, 1.00000f,
--0.50000f, 0.50000f, 0.50000f, 0.00000f, 1.00000f, 0.00000f,
-0.50000f, 0.50000f, 0.50000f, 0.00000f, 1.00000f, 0.00000f,
-0.50000f, 0.50000f, -0.50000f, 0.00000f, 1.00000f, 0.00000f,
-0.50000f, 0.50000f, 0.50000f, 1.00000f, 0.00000f, 0.00000f,
-0.50000f, -0.50000f, 0.50000f, 1.00000f, 0.00000f, 0.00000f,
-0.50000f, -0.50000f, -0.50000f, 1.00000f, 0.00000f, 0.00000f,
-0.50000f, -0.50000f, 0.50000f, 0.00000f, -1.00000f, 0.00000f,
--0.50000f, -0.50000f, 0.50000f, 0.00000f, -1.00000f, 0.00000f,
--0.50000f, -0.50000f, -0.50000f, 0.00000f, -1.00000f, 0.00000f,
--0.50000f, -0.50000f, 0.50000f, -1.00000f, 0.00000f, 0.00000f,
--0.50000f, 0.50000f, 0.50000f, -1.00000f, 0.00000f, 0.00000f,
--0.50000f, 0.50000f, -0.50000f, -1.00000f, 0.00000f, 0.00000f,
-0.50000f, -0.50000f, -0.50000f, 0.00000f, 0.00000f, -1.00000f,
--0.50000f, -0.50000f, -0.50000f, 0.00000f, 0.00000f, -1.00000f,
--0.50000f, 0.50000f, -0.50000f, 0.00000f, 0.00000f, -1.00000f,
-0.50000f, 0.50000f, 0.50000f, 0.00000f, 0.00000f, 1.00000f,
--0.50000f, 0.50000f, 0.50000f, 0.00000f, 0.00000f, 1.00000f,
--0.50000f, -0.50000f, 0.50000f, 0.00000f, 0.00000f, 1.00000f,
-};
\ No newline at end of file
+const float CubeVertices[24][6] = {
+	{ -0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f },
+	{ 0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f },
+	{ 0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f },
+	{ -0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f },
+	{ 0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f },
+	{ 0.5f, 0.5f, -0.5f, 1.0f, 0.0f, 0.0f },
+	{ 0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 0.0f },
+	{ 0.5f, -0.5f, 0.5f, 1.0f, 0.0f, 0.0f },
+	{ -0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f },
+	{ 0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f },
+	{ 0.5f, -0.5f, 0.5f, 0.0f, -1.0f, 0.0f },
+	{ -0.5f, -0.5f, 0.5f, 0.0f, -1.0f, 0.0f },
+	{ -0.5f, -0.5f, 0.5f, -1.0f, 0.0f, 0.0f },
+	{ -0.5f, 0.5f, 0.5f, -1.0f, 0.0f, 0.0f },
+	{ -0.5f, 0.5f, -0.5f, -1.0f, 0.0f, 0.0f },
+	{ -0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f },
+	{ -0.5f, 0.5f, -0.5f, 0.0f, 0.0f, -1.0f },
+	{ 0.5f, 0.5f, -0.5f, 0.0f, 0.0f, -1.0f },
+	{ 0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f },
+	{ -0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f },
+	{ -0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f },
+	{ 0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f },
+	{ 0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f },
+	{ -0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f }
+};
+
+// Two triangles per face, wound counter-clockwise when viewed from outside
+const unsigned char CubeIndices[36] = {
+	0, 1, 2, 0, 2, 3,
+	4, 5, 6, 4, 6, 7,
+	8, 9, 10, 8, 10, 11,
+	12, 13, 14, 12, 14, 15,
+	16, 17, 18, 16, 18, 19,
+	20, 21, 22, 20, 22, 23
+};
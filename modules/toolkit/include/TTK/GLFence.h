@@ -0,0 +1,23 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This header is a part of the Tutorial Tool Kit (TTK) library.
+// You may not use this header in your GDW games.
+//
+// This header contains a helper for waiting on OpenGL fences, used by the
+// persistent mapped rings that stream data to the GPU every frame
+//
+//////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "glad/glad.h"
+
+namespace TTK
+{
+	/*
+	 * Waits for the GPU to pass the given fence, then deletes it and sets it to nullptr.
+	 * Does nothing if the fence is already nullptr
+	 * @param fence The fence to wait on
+	 * @returns True if the GPU was still behind and we had to block, false if otherwise
+	 */
+	bool WaitForFence(GLsync& fence);
+}
@@ -0,0 +1,209 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This header is a part of the Tutorial Tool Kit (TTK) library.
+// You may not use this header in your GDW games.
+//
+// This header contains a small cache of the OpenGL state that we change
+// most often (programs, VAOs, textures, buffers and a few fixed function
+// toggles), so that redundant state changes never make it to the driver
+//
+//////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdint>
+#include "glad/glad.h"
+
+namespace TTK
+{
+	/*
+	 * Tracks the OpenGL state that has been set through it, and skips any calls that would
+	 * not change anything. This only works if all code that touches the tracked state goes
+	 * through the cache, if some other code changes the state behind its back (for instance
+	 * a third party renderer), call Invalidate afterwards so the cache forgets what it knew
+	 *
+	 * Anything the cache hasn't seen yet is treated as unknown, so the first call for a piece
+	 * of state always makes it through to OpenGL
+	 */
+	class GLStateCache {
+	public:
+		/*
+		 * The number of texture units and indexed buffer bindings that we track, calls for
+		 * higher units are always passed through to OpenGL
+		 */
+		static const GLuint MaxTextureUnits = 32;
+		static const GLuint MaxIndexedBindings = 16;
+
+		struct Stats {
+			// The number of state changes that were passed through to OpenGL
+			uint32_t CallsIssued;
+			// The number of state changes that were skipped because they were redundant
+			uint32_t CallsSkipped;
+		};
+
+		/*
+		 * Gets the state cache for the current OpenGL context
+		 */
+		static GLStateCache& Instance();
+
+		/*
+		 * Binds a shader program, as glUseProgram
+		 * @param program The handle of the program to bind, or 0 to unbind
+		 */
+		void UseProgram(GLuint program);
+		/*
+		 * Binds a vertex array object, as glBindVertexArray
+		 * @param vao The handle of the VAO to bind, or 0 to unbind
+		 */
+		void BindVertexArray(GLuint vao);
+		/*
+		 * Binds a texture to a texture unit, as glBindTextureUnit. Note that unlike glBindTexture,
+		 * this does not depend on (or change) the active texture unit
+		 * @param unit The index of the texture unit to bind to (not GL_TEXTURE0 + unit)
+		 * @param texture The handle of the texture to bind, or 0 to unbind all targets on the unit
+		 */
+		void BindTexture(GLuint unit, GLuint texture);
+		/*
+		 * Selects the active texture unit, as glActiveTexture. This only matters for code that
+		 * still uses glBindTexture and glTex* functions, BindTexture does not need it
+		 * @param unit The index of the texture unit to make active (not GL_TEXTURE0 + unit)
+		 */
+		void ActiveTexture(GLuint unit);
+		/*
+		 * Binds a buffer to a non-indexed target, as glBindBuffer. Note that the element array
+		 * binding belongs to the VAO, so it is forgotten whenever the VAO changes
+		 * @param target The target to bind to (ex: GL_ARRAY_BUFFER)
+		 * @param buffer The handle of the buffer to bind, or 0 to unbind
+		 */
+		void BindBuffer(GLenum target, GLuint buffer);
+		/*
+		 * Binds a whole buffer to an indexed target, as glBindBufferBase
+		 * @param target The indexed target to bind to (GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER)
+		 * @param index The binding index to bind to
+		 * @param buffer The handle of the buffer to bind, or 0 to unbind
+		 */
+		void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+		/*
+		 * Binds a range of a buffer to an indexed target, as glBindBufferRange
+		 * @param target The indexed target to bind to (GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER)
+		 * @param index The binding index to bind to
+		 * @param buffer The handle of the buffer to bind
+		 * @param offset The offset into the buffer, in bytes
+		 * @param size The size of the range to bind, in bytes
+		 */
+		void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+		/*
+		 * Enables or disables a capability, as glEnable or glDisable. Only the capabilities we
+		 * change at runtime are tracked (depth test, culling, blending, scissor, stencil and
+		 * program point size), anything else is passed straight through
+		 * @param cap The capability to change (ex: GL_DEPTH_TEST)
+		 * @param enabled True to enable the capability, false to disable it
+		 */
+		void SetEnabled(GLenum cap, bool enabled);
+		/*
+		 * Checks whether a capability is enabled, only asking OpenGL if we do not already know
+		 * @param cap The capability to check (ex: GL_BLEND)
+		 */
+		bool IsEnabled(GLenum cap);
+		/*
+		 * Sets whether depth writes are enabled, as glDepthMask
+		 */
+		void SetDepthMask(bool enabled);
+		/*
+		 * Gets whether depth writes are enabled, only asking OpenGL if we do not already know
+		 */
+		bool GetDepthMask();
+		/*
+		 * Sets the depth comparison function, as glDepthFunc
+		 */
+		void SetDepthFunc(GLenum func);
+		/*
+		 * Sets which faces get culled when culling is enabled, as glCullFace
+		 */
+		void SetCullFace(GLenum face);
+		/*
+		 * Sets the blending factors for color and alpha, as glBlendFuncSeparate
+		 */
+		void SetBlendFunc(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha);
+		/*
+		 * Sets the blending factors, as glBlendFunc
+		 */
+		void SetBlendFunc(GLenum src, GLenum dst) { SetBlendFunc(src, dst, src, dst); }
+
+		/*
+		 * These should be called right before an object is deleted, since OpenGL is free to hand
+		 * out the same handle to a new object, which we would otherwise think is already bound
+		 */
+		void OnProgramDeleted(GLuint program);
+		void OnVertexArrayDeleted(GLuint vao);
+		void OnTextureDeleted(GLuint texture);
+		void OnBufferDeleted(GLuint buffer);
+
+		/*
+		 * Forgets everything the cache knows, so that the next call for every piece of state will
+		 * be passed through to OpenGL. Call this after any code that changes state without going
+		 * through the cache
+		 */
+		void Invalidate();
+
+		/*
+		 * Should be called once at the end of every frame, stores the counters for the frame that
+		 * just finished so they can be read with GetFrameStats, and resets them for the next frame
+		 */
+		void EndFrame();
+		/*
+		 * Gets the counters for the last finished frame
+		 */
+		const Stats& GetFrameStats() const { return m_LastFrameStats; }
+
+	private:
+		GLStateCache();
+		~GLStateCache() = default;
+
+		GLStateCache(const GLStateCache& other) = delete;
+		GLStateCache(GLStateCache&& other) = delete;
+		GLStateCache& operator=(const GLStateCache& other) = delete;
+		GLStateCache& operator=(GLStateCache&& other) = delete;
+
+		// Used for object bindings that we do not know the value of
+		static const GLuint Unknown = ~0u;
+		// Used for tri-state flags, where we may not know the value
+		static const int8_t UnknownFlag = -1;
+
+		// The non-indexed buffer targets we track, see __GetBufferSlot
+		static const int BufferTargetCount = 9;
+		// The capabilities we track, see __GetCapSlot
+		static const int CapCount = 6;
+		// The indexed buffer targets we track
+		static const int IndexedTargetCount = 2;
+
+		struct IndexedBinding {
+			GLuint     Buffer;
+			GLintptr   Offset;
+			GLsizeiptr Size;
+		};
+
+		GLuint m_Program;
+		GLuint m_VAO;
+		GLuint m_ActiveTexture;
+		GLuint m_Textures[MaxTextureUnits];
+		GLuint m_Buffers[BufferTargetCount];
+		IndexedBinding m_IndexedBuffers[IndexedTargetCount][MaxIndexedBindings];
+
+		int8_t m_Caps[CapCount];
+		int8_t m_DepthMask;
+		GLenum m_DepthFunc;
+		GLenum m_CullFace;
+		GLenum m_BlendFunc[4];
+
+		Stats m_FrameStats;
+		Stats m_LastFrameStats;
+
+		inline void __Skip() { m_FrameStats.CallsSkipped++; }
+		inline void __Issue() { m_FrameStats.CallsIssued++; }
+
+		static int __GetBufferSlot(GLenum target);
+		static int __GetIndexedSlot(GLenum target);
+		static int __GetCapSlot(GLenum cap);
+	};
+}
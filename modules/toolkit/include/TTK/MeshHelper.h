@@ -17,25 +17,52 @@
 
 namespace TTK {
 	namespace Impl {
+		/*
+		 * Draws the teapot, sphere and cube. Calls to the Render functions are queued up, and
+		 * drawn with one instanced draw call per mesh when the context is flushed
+		 */
 		class MeshHelper {			
 		public:
 			~MeshHelper();
 			MeshHelper();
-			void RenderTeapot(const glm::mat4& transform, const glm::vec4& color) const;
-			void RenderSphere(const glm::mat4& transform, const glm::vec4& color) const;
-			void RenderCube(const glm::mat4& transform, const glm::vec4& color) const;
+			void RenderTeapot(const glm::mat4& transform, const glm::vec4& color);
+			void RenderSphere(const glm::mat4& transform, const glm::vec4& color);
+			void RenderCube(const glm::mat4& transform, const glm::vec4& color);
+
+			/*
+			 * Draws all the meshes queued since the last flush
+			 */
+			void Flush();
 			
 		private:
+			struct InstanceData {
+				glm::mat4 Transform;    // The full model view projection matrix
+				glm::vec4 Color;
+				glm::mat3 NormalMatrix; // Takes the mesh's normals into world space, for lighting
+			};
+			struct MeshVert {
+				glm::vec3 Position;
+				glm::vec3 Normal;
+			};
 			struct mesh {
 				GLuint VAO;
 				GLuint VBO;
+				GLuint EBO;
+				GLsizei IndexCount;
+				std::vector<InstanceData> Instances;
 			};
-			mesh __MakeMesh(const float* data, size_t size) const;
+			mesh __MakeMesh(const char* name, const std::vector<MeshVert>& vertices, const std::vector<uint16_t>& indices) const;
+			static void __BuildTeapot(std::vector<MeshVert>& vertices, std::vector<uint16_t>& indices);
+			static void __BuildSphere(std::vector<MeshVert>& vertices, std::vector<uint16_t>& indices);
+			static void __BuildCube(std::vector<MeshVert>& vertices, std::vector<uint16_t>& indices);
+			void __AddInstance(mesh& mesh, const glm::mat4& transform, const glm::vec4& color);
 			
 			mesh m_Teapot;
 			mesh m_Sphere;
 			mesh m_Cube;
 			GLuint m_Shader;
+			GLuint m_InstanceBuffer;
+			std::vector<InstanceData> m_InstanceData;
 		};
 	}
 }
\ No newline at end of file
@@ -0,0 +1,187 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This header is a part of the Tutorial Tool Kit (TTK) library.
+// You may not use this header in your GDW games.
+//
+// This header contains a frame profiler, which times nested scopes on
+// both the CPU and the GPU, shows them in an ImGui window, and can save
+// them as a Chrome trace (open chrome://tracing and load the file)
+//
+// Most code should use the PROFILE_* macros at the bottom of this file,
+// rather than using this class directly
+//
+//////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <thread>
+
+namespace TTK
+{
+	/*
+	 * Records a tree of timed scopes for every frame. CPU times are read from the high resolution
+	 * clock, GPU times come from glQueryCounter(GL_TIMESTAMP) queries that are issued around the
+	 * scope's OpenGL calls
+	 *
+	 * GPU results are double buffered, a frame's queries are only read back when its buffer comes
+	 * around again two frames later, by which point the GPU has almost always finished with them.
+	 * This keeps the profiler from stalling the pipeline, at the cost of results lagging behind
+	 * by a couple of frames
+	 *
+	 * Only scopes on the thread that called BeginFrame are recorded, scopes on any other thread
+	 * are ignored. Scope names are not copied, so they must be string literals (or otherwise live
+	 * for as long as the profiler)
+	 */
+	class Profiler {
+	public:
+		// The number of frames of queries in flight, see the class description
+		static const uint32_t FrameBuffers = 2;
+		// The number of resolved frames we keep around for the graph and for Chrome traces
+		static const uint32_t HistorySize = 240;
+
+		struct Sample {
+			const char* Name;
+			// How many scopes this one is nested in, the frame itself is at depth 0
+			uint32_t    Depth;
+			// When the scope started and how long it took, in milliseconds since the profiler was created
+			double      CpuStartMs;
+			double      CpuMs;
+			// The GPU times are moved onto the CPU timeline, lining up the start of the frame on both
+			double      GpuStartMs;
+			double      GpuMs;
+			bool        HasGpu;
+		};
+
+		struct Frame {
+			uint64_t            Index;
+			// Every scope in the frame, in the order they started (so each scope's children follow it)
+			std::vector<Sample> Samples;
+		};
+
+		struct Stats {
+			// The number of times we had to wait on the GPU for query results
+			uint32_t Stalls;
+			// The number of scopes that were dropped because they were opened outside of a frame
+			uint32_t Dropped;
+		};
+
+		/*
+		 * Gets the profiler, which must only be used while an OpenGL context is current
+		 */
+		static Profiler& Instance();
+
+		/*
+		 * Turns the profiler on or off, while it is off every call is ignored. Turning it off part way through
+		 * a frame ends the frame early
+		 */
+		void SetEnabled(bool enabled);
+		bool IsEnabled() const { return m_IsEnabled; }
+
+		/*
+		 * Starts a new frame, which is timed as a scope of its own. This also reads back the results of
+		 * the frame that last used this frame's query buffer
+		 */
+		void BeginFrame();
+		/*
+		 * Ends the current frame, this should be called after everything has been drawn but before the
+		 * buffers are swapped
+		 */
+		void EndFrame();
+
+		/*
+		 * Starts timing a scope, which will be nested inside of any scope that is already open
+		 * @param name The name to show for the scope, this must outlive the profiler
+		 * @param gpu True to time the OpenGL calls made in the scope as well as the CPU time
+		 */
+		void BeginScope(const char* name, bool gpu);
+		/*
+		 * Stops timing the most recently started scope
+		 */
+		void EndScope();
+
+		/*
+		 * Gets the most recent frame that has all of its results, or nullptr if no frames are ready yet
+		 */
+		const Frame* GetLastFrame() const { return m_History.empty() ? nullptr : &m_History.back(); }
+		/*
+		 * Gets the frames that we've kept results for, oldest first
+		 */
+		const std::deque<Frame>& GetHistory() const { return m_History; }
+		const Stats& GetStats() const { return m_Stats; }
+
+		/*
+		 * Draws the profiler window, showing a graph of recent frame times and a tree of the scopes in
+		 * the last frame. This must be called between TTK::Graphics::BeginGUI and EndGUI
+		 */
+		void DrawImGui();
+		/*
+		 * Saves every frame in the history as a Chrome trace, CPU scopes go on one track and GPU scopes
+		 * on another. Open chrome://tracing (or https://ui.perfetto.dev) and load the file to view it
+		 * @param path The file to write the trace to
+		 * @returns True if the file could be written
+		 */
+		bool SaveChromeTrace(const std::string& path) const;
+
+	private:
+		Profiler();
+		~Profiler();
+
+		Profiler(const Profiler& other) = delete;
+		Profiler(Profiler&& other) = delete;
+		Profiler& operator=(const Profiler& other) = delete;
+		Profiler& operator=(Profiler&& other) = delete;
+
+		typedef std::chrono::high_resolution_clock Clock;
+
+		struct FrameBuffer {
+			Frame                 Data;
+			// The start and end query for each sample, or -1 if it has no GPU timing
+			std::vector<int32_t>  SampleQueries;
+			std::vector<uint32_t> Queries;
+			size_t                QueriesUsed;
+			bool                  IsPending;
+		};
+
+		bool                  m_IsEnabled;
+		bool                  m_InFrame;
+		uint64_t              m_FrameIndex;
+		Clock::time_point     m_Epoch;
+		std::thread::id       m_Thread;
+		FrameBuffer           m_Buffers[FrameBuffers];
+		std::vector<uint32_t> m_Stack;
+		std::deque<Frame>     m_History;
+		Stats                 m_Stats;
+
+		double __Now() const;
+		void __Resolve(FrameBuffer& buffer);
+		size_t __DrawSample(const Frame& frame, size_t index);
+	};
+
+	/*
+	 * Times everything from its creation to the end of the enclosing scope, see the PROFILE_* macros below
+	 */
+	class ProfileScope {
+	public:
+		ProfileScope(const char* name, bool gpu) { Profiler::Instance().BeginScope(name, gpu); }
+		~ProfileScope() { Profiler::Instance().EndScope(); }
+
+		ProfileScope(const ProfileScope& other) = delete;
+		ProfileScope(ProfileScope&& other) = delete;
+		ProfileScope& operator=(const ProfileScope& other) = delete;
+		ProfileScope& operator=(ProfileScope&& other) = delete;
+	};
+}
+
+// Profiling macros, these time everything from the macro to the end of the enclosing scope
+#define __PROFILE_CONCAT_INNER(a, b) a##b
+#define __PROFILE_CONCAT(a, b) __PROFILE_CONCAT_INNER(a, b)
+// Times a scope on the CPU only
+#define PROFILE_SCOPE(name)     ::TTK::ProfileScope __PROFILE_CONCAT(__profileScope, __LINE__)(name, false)
+// Times a scope on the CPU, as well as the OpenGL work issued inside of it on the GPU
+#define PROFILE_GPU_SCOPE(name) ::TTK::ProfileScope __PROFILE_CONCAT(__profileScope, __LINE__)(name, true)
+// Times the rest of the current function on the CPU only
+#define PROFILE_FUNCTION()      PROFILE_SCOPE(__FUNCTION__)
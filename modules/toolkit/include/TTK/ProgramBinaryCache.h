@@ -0,0 +1,118 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This header is a part of the Tutorial Tool Kit (TTK) library.
+// You may not use this header in your GDW games.
+//
+// This header contains a cache of linked shader program binaries on
+// disk, so that programs only need to be compiled from source the first
+// time they are seen by a given driver
+//
+//////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "glad/glad.h"
+
+namespace TTK
+{
+	/*
+	 * Stores linked programs on disk using glGetProgramBinary, and loads them back with
+	 * glProgramBinary on the next run. Programs are keyed by a hash of their sources along
+	 * with the vendor, renderer and version strings of the driver, so a driver update or
+	 * a change to any of the sources will miss the cache rather than load a stale binary
+	 *
+	 * Drivers are allowed to reject a binary at any time (even one they produced), so
+	 * callers always need to be ready to compile from source when TryLoad fails
+	 */
+	class ProgramBinaryCache {
+	public:
+		struct Stats {
+			// The number of programs loaded from a binary
+			uint32_t Hits;
+			// The number of programs that had no binary and were compiled from source
+			uint32_t Misses;
+			// The number of binaries that were found, but rejected by the driver
+			uint32_t Rejected;
+			// The number of binaries written to disk
+			uint32_t Stored;
+		};
+
+		/*
+		 * Gets the program cache, which must only be used while an OpenGL context is current
+		 */
+		static ProgramBinaryCache& Instance();
+
+		/*
+		 * Sets the directory that binaries are stored in, relative to the working directory.
+		 * This defaults to "shader_cache", and is created the first time a binary is stored
+		 */
+		void SetDirectory(const std::string& path) { m_Directory = path; }
+		/*
+		 * Gets whether the driver supports any program binary formats, if not TryLoad will
+		 * always fail and Store will do nothing
+		 */
+		bool IsSupported();
+
+		/*
+		 * Makes a key for a program from all of its sources (in order). The key also covers the
+		 * current driver, so a binary from a different GPU or driver version is never loaded
+		 * @param sources The source for each stage of the program
+		 * @param count The number of sources
+		 */
+		uint64_t MakeKey(const char* const* sources, size_t count);
+		/*
+		 * Tries to load the binary for the given key into a program, leaving the program
+		 * linked and ready to use. Binaries that the driver rejects are deleted from disk
+		 * @param program The program to load into, this should have nothing attached
+		 * @param key The key for the program, from MakeKey
+		 * @returns True if the program was loaded, false if it needs to be compiled
+		 */
+		bool TryLoad(GLuint program, uint64_t key);
+		/*
+		 * Writes the binary for a linked program to disk. The program should have had
+		 * GL_PROGRAM_BINARY_RETRIEVABLE_HINT set before it was linked (see PrepareForLink)
+		 * @param program The linked program to store
+		 * @param key The key for the program, from MakeKey
+		 */
+		void Store(GLuint program, uint64_t key);
+		/*
+		 * Asks the driver to keep a program's binary around, this must be called before
+		 * linking any program that will be passed to Store
+		 */
+		static void PrepareForLink(GLuint program);
+
+		/*
+		 * Creates a program from a vertex and fragment shader, loading it from the cache if we
+		 * can and compiling it (then storing it) if we can't
+		 * @param vsSource The source for the vertex shader
+		 * @param fsSource The source for the fragment shader
+		 * @returns The handle of the linked program, or 0 if it failed to compile or link
+		 */
+		GLuint CreateProgram(const char* vsSource, const char* fsSource);
+
+		/*
+		 * Gets the hit and miss counters since the program started
+		 */
+		const Stats& GetStats() const { return m_Stats; }
+
+	private:
+		ProgramBinaryCache();
+		~ProgramBinaryCache() = default;
+
+		ProgramBinaryCache(const ProgramBinaryCache& other) = delete;
+		ProgramBinaryCache(ProgramBinaryCache&& other) = delete;
+		ProgramBinaryCache& operator=(const ProgramBinaryCache& other) = delete;
+		ProgramBinaryCache& operator=(ProgramBinaryCache&& other) = delete;
+
+		std::string m_Directory;
+		// A hash of the driver strings, which seeds every key. Zero until we first need it
+		uint64_t    m_DriverHash;
+		// Whether the driver has any binary formats, -1 until we first need to know
+		int8_t      m_IsSupported;
+		Stats       m_Stats;
+
+		std::string __GetPath(uint64_t key) const;
+		static GLuint __CompilePart(const char* source, GLenum type);
+	};
+}
@@ -1,969 +1,31 @@
 #pragma once
 /*
- * This is a sphere, defined in the worst possible format ever.
- * This is literally just every single position and normal in the model, written out in a float
- * array. Do not do this. This is really dumb. Just don't. Please.
+ * This is a unit sphere, stored as the icosahedron that it is built from. MeshHelper splits each
+ * triangle into 4 SphereSubdivisions times, pushing the new vertices out onto the sphere, which
+ * gives us 162 vertices and 320 triangles
  */
-float SphereData[] = {
-0.00000f, 0.00000f, -1.00000f, -0.00900f, -0.00292f, -0.05999f,
--0.14762f, -0.20318f, -0.96795f, -0.00900f, -0.00292f, -0.05999f,
--0.23885f, 0.07761f, -0.96795f, -0.00900f, -0.00292f, -0.05999f,
--0.52573f, -0.72361f, -0.44722f, -0.02502f, -0.04391f, -0.03367f,
--0.44286f, -0.60955f, -0.65752f, -0.02502f, -0.04391f, -0.03367f,
--0.29524f, -0.81273f, -0.50230f, -0.02502f, -0.04391f, -0.03367f,
-0.00000f, 0.00000f, -1.00000f, -0.00556f, 0.00766f, -0.05999f,
--0.23885f, 0.07761f, -0.96795f, -0.00556f, 0.00766f, -0.05999f,
-0.00000f, 0.25115f, -0.96795f, -0.00556f, 0.00766f, -0.05999f,
-0.00000f, 0.00000f, -1.00000f, 0.00556f, 0.00766f, -0.05999f,
-0.00000f, 0.25115f, -0.96795f, 0.00556f, 0.00766f, -0.05999f,
-0.23885f, 0.07761f, -0.96795f, 0.00556f, 0.00766f, -0.05999f,
-0.00000f, 0.00000f, -1.00000f, 0.00900f, -0.00292f, -0.05999f,
-0.23885f, 0.07761f, -0.96795f, 0.00900f, -0.00292f, -0.05999f,
-0.14762f, -0.20318f, -0.96795f, 0.00900f, -0.00292f, -0.05999f,
--0.52573f, -0.72361f, -0.44722f, -0.02503f, -0.04976f, -0.02421f,
--0.29524f, -0.81273f, -0.50230f, -0.02503f, -0.04976f, -0.02421f,
--0.44286f, -0.86070f, -0.25115f, -0.02503f, -0.04976f, -0.02421f,
--0.85065f, 0.27639f, -0.44722f, -0.05505f, 0.00842f, -0.02421f,
--0.86418f, 0.02964f, -0.50230f, -0.05505f, 0.00842f, -0.02421f,
--0.95542f, 0.15521f, -0.25115f, -0.05505f, 0.00842f, -0.02421f,
-0.00000f, 0.89443f, -0.44722f, -0.00900f, 0.05496f, -0.02421f,
--0.23885f, 0.83105f, -0.50230f, -0.00900f, 0.05496f, -0.02421f,
--0.14762f, 0.95663f, -0.25115f, -0.00900f, 0.05496f, -0.02421f,
-0.85065f, 0.27639f, -0.44722f, 0.04949f, 0.02554f, -0.02421f,
-0.71657f, 0.48397f, -0.50230f, 0.04949f, 0.02554f, -0.02421f,
-0.86419f, 0.43601f, -0.25115f, 0.04949f, 0.02554f, -0.02421f,
-0.52573f, -0.72361f, -0.44722f, 0.03959f, -0.03918f, -0.02421f,
-0.68171f, -0.53194f, -0.50230f, 0.03959f, -0.03918f, -0.02421f,
-0.68172f, -0.68716f, -0.25115f, 0.03959f, -0.03918f, -0.02421f,
--0.52573f, -0.72361f, -0.44722f, -0.03403f, -0.04683f, -0.01836f,
--0.44286f, -0.86070f, -0.25115f, -0.03403f, -0.04683f, -0.01836f,
--0.68172f, -0.68716f, -0.25115f, -0.03403f, -0.04683f, -0.01836f,
--0.85065f, 0.27639f, -0.44722f, -0.05505f, 0.01789f, -0.01836f,
--0.95542f, 0.15521f, -0.25115f, -0.05505f, 0.01789f, -0.01836f,
--0.86419f, 0.43601f, -0.25115f, -0.05505f, 0.01789f, -0.01836f,
-0.00000f, 0.89443f, -0.44722f, 0.00000f, 0.05789f, -0.01836f,
--0.14762f, 0.95663f, -0.25115f, 0.00000f, 0.05789f, -0.01836f,
-0.14762f, 0.95663f, -0.25115f, 0.00000f, 0.05789f, -0.01836f,
-0.85065f, 0.27639f, -0.44722f, 0.05505f, 0.01789f, -0.01836f,
-0.86419f, 0.43601f, -0.25115f, 0.05505f, 0.01789f, -0.01836f,
-0.95542f, 0.15521f, -0.25115f, 0.05505f, 0.01789f, -0.01836f,
-0.52573f, -0.72361f, -0.44722f, 0.03403f, -0.04683f, -0.01836f,
-0.68172f, -0.68716f, -0.25115f, 0.03403f, -0.04683f, -0.01836f,
-0.44286f, -0.86070f, -0.25115f, 0.03403f, -0.04683f, -0.01836f,
--0.85065f, -0.27639f, 0.44722f, -0.04605f, -0.02081f, 0.03368f,
--0.71657f, -0.48397f, 0.50230f, -0.04605f, -0.02081f, 0.03368f,
--0.71656f, -0.23282f, 0.65752f, -0.04605f, -0.02081f, 0.03368f,
--0.52573f, 0.72361f, 0.44722f, -0.03402f, 0.03737f, 0.03368f,
--0.68171f, 0.53194f, 0.50230f, -0.03402f, 0.03737f, 0.03368f,
--0.44286f, 0.60955f, 0.65752f, -0.03402f, 0.03737f, 0.03368f,
-0.52573f, 0.72361f, 0.44722f, 0.02502f, 0.04391f, 0.03367f,
-0.29524f, 0.81273f, 0.50230f, 0.02502f, 0.04391f, 0.03367f,
-0.44286f, 0.60955f, 0.65752f, 0.02502f, 0.04391f, 0.03367f,
-0.85065f, -0.27639f, 0.44722f, 0.04949f, -0.01023f, 0.03368f,
-0.86418f, -0.02964f, 0.50230f, 0.04949f, -0.01023f, 0.03368f,
-0.71656f, -0.23282f, 0.65752f, 0.04949f, -0.01023f, 0.03368f,
-0.00000f, -0.89443f, 0.44722f, 0.00556f, -0.05023f, 0.03367f,
-0.23885f, -0.83105f, 0.50230f, 0.00556f, -0.05023f, 0.03367f,
-0.00000f, -0.75344f, 0.65751f, 0.00556f, -0.05023f, 0.03367f,
-0.00000f, -0.25115f, 0.96795f, 0.00556f, -0.00766f, 0.05999f,
-0.23885f, -0.07761f, 0.96795f, 0.00556f, -0.00766f, 0.05999f,
-0.00000f, 0.00000f, 1.00000f, 0.00556f, -0.00766f, 0.05999f,
-0.00000f, -0.52573f, 0.85065f, 0.00721f, -0.03083f, 0.07218f,
-0.26286f, -0.36180f, 0.89443f, 0.00721f, -0.03083f, 0.07218f,
-0.00000f, -0.25115f, 0.96795f, 0.00721f, -0.03083f, 0.07218f,
-0.00000f, -0.75344f, 0.65751f, 0.00721f, -0.05077f, 0.05986f,
-0.26286f, -0.63819f, 0.72361f, 0.00721f, -0.05077f, 0.05986f,
-0.00000f, -0.52573f, 0.85065f, 0.00721f, -0.05077f, 0.05986f,
-0.00000f, -0.25115f, 0.96795f, 0.01276f, -0.01756f, 0.07205f,
-0.26286f, -0.36180f, 0.89443f, 0.01276f, -0.01756f, 0.07205f,
-0.23885f, -0.07761f, 0.96795f, 0.01276f, -0.01756f, 0.07205f,
-0.26286f, -0.36180f, 0.89443f, 0.02710f, -0.01638f, 0.07218f,
-0.49999f, -0.16246f, 0.85065f, 0.02710f, -0.01638f, 0.07218f,
-0.23885f, -0.07761f, 0.96795f, 0.02710f, -0.01638f, 0.07218f,
-0.00000f, -0.52573f, 0.85065f, 0.01590f, -0.04490f, 0.07265f,
-0.26286f, -0.63819f, 0.72361f, 0.01590f, -0.04490f, 0.07265f,
-0.26286f, -0.36180f, 0.89443f, 0.01590f, -0.04490f, 0.07265f,
-0.26286f, -0.63819f, 0.72361f, 0.03262f, -0.04490f, 0.07265f,
-0.52573f, -0.44721f, 0.72361f, 0.03262f, -0.04490f, 0.07265f,
-0.26286f, -0.36180f, 0.89443f, 0.03262f, -0.04490f, 0.07265f,
-0.26286f, -0.36180f, 0.89443f, 0.03779f, -0.02900f, 0.07265f,
-0.52573f, -0.44721f, 0.72361f, 0.03779f, -0.02900f, 0.07265f,
-0.49999f, -0.16246f, 0.85065f, 0.03779f, -0.02900f, 0.07265f,
-0.52573f, -0.44721f, 0.72361f, 0.04606f, -0.02254f, 0.05986f,
-0.71656f, -0.23282f, 0.65752f, 0.04606f, -0.02254f, 0.05986f,
-0.49999f, -0.16246f, 0.85065f, 0.04606f, -0.02254f, 0.05986f,
-0.00000f, -0.75344f, 0.65751f, 0.01276f, -0.05659f, 0.04793f,
-0.23885f, -0.83105f, 0.50230f, 0.01276f, -0.05659f, 0.04793f,
-0.26286f, -0.63819f, 0.72361f, 0.01276f, -0.05659f, 0.04793f,
-0.23885f, -0.83105f, 0.50230f, 0.02710f, -0.05723f, 0.04693f,
-0.50000f, -0.68819f, 0.52574f, 0.02710f, -0.05723f, 0.04693f,
-0.26286f, -0.63819f, 0.72361f, 0.02710f, -0.05723f, 0.04693f,
-0.26286f, -0.63819f, 0.72361f, 0.03779f, -0.05201f, 0.05843f,
-0.50000f, -0.68819f, 0.52574f, 0.03779f, -0.05201f, 0.05843f,
-0.52573f, -0.44721f, 0.72361f, 0.03779f, -0.05201f, 0.05843f,
-0.50000f, -0.68819f, 0.52574f, 0.04606f, -0.04346f, 0.04693f,
-0.71657f, -0.48397f, 0.50230f, 0.04606f, -0.04346f, 0.04693f,
-0.52573f, -0.44721f, 0.72361f, 0.04606f, -0.04346f, 0.04693f,
-0.52573f, -0.44721f, 0.72361f, 0.04988f, -0.02962f, 0.04793f,
-0.71657f, -0.48397f, 0.50230f, 0.04988f, -0.02962f, 0.04793f,
-0.71656f, -0.23282f, 0.65752f, 0.04988f, -0.02962f, 0.04793f,
-0.71657f, -0.48397f, 0.50230f, 0.04605f, -0.02081f, 0.03368f,
-0.85065f, -0.27639f, 0.44722f, 0.04605f, -0.02081f, 0.03368f,
-0.71656f, -0.23282f, 0.65752f, 0.04605f, -0.02081f, 0.03368f,
-0.23885f, -0.07761f, 0.96795f, 0.00900f, 0.00292f, 0.05999f,
-0.14762f, 0.20318f, 0.96795f, 0.00900f, 0.00292f, 0.05999f,
-0.00000f, 0.00000f, 1.00000f, 0.00900f, 0.00292f, 0.05999f,
-0.49999f, -0.16246f, 0.85065f, 0.03155f, -0.00267f, 0.07218f,
-0.42532f, 0.13820f, 0.89443f, 0.03155f, -0.00267f, 0.07218f,
-0.23885f, -0.07761f, 0.96795f, 0.03155f, -0.00267f, 0.07218f,
-0.71656f, -0.23282f, 0.65752f, 0.05051f, -0.00883f, 0.05986f,
-0.68818f, 0.05279f, 0.72361f, 0.05051f, -0.00883f, 0.05986f,
-0.49999f, -0.16246f, 0.85065f, 0.05051f, -0.00883f, 0.05986f,
-0.23885f, -0.07761f, 0.96795f, 0.02064f, 0.00671f, 0.07205f,
-0.42532f, 0.13820f, 0.89443f, 0.02064f, 0.00671f, 0.07205f,
-0.14762f, 0.20318f, 0.96795f, 0.02064f, 0.00671f, 0.07205f,
-0.42532f, 0.13820f, 0.89443f, 0.02395f, 0.02071f, 0.07218f,
-0.30901f, 0.42532f, 0.85065f, 0.02395f, 0.02071f, 0.07218f,
-0.14762f, 0.20318f, 0.96795f, 0.02395f, 0.02071f, 0.07218f,
-0.49999f, -0.16246f, 0.85065f, 0.04762f, 0.00125f, 0.07265f,
-0.68818f, 0.05279f, 0.72361f, 0.04762f, 0.00125f, 0.07265f,
-0.42532f, 0.13820f, 0.89443f, 0.04762f, 0.00125f, 0.07265f,
-0.68818f, 0.05279f, 0.72361f, 0.05279f, 0.01715f, 0.07265f,
-0.58778f, 0.36180f, 0.72361f, 0.05279f, 0.01715f, 0.07265f,
-0.42532f, 0.13820f, 0.89443f, 0.05279f, 0.01715f, 0.07265f,
-0.42532f, 0.13820f, 0.89443f, 0.03926f, 0.02698f, 0.07265f,
-0.58778f, 0.36180f, 0.72361f, 0.03926f, 0.02698f, 0.07265f,
-0.30901f, 0.42532f, 0.85065f, 0.03926f, 0.02698f, 0.07265f,
-0.58778f, 0.36180f, 0.72361f, 0.03567f, 0.03684f, 0.05986f,
-0.44286f, 0.60955f, 0.65752f, 0.03567f, 0.03684f, 0.05986f,
-0.30901f, 0.42532f, 0.85065f, 0.03567f, 0.03684f, 0.05986f,
-0.71656f, -0.23282f, 0.65752f, 0.05776f, -0.00535f, 0.04793f,
-0.86418f, -0.02964f, 0.50230f, 0.05776f, -0.00535f, 0.04793f,
-0.68818f, 0.05279f, 0.72361f, 0.05776f, -0.00535f, 0.04793f,
-0.86418f, -0.02964f, 0.50230f, 0.06280f, 0.00809f, 0.04693f,
-0.80901f, 0.26287f, 0.52574f, 0.06280f, 0.00809f, 0.04693f,
-0.68818f, 0.05279f, 0.72361f, 0.06280f, 0.00809f, 0.04693f,
-0.68818f, 0.05279f, 0.72361f, 0.06115f, 0.01987f, 0.05843f,
-0.80901f, 0.26287f, 0.52574f, 0.06115f, 0.01987f, 0.05843f,
-0.58778f, 0.36180f, 0.72361f, 0.06115f, 0.01987f, 0.05843f,
-0.80901f, 0.26287f, 0.52574f, 0.05556f, 0.03037f, 0.04693f,
-0.68171f, 0.53194f, 0.50230f, 0.05556f, 0.03037f, 0.04693f,
-0.58778f, 0.36180f, 0.72361f, 0.05556f, 0.03037f, 0.04693f,
-0.58778f, 0.36180f, 0.72361f, 0.04358f, 0.03828f, 0.04793f,
-0.68171f, 0.53194f, 0.50230f, 0.04358f, 0.03828f, 0.04793f,
-0.44286f, 0.60955f, 0.65752f, 0.04358f, 0.03828f, 0.04793f,
-0.68171f, 0.53194f, 0.50230f, 0.03402f, 0.03737f, 0.03368f,
-0.52573f, 0.72361f, 0.44722f, 0.03402f, 0.03737f, 0.03368f,
-0.44286f, 0.60955f, 0.65752f, 0.03402f, 0.03737f, 0.03368f,
-0.14762f, 0.20318f, 0.96795f, 0.00000f, 0.00946f, 0.05999f,
--0.14762f, 0.20318f, 0.96795f, 0.00000f, 0.00946f, 0.05999f,
-0.00000f, 0.00000f, 1.00000f, 0.00000f, 0.00946f, 0.05999f,
-0.30901f, 0.42532f, 0.85065f, 0.01229f, 0.02918f, 0.07218f,
-0.00000f, 0.44721f, 0.89443f, 0.01229f, 0.02918f, 0.07218f,
-0.14762f, 0.20318f, 0.96795f, 0.01229f, 0.02918f, 0.07218f,
-0.44286f, 0.60955f, 0.65752f, 0.02401f, 0.04531f, 0.05986f,
-0.16246f, 0.67082f, 0.72361f, 0.02401f, 0.04531f, 0.05986f,
-0.30901f, 0.42532f, 0.85065f, 0.02401f, 0.04531f, 0.05986f,
-0.14762f, 0.20318f, 0.96795f, 0.00000f, 0.02171f, 0.07205f,
-0.00000f, 0.44721f, 0.89443f, 0.00000f, 0.02171f, 0.07205f,
--0.14762f, 0.20318f, 0.96795f, 0.00000f, 0.02171f, 0.07205f,
-0.00000f, 0.44721f, 0.89443f, -0.01229f, 0.02918f, 0.07218f,
--0.30901f, 0.42532f, 0.85065f, -0.01229f, 0.02918f, 0.07218f,
--0.14762f, 0.20318f, 0.96795f, -0.01229f, 0.02918f, 0.07218f,
-0.30901f, 0.42532f, 0.85065f, 0.01353f, 0.04567f, 0.07265f,
-0.16246f, 0.67082f, 0.72361f, 0.01353f, 0.04567f, 0.07265f,
-0.00000f, 0.44721f, 0.89443f, 0.01353f, 0.04567f, 0.07265f,
-0.16246f, 0.67082f, 0.72361f, 0.00000f, 0.05550f, 0.07265f,
--0.16246f, 0.67082f, 0.72361f, 0.00000f, 0.05550f, 0.07265f,
-0.00000f, 0.44721f, 0.89443f, 0.00000f, 0.05550f, 0.07265f,
-0.00000f, 0.44721f, 0.89443f, -0.01353f, 0.04567f, 0.07265f,
--0.16246f, 0.67082f, 0.72361f, -0.01353f, 0.04567f, 0.07265f,
--0.30901f, 0.42532f, 0.85065f, -0.01353f, 0.04567f, 0.07265f,
--0.16246f, 0.67082f, 0.72361f, -0.02401f, 0.04531f, 0.05986f,
--0.44286f, 0.60955f, 0.65752f, -0.02401f, 0.04531f, 0.05986f,
--0.30901f, 0.42532f, 0.85065f, -0.02401f, 0.04531f, 0.05986f,
-0.44286f, 0.60955f, 0.65752f, 0.02294f, 0.05328f, 0.04793f,
-0.29524f, 0.81273f, 0.50230f, 0.02294f, 0.05328f, 0.04793f,
-0.16246f, 0.67082f, 0.72361f, 0.02294f, 0.05328f, 0.04793f,
-0.29524f, 0.81273f, 0.50230f, 0.01172f, 0.06223f, 0.04693f,
-0.00000f, 0.85065f, 0.52574f, 0.01172f, 0.06223f, 0.04693f,
-0.16246f, 0.67082f, 0.72361f, 0.01172f, 0.06223f, 0.04693f,
-0.16246f, 0.67082f, 0.72361f, 0.00000f, 0.06429f, 0.05843f,
-0.00000f, 0.85065f, 0.52574f, 0.00000f, 0.06429f, 0.05843f,
--0.16246f, 0.67082f, 0.72361f, 0.00000f, 0.06429f, 0.05843f,
-0.00000f, 0.85065f, 0.52574f, -0.01172f, 0.06223f, 0.04693f,
--0.29524f, 0.81273f, 0.50230f, -0.01172f, 0.06223f, 0.04693f,
--0.16246f, 0.67082f, 0.72361f, -0.01172f, 0.06223f, 0.04693f,
--0.16246f, 0.67082f, 0.72361f, -0.02294f, 0.05328f, 0.04793f,
--0.29524f, 0.81273f, 0.50230f, -0.02294f, 0.05328f, 0.04793f,
--0.44286f, 0.60955f, 0.65752f, -0.02294f, 0.05328f, 0.04793f,
--0.29524f, 0.81273f, 0.50230f, -0.02502f, 0.04391f, 0.03367f,
--0.52573f, 0.72361f, 0.44722f, -0.02502f, 0.04391f, 0.03367f,
--0.44286f, 0.60955f, 0.65752f, -0.02502f, 0.04391f, 0.03367f,
--0.14762f, 0.20318f, 0.96795f, -0.00900f, 0.00292f, 0.05999f,
--0.23885f, -0.07761f, 0.96795f, -0.00900f, 0.00292f, 0.05999f,
-0.00000f, 0.00000f, 1.00000f, -0.00900f, 0.00292f, 0.05999f,
--0.30901f, 0.42532f, 0.85065f, -0.02395f, 0.02071f, 0.07218f,
--0.42532f, 0.13820f, 0.89443f, -0.02395f, 0.02071f, 0.07218f,
--0.14762f, 0.20318f, 0.96795f, -0.02395f, 0.02071f, 0.07218f,
--0.44286f, 0.60955f, 0.65752f, -0.03567f, 0.03684f, 0.05986f,
--0.58778f, 0.36180f, 0.72361f, -0.03567f, 0.03684f, 0.05986f,
--0.30901f, 0.42532f, 0.85065f, -0.03567f, 0.03684f, 0.05986f,
--0.14762f, 0.20318f, 0.96795f, -0.02064f, 0.00671f, 0.07205f,
--0.42532f, 0.13820f, 0.89443f, -0.02064f, 0.00671f, 0.07205f,
--0.23885f, -0.07761f, 0.96795f, -0.02064f, 0.00671f, 0.07205f,
--0.42532f, 0.13820f, 0.89443f, -0.03155f, -0.00267f, 0.07218f,
--0.49999f, -0.16246f, 0.85065f, -0.03155f, -0.00267f, 0.07218f,
--0.23885f, -0.07761f, 0.96795f, -0.03155f, -0.00267f, 0.07218f,
--0.30901f, 0.42532f, 0.85065f, -0.03926f, 0.02698f, 0.07265f,
--0.58778f, 0.36180f, 0.72361f, -0.03926f, 0.02698f, 0.07265f,
--0.42532f, 0.13820f, 0.89443f, -0.03926f, 0.02698f, 0.07265f,
--0.58778f, 0.36180f, 0.72361f, -0.05279f, 0.01715f, 0.07265f,
--0.68818f, 0.05279f, 0.72361f, -0.05279f, 0.01715f, 0.07265f,
--0.42532f, 0.13820f, 0.89443f, -0.05279f, 0.01715f, 0.07265f,
--0.42532f, 0.13820f, 0.89443f, -0.04762f, 0.00125f, 0.07265f,
--0.68818f, 0.05279f, 0.72361f, -0.04762f, 0.00125f, 0.07265f,
--0.49999f, -0.16246f, 0.85065f, -0.04762f, 0.00125f, 0.07265f,
--0.68818f, 0.05279f, 0.72361f, -0.05051f, -0.00883f, 0.05986f,
--0.71656f, -0.23282f, 0.65752f, -0.05051f, -0.00883f, 0.05986f,
--0.49999f, -0.16246f, 0.85065f, -0.05051f, -0.00883f, 0.05986f,
--0.44286f, 0.60955f, 0.65752f, -0.04358f, 0.03828f, 0.04793f,
--0.68171f, 0.53194f, 0.50230f, -0.04358f, 0.03828f, 0.04793f,
--0.58778f, 0.36180f, 0.72361f, -0.04358f, 0.03828f, 0.04793f,
--0.68171f, 0.53194f, 0.50230f, -0.05556f, 0.03037f, 0.04693f,
--0.80901f, 0.26287f, 0.52574f, -0.05556f, 0.03037f, 0.04693f,
--0.58778f, 0.36180f, 0.72361f, -0.05556f, 0.03037f, 0.04693f,
--0.58778f, 0.36180f, 0.72361f, -0.06115f, 0.01987f, 0.05843f,
--0.80901f, 0.26287f, 0.52574f, -0.06115f, 0.01987f, 0.05843f,
--0.68818f, 0.05279f, 0.72361f, -0.06115f, 0.01987f, 0.05843f,
--0.80901f, 0.26287f, 0.52574f, -0.06280f, 0.00809f, 0.04693f,
--0.86418f, -0.02964f, 0.50230f, -0.06280f, 0.00809f, 0.04693f,
--0.68818f, 0.05279f, 0.72361f, -0.06280f, 0.00809f, 0.04693f,
--0.68818f, 0.05279f, 0.72361f, -0.05776f, -0.00535f, 0.04793f,
--0.86418f, -0.02964f, 0.50230f, -0.05776f, -0.00535f, 0.04793f,
--0.71656f, -0.23282f, 0.65752f, -0.05776f, -0.00535f, 0.04793f,
--0.86418f, -0.02964f, 0.50230f, -0.04949f, -0.01023f, 0.03368f,
--0.85065f, -0.27639f, 0.44722f, -0.04949f, -0.01023f, 0.03368f,
--0.71656f, -0.23282f, 0.65752f, -0.04949f, -0.01023f, 0.03368f,
--0.23885f, -0.07761f, 0.96795f, -0.00556f, -0.00766f, 0.05999f,
-0.00000f, -0.25115f, 0.96795f, -0.00556f, -0.00766f, 0.05999f,
-0.00000f, 0.00000f, 1.00000f, -0.00556f, -0.00766f, 0.05999f,
--0.49999f, -0.16246f, 0.85065f, -0.02710f, -0.01638f, 0.07218f,
--0.26286f, -0.36180f, 0.89443f, -0.02710f, -0.01638f, 0.07218f,
--0.23885f, -0.07761f, 0.96795f, -0.02710f, -0.01638f, 0.07218f,
--0.71656f, -0.23282f, 0.65752f, -0.04606f, -0.02254f, 0.05986f,
--0.52573f, -0.44721f, 0.72361f, -0.04606f, -0.02254f, 0.05986f,
--0.49999f, -0.16246f, 0.85065f, -0.04606f, -0.02254f, 0.05986f,
--0.23885f, -0.07761f, 0.96795f, -0.01276f, -0.01756f, 0.07205f,
--0.26286f, -0.36180f, 0.89443f, -0.01276f, -0.01756f, 0.07205f,
-0.00000f, -0.25115f, 0.96795f, -0.01276f, -0.01756f, 0.07205f,
--0.26286f, -0.36180f, 0.89443f, -0.00721f, -0.03083f, 0.07218f,
-0.00000f, -0.52573f, 0.85065f, -0.00721f, -0.03083f, 0.07218f,
-0.00000f, -0.25115f, 0.96795f, -0.00721f, -0.03083f, 0.07218f,
--0.49999f, -0.16246f, 0.85065f, -0.03779f, -0.02900f, 0.07265f,
--0.52573f, -0.44721f, 0.72361f, -0.03779f, -0.02900f, 0.07265f,
--0.26286f, -0.36180f, 0.89443f, -0.03779f, -0.02900f, 0.07265f,
--0.52573f, -0.44721f, 0.72361f, -0.03262f, -0.04490f, 0.07265f,
--0.26286f, -0.63819f, 0.72361f, -0.03262f, -0.04490f, 0.07265f,
--0.26286f, -0.36180f, 0.89443f, -0.03262f, -0.04490f, 0.07265f,
--0.26286f, -0.36180f, 0.89443f, -0.01590f, -0.04490f, 0.07265f,
--0.26286f, -0.63819f, 0.72361f, -0.01590f, -0.04490f, 0.07265f,
-0.00000f, -0.52573f, 0.85065f, -0.01590f, -0.04490f, 0.07265f,
--0.26286f, -0.63819f, 0.72361f, -0.00721f, -0.05077f, 0.05986f,
-0.00000f, -0.75344f, 0.65751f, -0.00721f, -0.05077f, 0.05986f,
-0.00000f, -0.52573f, 0.85065f, -0.00721f, -0.05077f, 0.05986f,
--0.71656f, -0.23282f, 0.65752f, -0.04988f, -0.02962f, 0.04793f,
--0.71657f, -0.48397f, 0.50230f, -0.04988f, -0.02962f, 0.04793f,
--0.52573f, -0.44721f, 0.72361f, -0.04988f, -0.02962f, 0.04793f,
--0.71657f, -0.48397f, 0.50230f, -0.04606f, -0.04346f, 0.04693f,
--0.50000f, -0.68819f, 0.52574f, -0.04606f, -0.04346f, 0.04693f,
--0.52573f, -0.44721f, 0.72361f, -0.04606f, -0.04346f, 0.04693f,
--0.52573f, -0.44721f, 0.72361f, -0.03779f, -0.05201f, 0.05843f,
--0.50000f, -0.68819f, 0.52574f, -0.03779f, -0.05201f, 0.05843f,
--0.26286f, -0.63819f, 0.72361f, -0.03779f, -0.05201f, 0.05843f,
--0.50000f, -0.68819f, 0.52574f, -0.02710f, -0.05723f, 0.04693f,
--0.23885f, -0.83105f, 0.50230f, -0.02710f, -0.05723f, 0.04693f,
--0.26286f, -0.63819f, 0.72361f, -0.02710f, -0.05723f, 0.04693f,
--0.26286f, -0.63819f, 0.72361f, -0.01276f, -0.05659f, 0.04793f,
--0.23885f, -0.83105f, 0.50230f, -0.01276f, -0.05659f, 0.04793f,
-0.00000f, -0.75344f, 0.65751f, -0.01276f, -0.05659f, 0.04793f,
--0.23885f, -0.83105f, 0.50230f, -0.00556f, -0.05023f, 0.03367f,
-0.00000f, -0.89443f, 0.44722f, -0.00556f, -0.05023f, 0.03367f,
-0.00000f, -0.75344f, 0.65751f, -0.00556f, -0.05023f, 0.03367f,
-0.14762f, -0.95663f, 0.25115f, 0.00900f, -0.05496f, 0.02421f,
-0.23885f, -0.83105f, 0.50230f, 0.00900f, -0.05496f, 0.02421f,
-0.00000f, -0.89443f, 0.44722f, 0.00900f, -0.05496f, 0.02421f,
-0.30901f, -0.95106f, 0.00000f, 0.02396f, -0.07382f, 0.01376f,
-0.42532f, -0.86180f, 0.27640f, 0.02396f, -0.07382f, 0.01376f,
-0.14762f, -0.95663f, 0.25115f, 0.02396f, -0.07382f, 0.01376f,
-0.44286f, -0.86070f, -0.25115f, 0.03567f, -0.07001f, -0.00618f,
-0.58778f, -0.80902f, 0.00000f, 0.03567f, -0.07001f, -0.00618f,
-0.30901f, -0.95106f, 0.00000f, 0.03567f, -0.07001f, -0.00618f,
-0.14762f, -0.95663f, 0.25115f, 0.02064f, -0.06744f, 0.02622f,
-0.42532f, -0.86180f, 0.27640f, 0.02064f, -0.06744f, 0.02622f,
-0.23885f, -0.83105f, 0.50230f, 0.02064f, -0.06744f, 0.02622f,
-0.42532f, -0.86180f, 0.27640f, 0.03155f, -0.06336f, 0.03467f,
-0.50000f, -0.68819f, 0.52574f, 0.03155f, -0.06336f, 0.03467f,
-0.23885f, -0.83105f, 0.50230f, 0.03155f, -0.06336f, 0.03467f,
-0.30901f, -0.95106f, 0.00000f, 0.03926f, -0.07705f, 0.00836f,
-0.58778f, -0.80902f, 0.00000f, 0.03926f, -0.07705f, 0.00836f,
-0.42532f, -0.86180f, 0.27640f, 0.03926f, -0.07705f, 0.00836f,
-0.58778f, -0.80902f, 0.00000f, 0.05279f, -0.07266f, 0.01715f,
-0.68819f, -0.67082f, 0.27640f, 0.05279f, -0.07266f, 0.01715f,
-0.42532f, -0.86180f, 0.27640f, 0.05279f, -0.07266f, 0.01715f,
-0.42532f, -0.86180f, 0.27640f, 0.04762f, -0.06554f, 0.03138f,
-0.68819f, -0.67082f, 0.27640f, 0.04762f, -0.06554f, 0.03138f,
-0.50000f, -0.68819f, 0.52574f, 0.04762f, -0.06554f, 0.03138f,
-0.68819f, -0.67082f, 0.27640f, 0.05051f, -0.04959f, 0.03467f,
-0.71657f, -0.48397f, 0.50230f, 0.05051f, -0.04959f, 0.03467f,
-0.50000f, -0.68819f, 0.52574f, 0.05051f, -0.04959f, 0.03467f,
-0.44286f, -0.86070f, -0.25115f, 0.04358f, -0.05999f, -0.01281f,
-0.68172f, -0.68716f, -0.25115f, 0.04358f, -0.05999f, -0.01281f,
-0.58778f, -0.80902f, 0.00000f, 0.04358f, -0.05999f, -0.01281f,
-0.68172f, -0.68716f, -0.25115f, 0.05556f, -0.05556f, -0.00618f,
-0.80902f, -0.58779f, -0.00000f, 0.05556f, -0.05556f, -0.00618f,
-0.58778f, -0.80902f, 0.00000f, 0.05556f, -0.05556f, -0.00618f,
-0.58778f, -0.80902f, 0.00000f, 0.06115f, -0.06115f, 0.00836f,
-0.80902f, -0.58779f, -0.00000f, 0.06115f, -0.06115f, 0.00836f,
-0.68819f, -0.67082f, 0.27640f, 0.06115f, -0.06115f, 0.00836f,
-0.80902f, -0.58779f, -0.00000f, 0.06281f, -0.04560f, 0.01376f,
-0.86419f, -0.43601f, 0.25115f, 0.06281f, -0.04560f, 0.01376f,
-0.68819f, -0.67082f, 0.27640f, 0.06281f, -0.04560f, 0.01376f,
-0.68819f, -0.67082f, 0.27640f, 0.05776f, -0.04048f, 0.02622f,
-0.86419f, -0.43601f, 0.25115f, 0.05776f, -0.04048f, 0.02622f,
-0.71657f, -0.48397f, 0.50230f, 0.05776f, -0.04048f, 0.02622f,
-0.86419f, -0.43601f, 0.25115f, 0.04949f, -0.02554f, 0.02421f,
-0.85065f, -0.27639f, 0.44722f, 0.04949f, -0.02554f, 0.02421f,
-0.71657f, -0.48397f, 0.50230f, 0.04949f, -0.02554f, 0.02421f,
-0.95542f, -0.15521f, 0.25115f, 0.05505f, -0.00842f, 0.02421f,
-0.86418f, -0.02964f, 0.50230f, 0.05505f, -0.00842f, 0.02421f,
-0.85065f, -0.27639f, 0.44722f, 0.05505f, -0.00842f, 0.02421f,
-1.00000f, 0.00000f, 0.00000f, 0.07761f, -0.00003f, 0.01376f,
-0.95105f, 0.13820f, 0.27640f, 0.07761f, -0.00003f, 0.01376f,
-0.95542f, -0.15521f, 0.25115f, 0.07761f, -0.00003f, 0.01376f,
-0.95542f, 0.15521f, -0.25115f, 0.07761f, 0.01229f, -0.00618f,
-0.95106f, 0.30902f, -0.00000f, 0.07761f, 0.01229f, -0.00618f,
-1.00000f, 0.00000f, 0.00000f, 0.07761f, 0.01229f, -0.00618f,
-0.95542f, -0.15521f, 0.25115f, 0.07052f, -0.00121f, 0.02622f,
-0.95105f, 0.13820f, 0.27640f, 0.07052f, -0.00121f, 0.02622f,
-0.86418f, -0.02964f, 0.50230f, 0.07052f, -0.00121f, 0.02622f,
-0.95105f, 0.13820f, 0.27640f, 0.07001f, 0.01043f, 0.03467f,
-0.80901f, 0.26287f, 0.52574f, 0.07001f, 0.01043f, 0.03467f,
-0.86418f, -0.02964f, 0.50230f, 0.07001f, 0.01043f, 0.03467f,
-1.00000f, 0.00000f, 0.00000f, 0.08541f, 0.01353f, 0.00836f,
-0.95106f, 0.30902f, -0.00000f, 0.08541f, 0.01353f, 0.00836f,
-0.95105f, 0.13820f, 0.27640f, 0.08541f, 0.01353f, 0.00836f,
-0.95106f, 0.30902f, -0.00000f, 0.08541f, 0.02775f, 0.01715f,
-0.85065f, 0.44721f, 0.27640f, 0.08541f, 0.02775f, 0.01715f,
-0.95105f, 0.13820f, 0.27640f, 0.08541f, 0.02775f, 0.01715f,
-0.95105f, 0.13820f, 0.27640f, 0.07705f, 0.02504f, 0.03138f,
-0.85065f, 0.44721f, 0.27640f, 0.07705f, 0.02504f, 0.03138f,
-0.80901f, 0.26287f, 0.52574f, 0.07705f, 0.02504f, 0.03138f,
-0.85065f, 0.44721f, 0.27640f, 0.06277f, 0.03272f, 0.03467f,
-0.68171f, 0.53194f, 0.50230f, 0.06277f, 0.03272f, 0.03467f,
-0.80901f, 0.26287f, 0.52574f, 0.06277f, 0.03272f, 0.03467f,
-0.95542f, 0.15521f, -0.25115f, 0.07052f, 0.02291f, -0.01281f,
-0.86419f, 0.43601f, -0.25115f, 0.07052f, 0.02291f, -0.01281f,
-0.95106f, 0.30902f, -0.00000f, 0.07052f, 0.02291f, -0.01281f,
-0.86419f, 0.43601f, -0.25115f, 0.07001f, 0.03567f, -0.00618f,
-0.80902f, 0.58779f, -0.00000f, 0.07001f, 0.03567f, -0.00618f,
-0.95106f, 0.30902f, -0.00000f, 0.07001f, 0.03567f, -0.00618f,
-0.95106f, 0.30902f, -0.00000f, 0.07705f, 0.03926f, 0.00836f,
-0.80902f, 0.58779f, -0.00000f, 0.07705f, 0.03926f, 0.00836f,
-0.85065f, 0.44721f, 0.27640f, 0.07705f, 0.03926f, 0.00836f,
-0.80902f, 0.58779f, -0.00000f, 0.06277f, 0.04564f, 0.01376f,
-0.68172f, 0.68716f, 0.25115f, 0.06277f, 0.04564f, 0.01376f,
-0.85065f, 0.44721f, 0.27640f, 0.06277f, 0.04564f, 0.01376f,
-0.85065f, 0.44721f, 0.27640f, 0.05634f, 0.04243f, 0.02622f,
-0.68172f, 0.68716f, 0.25115f, 0.05634f, 0.04243f, 0.02622f,
-0.68171f, 0.53194f, 0.50230f, 0.05634f, 0.04243f, 0.02622f,
-0.68172f, 0.68716f, 0.25115f, 0.03959f, 0.03918f, 0.02421f,
-0.52573f, 0.72361f, 0.44722f, 0.03959f, 0.03918f, 0.02421f,
-0.68171f, 0.53194f, 0.50230f, 0.03959f, 0.03918f, 0.02421f,
-0.44286f, 0.86070f, 0.25115f, 0.02503f, 0.04976f, 0.02421f,
-0.29524f, 0.81273f, 0.50230f, 0.02503f, 0.04976f, 0.02421f,
-0.52573f, 0.72361f, 0.44722f, 0.02503f, 0.04976f, 0.02421f,
-0.30901f, 0.95106f, 0.00000f, 0.02401f, 0.07380f, 0.01376f,
-0.16246f, 0.94721f, 0.27640f, 0.02401f, 0.07380f, 0.01376f,
-0.44286f, 0.86070f, 0.25115f, 0.02401f, 0.07380f, 0.01376f,
-0.14762f, 0.95663f, -0.25115f, 0.01229f, 0.07761f, -0.00618f,
--0.00000f, 1.00000f, 0.00000f, 0.01229f, 0.07761f, -0.00618f,
-0.30901f, 0.95106f, 0.00000f, 0.01229f, 0.07761f, -0.00618f,
-0.44286f, 0.86070f, 0.25115f, 0.02294f, 0.06670f, 0.02622f,
-0.16246f, 0.94721f, 0.27640f, 0.02294f, 0.06670f, 0.02622f,
-0.29524f, 0.81273f, 0.50230f, 0.02294f, 0.06670f, 0.02622f,
-0.16246f, 0.94721f, 0.27640f, 0.01172f, 0.06981f, 0.03467f,
-0.00000f, 0.85065f, 0.52574f, 0.01172f, 0.06981f, 0.03467f,
-0.29524f, 0.81273f, 0.50230f, 0.01172f, 0.06981f, 0.03467f,
-0.30901f, 0.95106f, 0.00000f, 0.01353f, 0.08541f, 0.00836f,
--0.00000f, 1.00000f, 0.00000f, 0.01353f, 0.08541f, 0.00836f,
-0.16246f, 0.94721f, 0.27640f, 0.01353f, 0.08541f, 0.00836f,
--0.00000f, 1.00000f, 0.00000f, 0.00000f, 0.08981f, 0.01715f,
--0.16246f, 0.94721f, 0.27640f, 0.00000f, 0.08981f, 0.01715f,
-0.16246f, 0.94721f, 0.27640f, 0.00000f, 0.08981f, 0.01715f,
-0.16246f, 0.94721f, 0.27640f, 0.00000f, 0.08101f, 0.03138f,
--0.16246f, 0.94721f, 0.27640f, 0.00000f, 0.08101f, 0.03138f,
-0.00000f, 0.85065f, 0.52574f, 0.00000f, 0.08101f, 0.03138f,
--0.16246f, 0.94721f, 0.27640f, -0.01172f, 0.06981f, 0.03467f,
--0.29524f, 0.81273f, 0.50230f, -0.01172f, 0.06981f, 0.03467f,
-0.00000f, 0.85065f, 0.52574f, -0.01172f, 0.06981f, 0.03467f,
-0.14762f, 0.95663f, -0.25115f, 0.00000f, 0.07415f, -0.01281f,
--0.14762f, 0.95663f, -0.25115f, 0.00000f, 0.07415f, -0.01281f,
--0.00000f, 1.00000f, 0.00000f, 0.00000f, 0.07415f, -0.01281f,
--0.14762f, 0.95663f, -0.25115f, -0.01229f, 0.07761f, -0.00618f,
--0.30901f, 0.95106f, -0.00000f, -0.01229f, 0.07761f, -0.00618f,
--0.00000f, 1.00000f, 0.00000f, -0.01229f, 0.07761f, -0.00618f,
--0.00000f, 1.00000f, 0.00000f, -0.01353f, 0.08541f, 0.00836f,
--0.30901f, 0.95106f, -0.00000f, -0.01353f, 0.08541f, 0.00836f,
--0.16246f, 0.94721f, 0.27640f, -0.01353f, 0.08541f, 0.00836f,
--0.30901f, 0.95106f, -0.00000f, -0.02401f, 0.07380f, 0.01376f,
--0.44286f, 0.86070f, 0.25115f, -0.02401f, 0.07380f, 0.01376f,
--0.16246f, 0.94721f, 0.27640f, -0.02401f, 0.07380f, 0.01376f,
--0.16246f, 0.94721f, 0.27640f, -0.02294f, 0.06670f, 0.02622f,
--0.44286f, 0.86070f, 0.25115f, -0.02294f, 0.06670f, 0.02622f,
--0.29524f, 0.81273f, 0.50230f, -0.02294f, 0.06670f, 0.02622f,
--0.44286f, 0.86070f, 0.25115f, -0.02503f, 0.04976f, 0.02421f,
--0.52573f, 0.72361f, 0.44722f, -0.02503f, 0.04976f, 0.02421f,
--0.29524f, 0.81273f, 0.50230f, -0.02503f, 0.04976f, 0.02421f,
--0.68172f, 0.68716f, 0.25115f, -0.03959f, 0.03918f, 0.02421f,
--0.68171f, 0.53194f, 0.50230f, -0.03959f, 0.03918f, 0.02421f,
--0.52573f, 0.72361f, 0.44722f, -0.03959f, 0.03918f, 0.02421f,
--0.80902f, 0.58779f, 0.00000f, -0.06277f, 0.04564f, 0.01376f,
--0.85065f, 0.44722f, 0.27640f, -0.06277f, 0.04564f, 0.01376f,
--0.68172f, 0.68716f, 0.25115f, -0.06277f, 0.04564f, 0.01376f,
--0.86419f, 0.43601f, -0.25115f, -0.07001f, 0.03567f, -0.00618f,
--0.95106f, 0.30902f, -0.00000f, -0.07001f, 0.03567f, -0.00618f,
--0.80902f, 0.58779f, 0.00000f, -0.07001f, 0.03567f, -0.00618f,
--0.68172f, 0.68716f, 0.25115f, -0.05634f, 0.04243f, 0.02622f,
--0.85065f, 0.44722f, 0.27640f, -0.05634f, 0.04243f, 0.02622f,
--0.68171f, 0.53194f, 0.50230f, -0.05634f, 0.04243f, 0.02622f,
--0.85065f, 0.44722f, 0.27640f, -0.06277f, 0.03272f, 0.03467f,
--0.80901f, 0.26287f, 0.52574f, -0.06277f, 0.03272f, 0.03467f,
--0.68171f, 0.53194f, 0.50230f, -0.06277f, 0.03272f, 0.03467f,
--0.80902f, 0.58779f, 0.00000f, -0.07705f, 0.03926f, 0.00836f,
--0.95106f, 0.30902f, -0.00000f, -0.07705f, 0.03926f, 0.00836f,
--0.85065f, 0.44722f, 0.27640f, -0.07705f, 0.03926f, 0.00836f,
--0.95106f, 0.30902f, -0.00000f, -0.08541f, 0.02775f, 0.01715f,
--0.95105f, 0.13820f, 0.27640f, -0.08541f, 0.02775f, 0.01715f,
--0.85065f, 0.44722f, 0.27640f, -0.08541f, 0.02775f, 0.01715f,
--0.85065f, 0.44722f, 0.27640f, -0.07705f, 0.02504f, 0.03138f,
--0.95105f, 0.13820f, 0.27640f, -0.07705f, 0.02504f, 0.03138f,
--0.80901f, 0.26287f, 0.52574f, -0.07705f, 0.02504f, 0.03138f,
--0.95105f, 0.13820f, 0.27640f, -0.07001f, 0.01043f, 0.03467f,
--0.86418f, -0.02964f, 0.50230f, -0.07001f, 0.01043f, 0.03467f,
--0.80901f, 0.26287f, 0.52574f, -0.07001f, 0.01043f, 0.03467f,
--0.86419f, 0.43601f, -0.25115f, -0.07052f, 0.02291f, -0.01281f,
--0.95542f, 0.15521f, -0.25115f, -0.07052f, 0.02291f, -0.01281f,
--0.95106f, 0.30902f, -0.00000f, -0.07052f, 0.02291f, -0.01281f,
--0.95542f, 0.15521f, -0.25115f, -0.07761f, 0.01229f, -0.00618f,
--1.00000f, 0.00000f, -0.00000f, -0.07761f, 0.01229f, -0.00618f,
--0.95106f, 0.30902f, -0.00000f, -0.07761f, 0.01229f, -0.00618f,
--0.95106f, 0.30902f, -0.00000f, -0.08541f, 0.01353f, 0.00836f,
--1.00000f, 0.00000f, -0.00000f, -0.08541f, 0.01353f, 0.00836f,
--0.95105f, 0.13820f, 0.27640f, -0.08541f, 0.01353f, 0.00836f,
--1.00000f, 0.00000f, -0.00000f, -0.07761f, -0.00003f, 0.01376f,
--0.95542f, -0.15521f, 0.25115f, -0.07761f, -0.00003f, 0.01376f,
--0.95105f, 0.13820f, 0.27640f, -0.07761f, -0.00003f, 0.01376f,
--0.95105f, 0.13820f, 0.27640f, -0.07052f, -0.00121f, 0.02622f,
--0.95542f, -0.15521f, 0.25115f, -0.07052f, -0.00121f, 0.02622f,
--0.86418f, -0.02964f, 0.50230f, -0.07052f, -0.00121f, 0.02622f,
--0.95542f, -0.15521f, 0.25115f, -0.05505f, -0.00842f, 0.02421f,
--0.85065f, -0.27639f, 0.44722f, -0.05505f, -0.00842f, 0.02421f,
--0.86418f, -0.02964f, 0.50230f, -0.05505f, -0.00842f, 0.02421f,
--0.86419f, -0.43601f, 0.25115f, -0.04949f, -0.02554f, 0.02421f,
--0.71657f, -0.48397f, 0.50230f, -0.04949f, -0.02554f, 0.02421f,
--0.85065f, -0.27639f, 0.44722f, -0.04949f, -0.02554f, 0.02421f,
--0.80902f, -0.58779f, 0.00000f, -0.06281f, -0.04559f, 0.01376f,
--0.68819f, -0.67082f, 0.27640f, -0.06281f, -0.04559f, 0.01376f,
--0.86419f, -0.43601f, 0.25115f, -0.06281f, -0.04559f, 0.01376f,
--0.68172f, -0.68716f, -0.25115f, -0.05556f, -0.05556f, -0.00618f,
--0.58778f, -0.80902f, -0.00000f, -0.05556f, -0.05556f, -0.00618f,
--0.80902f, -0.58779f, 0.00000f, -0.05556f, -0.05556f, -0.00618f,
--0.86419f, -0.43601f, 0.25115f, -0.05776f, -0.04048f, 0.02622f,
--0.68819f, -0.67082f, 0.27640f, -0.05776f, -0.04048f, 0.02622f,
--0.71657f, -0.48397f, 0.50230f, -0.05776f, -0.04048f, 0.02622f,
--0.68819f, -0.67082f, 0.27640f, -0.05051f, -0.04959f, 0.03467f,
--0.50000f, -0.68819f, 0.52574f, -0.05051f, -0.04959f, 0.03467f,
--0.71657f, -0.48397f, 0.50230f, -0.05051f, -0.04959f, 0.03467f,
--0.80902f, -0.58779f, 0.00000f, -0.06115f, -0.06115f, 0.00836f,
--0.58778f, -0.80902f, -0.00000f, -0.06115f, -0.06115f, 0.00836f,
--0.68819f, -0.67082f, 0.27640f, -0.06115f, -0.06115f, 0.00836f,
--0.58778f, -0.80902f, -0.00000f, -0.05279f, -0.07266f, 0.01715f,
--0.42532f, -0.86180f, 0.27639f, -0.05279f, -0.07266f, 0.01715f,
--0.68819f, -0.67082f, 0.27640f, -0.05279f, -0.07266f, 0.01715f,
--0.68819f, -0.67082f, 0.27640f, -0.04762f, -0.06554f, 0.03138f,
--0.42532f, -0.86180f, 0.27639f, -0.04762f, -0.06554f, 0.03138f,
--0.50000f, -0.68819f, 0.52574f, -0.04762f, -0.06554f, 0.03138f,
--0.42532f, -0.86180f, 0.27639f, -0.03155f, -0.06336f, 0.03467f,
--0.23885f, -0.83105f, 0.50230f, -0.03155f, -0.06336f, 0.03467f,
--0.50000f, -0.68819f, 0.52574f, -0.03155f, -0.06336f, 0.03467f,
--0.68172f, -0.68716f, -0.25115f, -0.04358f, -0.05999f, -0.01281f,
--0.44286f, -0.86070f, -0.25115f, -0.04358f, -0.05999f, -0.01281f,
--0.58778f, -0.80902f, -0.00000f, -0.04358f, -0.05999f, -0.01281f,
--0.44286f, -0.86070f, -0.25115f, -0.03567f, -0.07001f, -0.00618f,
--0.30901f, -0.95106f, -0.00000f, -0.03567f, -0.07001f, -0.00618f,
--0.58778f, -0.80902f, -0.00000f, -0.03567f, -0.07001f, -0.00618f,
--0.58778f, -0.80902f, -0.00000f, -0.03926f, -0.07705f, 0.00836f,
--0.30901f, -0.95106f, -0.00000f, -0.03926f, -0.07705f, 0.00836f,
--0.42532f, -0.86180f, 0.27639f, -0.03926f, -0.07705f, 0.00836f,
--0.30901f, -0.95106f, -0.00000f, -0.02396f, -0.07382f, 0.01376f,
--0.14762f, -0.95663f, 0.25115f, -0.02396f, -0.07382f, 0.01376f,
--0.42532f, -0.86180f, 0.27639f, -0.02396f, -0.07382f, 0.01376f,
--0.42532f, -0.86180f, 0.27639f, -0.02064f, -0.06744f, 0.02622f,
--0.14762f, -0.95663f, 0.25115f, -0.02064f, -0.06744f, 0.02622f,
--0.23885f, -0.83105f, 0.50230f, -0.02064f, -0.06744f, 0.02622f,
--0.14762f, -0.95663f, 0.25115f, -0.00900f, -0.05496f, 0.02421f,
-0.00000f, -0.89443f, 0.44722f, -0.00900f, -0.05496f, 0.02421f,
--0.23885f, -0.83105f, 0.50230f, -0.00900f, -0.05496f, 0.02421f,
-0.86419f, -0.43601f, 0.25115f, 0.05505f, -0.01789f, 0.01836f,
-0.95542f, -0.15521f, 0.25115f, 0.05505f, -0.01789f, 0.01836f,
-0.85065f, -0.27639f, 0.44722f, 0.05505f, -0.01789f, 0.01836f,
-0.80902f, -0.58779f, -0.00000f, 0.07001f, -0.03567f, 0.00618f,
-0.95106f, -0.30902f, -0.00000f, 0.07001f, -0.03567f, 0.00618f,
-0.86419f, -0.43601f, 0.25115f, 0.07001f, -0.03567f, 0.00618f,
-0.68172f, -0.68716f, -0.25115f, 0.06277f, -0.04564f, -0.01376f,
-0.85065f, -0.44722f, -0.27640f, 0.06277f, -0.04564f, -0.01376f,
-0.80902f, -0.58779f, -0.00000f, 0.06277f, -0.04564f, -0.01376f,
-0.86419f, -0.43601f, 0.25115f, 0.07052f, -0.02291f, 0.01281f,
-0.95106f, -0.30902f, -0.00000f, 0.07052f, -0.02291f, 0.01281f,
-0.95542f, -0.15521f, 0.25115f, 0.07052f, -0.02291f, 0.01281f,
-0.95106f, -0.30902f, -0.00000f, 0.07761f, -0.01229f, 0.00618f,
-1.00000f, 0.00000f, 0.00000f, 0.07761f, -0.01229f, 0.00618f,
-0.95542f, -0.15521f, 0.25115f, 0.07761f, -0.01229f, 0.00618f,
-0.80902f, -0.58779f, -0.00000f, 0.07705f, -0.03926f, -0.00836f,
-0.85065f, -0.44722f, -0.27640f, 0.07705f, -0.03926f, -0.00836f,
-0.95106f, -0.30902f, -0.00000f, 0.07705f, -0.03926f, -0.00836f,
-0.85065f, -0.44722f, -0.27640f, 0.08541f, -0.02775f, -0.01715f,
-0.95105f, -0.13820f, -0.27640f, 0.08541f, -0.02775f, -0.01715f,
-0.95106f, -0.30902f, -0.00000f, 0.08541f, -0.02775f, -0.01715f,
-0.95106f, -0.30902f, -0.00000f, 0.08541f, -0.01353f, -0.00836f,
-0.95105f, -0.13820f, -0.27640f, 0.08541f, -0.01353f, -0.00836f,
-1.00000f, 0.00000f, 0.00000f, 0.08541f, -0.01353f, -0.00836f,
-0.95105f, -0.13820f, -0.27640f, 0.07761f, 0.00003f, -0.01376f,
-0.95542f, 0.15521f, -0.25115f, 0.07761f, 0.00003f, -0.01376f,
-1.00000f, 0.00000f, 0.00000f, 0.07761f, 0.00003f, -0.01376f,
-0.68172f, -0.68716f, -0.25115f, 0.05634f, -0.04243f, -0.02622f,
-0.68171f, -0.53194f, -0.50230f, 0.05634f, -0.04243f, -0.02622f,
-0.85065f, -0.44722f, -0.27640f, 0.05634f, -0.04243f, -0.02622f,
-0.68171f, -0.53194f, -0.50230f, 0.06277f, -0.03272f, -0.03467f,
-0.80901f, -0.26287f, -0.52574f, 0.06277f, -0.03272f, -0.03467f,
-0.85065f, -0.44722f, -0.27640f, 0.06277f, -0.03272f, -0.03467f,
-0.85065f, -0.44722f, -0.27640f, 0.07705f, -0.02504f, -0.03138f,
-0.80901f, -0.26287f, -0.52574f, 0.07705f, -0.02504f, -0.03138f,
-0.95105f, -0.13820f, -0.27640f, 0.07705f, -0.02504f, -0.03138f,
-0.80901f, -0.26287f, -0.52574f, 0.07001f, -0.01043f, -0.03467f,
-0.86418f, 0.02964f, -0.50230f, 0.07001f, -0.01043f, -0.03467f,
-0.95105f, -0.13820f, -0.27640f, 0.07001f, -0.01043f, -0.03467f,
-0.95105f, -0.13820f, -0.27640f, 0.07052f, 0.00121f, -0.02622f,
-0.86418f, 0.02964f, -0.50230f, 0.07052f, 0.00121f, -0.02622f,
-0.95542f, 0.15521f, -0.25115f, 0.07052f, 0.00121f, -0.02622f,
-0.86418f, 0.02964f, -0.50230f, 0.05505f, 0.00842f, -0.02421f,
-0.85065f, 0.27639f, -0.44722f, 0.05505f, 0.00842f, -0.02421f,
-0.95542f, 0.15521f, -0.25115f, 0.05505f, 0.00842f, -0.02421f,
-0.68172f, 0.68716f, 0.25115f, 0.03403f, 0.04683f, 0.01836f,
-0.44286f, 0.86070f, 0.25115f, 0.03403f, 0.04683f, 0.01836f,
-0.52573f, 0.72361f, 0.44722f, 0.03403f, 0.04683f, 0.01836f,
-0.80902f, 0.58779f, -0.00000f, 0.05556f, 0.05556f, 0.00618f,
-0.58778f, 0.80902f, -0.00000f, 0.05556f, 0.05556f, 0.00618f,
-0.68172f, 0.68716f, 0.25115f, 0.05556f, 0.05556f, 0.00618f,
-0.86419f, 0.43601f, -0.25115f, 0.06281f, 0.04559f, -0.01376f,
-0.68819f, 0.67082f, -0.27640f, 0.06281f, 0.04559f, -0.01376f,
-0.80902f, 0.58779f, -0.00000f, 0.06281f, 0.04559f, -0.01376f,
-0.68172f, 0.68716f, 0.25115f, 0.04358f, 0.05999f, 0.01281f,
-0.58778f, 0.80902f, -0.00000f, 0.04358f, 0.05999f, 0.01281f,
-0.44286f, 0.86070f, 0.25115f, 0.04358f, 0.05999f, 0.01281f,
-0.58778f, 0.80902f, -0.00000f, 0.03567f, 0.07001f, 0.00618f,
-0.30901f, 0.95106f, 0.00000f, 0.03567f, 0.07001f, 0.00618f,
-0.44286f, 0.86070f, 0.25115f, 0.03567f, 0.07001f, 0.00618f,
-0.80902f, 0.58779f, -0.00000f, 0.06115f, 0.06115f, -0.00836f,
-0.68819f, 0.67082f, -0.27640f, 0.06115f, 0.06115f, -0.00836f,
-0.58778f, 0.80902f, -0.00000f, 0.06115f, 0.06115f, -0.00836f,
-0.68819f, 0.67082f, -0.27640f, 0.05279f, 0.07266f, -0.01715f,
-0.42532f, 0.86180f, -0.27640f, 0.05279f, 0.07266f, -0.01715f,
-0.58778f, 0.80902f, -0.00000f, 0.05279f, 0.07266f, -0.01715f,
-0.58778f, 0.80902f, -0.00000f, 0.03926f, 0.07705f, -0.00836f,
-0.42532f, 0.86180f, -0.27640f, 0.03926f, 0.07705f, -0.00836f,
-0.30901f, 0.95106f, 0.00000f, 0.03926f, 0.07705f, -0.00836f,
-0.42532f, 0.86180f, -0.27640f, 0.02396f, 0.07382f, -0.01376f,
-0.14762f, 0.95663f, -0.25115f, 0.02396f, 0.07382f, -0.01376f,
-0.30901f, 0.95106f, 0.00000f, 0.02396f, 0.07382f, -0.01376f,
-0.86419f, 0.43601f, -0.25115f, 0.05776f, 0.04047f, -0.02622f,
-0.71657f, 0.48397f, -0.50230f, 0.05776f, 0.04047f, -0.02622f,
-0.68819f, 0.67082f, -0.27640f, 0.05776f, 0.04047f, -0.02622f,
-0.71657f, 0.48397f, -0.50230f, 0.05051f, 0.04959f, -0.03467f,
-0.50000f, 0.68819f, -0.52574f, 0.05051f, 0.04959f, -0.03467f,
-0.68819f, 0.67082f, -0.27640f, 0.05051f, 0.04959f, -0.03467f,
-0.68819f, 0.67082f, -0.27640f, 0.04762f, 0.06554f, -0.03138f,
-0.50000f, 0.68819f, -0.52574f, 0.04762f, 0.06554f, -0.03138f,
-0.42532f, 0.86180f, -0.27640f, 0.04762f, 0.06554f, -0.03138f,
-0.50000f, 0.68819f, -0.52574f, 0.03155f, 0.06336f, -0.03467f,
-0.23885f, 0.83105f, -0.50230f, 0.03155f, 0.06336f, -0.03467f,
-0.42532f, 0.86180f, -0.27640f, 0.03155f, 0.06336f, -0.03467f,
-0.42532f, 0.86180f, -0.27640f, 0.02064f, 0.06744f, -0.02622f,
-0.23885f, 0.83105f, -0.50230f, 0.02064f, 0.06744f, -0.02622f,
-0.14762f, 0.95663f, -0.25115f, 0.02064f, 0.06744f, -0.02622f,
-0.23885f, 0.83105f, -0.50230f, 0.00900f, 0.05496f, -0.02421f,
-0.00000f, 0.89443f, -0.44722f, 0.00900f, 0.05496f, -0.02421f,
-0.14762f, 0.95663f, -0.25115f, 0.00900f, 0.05496f, -0.02421f,
--0.44286f, 0.86070f, 0.25115f, -0.03403f, 0.04683f, 0.01836f,
--0.68172f, 0.68716f, 0.25115f, -0.03403f, 0.04683f, 0.01836f,
--0.52573f, 0.72361f, 0.44722f, -0.03403f, 0.04683f, 0.01836f,
--0.30901f, 0.95106f, -0.00000f, -0.03567f, 0.07001f, 0.00618f,
--0.58778f, 0.80902f, 0.00000f, -0.03567f, 0.07001f, 0.00618f,
--0.44286f, 0.86070f, 0.25115f, -0.03567f, 0.07001f, 0.00618f,
--0.14762f, 0.95663f, -0.25115f, -0.02396f, 0.07382f, -0.01376f,
--0.42532f, 0.86180f, -0.27640f, -0.02396f, 0.07382f, -0.01376f,
--0.30901f, 0.95106f, -0.00000f, -0.02396f, 0.07382f, -0.01376f,
--0.44286f, 0.86070f, 0.25115f, -0.04358f, 0.05999f, 0.01281f,
--0.58778f, 0.80902f, 0.00000f, -0.04358f, 0.05999f, 0.01281f,
--0.68172f, 0.68716f, 0.25115f, -0.04358f, 0.05999f, 0.01281f,
--0.58778f, 0.80902f, 0.00000f, -0.05556f, 0.05556f, 0.00618f,
--0.80902f, 0.58779f, 0.00000f, -0.05556f, 0.05556f, 0.00618f,
--0.68172f, 0.68716f, 0.25115f, -0.05556f, 0.05556f, 0.00618f,
--0.30901f, 0.95106f, -0.00000f, -0.03926f, 0.07705f, -0.00836f,
--0.42532f, 0.86180f, -0.27640f, -0.03926f, 0.07705f, -0.00836f,
--0.58778f, 0.80902f, 0.00000f, -0.03926f, 0.07705f, -0.00836f,
--0.42532f, 0.86180f, -0.27640f, -0.05279f, 0.07266f, -0.01715f,
--0.68819f, 0.67082f, -0.27640f, -0.05279f, 0.07266f, -0.01715f,
--0.58778f, 0.80902f, 0.00000f, -0.05279f, 0.07266f, -0.01715f,
--0.58778f, 0.80902f, 0.00000f, -0.06115f, 0.06115f, -0.00836f,
--0.68819f, 0.67082f, -0.27640f, -0.06115f, 0.06115f, -0.00836f,
--0.80902f, 0.58779f, 0.00000f, -0.06115f, 0.06115f, -0.00836f,
--0.68819f, 0.67082f, -0.27640f, -0.06281f, 0.04559f, -0.01376f,
--0.86419f, 0.43601f, -0.25115f, -0.06281f, 0.04559f, -0.01376f,
--0.80902f, 0.58779f, 0.00000f, -0.06281f, 0.04559f, -0.01376f,
--0.14762f, 0.95663f, -0.25115f, -0.02064f, 0.06744f, -0.02622f,
--0.23885f, 0.83105f, -0.50230f, -0.02064f, 0.06744f, -0.02622f,
--0.42532f, 0.86180f, -0.27640f, -0.02064f, 0.06744f, -0.02622f,
--0.23885f, 0.83105f, -0.50230f, -0.03155f, 0.06336f, -0.03467f,
--0.50000f, 0.68819f, -0.52574f, -0.03155f, 0.06336f, -0.03467f,
--0.42532f, 0.86180f, -0.27640f, -0.03155f, 0.06336f, -0.03467f,
--0.42532f, 0.86180f, -0.27640f, -0.04762f, 0.06554f, -0.03138f,
--0.50000f, 0.68819f, -0.52574f, -0.04762f, 0.06554f, -0.03138f,
--0.68819f, 0.67082f, -0.27640f, -0.04762f, 0.06554f, -0.03138f,
--0.50000f, 0.68819f, -0.52574f, -0.05051f, 0.04959f, -0.03467f,
--0.71657f, 0.48397f, -0.50230f, -0.05051f, 0.04959f, -0.03467f,
--0.68819f, 0.67082f, -0.27640f, -0.05051f, 0.04959f, -0.03467f,
--0.68819f, 0.67082f, -0.27640f, -0.05776f, 0.04047f, -0.02622f,
--0.71657f, 0.48397f, -0.50230f, -0.05776f, 0.04047f, -0.02622f,
--0.86419f, 0.43601f, -0.25115f, -0.05776f, 0.04047f, -0.02622f,
--0.71657f, 0.48397f, -0.50230f, -0.04949f, 0.02554f, -0.02421f,
--0.85065f, 0.27639f, -0.44722f, -0.04949f, 0.02554f, -0.02421f,
--0.86419f, 0.43601f, -0.25115f, -0.04949f, 0.02554f, -0.02421f,
--0.95542f, -0.15521f, 0.25115f, -0.05505f, -0.01789f, 0.01836f,
--0.86419f, -0.43601f, 0.25115f, -0.05505f, -0.01789f, 0.01836f,
--0.85065f, -0.27639f, 0.44722f, -0.05505f, -0.01789f, 0.01836f,
--1.00000f, 0.00000f, -0.00000f, -0.07761f, -0.01229f, 0.00618f,
--0.95106f, -0.30902f, 0.00000f, -0.07761f, -0.01229f, 0.00618f,
--0.95542f, -0.15521f, 0.25115f, -0.07761f, -0.01229f, 0.00618f,
--0.95542f, 0.15521f, -0.25115f, -0.07761f, 0.00003f, -0.01376f,
--0.95105f, -0.13820f, -0.27640f, -0.07761f, 0.00003f, -0.01376f,
--1.00000f, 0.00000f, -0.00000f, -0.07761f, 0.00003f, -0.01376f,
--0.95542f, -0.15521f, 0.25115f, -0.07052f, -0.02291f, 0.01281f,
--0.95106f, -0.30902f, 0.00000f, -0.07052f, -0.02291f, 0.01281f,
--0.86419f, -0.43601f, 0.25115f, -0.07052f, -0.02291f, 0.01281f,
--0.95106f, -0.30902f, 0.00000f, -0.07001f, -0.03567f, 0.00618f,
--0.80902f, -0.58779f, 0.00000f, -0.07001f, -0.03567f, 0.00618f,
--0.86419f, -0.43601f, 0.25115f, -0.07001f, -0.03567f, 0.00618f,
--1.00000f, 0.00000f, -0.00000f, -0.08541f, -0.01353f, -0.00836f,
--0.95105f, -0.13820f, -0.27640f, -0.08541f, -0.01353f, -0.00836f,
--0.95106f, -0.30902f, 0.00000f, -0.08541f, -0.01353f, -0.00836f,
--0.95105f, -0.13820f, -0.27640f, -0.08541f, -0.02775f, -0.01715f,
--0.85065f, -0.44722f, -0.27640f, -0.08541f, -0.02775f, -0.01715f,
--0.95106f, -0.30902f, 0.00000f, -0.08541f, -0.02775f, -0.01715f,
--0.95106f, -0.30902f, 0.00000f, -0.07705f, -0.03926f, -0.00836f,
--0.85065f, -0.44722f, -0.27640f, -0.07705f, -0.03926f, -0.00836f,
--0.80902f, -0.58779f, 0.00000f, -0.07705f, -0.03926f, -0.00836f,
--0.85065f, -0.44722f, -0.27640f, -0.06277f, -0.04564f, -0.01376f,
--0.68172f, -0.68716f, -0.25115f, -0.06277f, -0.04564f, -0.01376f,
--0.80902f, -0.58779f, 0.00000f, -0.06277f, -0.04564f, -0.01376f,
--0.95542f, 0.15521f, -0.25115f, -0.07052f, 0.00121f, -0.02622f,
--0.86418f, 0.02964f, -0.50230f, -0.07052f, 0.00121f, -0.02622f,
--0.95105f, -0.13820f, -0.27640f, -0.07052f, 0.00121f, -0.02622f,
--0.86418f, 0.02964f, -0.50230f, -0.07001f, -0.01043f, -0.03467f,
--0.80901f, -0.26287f, -0.52574f, -0.07001f, -0.01043f, -0.03467f,
--0.95105f, -0.13820f, -0.27640f, -0.07001f, -0.01043f, -0.03467f,
--0.95105f, -0.13820f, -0.27640f, -0.07705f, -0.02504f, -0.03138f,
--0.80901f, -0.26287f, -0.52574f, -0.07705f, -0.02504f, -0.03138f,
--0.85065f, -0.44722f, -0.27640f, -0.07705f, -0.02504f, -0.03138f,
--0.80901f, -0.26287f, -0.52574f, -0.06277f, -0.03272f, -0.03467f,
--0.68171f, -0.53194f, -0.50230f, -0.06277f, -0.03272f, -0.03467f,
--0.85065f, -0.44722f, -0.27640f, -0.06277f, -0.03272f, -0.03467f,
--0.85065f, -0.44722f, -0.27640f, -0.05634f, -0.04243f, -0.02622f,
--0.68171f, -0.53194f, -0.50230f, -0.05634f, -0.04243f, -0.02622f,
--0.68172f, -0.68716f, -0.25115f, -0.05634f, -0.04243f, -0.02622f,
--0.68171f, -0.53194f, -0.50230f, -0.03959f, -0.03918f, -0.02421f,
--0.52573f, -0.72361f, -0.44722f, -0.03959f, -0.03918f, -0.02421f,
--0.68172f, -0.68716f, -0.25115f, -0.03959f, -0.03918f, -0.02421f,
--0.14762f, -0.95663f, 0.25115f, 0.00000f, -0.05789f, 0.01836f,
-0.14762f, -0.95663f, 0.25115f, 0.00000f, -0.05789f, 0.01836f,
-0.00000f, -0.89443f, 0.44722f, 0.00000f, -0.05789f, 0.01836f,
--0.30901f, -0.95106f, -0.00000f, -0.01229f, -0.07761f, 0.00618f,
-0.00000f, -1.00000f, 0.00000f, -0.01229f, -0.07761f, 0.00618f,
--0.14762f, -0.95663f, 0.25115f, -0.01229f, -0.07761f, 0.00618f,
--0.44286f, -0.86070f, -0.25115f, -0.02401f, -0.07380f, -0.01376f,
--0.16246f, -0.94721f, -0.27640f, -0.02401f, -0.07380f, -0.01376f,
--0.30901f, -0.95106f, -0.00000f, -0.02401f, -0.07380f, -0.01376f,
--0.14762f, -0.95663f, 0.25115f, 0.00000f, -0.07415f, 0.01281f,
-0.00000f, -1.00000f, 0.00000f, 0.00000f, -0.07415f, 0.01281f,
-0.14762f, -0.95663f, 0.25115f, 0.00000f, -0.07415f, 0.01281f,
-0.00000f, -1.00000f, 0.00000f, 0.01229f, -0.07761f, 0.00618f,
-0.30901f, -0.95106f, 0.00000f, 0.01229f, -0.07761f, 0.00618f,
-0.14762f, -0.95663f, 0.25115f, 0.01229f, -0.07761f, 0.00618f,
--0.30901f, -0.95106f, -0.00000f, -0.01353f, -0.08541f, -0.00836f,
--0.16246f, -0.94721f, -0.27640f, -0.01353f, -0.08541f, -0.00836f,
-0.00000f, -1.00000f, 0.00000f, -0.01353f, -0.08541f, -0.00836f,
--0.16246f, -0.94721f, -0.27640f, 0.00000f, -0.08981f, -0.01715f,
-0.16246f, -0.94721f, -0.27640f, 0.00000f, -0.08981f, -0.01715f,
-0.00000f, -1.00000f, 0.00000f, 0.00000f, -0.08981f, -0.01715f,
-0.00000f, -1.00000f, 0.00000f, 0.01353f, -0.08541f, -0.00836f,
-0.16246f, -0.94721f, -0.27640f, 0.01353f, -0.08541f, -0.00836f,
-0.30901f, -0.95106f, 0.00000f, 0.01353f, -0.08541f, -0.00836f,
-0.16246f, -0.94721f, -0.27640f, 0.02401f, -0.07380f, -0.01376f,
-0.44286f, -0.86070f, -0.25115f, 0.02401f, -0.07380f, -0.01376f,
-0.30901f, -0.95106f, 0.00000f, 0.02401f, -0.07380f, -0.01376f,
--0.44286f, -0.86070f, -0.25115f, -0.02294f, -0.06670f, -0.02622f,
--0.29524f, -0.81273f, -0.50230f, -0.02294f, -0.06670f, -0.02622f,
--0.16246f, -0.94721f, -0.27640f, -0.02294f, -0.06670f, -0.02622f,
--0.29524f, -0.81273f, -0.50230f, -0.01172f, -0.06981f, -0.03467f,
-0.00000f, -0.85065f, -0.52574f, -0.01172f, -0.06981f, -0.03467f,
--0.16246f, -0.94721f, -0.27640f, -0.01172f, -0.06981f, -0.03467f,
--0.16246f, -0.94721f, -0.27640f, 0.00000f, -0.08101f, -0.03138f,
-0.00000f, -0.85065f, -0.52574f, 0.00000f, -0.08101f, -0.03138f,
-0.16246f, -0.94721f, -0.27640f, 0.00000f, -0.08101f, -0.03138f,
-0.00000f, -0.85065f, -0.52574f, 0.01172f, -0.06981f, -0.03467f,
-0.29524f, -0.81273f, -0.50230f, 0.01172f, -0.06981f, -0.03467f,
-0.16246f, -0.94721f, -0.27640f, 0.01172f, -0.06981f, -0.03467f,
-0.16246f, -0.94721f, -0.27640f, 0.02294f, -0.06670f, -0.02622f,
-0.29524f, -0.81273f, -0.50230f, 0.02294f, -0.06670f, -0.02622f,
-0.44286f, -0.86070f, -0.25115f, 0.02294f, -0.06670f, -0.02622f,
-0.29524f, -0.81273f, -0.50230f, 0.02503f, -0.04976f, -0.02421f,
-0.52573f, -0.72361f, -0.44722f, 0.02503f, -0.04976f, -0.02421f,
-0.44286f, -0.86070f, -0.25115f, 0.02503f, -0.04976f, -0.02421f,
-0.44286f, -0.60955f, -0.65752f, 0.03402f, -0.03737f, -0.03368f,
-0.68171f, -0.53194f, -0.50230f, 0.03402f, -0.03737f, -0.03368f,
-0.52573f, -0.72361f, -0.44722f, 0.03402f, -0.03737f, -0.03368f,
-0.30901f, -0.42532f, -0.85065f, 0.03567f, -0.03684f, -0.05986f,
-0.58778f, -0.36180f, -0.72361f, 0.03567f, -0.03684f, -0.05986f,
-0.44286f, -0.60955f, -0.65752f, 0.03567f, -0.03684f, -0.05986f,
-0.14762f, -0.20318f, -0.96795f, 0.02395f, -0.02071f, -0.07218f,
-0.42532f, -0.13820f, -0.89443f, 0.02395f, -0.02071f, -0.07218f,
-0.30901f, -0.42532f, -0.85065f, 0.02395f, -0.02071f, -0.07218f,
-0.44286f, -0.60955f, -0.65752f, 0.04358f, -0.03828f, -0.04793f,
-0.58778f, -0.36180f, -0.72361f, 0.04358f, -0.03828f, -0.04793f,
-0.68171f, -0.53194f, -0.50230f, 0.04358f, -0.03828f, -0.04793f,
-0.58778f, -0.36180f, -0.72361f, 0.05556f, -0.03037f, -0.04693f,
-0.80901f, -0.26287f, -0.52574f, 0.05556f, -0.03037f, -0.04693f,
-0.68171f, -0.53194f, -0.50230f, 0.05556f, -0.03037f, -0.04693f,
-0.30901f, -0.42532f, -0.85065f, 0.03926f, -0.02698f, -0.07265f,
-0.42532f, -0.13820f, -0.89443f, 0.03926f, -0.02698f, -0.07265f,
-0.58778f, -0.36180f, -0.72361f, 0.03926f, -0.02698f, -0.07265f,
-0.42532f, -0.13820f, -0.89443f, 0.05279f, -0.01715f, -0.07265f,
-0.68819f, -0.05279f, -0.72361f, 0.05279f, -0.01715f, -0.07265f,
-0.58778f, -0.36180f, -0.72361f, 0.05279f, -0.01715f, -0.07265f,
-0.58778f, -0.36180f, -0.72361f, 0.06115f, -0.01987f, -0.05843f,
-0.68819f, -0.05279f, -0.72361f, 0.06115f, -0.01987f, -0.05843f,
-0.80901f, -0.26287f, -0.52574f, 0.06115f, -0.01987f, -0.05843f,
-0.68819f, -0.05279f, -0.72361f, 0.06280f, -0.00809f, -0.04693f,
-0.86418f, 0.02964f, -0.50230f, 0.06280f, -0.00809f, -0.04693f,
-0.80901f, -0.26287f, -0.52574f, 0.06280f, -0.00809f, -0.04693f,
-0.14762f, -0.20318f, -0.96795f, 0.02064f, -0.00671f, -0.07205f,
-0.23885f, 0.07761f, -0.96795f, 0.02064f, -0.00671f, -0.07205f,
-0.42532f, -0.13820f, -0.89443f, 0.02064f, -0.00671f, -0.07205f,
-0.23885f, 0.07761f, -0.96795f, 0.03155f, 0.00267f, -0.07218f,
-0.49999f, 0.16246f, -0.85065f, 0.03155f, 0.00267f, -0.07218f,
-0.42532f, -0.13820f, -0.89443f, 0.03155f, 0.00267f, -0.07218f,
-0.42532f, -0.13820f, -0.89443f, 0.04762f, -0.00125f, -0.07265f,
-0.49999f, 0.16246f, -0.85065f, 0.04762f, -0.00125f, -0.07265f,
-0.68819f, -0.05279f, -0.72361f, 0.04762f, -0.00125f, -0.07265f,
-0.49999f, 0.16246f, -0.85065f, 0.05051f, 0.00883f, -0.05986f,
-0.71656f, 0.23282f, -0.65752f, 0.05051f, 0.00883f, -0.05986f,
-0.68819f, -0.05279f, -0.72361f, 0.05051f, 0.00883f, -0.05986f,
-0.68819f, -0.05279f, -0.72361f, 0.05776f, 0.00535f, -0.04793f,
-0.71656f, 0.23282f, -0.65752f, 0.05776f, 0.00535f, -0.04793f,
-0.86418f, 0.02964f, -0.50230f, 0.05776f, 0.00535f, -0.04793f,
-0.71656f, 0.23282f, -0.65752f, 0.04949f, 0.01023f, -0.03368f,
-0.85065f, 0.27639f, -0.44722f, 0.04949f, 0.01023f, -0.03368f,
-0.86418f, 0.02964f, -0.50230f, 0.04949f, 0.01023f, -0.03368f,
-0.71656f, 0.23282f, -0.65752f, 0.04605f, 0.02081f, -0.03368f,
-0.71657f, 0.48397f, -0.50230f, 0.04605f, 0.02081f, -0.03368f,
-0.85065f, 0.27639f, -0.44722f, 0.04605f, 0.02081f, -0.03368f,
-0.49999f, 0.16246f, -0.85065f, 0.04606f, 0.02254f, -0.05986f,
-0.52573f, 0.44721f, -0.72361f, 0.04606f, 0.02254f, -0.05986f,
-0.71656f, 0.23282f, -0.65752f, 0.04606f, 0.02254f, -0.05986f,
-0.23885f, 0.07761f, -0.96795f, 0.02710f, 0.01638f, -0.07218f,
-0.26286f, 0.36180f, -0.89443f, 0.02710f, 0.01638f, -0.07218f,
-0.49999f, 0.16246f, -0.85065f, 0.02710f, 0.01638f, -0.07218f,
-0.71656f, 0.23282f, -0.65752f, 0.04988f, 0.02962f, -0.04793f,
-0.52573f, 0.44721f, -0.72361f, 0.04988f, 0.02962f, -0.04793f,
-0.71657f, 0.48397f, -0.50230f, 0.04988f, 0.02962f, -0.04793f,
-0.52573f, 0.44721f, -0.72361f, 0.04606f, 0.04346f, -0.04693f,
-0.50000f, 0.68819f, -0.52574f, 0.04606f, 0.04346f, -0.04693f,
-0.71657f, 0.48397f, -0.50230f, 0.04606f, 0.04346f, -0.04693f,
-0.49999f, 0.16246f, -0.85065f, 0.03779f, 0.02900f, -0.07265f,
-0.26286f, 0.36180f, -0.89443f, 0.03779f, 0.02900f, -0.07265f,
-0.52573f, 0.44721f, -0.72361f, 0.03779f, 0.02900f, -0.07265f,
-0.26286f, 0.36180f, -0.89443f, 0.03262f, 0.04490f, -0.07265f,
-0.26286f, 0.63819f, -0.72361f, 0.03262f, 0.04490f, -0.07265f,
-0.52573f, 0.44721f, -0.72361f, 0.03262f, 0.04490f, -0.07265f,
-0.52573f, 0.44721f, -0.72361f, 0.03779f, 0.05201f, -0.05843f,
-0.26286f, 0.63819f, -0.72361f, 0.03779f, 0.05201f, -0.05843f,
-0.50000f, 0.68819f, -0.52574f, 0.03779f, 0.05201f, -0.05843f,
-0.26286f, 0.63819f, -0.72361f, 0.02710f, 0.05723f, -0.04693f,
-0.23885f, 0.83105f, -0.50230f, 0.02710f, 0.05723f, -0.04693f,
-0.50000f, 0.68819f, -0.52574f, 0.02710f, 0.05723f, -0.04693f,
-0.23885f, 0.07761f, -0.96795f, 0.01276f, 0.01756f, -0.07205f,
-0.00000f, 0.25115f, -0.96795f, 0.01276f, 0.01756f, -0.07205f,
-0.26286f, 0.36180f, -0.89443f, 0.01276f, 0.01756f, -0.07205f,
-0.00000f, 0.25115f, -0.96795f, 0.00721f, 0.03083f, -0.07218f,
-0.00000f, 0.52573f, -0.85065f, 0.00721f, 0.03083f, -0.07218f,
-0.26286f, 0.36180f, -0.89443f, 0.00721f, 0.03083f, -0.07218f,
-0.26286f, 0.36180f, -0.89443f, 0.01590f, 0.04490f, -0.07265f,
-0.00000f, 0.52573f, -0.85065f, 0.01590f, 0.04490f, -0.07265f,
-0.26286f, 0.63819f, -0.72361f, 0.01590f, 0.04490f, -0.07265f,
-0.00000f, 0.52573f, -0.85065f, 0.00721f, 0.05077f, -0.05986f,
-0.00000f, 0.75344f, -0.65751f, 0.00721f, 0.05077f, -0.05986f,
-0.26286f, 0.63819f, -0.72361f, 0.00721f, 0.05077f, -0.05986f,
-0.26286f, 0.63819f, -0.72361f, 0.01276f, 0.05659f, -0.04793f,
-0.00000f, 0.75344f, -0.65751f, 0.01276f, 0.05659f, -0.04793f,
-0.23885f, 0.83105f, -0.50230f, 0.01276f, 0.05659f, -0.04793f,
-0.00000f, 0.75344f, -0.65751f, 0.00556f, 0.05023f, -0.03367f,
-0.00000f, 0.89443f, -0.44722f, 0.00556f, 0.05023f, -0.03367f,
-0.23885f, 0.83105f, -0.50230f, 0.00556f, 0.05023f, -0.03367f,
-0.00000f, 0.75344f, -0.65751f, -0.00556f, 0.05023f, -0.03367f,
--0.23885f, 0.83105f, -0.50230f, -0.00556f, 0.05023f, -0.03367f,
-0.00000f, 0.89443f, -0.44722f, -0.00556f, 0.05023f, -0.03367f,
-0.00000f, 0.52573f, -0.85065f, -0.00721f, 0.05077f, -0.05986f,
--0.26286f, 0.63819f, -0.72361f, -0.00721f, 0.05077f, -0.05986f,
-0.00000f, 0.75344f, -0.65751f, -0.00721f, 0.05077f, -0.05986f,
-0.00000f, 0.25115f, -0.96795f, -0.00721f, 0.03083f, -0.07218f,
--0.26286f, 0.36180f, -0.89443f, -0.00721f, 0.03083f, -0.07218f,
-0.00000f, 0.52573f, -0.85065f, -0.00721f, 0.03083f, -0.07218f,
-0.00000f, 0.75344f, -0.65751f, -0.01276f, 0.05659f, -0.04793f,
--0.26286f, 0.63819f, -0.72361f, -0.01276f, 0.05659f, -0.04793f,
--0.23885f, 0.83105f, -0.50230f, -0.01276f, 0.05659f, -0.04793f,
--0.26286f, 0.63819f, -0.72361f, -0.02710f, 0.05723f, -0.04693f,
--0.50000f, 0.68819f, -0.52574f, -0.02710f, 0.05723f, -0.04693f,
--0.23885f, 0.83105f, -0.50230f, -0.02710f, 0.05723f, -0.04693f,
-0.00000f, 0.52573f, -0.85065f, -0.01590f, 0.04490f, -0.07265f,
--0.26286f, 0.36180f, -0.89443f, -0.01590f, 0.04490f, -0.07265f,
--0.26286f, 0.63819f, -0.72361f, -0.01590f, 0.04490f, -0.07265f,
--0.26286f, 0.36180f, -0.89443f, -0.03262f, 0.04490f, -0.07265f,
--0.52573f, 0.44721f, -0.72361f, -0.03262f, 0.04490f, -0.07265f,
--0.26286f, 0.63819f, -0.72361f, -0.03262f, 0.04490f, -0.07265f,
--0.26286f, 0.63819f, -0.72361f, -0.03779f, 0.05201f, -0.05843f,
--0.52573f, 0.44721f, -0.72361f, -0.03779f, 0.05201f, -0.05843f,
--0.50000f, 0.68819f, -0.52574f, -0.03779f, 0.05201f, -0.05843f,
--0.52573f, 0.44721f, -0.72361f, -0.04606f, 0.04346f, -0.04693f,
--0.71657f, 0.48397f, -0.50230f, -0.04606f, 0.04346f, -0.04693f,
--0.50000f, 0.68819f, -0.52574f, -0.04606f, 0.04346f, -0.04693f,
-0.00000f, 0.25115f, -0.96795f, -0.01276f, 0.01756f, -0.07205f,
--0.23885f, 0.07761f, -0.96795f, -0.01276f, 0.01756f, -0.07205f,
--0.26286f, 0.36180f, -0.89443f, -0.01276f, 0.01756f, -0.07205f,
--0.23885f, 0.07761f, -0.96795f, -0.02710f, 0.01638f, -0.07218f,
--0.49999f, 0.16246f, -0.85065f, -0.02710f, 0.01638f, -0.07218f,
--0.26286f, 0.36180f, -0.89443f, -0.02710f, 0.01638f, -0.07218f,
--0.26286f, 0.36180f, -0.89443f, -0.03779f, 0.02900f, -0.07265f,
--0.49999f, 0.16246f, -0.85065f, -0.03779f, 0.02900f, -0.07265f,
--0.52573f, 0.44721f, -0.72361f, -0.03779f, 0.02900f, -0.07265f,
--0.49999f, 0.16246f, -0.85065f, -0.04606f, 0.02254f, -0.05986f,
--0.71656f, 0.23282f, -0.65752f, -0.04606f, 0.02254f, -0.05986f,
--0.52573f, 0.44721f, -0.72361f, -0.04606f, 0.02254f, -0.05986f,
--0.52573f, 0.44721f, -0.72361f, -0.04988f, 0.02962f, -0.04793f,
--0.71656f, 0.23282f, -0.65752f, -0.04988f, 0.02962f, -0.04793f,
--0.71657f, 0.48397f, -0.50230f, -0.04988f, 0.02962f, -0.04793f,
--0.71656f, 0.23282f, -0.65752f, -0.04605f, 0.02081f, -0.03368f,
--0.85065f, 0.27639f, -0.44722f, -0.04605f, 0.02081f, -0.03368f,
--0.71657f, 0.48397f, -0.50230f, -0.04605f, 0.02081f, -0.03368f,
-0.29524f, -0.81273f, -0.50230f, 0.02502f, -0.04391f, -0.03367f,
-0.44286f, -0.60955f, -0.65752f, 0.02502f, -0.04391f, -0.03367f,
-0.52573f, -0.72361f, -0.44722f, 0.02502f, -0.04391f, -0.03367f,
-0.00000f, -0.85065f, -0.52574f, 0.01172f, -0.06223f, -0.04693f,
-0.16246f, -0.67082f, -0.72361f, 0.01172f, -0.06223f, -0.04693f,
-0.29524f, -0.81273f, -0.50230f, 0.01172f, -0.06223f, -0.04693f,
--0.29524f, -0.81273f, -0.50230f, -0.01172f, -0.06223f, -0.04693f,
--0.16246f, -0.67082f, -0.72361f, -0.01172f, -0.06223f, -0.04693f,
-0.00000f, -0.85065f, -0.52574f, -0.01172f, -0.06223f, -0.04693f,
-0.29524f, -0.81273f, -0.50230f, 0.02294f, -0.05328f, -0.04793f,
-0.16246f, -0.67082f, -0.72361f, 0.02294f, -0.05328f, -0.04793f,
-0.44286f, -0.60955f, -0.65752f, 0.02294f, -0.05328f, -0.04793f,
-0.16246f, -0.67082f, -0.72361f, 0.02401f, -0.04531f, -0.05986f,
-0.30901f, -0.42532f, -0.85065f, 0.02401f, -0.04531f, -0.05986f,
-0.44286f, -0.60955f, -0.65752f, 0.02401f, -0.04531f, -0.05986f,
-0.00000f, -0.85065f, -0.52574f, 0.00000f, -0.06429f, -0.05843f,
--0.16246f, -0.67082f, -0.72361f, 0.00000f, -0.06429f, -0.05843f,
-0.16246f, -0.67082f, -0.72361f, 0.00000f, -0.06429f, -0.05843f,
--0.16246f, -0.67082f, -0.72361f, -0.00000f, -0.05550f, -0.07265f,
--0.00000f, -0.44721f, -0.89443f, -0.00000f, -0.05550f, -0.07265f,
-0.16246f, -0.67082f, -0.72361f, -0.00000f, -0.05550f, -0.07265f,
-0.16246f, -0.67082f, -0.72361f, 0.01353f, -0.04567f, -0.07265f,
--0.00000f, -0.44721f, -0.89443f, 0.01353f, -0.04567f, -0.07265f,
-0.30901f, -0.42532f, -0.85065f, 0.01353f, -0.04567f, -0.07265f,
--0.00000f, -0.44721f, -0.89443f, 0.01229f, -0.02918f, -0.07218f,
-0.14762f, -0.20318f, -0.96795f, 0.01229f, -0.02918f, -0.07218f,
-0.30901f, -0.42532f, -0.85065f, 0.01229f, -0.02918f, -0.07218f,
--0.29524f, -0.81273f, -0.50230f, -0.02294f, -0.05328f, -0.04793f,
--0.44286f, -0.60955f, -0.65752f, -0.02294f, -0.05328f, -0.04793f,
--0.16246f, -0.67082f, -0.72361f, -0.02294f, -0.05328f, -0.04793f,
--0.44286f, -0.60955f, -0.65752f, -0.02401f, -0.04531f, -0.05986f,
--0.30901f, -0.42532f, -0.85065f, -0.02401f, -0.04531f, -0.05986f,
--0.16246f, -0.67082f, -0.72361f, -0.02401f, -0.04531f, -0.05986f,
--0.16246f, -0.67082f, -0.72361f, -0.01353f, -0.04567f, -0.07265f,
--0.30901f, -0.42532f, -0.85065f, -0.01353f, -0.04567f, -0.07265f,
--0.00000f, -0.44721f, -0.89443f, -0.01353f, -0.04567f, -0.07265f,
--0.30901f, -0.42532f, -0.85065f, -0.01229f, -0.02918f, -0.07218f,
--0.14762f, -0.20318f, -0.96795f, -0.01229f, -0.02918f, -0.07218f,
--0.00000f, -0.44721f, -0.89443f, -0.01229f, -0.02918f, -0.07218f,
--0.00000f, -0.44721f, -0.89443f, 0.00000f, -0.02171f, -0.07205f,
--0.14762f, -0.20318f, -0.96795f, 0.00000f, -0.02171f, -0.07205f,
-0.14762f, -0.20318f, -0.96795f, 0.00000f, -0.02171f, -0.07205f,
--0.14762f, -0.20318f, -0.96795f, 0.00000f, -0.00946f, -0.05999f,
-0.00000f, 0.00000f, -1.00000f, 0.00000f, -0.00946f, -0.05999f,
-0.14762f, -0.20318f, -0.96795f, 0.00000f, -0.00946f, -0.05999f,
--0.71656f, 0.23282f, -0.65752f, -0.04949f, 0.01023f, -0.03368f,
--0.86418f, 0.02964f, -0.50230f, -0.04949f, 0.01023f, -0.03368f,
--0.85065f, 0.27639f, -0.44722f, -0.04949f, 0.01023f, -0.03368f,
--0.49999f, 0.16246f, -0.85065f, -0.05051f, 0.00883f, -0.05986f,
--0.68818f, -0.05279f, -0.72361f, -0.05051f, 0.00883f, -0.05986f,
--0.71656f, 0.23282f, -0.65752f, -0.05051f, 0.00883f, -0.05986f,
--0.23885f, 0.07761f, -0.96795f, -0.03155f, 0.00267f, -0.07218f,
--0.42532f, -0.13820f, -0.89443f, -0.03155f, 0.00267f, -0.07218f,
--0.49999f, 0.16246f, -0.85065f, -0.03155f, 0.00267f, -0.07218f,
--0.71656f, 0.23282f, -0.65752f, -0.05776f, 0.00535f, -0.04793f,
--0.68818f, -0.05279f, -0.72361f, -0.05776f, 0.00535f, -0.04793f,
--0.86418f, 0.02964f, -0.50230f, -0.05776f, 0.00535f, -0.04793f,
--0.68818f, -0.05279f, -0.72361f, -0.06280f, -0.00809f, -0.04693f,
--0.80901f, -0.26287f, -0.52574f, -0.06280f, -0.00809f, -0.04693f,
--0.86418f, 0.02964f, -0.50230f, -0.06280f, -0.00809f, -0.04693f,
--0.49999f, 0.16246f, -0.85065f, -0.04762f, -0.00125f, -0.07265f,
--0.42532f, -0.13820f, -0.89443f, -0.04762f, -0.00125f, -0.07265f,
--0.68818f, -0.05279f, -0.72361f, -0.04762f, -0.00125f, -0.07265f,
--0.42532f, -0.13820f, -0.89443f, -0.05279f, -0.01715f, -0.07265f,
--0.58778f, -0.36180f, -0.72361f, -0.05279f, -0.01715f, -0.07265f,
--0.68818f, -0.05279f, -0.72361f, -0.05279f, -0.01715f, -0.07265f,
--0.68818f, -0.05279f, -0.72361f, -0.06115f, -0.01987f, -0.05843f,
--0.58778f, -0.36180f, -0.72361f, -0.06115f, -0.01987f, -0.05843f,
--0.80901f, -0.26287f, -0.52574f, -0.06115f, -0.01987f, -0.05843f,
--0.58778f, -0.36180f, -0.72361f, -0.05556f, -0.03037f, -0.04693f,
--0.68171f, -0.53194f, -0.50230f, -0.05556f, -0.03037f, -0.04693f,
--0.80901f, -0.26287f, -0.52574f, -0.05556f, -0.03037f, -0.04693f,
--0.23885f, 0.07761f, -0.96795f, -0.02064f, -0.00671f, -0.07205f,
--0.14762f, -0.20318f, -0.96795f, -0.02064f, -0.00671f, -0.07205f,
--0.42532f, -0.13820f, -0.89443f, -0.02064f, -0.00671f, -0.07205f,
--0.14762f, -0.20318f, -0.96795f, -0.02395f, -0.02071f, -0.07218f,
--0.30901f, -0.42532f, -0.85065f, -0.02395f, -0.02071f, -0.07218f,
--0.42532f, -0.13820f, -0.89443f, -0.02395f, -0.02071f, -0.07218f,
--0.42532f, -0.13820f, -0.89443f, -0.03926f, -0.02698f, -0.07265f,
--0.30901f, -0.42532f, -0.85065f, -0.03926f, -0.02698f, -0.07265f,
--0.58778f, -0.36180f, -0.72361f, -0.03926f, -0.02698f, -0.07265f,
--0.30901f, -0.42532f, -0.85065f, -0.03567f, -0.03684f, -0.05986f,
--0.44286f, -0.60955f, -0.65752f, -0.03567f, -0.03684f, -0.05986f,
--0.58778f, -0.36180f, -0.72361f, -0.03567f, -0.03684f, -0.05986f,
--0.58778f, -0.36180f, -0.72361f, -0.04358f, -0.03828f, -0.04793f,
--0.44286f, -0.60955f, -0.65752f, -0.04358f, -0.03828f, -0.04793f,
--0.68171f, -0.53194f, -0.50230f, -0.04358f, -0.03828f, -0.04793f,
--0.44286f, -0.60955f, -0.65752f, -0.03402f, -0.03737f, -0.03368f,
--0.52573f, -0.72361f, -0.44722f, -0.03402f, -0.03737f, -0.03368f,
--0.68171f, -0.53194f, -0.50230f, -0.03402f, -0.03737f, -0.03368f,
+const int SphereSubdivisions = 2;
 
-};
\ No newline at end of file
+// The corners of an icosahedron, with a vertex at each pole and two rings of 5 in between
+const float SphereIcosahedronVertices[12][3] = {
+	{ 0.0f, 0.0f, 1.0f },
+	{ 0.894427f, 0.0f, 0.447214f },
+	{ 0.276393f, 0.850651f, 0.447214f },
+	{ -0.723607f, 0.525731f, 0.447214f },
+	{ -0.723607f, -0.525731f, 0.447214f },
+	{ 0.276393f, -0.850651f, 0.447214f },
+	{ 0.723607f, 0.525731f, -0.447214f },
+	{ -0.276393f, 0.850651f, -0.447214f },
+	{ -0.894427f, 0.0f, -0.447214f },
+	{ -0.276393f, -0.850651f, -0.447214f },
+	{ 0.723607f, -0.525731f, -0.447214f },
+	{ 0.0f, 0.0f, -1.0f }
+};
+
+// The faces of the icosahedron, wound counter-clockwise when viewed from outside
+const unsigned char SphereIcosahedronFaces[20][3] = {
+	{ 0, 1, 2 }, { 0, 2, 3 }, { 0, 3, 4 }, { 0, 4, 5 }, { 0, 5, 1 },
+	{ 1, 6, 2 }, { 2, 6, 7 }, { 2, 7, 3 }, { 3, 7, 8 }, { 3, 8, 4 },
+	{ 4, 8, 9 }, { 4, 9, 5 }, { 5, 9, 10 }, { 5, 10, 1 }, { 1, 10, 6 },
+	{ 11, 7, 6 }, { 11, 8, 7 }, { 11, 9, 8 }, { 11, 10, 9 }, { 11, 6, 10 }
+};
@@ -13,6 +13,7 @@
 //////////////////////////////////////////////////////////////////////////
 #pragma once
 
+#include <vector>
 #include <GLM/glm.hpp>
 #include "FontRenderer.h"
 
@@ -35,6 +36,22 @@ namespace TTK
 			glm::vec4 Color;
 			float     Size;
 		};
+
+		/*
+		 * Counters for the data streamed to the GPU by the batched primitives, these are
+		 * totals since the context was created or the stats were last reset
+		 */
+		struct StreamStats
+		{
+			// The number of bytes of vertex data copied into the ring buffers
+			size_t BytesStreamed = 0;
+			// The number of draw calls issued for lines, triangles and points
+			size_t DrawCalls = 0;
+			// The number of times we had to stall waiting for the GPU to finish with a section of the ring
+			size_t FencesWaited = 0;
+			// The number of times a ring buffer had to be re-allocated to fit a frame's worth of primitives
+			size_t Reallocations = 0;
+		};
 		
 		inline static Context& Instance() {
 			if (m_Instance == nullptr)
@@ -74,8 +91,15 @@ namespace TTK
 		void AddQuad(const glm::vec3& min, const glm::vec3& max, const glm::vec4& color = { 0, 0, 0, 1 });
 		void AddPoint(const glm::vec3& pos, float size, const glm::vec4& color = { 0, 0, 0, 1 });
 		
+		/*
+		 * Draws all the meshes, lines, triangles and points added since the last flush, with one
+		 * draw call per mesh or primitive type. This should usually be called once per frame
+		 */
 		void Flush();
 
+		const StreamStats& GetStreamStats() const { return m_Stats; }
+		void ResetStreamStats() { m_Stats = StreamStats(); }
+
 	private:
 		Context();
 		glm::mat4				  m_Projection;
@@ -86,28 +110,39 @@ namespace TTK
 
 		GLuint m_ShaderHandle;
 		GLuint m_PointShaderHandle;
+
+		// Each primitive type streams into a persistently mapped buffer split into this many sections,
+		// so that we can write one frame while the GPU is still reading the last couple
+		static const size_t RingFrames = 3;
+
 		struct GLBuff {
 			GLuint VBO, VAO;
-			size_t Count;
+			size_t Capacity; // The number of elements in each section of the ring
 			size_t ElemSize;
 			GLenum Mode;
-			void*  Data;
 			GLuint Shader;
+			uint8_t* Mapped;
 		};
 		GLBuff m_Tris, m_Lines, m_Points;
+		GLsync m_Fences[RingFrames];
+		size_t m_FrameIndex;
+		StreamStats m_Stats;
 
 		int m_WindowWidth, m_WindowHeight;
 
-		GLBuff __InitBuff(GLenum mode, GLuint shader, void* dataSource, size_t elemSize, size_t maxElems);
-		void __Flush(GLBuff& buff);
+		GLBuff __InitBuff(GLenum mode, GLuint shader, size_t elemSize, size_t initialElems);
+		void __AllocateRing(GLBuff& buff, size_t capacity);
+		void __FreeRing(GLBuff& buff);
+		void __Flush(GLBuff& buff, const void* data, size_t count);
 		GLuint __CompileShader(const char* vsSource, const char* fsSource);
 
-		static const size_t MaxPointVerts = 512;
-		static const size_t MaxLineVerts = 512 * 2;
-		static const size_t MaxTriVerts = 512 * 3;
+		// The initial size of each ring section, these will grow as needed
+		static const size_t InitialPointVerts = 512;
+		static const size_t InitialLineVerts = 512 * 2;
+		static const size_t InitialTriVerts = 512 * 3;
 
-		PointVert  m_PointVerts[MaxPointVerts];
-		SimpleVert m_LineVerts[MaxLineVerts];
-		SimpleVert m_TriVerts[MaxTriVerts];
+		std::vector<PointVert>  m_PointVerts;
+		std::vector<SimpleVert> m_LineVerts;
+		std::vector<SimpleVert> m_TriVerts;
 	};
 }
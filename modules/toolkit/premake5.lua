@@ -29,7 +29,8 @@ project "toolkit"
         "%{wks.location}\\dependencies\\glad\\include",
         "%{wks.location}\\dependencies\\glfw3\\include",
         "%{wks.location}\\dependencies\\imgui",
-        "%{wks.location}\\dependencies\\stbs"
+        "%{wks.location}\\dependencies\\stbs",
+        "%{wks.location}\\dependencies\\json"
     }
 
     disablewarnings {
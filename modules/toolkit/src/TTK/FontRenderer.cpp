@@ -15,6 +15,8 @@
 #include "Logging.h"
 #include <GLM/gtc/matrix_transform.hpp>
 #include "TTK/TTKContext.h"
+#include "TTK/GLStateCache.h"
+#include "TTK/ProgramBinaryCache.h"
 
 // Implementaiton of readFile
 char* readFile(const char* filename) {
@@ -197,6 +199,7 @@ glm::vec2 TTK::TrueTypeTextureFont::MeausureString(const char* text, const float
 
 TTK::FontRenderer::~FontRenderer()
 {
+	GLStateCache::Instance().OnVertexArrayDeleted(m_VAO);
 	glDeleteShader(m_ShaderHandle);
 	glDeleteVertexArrays(1, &m_VAO);
 }
@@ -273,25 +276,25 @@ void TTK::FontRenderer::Render(const TrueTypeTextureFont& font, const char* text
 	length = quads;
 
 	// Update and render our meshes
-	bool blendState = glIsEnabled(GL_BLEND);
-	GLboolean depthMaskEnabled = false;
-	glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMaskEnabled);
-	glDepthMask(GL_FALSE);
-	glEnable(GL_BLEND);
-	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
+	GLStateCache& state = GLStateCache::Instance();
+	bool blendState = state.IsEnabled(GL_BLEND);
+	bool depthMaskEnabled = state.GetDepthMask();
+	state.SetDepthMask(false);
+	state.SetEnabled(GL_BLEND, true);
+	state.SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
 	glGetError();
 	glm::mat4 proj = TTK::Context::Instance().GetOrthoProjection();
-	glUseProgram(m_ShaderHandle);
+	state.UseProgram(m_ShaderHandle);
 	glProgramUniformMatrix4fv(m_ShaderHandle, 0, 1, false, &proj[0][0]);
 	glProgramUniformHandleui64ARB(m_ShaderHandle, 1, font.m_TexHandle);	
-	glBindVertexArray(m_VAO);
+	state.BindVertexArray(m_VAO);
 	glNamedBufferSubData(m_VBO, 0, length * 4 * sizeof(Vert), m_MeshData);
 	glNamedBufferSubData(m_EBO, 0, length * 6 * sizeof(GLuint), m_IndexData);
 	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(length * 6), GL_UNSIGNED_INT, nullptr);
-	glBindVertexArray(0);
+	state.BindVertexArray(0);
 	LOG_ASSERT(glGetError() == GL_NONE, "Failed to draw our text mesh!");
-	if (!blendState) glDisable(GL_BLEND);
-	glDepthMask(depthMaskEnabled);
+	if (!blendState) state.SetEnabled(GL_BLEND, false);
+	state.SetDepthMask(depthMaskEnabled);
 }
 
 TTK::FontRenderer::FontRenderer() {
@@ -300,13 +303,14 @@ TTK::FontRenderer::FontRenderer() {
 	memset(m_MeshData, 0, sizeof(m_MeshData));
 	memset(m_IndexData, 0, sizeof(m_IndexData));
 
+	GLStateCache& state = GLStateCache::Instance();
 	glCreateVertexArrays(1, &m_VAO);
-	glBindVertexArray(m_VAO);
+	state.BindVertexArray(m_VAO);
 	GLuint buffers[2];
 	glCreateBuffers(2, buffers);
-	glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+	state.BindBuffer(GL_ARRAY_BUFFER, buffers[0]);
 	glNamedBufferData(buffers[0], 256 * 4 * sizeof(Vert), m_MeshData, GL_DYNAMIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+	state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
 	glNamedBufferData(buffers[1], 256 * 6 * sizeof(GLuint), m_IndexData, GL_DYNAMIC_DRAW);
 	glEnableVertexAttribArray(0);
 	glEnableVertexAttribArray(1);
@@ -319,7 +323,7 @@ TTK::FontRenderer::FontRenderer() {
 	glVertexAttribPointer(2, 2, GL_FLOAT, false, sizeof(Vert), &v->UV);
 	#pragma warning(pop)
 	
-	glBindVertexArray(0);
+	state.BindVertexArray(0);
 
 	m_VBO = buffers[0];
 	m_EBO = buffers[1];
@@ -348,30 +352,9 @@ TTK::FontRenderer::FontRenderer() {
 				frag_color.a = texture2D(xSampler, fragUv).r;
             })LIT";
 
-	m_ShaderHandle = glCreateProgram();
+	m_ShaderHandle = ProgramBinaryCache::Instance().CreateProgram(vsSource, fsSource);
 
-	GLuint programs[2];
-	programs[0] = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(programs[0], 1, &vsSource, NULL);
-	glCompileShader(programs[0]);
-	programs[1] = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(programs[1], 1, &fsSource, NULL);
-	glCompileShader(programs[1]);
-	
-	// Attach our two shaders
-	glAttachShader(m_ShaderHandle, programs[0]);
-	glAttachShader(m_ShaderHandle, programs[1]);
-
-	// Perform linking
-	glLinkProgram(m_ShaderHandle);
-
-	// Remove shader parts to save space
-	glDetachShader(m_ShaderHandle, programs[0]);
-	glDeleteShader(programs[0]);
-	glDetachShader(m_ShaderHandle, programs[1]);
-	glDeleteShader(programs[1]);
-
-	glBindVertexArray(0);
+	state.BindVertexArray(0);
 	
 	LOG_INFO("Done initilaizing font renderer");
 }
@@ -0,0 +1,25 @@
+#include "TTK/GLFence.h"
+#include "Logging.h"
+
+bool TTK::WaitForFence(GLsync& fence)
+{
+	if (fence == nullptr) {
+		return false;
+	}
+
+	// Poll first, so that we only report the times where the GPU is actually behind
+	bool blocked = false;
+	GLenum status = glClientWaitSync(fence, 0, 0);
+	if (status == GL_TIMEOUT_EXPIRED) {
+		blocked = true;
+		do {
+			status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms
+		} while (status == GL_TIMEOUT_EXPIRED);
+	}
+	if (status == GL_WAIT_FAILED) {
+		LOG_WARN("Failed to wait on fence");
+	}
+	glDeleteSync(fence);
+	fence = nullptr;
+	return blocked;
+}
@@ -0,0 +1,235 @@
+#include "TTK/GLStateCache.h"
+
+namespace TTK {
+	GLStateCache& GLStateCache::Instance() {
+		static GLStateCache instance;
+		return instance;
+	}
+
+	GLStateCache::GLStateCache() :
+		m_FrameStats({ 0, 0 }),
+		m_LastFrameStats({ 0, 0 })
+	{
+		Invalidate();
+	}
+
+	void GLStateCache::UseProgram(GLuint program) {
+		if (m_Program == program) return __Skip();
+		m_Program = program;
+		glUseProgram(program);
+		__Issue();
+	}
+
+	void GLStateCache::BindVertexArray(GLuint vao) {
+		if (m_VAO == vao) return __Skip();
+		m_VAO = vao;
+		// The element array binding is part of the VAO, so we no longer know what it is
+		m_Buffers[__GetBufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = Unknown;
+		glBindVertexArray(vao);
+		__Issue();
+	}
+
+	void GLStateCache::BindTexture(GLuint unit, GLuint texture) {
+		if (unit < MaxTextureUnits) {
+			if (m_Textures[unit] == texture) return __Skip();
+			m_Textures[unit] = texture;
+		}
+		glBindTextureUnit(unit, texture);
+		__Issue();
+	}
+
+	void GLStateCache::ActiveTexture(GLuint unit) {
+		if (m_ActiveTexture == unit) return __Skip();
+		m_ActiveTexture = unit;
+		glActiveTexture(GL_TEXTURE0 + unit);
+		__Issue();
+	}
+
+	void GLStateCache::BindBuffer(GLenum target, GLuint buffer) {
+		int slot = __GetBufferSlot(target);
+		if (slot >= 0) {
+			if (m_Buffers[slot] == buffer) return __Skip();
+			m_Buffers[slot] = buffer;
+		}
+		glBindBuffer(target, buffer);
+		__Issue();
+	}
+
+	void GLStateCache::BindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+		int slot = __GetIndexedSlot(target);
+		if (slot >= 0 && index < MaxIndexedBindings) {
+			IndexedBinding& binding = m_IndexedBuffers[slot][index];
+			// A size of 0 marks a whole buffer binding, since a range can never be empty
+			if (binding.Buffer == buffer && binding.Offset == 0 && binding.Size == 0) return __Skip();
+			binding = { buffer, 0, 0 };
+		}
+		// Binding to an indexed target also replaces the generic binding for that target
+		int generic = __GetBufferSlot(target);
+		if (generic >= 0) m_Buffers[generic] = buffer;
+		glBindBufferBase(target, index, buffer);
+		__Issue();
+	}
+
+	void GLStateCache::BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+		int slot = __GetIndexedSlot(target);
+		if (slot >= 0 && index < MaxIndexedBindings) {
+			IndexedBinding& binding = m_IndexedBuffers[slot][index];
+			if (binding.Buffer == buffer && binding.Offset == offset && binding.Size == size) return __Skip();
+			binding = { buffer, offset, size };
+		}
+		int generic = __GetBufferSlot(target);
+		if (generic >= 0) m_Buffers[generic] = buffer;
+		glBindBufferRange(target, index, buffer, offset, size);
+		__Issue();
+	}
+
+	void GLStateCache::SetEnabled(GLenum cap, bool enabled) {
+		int slot = __GetCapSlot(cap);
+		if (slot >= 0) {
+			if (m_Caps[slot] == (int8_t)enabled) return __Skip();
+			m_Caps[slot] = (int8_t)enabled;
+		}
+		if (enabled)
+			glEnable(cap);
+		else
+			glDisable(cap);
+		__Issue();
+	}
+
+	bool GLStateCache::IsEnabled(GLenum cap) {
+		int slot = __GetCapSlot(cap);
+		if (slot < 0) {
+			return glIsEnabled(cap);
+		}
+		if (m_Caps[slot] == UnknownFlag) {
+			m_Caps[slot] = glIsEnabled(cap) ? 1 : 0;
+		}
+		return m_Caps[slot] == 1;
+	}
+
+	void GLStateCache::SetDepthMask(bool enabled) {
+		if (m_DepthMask == (int8_t)enabled) return __Skip();
+		m_DepthMask = (int8_t)enabled;
+		glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+		__Issue();
+	}
+
+	bool GLStateCache::GetDepthMask() {
+		if (m_DepthMask == UnknownFlag) {
+			GLboolean result = GL_TRUE;
+			glGetBooleanv(GL_DEPTH_WRITEMASK, &result);
+			m_DepthMask = result ? 1 : 0;
+		}
+		return m_DepthMask == 1;
+	}
+
+	void GLStateCache::SetDepthFunc(GLenum func) {
+		if (m_DepthFunc == func) return __Skip();
+		m_DepthFunc = func;
+		glDepthFunc(func);
+		__Issue();
+	}
+
+	void GLStateCache::SetCullFace(GLenum face) {
+		if (m_CullFace == face) return __Skip();
+		m_CullFace = face;
+		glCullFace(face);
+		__Issue();
+	}
+
+	void GLStateCache::SetBlendFunc(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha) {
+		if (m_BlendFunc[0] == srcRGB && m_BlendFunc[1] == dstRGB &&
+			m_BlendFunc[2] == srcAlpha && m_BlendFunc[3] == dstAlpha) return __Skip();
+		m_BlendFunc[0] = srcRGB;
+		m_BlendFunc[1] = dstRGB;
+		m_BlendFunc[2] = srcAlpha;
+		m_BlendFunc[3] = dstAlpha;
+		glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+		__Issue();
+	}
+
+	void GLStateCache::OnProgramDeleted(GLuint program) {
+		// A deleted program stays in use until something else is bound, so we can't assume 0 here
+		if (m_Program == program) m_Program = Unknown;
+	}
+
+	void GLStateCache::OnVertexArrayDeleted(GLuint vao) {
+		if (m_VAO == vao) {
+			m_VAO = Unknown;
+			m_Buffers[__GetBufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = Unknown;
+		}
+	}
+
+	void GLStateCache::OnTextureDeleted(GLuint texture) {
+		for (GLuint& bound : m_Textures) {
+			if (bound == texture) bound = Unknown;
+		}
+	}
+
+	void GLStateCache::OnBufferDeleted(GLuint buffer) {
+		for (GLuint& bound : m_Buffers) {
+			if (bound == buffer) bound = Unknown;
+		}
+		for (auto& target : m_IndexedBuffers) {
+			for (IndexedBinding& binding : target) {
+				if (binding.Buffer == buffer) binding = { Unknown, 0, 0 };
+			}
+		}
+	}
+
+	void GLStateCache::Invalidate() {
+		m_Program = Unknown;
+		m_VAO = Unknown;
+		m_ActiveTexture = Unknown;
+		for (GLuint& texture : m_Textures) texture = Unknown;
+		for (GLuint& buffer : m_Buffers) buffer = Unknown;
+		for (auto& target : m_IndexedBuffers) {
+			for (IndexedBinding& binding : target) binding = { Unknown, 0, 0 };
+		}
+		for (int8_t& cap : m_Caps) cap = UnknownFlag;
+		m_DepthMask = UnknownFlag;
+		m_DepthFunc = Unknown;
+		m_CullFace = Unknown;
+		for (GLenum& factor : m_BlendFunc) factor = Unknown;
+	}
+
+	void GLStateCache::EndFrame() {
+		m_LastFrameStats = m_FrameStats;
+		m_FrameStats = { 0, 0 };
+	}
+
+	int GLStateCache::__GetBufferSlot(GLenum target) {
+		switch (target) {
+			case GL_ARRAY_BUFFER:          return 0;
+			case GL_ELEMENT_ARRAY_BUFFER:  return 1;
+			case GL_UNIFORM_BUFFER:        return 2;
+			case GL_SHADER_STORAGE_BUFFER: return 3;
+			case GL_PIXEL_PACK_BUFFER:     return 4;
+			case GL_PIXEL_UNPACK_BUFFER:   return 5;
+			case GL_DRAW_INDIRECT_BUFFER:  return 6;
+			case GL_COPY_READ_BUFFER:      return 7;
+			case GL_COPY_WRITE_BUFFER:     return 8;
+			default:                       return -1;
+		}
+	}
+
+	int GLStateCache::__GetIndexedSlot(GLenum target) {
+		switch (target) {
+			case GL_UNIFORM_BUFFER:        return 0;
+			case GL_SHADER_STORAGE_BUFFER: return 1;
+			default:                       return -1;
+		}
+	}
+
+	int GLStateCache::__GetCapSlot(GLenum cap) {
+		switch (cap) {
+			case GL_DEPTH_TEST:         return 0;
+			case GL_CULL_FACE:          return 1;
+			case GL_BLEND:              return 2;
+			case GL_SCISSOR_TEST:       return 3;
+			case GL_STENCIL_TEST:       return 4;
+			case GL_PROGRAM_POINT_SIZE: return 5;
+			default:                    return -1;
+		}
+	}
+}
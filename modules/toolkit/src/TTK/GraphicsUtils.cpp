@@ -13,6 +13,7 @@
 
 #include "TTK/GraphicsUtils.h"
 #include "TTK/TTKContext.h"
+#include "TTK/GLStateCache.h"
 #include <GLM/gtc/matrix_transform.inl>
 
 #include "imgui.h"
@@ -39,10 +40,7 @@ void TTK::Graphics::SetCameraMode3D(int windowWidth, int windowHeight) {
 }
 
 void TTK::Graphics::SetDepthEnabled(bool isEnabled) {
-	if (isEnabled)
-		glEnable(GL_DEPTH_TEST);
-	else
-		glDisable(GL_DEPTH_TEST);
+	GLStateCache::Instance().SetEnabled(GL_DEPTH_TEST, isEnabled);
 }
 
 void TTK::Graphics::SetCameraMatrix(const glm::mat4& view) {
@@ -63,6 +61,7 @@ void TTK::Graphics::ClearScreen() {
 
 void TTK::Graphics::EndFrame() {
 	TTK::Context::Instance().Flush();
+	GLStateCache::Instance().EndFrame();
 }
 
 void TTK::Graphics::DrawGrid(float gridWidth, AlignMode mode) {
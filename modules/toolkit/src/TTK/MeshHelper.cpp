@@ -14,128 +14,297 @@
 #include "TTK/Teapot.h"
 #include "TTK/Sphere.h"
 #include "TTK/Cube.h"
+#include "TTK/GLStateCache.h"
+#include "TTK/ProgramBinaryCache.h"
 #include "Logging.h"
 
+#include <unordered_map>
+
 
 TTK::Impl::MeshHelper::~MeshHelper() {
+	GLStateCache& state = GLStateCache::Instance();
+	for (const mesh* mesh : { &m_Teapot, &m_Sphere, &m_Cube }) {
+		state.OnBufferDeleted(mesh->VBO);
+		state.OnBufferDeleted(mesh->EBO);
+		state.OnVertexArrayDeleted(mesh->VAO);
+	}
+	state.OnBufferDeleted(m_InstanceBuffer);
+	state.OnProgramDeleted(m_Shader);
 	glDeleteBuffers(1, &m_Teapot.VBO);
 	glDeleteBuffers(1, &m_Sphere.VBO);
 	glDeleteBuffers(1, &m_Cube.VBO);
+	glDeleteBuffers(1, &m_Teapot.EBO);
+	glDeleteBuffers(1, &m_Sphere.EBO);
+	glDeleteBuffers(1, &m_Cube.EBO);
+	glDeleteBuffers(1, &m_InstanceBuffer);
 	glDeleteVertexArrays(1, &m_Teapot.VAO);
 	glDeleteVertexArrays(1, &m_Sphere.VAO);
 	glDeleteVertexArrays(1, &m_Cube.VAO);
 	glDeleteProgram(m_Shader);
 }
 
-void TTK::Impl::MeshHelper::RenderTeapot(const glm::mat4& transform, const glm::vec4& color) const {
-	glUseProgram(m_Shader);
-	glm::mat4 t = Context::Instance().GetViewProjection() * transform;
-	glProgramUniformMatrix4fv(m_Shader, 0, 1, FALSE, &t[0][0]);
-	glProgramUniform4fv(m_Shader, 1, 1, &color[0]);
-	glBindVertexArray(m_Teapot.VAO);
-	glDrawArrays(GL_TRIANGLES, 0, sizeof(TeapotData) / (sizeof(float) * 6));
+void TTK::Impl::MeshHelper::RenderTeapot(const glm::mat4& transform, const glm::vec4& color) {
+	__AddInstance(m_Teapot, transform, color);
 }
 
-void TTK::Impl::MeshHelper::RenderSphere(const glm::mat4& transform, const glm::vec4& color) const {
-	glUseProgram(m_Shader);
-	glm::mat4 t = Context::Instance().GetViewProjection() * transform;
-	glProgramUniformMatrix4fv(m_Shader, 0, 1, FALSE, &t[0][0]);
-	glProgramUniform4fv(m_Shader, 1, 1, &color[0]);
-	glBindVertexArray(m_Sphere.VAO);
-	glDrawArrays(GL_TRIANGLES, 0, sizeof(SphereData) / (sizeof(float) * 6));
+void TTK::Impl::MeshHelper::RenderSphere(const glm::mat4& transform, const glm::vec4& color) {
+	__AddInstance(m_Sphere, transform, color);
 }
 
-void TTK::Impl::MeshHelper::RenderCube(const glm::mat4& transform, const glm::vec4& color) const
+void TTK::Impl::MeshHelper::RenderCube(const glm::mat4& transform, const glm::vec4& color)
 {
-	glUseProgram(m_Shader);
-	glm::mat4 t = Context::Instance().GetViewProjection() * transform;
-	glProgramUniformMatrix4fv(m_Shader, 0, 1, FALSE, &t[0][0]);
-	glProgramUniform4fv(m_Shader, 1, 1, &color[0]);
-	glBindVertexArray(m_Cube.VAO);
-	glDrawArrays(GL_TRIANGLES, 0, sizeof(CubeData) / (sizeof(float) * 6));
+	__AddInstance(m_Cube, transform, color);
+}
+
+void TTK::Impl::MeshHelper::__AddInstance(mesh& mesh, const glm::mat4& transform, const glm::vec4& color) {
+	// We bake the view projection in now, so that instances use the camera that was active
+	// when they were added, the same as when we drew them immediately
+	mesh.Instances.push_back({ Context::Instance().GetViewProjection() * transform, color, glm::transpose(glm::inverse(glm::mat3(transform))) });
+}
+
+void TTK::Impl::MeshHelper::Flush() {
+	mesh* meshes[] = { &m_Teapot, &m_Sphere, &m_Cube };
+
+	// Gather all the instances into one upload, each mesh will draw a range of it
+	m_InstanceData.clear();
+	for (mesh* mesh : meshes) {
+		m_InstanceData.insert(m_InstanceData.end(), mesh->Instances.begin(), mesh->Instances.end());
+	}
+	if (m_InstanceData.empty()) {
+		return;
+	}
+	// Re-specifying the store lets the driver hand us fresh memory instead of waiting on last frame's draws
+	glNamedBufferData(m_InstanceBuffer, m_InstanceData.size() * sizeof(InstanceData), m_InstanceData.data(), GL_STREAM_DRAW);
+
+	GLStateCache& state = GLStateCache::Instance();
+	state.UseProgram(m_Shader);
+	GLuint baseInstance = 0;
+	for (mesh* mesh : meshes) {
+		if (!mesh->Instances.empty()) {
+			GLsizei count = static_cast<GLsizei>(mesh->Instances.size());
+			state.BindVertexArray(mesh->VAO);
+			glDrawElementsInstancedBaseInstance(GL_TRIANGLES, mesh->IndexCount, GL_UNSIGNED_SHORT, nullptr, count, baseInstance);
+			baseInstance += count;
+			mesh->Instances.clear();
+		}
+	}
+	state.BindVertexArray(0);
 }
 
-TTK::Impl::MeshHelper::mesh TTK::Impl::MeshHelper::__MakeMesh(const float* data, size_t size) const {
+TTK::Impl::MeshHelper::mesh TTK::Impl::MeshHelper::__MakeMesh(const char* name, const std::vector<MeshVert>& vertices, const std::vector<uint16_t>& indices) const {
 	mesh result;
+	result.IndexCount = static_cast<GLsizei>(indices.size());
 	glCreateVertexArrays(1, &result.VAO);
-	glBindVertexArray(result.VAO);
+
+	// These never change, so we can use immutable storage and let the driver put them wherever is fastest
 	glCreateBuffers(1, &result.VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, result.VBO);
-	glNamedBufferData(result.VBO, size, data, GL_DYNAMIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(float) * 6, 0);
+	glNamedBufferStorage(result.VBO, vertices.size() * sizeof(MeshVert), vertices.data(), 0);
+	glCreateBuffers(1, &result.EBO);
+	glNamedBufferStorage(result.EBO, indices.size() * sizeof(uint16_t), indices.data(), 0);
+	glVertexArrayElementBuffer(result.VAO, result.EBO);
+
+	// Binding 0 is the mesh itself, with the position in slot 0 and the normal in slot 1
+	glVertexArrayVertexBuffer(result.VAO, 0, result.VBO, 0, sizeof(MeshVert));
+	glEnableVertexArrayAttrib(result.VAO, 0);
+	glVertexArrayAttribFormat(result.VAO, 0, 3, GL_FLOAT, false, offsetof(MeshVert, Position));
+	glVertexArrayAttribBinding(result.VAO, 0, 0);
+	glEnableVertexArrayAttrib(result.VAO, 1);
+	glVertexArrayAttribFormat(result.VAO, 1, 3, GL_FLOAT, false, offsetof(MeshVert, Normal));
+	glVertexArrayAttribBinding(result.VAO, 1, 0);
+
+	// Binding 1 is the instance data, a mat4 takes up 4 attribute slots (2-5), followed by the color (6)
+	// and the normal matrix (7-9)
+	glVertexArrayVertexBuffer(result.VAO, 1, m_InstanceBuffer, 0, sizeof(InstanceData));
+	glVertexArrayBindingDivisor(result.VAO, 1, 1);
+	for (GLuint column = 0; column < 4; column++) {
+		glEnableVertexArrayAttrib(result.VAO, 2 + column);
+		glVertexArrayAttribFormat(result.VAO, 2 + column, 4, GL_FLOAT, false, offsetof(InstanceData, Transform) + sizeof(glm::vec4) * column);
+		glVertexArrayAttribBinding(result.VAO, 2 + column, 1);
+	}
+	glEnableVertexArrayAttrib(result.VAO, 6);
+	glVertexArrayAttribFormat(result.VAO, 6, 4, GL_FLOAT, false, offsetof(InstanceData, Color));
+	glVertexArrayAttribBinding(result.VAO, 6, 1);
+	for (GLuint column = 0; column < 3; column++) {
+		glEnableVertexArrayAttrib(result.VAO, 7 + column);
+		glVertexArrayAttribFormat(result.VAO, 7 + column, 3, GL_FLOAT, false, offsetof(InstanceData, NormalMatrix) + sizeof(glm::vec3) * column);
+		glVertexArrayAttribBinding(result.VAO, 7 + column, 1);
+	}
+
+	LOG_INFO("Built TTK {} with {} vertices and {} triangles ({} vertices before indexing)", name, vertices.size(), indices.size() / 3, indices.size());
 	return result;
 }
 
+void TTK::Impl::MeshHelper::__BuildTeapot(std::vector<MeshVert>& vertices, std::vector<uint16_t>& indices) {
+	const int size = TeapotTessellation + 1;
+
+	// Patches share their edges with their neighbours (and their mirror images), so we weld together
+	// any points that land in the same spot. We key on the position snapped to a fine grid
+	std::unordered_map<uint64_t, uint16_t> weld;
+	auto getIndex = [&](const glm::vec3& pos) {
+		glm::i64vec3 snapped = glm::i64vec3(glm::round(pos * 10000.0f)) + glm::i64vec3(1 << 20);
+		uint64_t key = (uint64_t)snapped.x | ((uint64_t)snapped.y << 21) | ((uint64_t)snapped.z << 42);
+		auto it = weld.find(key);
+		if (it != weld.end()) {
+			return it->second;
+		}
+		uint16_t index = static_cast<uint16_t>(vertices.size());
+		vertices.push_back({ pos, glm::vec3(0.0f) });
+		weld[key] = index;
+		return index;
+	};
+
+	std::vector<uint16_t> grid(size * size);
+	for (int patch = 0; patch < TeapotPatchCount; patch++) {
+		int mirrors = patch < TeapotQuarterPatchCount ? 4 : 2;
+		for (int mirror = 0; mirror < mirrors; mirror++) {
+			glm::vec3 scale = glm::vec3(mirror & 2 ? -1.0f : 1.0f, mirror & 1 ? -1.0f : 1.0f, 1.0f);
+
+			// Evaluate the bicubic patch over a regular grid
+			for (int ix = 0; ix < size; ix++) {
+				float u = ix / (float)TeapotTessellation;
+				glm::vec4 bu = glm::vec4((1 - u) * (1 - u) * (1 - u), 3 * u * (1 - u) * (1 - u), 3 * u * u * (1 - u), u * u * u);
+				for (int iy = 0; iy < size; iy++) {
+					float v = iy / (float)TeapotTessellation;
+					glm::vec4 bv = glm::vec4((1 - v) * (1 - v) * (1 - v), 3 * v * (1 - v) * (1 - v), 3 * v * v * (1 - v), v * v * v);
+					glm::vec3 pos = glm::vec3(0.0f);
+					for (int row = 0; row < 4; row++) {
+						for (int col = 0; col < 4; col++) {
+							const float* point = TeapotControlPoints[TeapotPatches[patch][row * 4 + col]];
+							pos += bu[row] * bv[col] * glm::vec3(point[0], point[1], point[2]);
+						}
+					}
+					pos *= scale;
+					// Rotate from Z-up to Y-up
+					grid[ix * size + iy] = getIndex(glm::vec3(pos.x, pos.z, -pos.y));
+				}
+			}
+
+			// The patches face inwards, so we wind them backwards, unless a single mirror has already flipped them
+			bool flip = (scale.x * scale.y) < 0.0f;
+			for (int ix = 0; ix < TeapotTessellation; ix++) {
+				for (int iy = 0; iy < TeapotTessellation; iy++) {
+					uint16_t a = grid[ix * size + iy], b = grid[(ix + 1) * size + iy];
+					uint16_t c = grid[ix * size + iy + 1], d = grid[(ix + 1) * size + iy + 1];
+					uint16_t tris[2][3] = { { a, c, b }, { b, c, d } };
+					for (auto& tri : tris) {
+						// Some patches collapse to a point at the top of the lid and bottom of the pot
+						if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2]) {
+							continue;
+						}
+						if (flip) {
+							std::swap(tri[1], tri[2]);
+						}
+						indices.insert(indices.end(), tri, tri + 3);
+					}
+				}
+			}
+		}
+	}
+
+	// Smooth the normals by summing the (area weighted) normals of the faces around each vertex
+	for (size_t ix = 0; ix < indices.size(); ix += 3) {
+		MeshVert& a = vertices[indices[ix]];
+		MeshVert& b = vertices[indices[ix + 1]];
+		MeshVert& c = vertices[indices[ix + 2]];
+		glm::vec3 normal = glm::cross(b.Position - a.Position, c.Position - a.Position);
+		a.Normal += normal;
+		b.Normal += normal;
+		c.Normal += normal;
+	}
+	for (MeshVert& vert : vertices) {
+		vert.Normal = glm::normalize(vert.Normal);
+	}
+}
+
+void TTK::Impl::MeshHelper::__BuildSphere(std::vector<MeshVert>& vertices, std::vector<uint16_t>& indices) {
+	for (const float* pos : SphereIcosahedronVertices) {
+		vertices.push_back({ glm::vec3(pos[0], pos[1], pos[2]), glm::vec3(pos[0], pos[1], pos[2]) });
+	}
+	for (const unsigned char* face : SphereIcosahedronFaces) {
+		indices.insert(indices.end(), face, face + 3);
+	}
+
+	// Each pass splits every triangle into 4, sharing the new vertex in the middle of each edge with the
+	// triangle on the other side
+	std::unordered_map<uint32_t, uint16_t> midpoints;
+	auto getMidpoint = [&](uint16_t a, uint16_t b) {
+		uint32_t key = a < b ? (a << 16) | b : (b << 16) | a;
+		auto it = midpoints.find(key);
+		if (it != midpoints.end()) {
+			return it->second;
+		}
+		glm::vec3 pos = glm::normalize(vertices[a].Position + vertices[b].Position);
+		uint16_t index = static_cast<uint16_t>(vertices.size());
+		vertices.push_back({ pos, pos });
+		midpoints[key] = index;
+		return index;
+	};
+
+	for (int pass = 0; pass < SphereSubdivisions; pass++) {
+		std::vector<uint16_t> split;
+		split.reserve(indices.size() * 4);
+		for (size_t ix = 0; ix < indices.size(); ix += 3) {
+			uint16_t a = indices[ix], b = indices[ix + 1], c = indices[ix + 2];
+			uint16_t ab = getMidpoint(a, b), bc = getMidpoint(b, c), ca = getMidpoint(c, a);
+			uint16_t tris[] = { a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca };
+			split.insert(split.end(), tris, tris + 12);
+		}
+		indices = std::move(split);
+		midpoints.clear();
+	}
+}
+
+void TTK::Impl::MeshHelper::__BuildCube(std::vector<MeshVert>& vertices, std::vector<uint16_t>& indices) {
+	for (const float* vert : CubeVertices) {
+		vertices.push_back({ glm::vec3(vert[0], vert[1], vert[2]), glm::vec3(vert[3], vert[4], vert[5]) });
+	}
+	indices.assign(CubeIndices, CubeIndices + 36);
+}
+
 TTK::Impl::MeshHelper::MeshHelper()
 {
-	m_Teapot = __MakeMesh(TeapotData, sizeof(TeapotData));
-	m_Sphere = __MakeMesh(SphereData, sizeof(SphereData));
-	m_Cube   = __MakeMesh(CubeData, sizeof(CubeData));
+	// The instance buffer needs to exist before the meshes so they can bind it
+	glCreateBuffers(1, &m_InstanceBuffer);
 	
-	glBindVertexArray(0);
+	std::vector<MeshVert> vertices;
+	std::vector<uint16_t> indices;
+	__BuildTeapot(vertices, indices);
+	m_Teapot = __MakeMesh("teapot", vertices, indices);
+	vertices.clear(); indices.clear();
+	__BuildSphere(vertices, indices);
+	m_Sphere = __MakeMesh("sphere", vertices, indices);
+	vertices.clear(); indices.clear();
+	__BuildCube(vertices, indices);
+	m_Cube   = __MakeMesh("cube", vertices, indices);
 	
 	const char* vsSource = R"LIT(#version 430
             layout (location = 0) in vec3 vertexPosition;
-            layout (location = 0) uniform mat4 xTransform;	
+            layout (location = 1) in vec3 vertexNormal;
+            layout (location = 2) in mat4 instanceTransform;
+            layout (location = 6) in vec4 instanceColor;
+            layout (location = 7) in mat3 instanceNormalMatrix;
+            layout (location = 0) out vec4 fragmentColor;
+            layout (location = 1) out vec3 fragmentNormal;
             void main() {
-                gl_Position = xTransform * vec4(vertexPosition, 1);
+                gl_Position = instanceTransform * vec4(vertexPosition, 1);
+                fragmentColor = instanceColor;
+                fragmentNormal = instanceNormalMatrix * vertexNormal;
             })LIT";
 
+	// A single light from above and to the side, which reads as lit whether the world is Y or Z up
 	const char* fsSource = R"LIT(#version 430   
-            layout (location = 1) uniform vec4 xColor;		
+            layout (location = 0) in vec4 fragColor;
+            layout (location = 1) in vec3 fragNormal;
             out vec4 frag_color;            	
+            const vec3 lightDir = normalize(vec3(0.4, 0.7, 0.6));
             void main() {
-                frag_color = xColor;
+                float diffuse = max(dot(normalize(fragNormal), lightDir), 0.0);
+                frag_color = vec4(fragColor.rgb * (0.35 + 0.65 * diffuse), fragColor.a);
             })LIT";
 
-	m_Shader = glCreateProgram();
-
-	GLuint programs[2];
-	programs[0] = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(programs[0], 1, &vsSource, NULL);
-	glCompileShader(programs[0]);
-	programs[1] = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(programs[1], 1, &fsSource, NULL);
-	glCompileShader(programs[1]);
-
-	// Attach our two shaders
-	glAttachShader(m_Shader, programs[0]);
-	glAttachShader(m_Shader, programs[1]);
-
-	// Perform linking
-	glLinkProgram(m_Shader);
-
-	GLint success = 0;
-	glGetProgramiv(m_Shader, GL_LINK_STATUS, &success);
-	LOG_INFO("Status: {}", success);
-
-	if (success == GL_FALSE) {
-		// Get the length of the log
-		GLint length = 0;
-		glGetProgramiv(m_Shader, GL_INFO_LOG_LENGTH, &length);
-
-		if (length > 0) {
-			// Read the log from openGL
-			char* log = new char[length];
-			glGetProgramInfoLog(m_Shader, length, &length, log);
-			LOG_ERROR("Shader failed to link:\n{}", log);
-			delete[] log;
-		}
-		else {
-			LOG_ERROR("Shader failed to link for an unknown reason!");
-		}
-
-		// Delete the partial program
-		glDeleteProgram(m_Shader);
-
+	m_Shader = ProgramBinaryCache::Instance().CreateProgram(vsSource, fsSource);
+	if (m_Shader == 0) {
 		// Throw a runtime exception
 		throw new std::runtime_error("Failed to link shader program!");
 	}
-
-	// Remove shader parts to save space
-	glDetachShader(m_Shader, programs[0]);
-	glDeleteShader(programs[0]);
-	glDetachShader(m_Shader, programs[1]);
-	glDeleteShader(programs[1]);
 }
@@ -0,0 +1,271 @@
+#include "TTK/Profiler.h"
+#include "Logging.h"
+#include "glad/glad.h"
+#include "imgui.h"
+#include <json.hpp>
+#include <fstream>
+#include <cfloat>
+#include <cstdio>
+
+namespace TTK {
+	Profiler& Profiler::Instance() {
+		static Profiler instance;
+		return instance;
+	}
+
+	Profiler::Profiler() :
+		m_IsEnabled(true),
+		m_InFrame(false),
+		m_FrameIndex(0),
+		m_Epoch(Clock::now()),
+		m_Stats({ 0, 0 })
+	{
+		for (FrameBuffer& buffer : m_Buffers) {
+			buffer.QueriesUsed = 0;
+			buffer.IsPending = false;
+		}
+	}
+
+	Profiler::~Profiler() {
+		// The context is usually gone by the time statics are destroyed, so we leak the queries rather than
+		// calling into a dead context. They'll go with the context anyways
+	}
+
+	void Profiler::SetEnabled(bool enabled) {
+		if (!enabled && m_InFrame) {
+			EndFrame();
+		}
+		m_IsEnabled = enabled;
+	}
+
+	void Profiler::BeginFrame() {
+		if (!m_IsEnabled) {
+			return;
+		}
+		if (m_InFrame) {
+			EndFrame();
+		}
+
+		// Before we reuse this buffer, read back the results from the last frame that used it
+		FrameBuffer& buffer = m_Buffers[m_FrameIndex % FrameBuffers];
+		if (buffer.IsPending) {
+			__Resolve(buffer);
+		}
+
+		buffer.Data.Index = m_FrameIndex;
+		buffer.Data.Samples.clear();
+		buffer.SampleQueries.clear();
+		buffer.QueriesUsed = 0;
+		m_Stack.clear();
+		m_Thread = std::this_thread::get_id();
+		m_InFrame = true;
+
+		BeginScope("Frame", true);
+	}
+
+	void Profiler::EndFrame() {
+		if (!m_InFrame) {
+			return;
+		}
+		// Close anything that was left open, so the frame scope is always the last to end
+		while (!m_Stack.empty()) {
+			EndScope();
+		}
+		m_Buffers[m_FrameIndex % FrameBuffers].IsPending = true;
+		m_InFrame = false;
+		m_FrameIndex++;
+	}
+
+	void Profiler::BeginScope(const char* name, bool gpu) {
+		if (!m_IsEnabled || std::this_thread::get_id() != m_Thread) {
+			return;
+		}
+		if (!m_InFrame) {
+			m_Stats.Dropped++;
+			return;
+		}
+
+		FrameBuffer& buffer = m_Buffers[m_FrameIndex % FrameBuffers];
+		m_Stack.push_back(static_cast<uint32_t>(buffer.Data.Samples.size()));
+		buffer.Data.Samples.push_back({ name, static_cast<uint32_t>(m_Stack.size() - 1), __Now(), 0.0, 0.0, 0.0, gpu });
+		buffer.SampleQueries.push_back(-1);
+
+		if (gpu) {
+			// Queries are kept between frames, we only ever need to make more when a frame has more GPU scopes than before
+			if (buffer.QueriesUsed + 2 > buffer.Queries.size()) {
+				size_t first = buffer.Queries.size();
+				buffer.Queries.resize(buffer.QueriesUsed + 2 + first);
+				glGenQueries(static_cast<GLsizei>(buffer.Queries.size() - first), &buffer.Queries[first]);
+			}
+			buffer.SampleQueries.back() = static_cast<int32_t>(buffer.QueriesUsed);
+			glQueryCounter(buffer.Queries[buffer.QueriesUsed], GL_TIMESTAMP);
+			buffer.QueriesUsed += 2;
+		}
+	}
+
+	void Profiler::EndScope() {
+		if (!m_IsEnabled || std::this_thread::get_id() != m_Thread || !m_InFrame || m_Stack.empty()) {
+			return;
+		}
+
+		FrameBuffer& buffer = m_Buffers[m_FrameIndex % FrameBuffers];
+		uint32_t index = m_Stack.back();
+		m_Stack.pop_back();
+		Sample& sample = buffer.Data.Samples[index];
+		sample.CpuMs = __Now() - sample.CpuStartMs;
+		if (buffer.SampleQueries[index] >= 0) {
+			glQueryCounter(buffer.Queries[buffer.SampleQueries[index] + 1], GL_TIMESTAMP);
+		}
+	}
+
+	void Profiler::DrawImGui() {
+		ImGui::Begin("Profiler");
+
+		const Frame* frame = GetLastFrame();
+		if (frame == nullptr || frame->Samples.empty()) {
+			ImGui::Text("Waiting for results...");
+			ImGui::End();
+			return;
+		}
+
+		// Graph the CPU and GPU time of every frame in the history
+		float cpuTimes[HistorySize];
+		float gpuTimes[HistorySize];
+		int count = 0;
+		for (const Frame& item : m_History) {
+			cpuTimes[count] = item.Samples.empty() ? 0.0f : static_cast<float>(item.Samples[0].CpuMs);
+			gpuTimes[count] = item.Samples.empty() ? 0.0f : static_cast<float>(item.Samples[0].GpuMs);
+			count++;
+		}
+		const Sample& root = frame->Samples[0];
+		char overlay[32];
+		snprintf(overlay, sizeof(overlay), "%.2f ms", root.CpuMs);
+		ImGui::PlotLines("CPU", cpuTimes, count, 0, overlay, 0.0f, FLT_MAX, ImVec2(0, 40));
+		snprintf(overlay, sizeof(overlay), "%.2f ms", root.GpuMs);
+		ImGui::PlotLines("GPU", gpuTimes, count, 0, overlay, 0.0f, FLT_MAX, ImVec2(0, 40));
+		ImGui::Text("Frame %llu, %u stalls", static_cast<unsigned long long>(frame->Index), m_Stats.Stalls);
+
+		if (ImGui::Button("Save Chrome Trace")) {
+			SaveChromeTrace("profile.json");
+		}
+		ImGui::Separator();
+
+		// The scope tree, with the CPU and GPU times in their own columns
+		ImGui::Columns(3, "ProfilerColumns");
+		ImGui::Text("Scope"); ImGui::NextColumn();
+		ImGui::Text("CPU (ms)"); ImGui::NextColumn();
+		ImGui::Text("GPU (ms)"); ImGui::NextColumn();
+		ImGui::Separator();
+		for (size_t ix = 0; ix < frame->Samples.size();) {
+			ix = __DrawSample(*frame, ix);
+		}
+		ImGui::Columns(1);
+
+		ImGui::End();
+	}
+
+	bool Profiler::SaveChromeTrace(const std::string& path) const {
+		nlohmann::json events = nlohmann::json::array();
+		events.push_back({ { "name", "thread_name" }, { "ph", "M" }, { "pid", 0 }, { "tid", 0 }, { "args", { { "name", "CPU" } } } });
+		events.push_back({ { "name", "thread_name" }, { "ph", "M" }, { "pid", 0 }, { "tid", 1 }, { "args", { { "name", "GPU" } } } });
+		for (const Frame& frame : m_History) {
+			for (const Sample& sample : frame.Samples) {
+				// Chrome wants its times in microseconds
+				events.push_back({ { "name", sample.Name }, { "cat", "CPU" }, { "ph", "X" }, { "pid", 0 }, { "tid", 0 },
+					{ "ts", sample.CpuStartMs * 1000.0 }, { "dur", sample.CpuMs * 1000.0 },
+					{ "args", { { "frame", frame.Index } } } });
+				if (sample.HasGpu) {
+					events.push_back({ { "name", sample.Name }, { "cat", "GPU" }, { "ph", "X" }, { "pid", 0 }, { "tid", 1 },
+						{ "ts", sample.GpuStartMs * 1000.0 }, { "dur", sample.GpuMs * 1000.0 },
+						{ "args", { { "frame", frame.Index } } } });
+				}
+			}
+		}
+
+		std::ofstream file(path);
+		if (!file.is_open()) {
+			LOG_WARN("Failed to open {} to save the profiler trace", path);
+			return false;
+		}
+		file << nlohmann::json({ { "traceEvents", events }, { "displayTimeUnit", "ms" } }).dump();
+		LOG_INFO("Saved {} frames of profiling to {}", m_History.size(), path);
+		return true;
+	}
+
+	double Profiler::__Now() const {
+		return std::chrono::duration<double, std::milli>(Clock::now() - m_Epoch).count();
+	}
+
+	void Profiler::__Resolve(FrameBuffer& buffer) {
+		buffer.IsPending = false;
+		if (buffer.QueriesUsed > 0) {
+			// The last query to be issued is the end of the frame, once it's ready all the others are as well
+			GLint isAvailable = GL_FALSE;
+			glGetQueryObjectiv(buffer.Queries[buffer.QueriesUsed - 1], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+			if (!isAvailable) {
+				m_Stats.Stalls++;
+			}
+		}
+
+		// The frame scope is always first, we use it to line the GPU timeline up with the CPU one
+		GLuint64 gpuEpoch = 0;
+		double cpuEpoch = 0.0;
+		for (size_t ix = 0; ix < buffer.Data.Samples.size(); ix++) {
+			Sample& sample = buffer.Data.Samples[ix];
+			int32_t query = buffer.SampleQueries[ix];
+			if (query < 0) {
+				continue;
+			}
+			GLuint64 start = 0, end = 0;
+			glGetQueryObjectui64v(buffer.Queries[query], GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(buffer.Queries[query + 1], GL_QUERY_RESULT, &end);
+			if (ix == 0) {
+				gpuEpoch = start;
+				cpuEpoch = sample.CpuStartMs;
+			}
+			sample.GpuStartMs = cpuEpoch + static_cast<double>(static_cast<int64_t>(start - gpuEpoch)) / 1000000.0;
+			sample.GpuMs = static_cast<double>(end - start) / 1000000.0;
+		}
+
+		if (m_History.size() >= HistorySize) {
+			m_History.pop_front();
+		}
+		m_History.push_back(buffer.Data);
+	}
+
+	size_t Profiler::__DrawSample(const Frame& frame, size_t index) {
+		const Sample& sample = frame.Samples[index];
+		bool hasChildren = index + 1 < frame.Samples.size() && frame.Samples[index + 1].Depth > sample.Depth;
+
+		ImGui::PushID(static_cast<int>(index));
+		ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_DefaultOpen;
+		if (!hasChildren) {
+			flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+		}
+		bool isOpen = ImGui::TreeNodeEx(sample.Name, flags);
+		ImGui::NextColumn();
+		ImGui::Text("%.3f", sample.CpuMs);
+		ImGui::NextColumn();
+		if (sample.HasGpu) {
+			ImGui::Text("%.3f", sample.GpuMs);
+		} else {
+			ImGui::TextDisabled("-");
+		}
+		ImGui::NextColumn();
+		ImGui::PopID();
+
+		// Children follow their parent, and end when we get back to the parent's depth
+		size_t next = index + 1;
+		while (next < frame.Samples.size() && frame.Samples[next].Depth > sample.Depth) {
+			if (hasChildren && isOpen) {
+				next = __DrawSample(frame, next);
+			} else {
+				next++;
+			}
+		}
+		if (hasChildren && isOpen) {
+			ImGui::TreePop();
+		}
+		return next;
+	}
+}
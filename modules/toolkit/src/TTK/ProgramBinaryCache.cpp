@@ -0,0 +1,237 @@
+#include "TTK/ProgramBinaryCache.h"
+#include "Logging.h"
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+namespace TTK {
+	// Written at the start of every binary file, so that we never hand the driver a truncated
+	// file or one written by a different version of the cache
+	struct BinaryHeader {
+		uint32_t Magic;
+		uint32_t Version;
+		uint64_t Key;
+		uint32_t Format;
+		uint32_t Length;
+	};
+	static const uint32_t BinaryMagic = 0x43425054; // "TPBC"
+	static const uint32_t BinaryVersion = 1;
+
+	// 64 bit FNV-1a, we hash the length of each string as well so that moving text from
+	// one source to the next changes the key
+	static uint64_t __HashBytes(uint64_t hash, const void* data, size_t length) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t ix = 0; ix < length; ix++) {
+			hash = (hash ^ bytes[ix]) * 0x100000001B3ull;
+		}
+		return hash;
+	}
+	static uint64_t __HashString(uint64_t hash, const char* value) {
+		size_t length = value != nullptr ? strlen(value) : 0;
+		hash = __HashBytes(hash, &length, sizeof(size_t));
+		return __HashBytes(hash, value, length);
+	}
+
+	ProgramBinaryCache& ProgramBinaryCache::Instance() {
+		static ProgramBinaryCache instance;
+		return instance;
+	}
+
+	ProgramBinaryCache::ProgramBinaryCache() :
+		m_Directory("shader_cache"),
+		m_DriverHash(0),
+		m_IsSupported(-1),
+		m_Stats({ 0, 0, 0, 0 })
+	{ }
+
+	bool ProgramBinaryCache::IsSupported() {
+		if (m_IsSupported == -1) {
+			GLint formats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+			m_IsSupported = formats > 0 ? 1 : 0;
+			if (!m_IsSupported) {
+				LOG_WARN("The driver does not support program binaries, shaders will always be compiled from source");
+			}
+		}
+		return m_IsSupported == 1;
+	}
+
+	uint64_t ProgramBinaryCache::MakeKey(const char* const* sources, size_t count) {
+		if (m_DriverHash == 0) {
+			m_DriverHash = 0xCBF29CE484222325ull;
+			m_DriverHash = __HashString(m_DriverHash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+			m_DriverHash = __HashString(m_DriverHash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+			m_DriverHash = __HashString(m_DriverHash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+		}
+		uint64_t key = m_DriverHash;
+		for (size_t ix = 0; ix < count; ix++) {
+			key = __HashString(key, sources[ix]);
+		}
+		return key;
+	}
+
+	bool ProgramBinaryCache::TryLoad(GLuint program, uint64_t key) {
+		if (!IsSupported()) {
+			m_Stats.Misses++;
+			return false;
+		}
+
+		std::string path = __GetPath(key);
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			m_Stats.Misses++;
+			return false;
+		}
+
+		BinaryHeader header;
+		std::vector<char> binary;
+		bool isValid = file.read(reinterpret_cast<char*>(&header), sizeof(BinaryHeader)) &&
+			header.Magic == BinaryMagic && header.Version == BinaryVersion && header.Key == key;
+		if (isValid) {
+			binary.resize(header.Length);
+			isValid = static_cast<bool>(file.read(binary.data(), header.Length));
+		}
+		file.close();
+
+		GLint status = GL_FALSE;
+		if (isValid) {
+			glProgramBinary(program, header.Format, binary.data(), static_cast<GLsizei>(binary.size()));
+			glGetProgramiv(program, GL_LINK_STATUS, &status);
+		}
+		if (status == GL_FALSE) {
+			// Either the file is damaged or the driver no longer likes it, in both cases we'll
+			// compile from source and replace it
+			LOG_WARN("Discarding shader binary {}", path);
+			std::remove(path.c_str());
+			m_Stats.Rejected++;
+			return false;
+		}
+
+		m_Stats.Hits++;
+		return true;
+	}
+
+	void ProgramBinaryCache::Store(GLuint program, uint64_t key) {
+		if (!IsSupported()) {
+			return;
+		}
+
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0) {
+			return;
+		}
+		std::vector<char> binary(length);
+		BinaryHeader header = { BinaryMagic, BinaryVersion, key, GL_NONE, 0 };
+		glGetProgramBinary(program, length, &length, &header.Format, binary.data());
+		header.Length = static_cast<uint32_t>(length);
+
+		std::error_code error;
+		std::filesystem::create_directories(m_Directory, error);
+
+		// Write to a temporary file first, so that a crash mid-write can't leave a half written binary
+		std::string path = __GetPath(key);
+		std::string tempPath = path + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open()) {
+				LOG_WARN("Failed to open {} for writing", tempPath);
+				return;
+			}
+			file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
+			file.write(binary.data(), header.Length);
+		}
+		std::filesystem::rename(tempPath, path, error);
+		if (error) {
+			LOG_WARN("Failed to store shader binary {}: {}", path, error.message());
+			std::remove(tempPath.c_str());
+			return;
+		}
+		m_Stats.Stored++;
+	}
+
+	void ProgramBinaryCache::PrepareForLink(GLuint program) {
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
+	GLuint ProgramBinaryCache::CreateProgram(const char* vsSource, const char* fsSource) {
+		GLuint result = glCreateProgram();
+
+		const char* sources[2] = { vsSource, fsSource };
+		uint64_t key = MakeKey(sources, 2);
+		if (TryLoad(result, key)) {
+			return result;
+		}
+
+		GLuint vs = __CompilePart(vsSource, GL_VERTEX_SHADER);
+		GLuint fs = __CompilePart(fsSource, GL_FRAGMENT_SHADER);
+
+		// Attach our two shaders
+		glAttachShader(result, vs);
+		glAttachShader(result, fs);
+
+		// Perform linking
+		PrepareForLink(result);
+		glLinkProgram(result);
+
+		// Remove shader parts to save space
+		glDetachShader(result, vs);
+		glDeleteShader(vs);
+		glDetachShader(result, fs);
+		glDeleteShader(fs);
+
+		GLint success = 0;
+		glGetProgramiv(result, GL_LINK_STATUS, &success);
+		if (success == GL_FALSE) {
+			// Get the length of the log
+			GLint length = 0;
+			glGetProgramiv(result, GL_INFO_LOG_LENGTH, &length);
+
+			if (length > 0) {
+				// Read the log from openGL
+				char* log = new char[length];
+				glGetProgramInfoLog(result, length, &length, log);
+				LOG_ERROR("Shader failed to link:\n{}", log);
+				delete[] log;
+			}
+			else {
+				LOG_ERROR("Shader failed to link for an unknown reason!");
+			}
+
+			// Delete the partial program
+			glDeleteProgram(result);
+			return 0;
+		}
+
+		Store(result, key);
+		return result;
+	}
+
+	std::string ProgramBinaryCache::__GetPath(uint64_t key) const {
+		char name[24];
+		snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+		return (std::filesystem::path(m_Directory) / name).string();
+	}
+
+	GLuint ProgramBinaryCache::__CompilePart(const char* source, GLenum type) {
+		GLuint result = glCreateShader(type);
+		glShaderSource(result, 1, &source, NULL);
+		glCompileShader(result);
+
+		GLint success = 0;
+		glGetShaderiv(result, GL_COMPILE_STATUS, &success);
+		if (success == GL_FALSE) {
+			GLint length = 0;
+			glGetShaderiv(result, GL_INFO_LOG_LENGTH, &length);
+			if (length > 0) {
+				char* log = new char[length];
+				glGetShaderInfoLog(result, length, &length, log);
+				LOG_ERROR("Shader failed to compile:\n{}", log);
+				delete[] log;
+			}
+		}
+		return result;
+	}
+}
@@ -5,6 +5,8 @@
 
 #include <glad/glad.h>
 #include "Logging.h"
+#include "TTK/GLStateCache.h"
+#include "TTK/ProgramBinaryCache.h"
 
 TTK::SpriteSheetQuad::SpriteSheetQuad()
 {
@@ -26,15 +28,14 @@ TTK::SpriteSheetQuad::SpriteSheetQuad()
 		2, 1, 3
 	};
 
-	int currentVAO = 0;
-	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &currentVAO);
+	GLStateCache& state = GLStateCache::Instance();
 	glCreateVertexArrays(1, &m_VAO);
-	glBindVertexArray(m_VAO);
+	state.BindVertexArray(m_VAO);
 	glCreateBuffers(1, &m_VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	state.BindBuffer(GL_ARRAY_BUFFER, m_VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(QuadVert) * 4, m_Vertices, GL_STREAM_DRAW);
 	glCreateBuffers(1, &m_EBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+	state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * 6, indices, GL_STATIC_DRAW);
 	#pragma warning(push)
 	#pragma warning(disable: 6011)
@@ -43,7 +44,7 @@ TTK::SpriteSheetQuad::SpriteSheetQuad()
 	glEnableVertexAttribArray(1);
 	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(QuadVert), &(nullVert->Position));
 	glVertexAttribPointer(1, 2, GL_FLOAT, false, sizeof(QuadVert), &(nullVert->Texture));
-	glBindVertexArray(currentVAO);
+	state.BindVertexArray(0);
 	#pragma warning(pop)
 
 	const char* vsSource = R"LIT(#version 440
@@ -65,28 +66,7 @@ TTK::SpriteSheetQuad::SpriteSheetQuad()
 				frag_color = texture2D(xSampler, fragUv) * xColor;
             })LIT";
 
-	m_Shader = glCreateProgram();
-
-	GLuint programs[2];
-	programs[0] = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(programs[0], 1, &vsSource, NULL);
-	glCompileShader(programs[0]);
-	programs[1] = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(programs[1], 1, &fsSource, NULL);
-	glCompileShader(programs[1]);
-
-	// Attach our two shaders
-	glAttachShader(m_Shader, programs[0]);
-	glAttachShader(m_Shader, programs[1]);
-
-	// Perform linking
-	glLinkProgram(m_Shader);
-
-	// Remove shader parts to save space
-	glDetachShader(m_Shader, programs[0]);
-	glDeleteShader(programs[0]);
-	glDetachShader(m_Shader, programs[1]);
-	glDeleteShader(programs[1]);
+	m_Shader = ProgramBinaryCache::Instance().CreateProgram(vsSource, fsSource);
 }
 
 void TTK::SpriteSheetQuad::SliceSpriteSheet(const char* fileName, float spriteSizeX, float spriteSizeY,
@@ -167,19 +147,16 @@ void TTK::SpriteSheetQuad::Draw(const glm::mat4& matrix)
 	m_Vertices[2].Texture = { sc.uMin, sc.vMax };
 	m_Vertices[3].Texture = { sc.uMax, sc.vMax };
 	
-	int currentProgram, currentVAO;
-	glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
-	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &currentVAO);
-	glUseProgram(m_Shader);
+	// The state cache knows what's bound, so we no longer need to query and restore it
+	GLStateCache& state = GLStateCache::Instance();
+	state.UseProgram(m_Shader);
 	glProgramUniform4fv(m_Shader, 2, 1, &m_Color.x);
 	glProgramUniformMatrix4fv(m_Shader, 0, 1, false, &matrix[0][0]);
 	m_Texture.Bind();
-	glBindVertexArray(m_VAO);
+	state.BindVertexArray(m_VAO);
 	glNamedBufferData(m_VBO, sizeof(QuadVert) * 4, m_Vertices, GL_STREAM_DRAW);
 	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
 	m_Texture.Unbind();
-	glBindVertexArray(currentVAO);
-	glUseProgram(currentProgram);
 }
 
 void TTK::SpriteSheetQuad::SetFrameLength(int frameNumber, float time)
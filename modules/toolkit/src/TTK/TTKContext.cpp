@@ -13,21 +13,38 @@
 #include "TTK/TTKContext.h"
 #include <GLM/gtc/matrix_transform.hpp>
 #include <string>
+#include <cstring>
+#include <algorithm>
 #include "Logging.h"
 #include "TTK/MeshHelper.h"
+#include "TTK/GLStateCache.h"
+#include "TTK/GLFence.h"
+#include "TTK/ProgramBinaryCache.h"
 
 TTK::Context* TTK::Context::m_Instance = nullptr;
 
 TTK::Context::~Context() {
 	delete m_MeshHelper;
 	delete m_DefaultFont;
-	glDeleteBuffers(1, &m_Tris.VBO);
-	glDeleteBuffers(1, &m_Lines.VBO);
-	glDeleteBuffers(1, &m_Points.VBO);
+	for (GLsync& fence : m_Fences) {
+		if (fence != nullptr) {
+			glDeleteSync(fence);
+		}
+	}
+	__FreeRing(m_Tris);
+	__FreeRing(m_Lines);
+	__FreeRing(m_Points);
+	GLStateCache& state = GLStateCache::Instance();
+	state.OnVertexArrayDeleted(m_Tris.VAO);
+	state.OnVertexArrayDeleted(m_Lines.VAO);
+	state.OnVertexArrayDeleted(m_Points.VAO);
+	state.OnProgramDeleted(m_ShaderHandle);
+	state.OnProgramDeleted(m_PointShaderHandle);
 	glDeleteVertexArrays(1, &m_Tris.VAO);
 	glDeleteVertexArrays(1, &m_Lines.VAO);
 	glDeleteVertexArrays(1, &m_Points.VAO);
 	glDeleteProgram(m_ShaderHandle);
+	glDeleteProgram(m_PointShaderHandle);
 }
 
 glm::mat4 TTK::Context::GetOrthoProjection() const {
@@ -58,27 +75,14 @@ void TTK::Context::DrawCube(const glm::mat4& mat, const glm::vec4& color) const
 }
 
 void TTK::Context::AddLine(const glm::vec3& a, const glm::vec3& b, const glm::vec4& color) {
-	m_LineVerts[m_Lines.Count + 0].Position = a;
-	m_LineVerts[m_Lines.Count + 0].Color = color;
-	m_LineVerts[m_Lines.Count + 1].Position = b;
-	m_LineVerts[m_Lines.Count + 1].Color = color;
-	m_Lines.Count += 2;
-	if (m_Lines.Count == MaxLineVerts) {
-		__Flush(m_Lines);
-	}
+	m_LineVerts.push_back({ a, color });
+	m_LineVerts.push_back({ b, color });
 }
 
 void TTK::Context::AddTri(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec4& color) {
-	m_TriVerts[m_Tris.Count + 0].Position = a;
-	m_TriVerts[m_Tris.Count + 0].Color = color;
-	m_TriVerts[m_Tris.Count + 1].Position = b;
-	m_TriVerts[m_Tris.Count + 1].Color = color;
-	m_TriVerts[m_Tris.Count + 2].Position = c;
-	m_TriVerts[m_Tris.Count + 2].Color = color;
-	m_Tris.Count += 3;
-	if (m_Tris.Count == MaxTriVerts) {
-		__Flush(m_Tris);
-	}
+	m_TriVerts.push_back({ a, color });
+	m_TriVerts.push_back({ b, color });
+	m_TriVerts.push_back({ c, color });
 }
 
 void TTK::Context::AddQuad(const glm::vec3& min, const glm::vec3& max, const glm::vec4& color) {
@@ -90,22 +94,41 @@ void TTK::Context::AddQuad(const glm::vec3& min, const glm::vec3& max, const glm
 
 void TTK::Context::AddPoint(const glm::vec3& pos, float size, const glm::vec4& color)
 {
-	m_PointVerts[m_Points.Count].Position = pos;
-	m_PointVerts[m_Points.Count].Color = color;
-	m_PointVerts[m_Points.Count].Size = size;
-	m_Points.Count += 1;
-	if (m_Points.Count == MaxPointVerts) {
-		__Flush(m_Points);
-	}
+	m_PointVerts.push_back({ pos, color, size });
 }
 
 void TTK::Context::Flush() {
-	__Flush(m_Tris);
-	__Flush(m_Lines);
-	__Flush(m_Points);
+	m_MeshHelper->Flush();
+
+	if (m_TriVerts.empty() && m_LineVerts.empty() && m_PointVerts.empty()) {
+		return;
+	}
+
+	// Make sure the GPU is done with the section of the rings we're about to write into
+	if (WaitForFence(m_Fences[m_FrameIndex])) {
+		m_Stats.FencesWaited++;
+	}
+
+	__Flush(m_Tris, m_TriVerts.data(), m_TriVerts.size());
+	__Flush(m_Lines, m_LineVerts.data(), m_LineVerts.size());
+	__Flush(m_Points, m_PointVerts.data(), m_PointVerts.size());
+	GLStateCache::Instance().BindVertexArray(0);
+
+	// Mark this section as in use until the draws above have completed
+	m_Fences[m_FrameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_FrameIndex = (m_FrameIndex + 1) % RingFrames;
+
+	// Clearing keeps the capacity, so after the first few frames we stop allocating
+	m_TriVerts.clear();
+	m_LineVerts.clear();
+	m_PointVerts.clear();
 }
 
-TTK::Context::Context() {
+TTK::Context::Context() :
+	m_Fences(),
+	m_FrameIndex(0),
+	m_Stats(StreamStats())
+{
 	m_Projection = glm::ortho(0.0f, 800.0f, 0.0f, 600.0f);
 	m_ViewMatrix = glm::mat4(1.0f);
 	m_DefaultFont = new TrueTypeTextureFont("C:\\\\Windows\\Fonts\\consola.ttf", 32);
@@ -148,115 +171,111 @@ TTK::Context::Context() {
 	m_PointShaderHandle = __CompileShader(vsSourcePoint, fsSource);
 
 
-	m_Tris = __InitBuff(GL_TRIANGLES, m_ShaderHandle, m_TriVerts, sizeof(SimpleVert), MaxTriVerts);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(SimpleVert), (void*)offsetof(SimpleVert, Position));
-	glVertexAttribPointer(1, 4, GL_FLOAT, false, sizeof(SimpleVert), (void*)offsetof(SimpleVert, Color));
+	// The VAOs read from binding 0, which we point at the ring buffer whenever it is (re)allocated
+	m_Tris = __InitBuff(GL_TRIANGLES, m_ShaderHandle, sizeof(SimpleVert), InitialTriVerts);
+	glVertexArrayAttribFormat(m_Tris.VAO, 0, 3, GL_FLOAT, false, offsetof(SimpleVert, Position));
+	glVertexArrayAttribFormat(m_Tris.VAO, 1, 4, GL_FLOAT, false, offsetof(SimpleVert, Color));
 
-	m_Lines = __InitBuff(GL_LINES, m_ShaderHandle, m_LineVerts, sizeof(SimpleVert), MaxLineVerts);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(SimpleVert), (void*)offsetof(SimpleVert, Position));
-	glVertexAttribPointer(1, 4, GL_FLOAT, false, sizeof(SimpleVert), (void*)offsetof(SimpleVert, Color));
+	m_Lines = __InitBuff(GL_LINES, m_ShaderHandle, sizeof(SimpleVert), InitialLineVerts);
+	glVertexArrayAttribFormat(m_Lines.VAO, 0, 3, GL_FLOAT, false, offsetof(SimpleVert, Position));
+	glVertexArrayAttribFormat(m_Lines.VAO, 1, 4, GL_FLOAT, false, offsetof(SimpleVert, Color));
 
-	m_Points = __InitBuff(GL_POINTS, m_PointShaderHandle, m_PointVerts, sizeof(PointVert), MaxLineVerts);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(PointVert), (void*)offsetof(PointVert, Position));
-	glVertexAttribPointer(1, 4, GL_FLOAT, false, sizeof(PointVert), (void*)offsetof(PointVert, Color));
-	glVertexAttribPointer(2, 1, GL_FLOAT, false, sizeof(PointVert), (void*)offsetof(PointVert, Size));
+	m_Points = __InitBuff(GL_POINTS, m_PointShaderHandle, sizeof(PointVert), InitialPointVerts);
+	glVertexArrayAttribFormat(m_Points.VAO, 0, 3, GL_FLOAT, false, offsetof(PointVert, Position));
+	glVertexArrayAttribFormat(m_Points.VAO, 1, 4, GL_FLOAT, false, offsetof(PointVert, Color));
+	glVertexArrayAttribFormat(m_Points.VAO, 2, 1, GL_FLOAT, false, offsetof(PointVert, Size));
+	glEnableVertexArrayAttrib(m_Points.VAO, 2);
+	glVertexArrayAttribBinding(m_Points.VAO, 2, 0);
 
-	glBindVertexArray(0);
+	m_TriVerts.reserve(InitialTriVerts);
+	m_LineVerts.reserve(InitialLineVerts);
+	m_PointVerts.reserve(InitialPointVerts);
 
 	// Make sure that the mesh helper has a context
 	m_MeshHelper = new Impl::MeshHelper();
 
 	// Allow our shaders to specify a point size
-	glEnable(GL_PROGRAM_POINT_SIZE);
+	GLStateCache::Instance().SetEnabled(GL_PROGRAM_POINT_SIZE, true);
 }
 
-TTK::Context::GLBuff TTK::Context::__InitBuff(GLenum mode, GLuint shader, void* dataSource, size_t elemSize, size_t maxElems)
+TTK::Context::GLBuff TTK::Context::__InitBuff(GLenum mode, GLuint shader, size_t elemSize, size_t initialElems)
 {
 	GLBuff result;
 	result.Mode = mode;
-	result.Count = 0;
-	result.Data = dataSource;
 	result.ElemSize = elemSize;
 	result.Shader = shader;
+	result.VBO = 0;
+	result.Capacity = 0;
+	result.Mapped = nullptr;
 
+	// Every buffer has a position and color, the caller can add any extra attributes
 	glCreateVertexArrays(1, &result.VAO);
-	glBindVertexArray(result.VAO);
-	glCreateBuffers(1, &result.VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, result.VBO);
-	glNamedBufferData(result.VBO, elemSize * maxElems, nullptr, GL_STREAM_DRAW);
+	for (GLuint attrib = 0; attrib < 2; attrib++) {
+		glEnableVertexArrayAttrib(result.VAO, attrib);
+		glVertexArrayAttribBinding(result.VAO, attrib, 0);
+	}
+	__AllocateRing(result, initialElems);
 
 	return result;
 }
 
-void TTK::Context::__Flush(GLBuff& buff) {
-	if (buff.Count > 0) {
-		glUseProgram(buff.Shader);
-		glUniformMatrix4fv(0, 1, false, &m_ViewProjection[0][0]);
-		glNamedBufferSubData(buff.VBO, 0, buff.Count * buff.ElemSize, buff.Data);
-		glBindVertexArray(buff.VAO);
-		glDrawArrays(buff.Mode, 0, static_cast<GLsizei>(buff.Count));
-		buff.Count = 0;
-	}
+void TTK::Context::__AllocateRing(GLBuff& buff, size_t capacity)
+{
+	// Any draws still reading the old buffer keep it alive on the driver side, so we can
+	// drop our handle straight away
+	__FreeRing(buff);
+
+	buff.Capacity = capacity;
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	const GLsizeiptr size = static_cast<GLsizeiptr>(buff.ElemSize * capacity * RingFrames);
+	glCreateBuffers(1, &buff.VBO);
+	glNamedBufferStorage(buff.VBO, size, nullptr, flags);
+	buff.Mapped = static_cast<uint8_t*>(glMapNamedBufferRange(buff.VBO, 0, size, flags));
+	LOG_ASSERT(buff.Mapped != nullptr, "Failed to map TTK stream buffer!");
+
+	glVertexArrayVertexBuffer(buff.VAO, 0, buff.VBO, 0, static_cast<GLsizei>(buff.ElemSize));
 }
 
-GLuint TTK::Context::__CompileShader(const char* vsSource, const char* fsSource)
+void TTK::Context::__FreeRing(GLBuff& buff)
 {
-	GLuint result = glCreateProgram();
-
-	GLuint programs[2];
-	programs[0] = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(programs[0], 1, &vsSource, NULL);
-	glCompileShader(programs[0]);
-	programs[1] = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(programs[1], 1, &fsSource, NULL);
-	glCompileShader(programs[1]);
-
-	// Attach our two shaders
-	glAttachShader(result, programs[0]);
-	glAttachShader(result, programs[1]);
-
-	// Perform linking
-	glLinkProgram(result);
-
-	GLint success = 0;
-	glGetProgramiv(result, GL_LINK_STATUS, &success);
-	LOG_INFO("Status: {}", success);
-
-	if (success == GL_FALSE) {
-		// Get the length of the log
-		GLint length = 0;
-		glGetProgramiv(result, GL_INFO_LOG_LENGTH, &length);
-
-		if (length > 0) {
-			// Read the log from openGL
-			char* log = new char[length];
-			glGetProgramInfoLog(result, length, &length, log);
-			LOG_ERROR("Shader failed to link:\n{}", log);
-			delete[] log;
-		}
-		else {
-			LOG_ERROR("Shader failed to link for an unknown reason!");
+	if (buff.VBO != 0) {
+		glUnmapNamedBuffer(buff.VBO);
+		GLStateCache::Instance().OnBufferDeleted(buff.VBO);
+		glDeleteBuffers(1, &buff.VBO);
+		buff.VBO = 0;
+		buff.Mapped = nullptr;
+	}
+}
+
+void TTK::Context::__Flush(GLBuff& buff, const void* data, size_t count) {
+	if (count > 0) {
+		if (count > buff.Capacity) {
+			// Grow to at least double, so that a steadily climbing count doesn't re-allocate every frame
+			__AllocateRing(buff, std::max(count, buff.Capacity * 2));
+			m_Stats.Reallocations++;
 		}
 
-		// Delete the partial program
-		glDeleteProgram(result);
+		const size_t first = m_FrameIndex * buff.Capacity;
+		const size_t bytes = count * buff.ElemSize;
+		memcpy(buff.Mapped + first * buff.ElemSize, data, bytes);
+		m_Stats.BytesStreamed += bytes;
 
+		GLStateCache& state = GLStateCache::Instance();
+		state.UseProgram(buff.Shader);
+		glUniformMatrix4fv(0, 1, false, &m_ViewProjection[0][0]);
+		state.BindVertexArray(buff.VAO);
+		glDrawArrays(buff.Mode, static_cast<GLint>(first), static_cast<GLsizei>(count));
+		m_Stats.DrawCalls++;
+	}
+}
+
+GLuint TTK::Context::__CompileShader(const char* vsSource, const char* fsSource)
+{
+	// The cache will only compile the sources if it doesn't already have a binary for them
+	GLuint result = ProgramBinaryCache::Instance().CreateProgram(vsSource, fsSource);
+	if (result == 0) {
 		// Throw a runtime exception
 		throw new std::runtime_error("Failed to link shader program!");
 	}
-
-	// Remove shader parts to save space
-	glDetachShader(result, programs[0]);
-	glDeleteShader(programs[0]);
-	glDetachShader(result, programs[1]);
-	glDeleteShader(programs[1]);
-
 	return result;
 }
@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include "Logging.h"
+#include "TTK/GLStateCache.h"
 
 namespace TTK {
 	Texture2D::Texture2D() :
@@ -22,18 +23,17 @@ namespace TTK {
 	}
 
 	Texture2D::~Texture2D() {
+		GLStateCache::Instance().OnTextureDeleted(m_TexID);
 		glDeleteTextures(1, &m_TexID);
 	}
 
 	void Texture2D::Bind(GLenum textureUnit /* = GL_TEXTURE0 */) {
-		glActiveTexture(textureUnit);
-		glBindTexture(m_Target, m_TexID);
+		GLStateCache::Instance().BindTexture(textureUnit - GL_TEXTURE0, m_TexID);
 	}
 
 	void Texture2D::Unbind(GLenum textureUnit /* = GL_TEXTURE0 */)
 	{
-		glActiveTexture(textureUnit);
-		glBindTexture(m_Target, 0);
+		GLStateCache::Instance().BindTexture(textureUnit - GL_TEXTURE0, 0);
 	}
 
 	void Texture2D::LoadTextureFromFile(const std::string& filePath)
@@ -96,26 +96,31 @@ namespace TTK {
 	//	glEnable(m_pTarget);
 	//	error = glGetError();
 
-		if (m_TexID)
+		GLStateCache& state = GLStateCache::Instance();
+		if (m_TexID) {
+			state.OnTextureDeleted(m_TexID);
 			glDeleteTextures(1, &m_TexID);
+		}
 
-		glGenTextures(1, &m_TexID);
-		glBindTexture(target, m_TexID);
+		glCreateTextures(target, 1, &m_TexID);
 		error = glGetError();
 
-		glTexParameteri(m_Target, GL_TEXTURE_MIN_FILTER, filtering);
-		glTexParameteri(m_Target, GL_TEXTURE_MAG_FILTER, filtering);
-		glTexParameteri(m_Target, GL_TEXTURE_WRAP_S, edgeBehaviour);
-		glTexParameteri(m_Target, GL_TEXTURE_WRAP_T, edgeBehaviour);
+		glTextureParameteri(m_TexID, GL_TEXTURE_MIN_FILTER, filtering);
+		glTextureParameteri(m_TexID, GL_TEXTURE_MAG_FILTER, filtering);
+		glTextureParameteri(m_TexID, GL_TEXTURE_WRAP_S, edgeBehaviour);
+		glTextureParameteri(m_TexID, GL_TEXTURE_WRAP_T, edgeBehaviour);
 		error = glGetError();
 
+		// There's no DSA version of glTexImage2D, so we still need to bind to the active unit for the upload
+		state.ActiveTexture(0);
+		state.BindTexture(0, m_TexID);
 		glTexImage2D(m_Target, 0, internalFormat, w, h, 0, textureFormat, dataType, data);
 		error = glGetError();
 
 		if (error != 0)
 			LOG_ERROR("An error has occured while creating a texture. Continuing...");
 
-		glBindTexture(m_Target, 0);
+		state.BindTexture(0, 0);
 
 	}
 
@@ -124,11 +129,6 @@ namespace TTK {
 		if (newDataPtr == nullptr)
 			return;
 
-		glBindTexture(m_Target, m_TexID);
-
-		if (newDataPtr != nullptr)
-			glTexSubImage2D(m_Target, 0, 0, 0, m_TexWidth, m_TexHeight, m_TextureFormat, m_DataType, newDataPtr);
-
-		glBindTexture(m_Target, 0);
+		glTextureSubImage2D(m_TexID, 0, 0, 0, m_TexWidth, m_TexHeight, m_TextureFormat, m_DataType, newDataPtr);
 	}
 }
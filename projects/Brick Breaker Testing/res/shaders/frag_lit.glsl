@@ -0,0 +1,104 @@
+#version 430
+
+// Keywords, which are defined by the C++ side when it asks for a variant (see ShaderKeyword):
+//   TEXTURED     - Multiply the color by the albedo texture in s_Diffuse
+//   SPECULAR_MAP - Scale the specular highlight by the red channel of s_Specular
+//   ATTENUATION  - Fade the light out with distance, using the falloff terms in b_FrameData, reaching zero at its radius
+//   PHONG        - Use the classic Phong reflection for highlights, rather than Blinn-Phong
+//   CLUSTERED    - Only shade with the lights in this fragment's cluster, rather than looping over every light (lights
+//                  always reach zero at their radius, since that is where the clusters cut them off)
+
+layout(location = 0) in vec3 inPos;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec3 inNormal;
+layout(location = 3) in vec2 inUV;
+
+#ifdef TEXTURED
+uniform sampler2D s_Diffuse;
+#endif
+#ifdef SPECULAR_MAP
+uniform sampler2D s_Specular;
+#endif
+
+#include "include/frame_data.glsl"
+#include "include/draw_data.glsl"
+#include "include/lights.glsl"
+
+out vec4 frag_color;
+
+// https://learnopengl.com/Advanced-Lighting/Advanced-Lighting
+vec3 ShadeLight(PointLight light, vec3 N, vec3 viewDir, float specularPower) {
+	// Lecture 5
+	vec3 ambient = light.AmbientStrength * light.Color;
+
+	// Diffuse
+	vec3 toLight = light.Position - inPos;
+	float dist = length(toLight);
+	vec3 lightDir = toLight / max(dist, 1e-5);
+
+	float dif = max(dot(N, lightDir), 0.0);
+	vec3 diffuse = dif * light.Color;// add diffuse intensity
+
+	// Specular
+#ifdef PHONG
+	vec3 reflectDir = reflect(-lightDir, N);
+	float spec = pow(max(dot(viewDir, reflectDir), 0.0), u_Shininess); // Shininess coefficient (can be a uniform)
+#else
+	vec3 h = normalize(lightDir + viewDir);
+	float spec = pow(max(dot(N, h), 0.0), u_Shininess); // Shininess coefficient (can be a uniform)
+#endif
+	vec3 specular = specularPower * spec * light.Color; // Can also use a specular color
+
+	float attenuation = 1.0;
+#if defined(ATTENUATION) || defined(CLUSTERED)
+	// Fade the light out to nothing at its radius, so it can't pop when it leaves a cluster. Without either
+	// keyword the light keeps its unlimited range
+	float window = clamp(1.0 - pow(dist / light.Radius, 4.0), 0.0, 1.0);
+	attenuation = window * window;
+#endif
+#ifdef ATTENUATION
+	attenuation /= (
+		u_LightAttenuationConstant + 
+		u_LightAttenuationLinear * dist +
+		u_LightAttenuationQuadratic * dist * dist);
+#endif
+
+	return (ambient + diffuse + specular) * attenuation;
+}
+
+void main() {
+	vec3 N = normalize(inNormal);
+	vec3 viewDir = normalize(u_CamPos - inPos);
+
+	float specularPower = u_SpecularLightStrength;
+#ifdef SPECULAR_MAP
+	// Get the specular power from the specular map
+	specularPower *= texture(s_Specular, inUV).x;
+#endif
+
+	vec3 lighting = vec3(0.0);
+#ifdef CLUSTERED
+	float viewDepth = -(u_View * vec4(inPos, 1.0)).z;
+	uvec2 cluster = GetLightCluster(gl_FragCoord.xy, viewDepth);
+	for (uint ix = cluster.x; ix < cluster.x + cluster.y; ix++) {
+		lighting += ShadeLight(u_Lights[u_LightIndices[ix]], N, viewDir, specularPower);
+	}
+#else
+	for (uint ix = 0; ix < u_LightCount; ix++) {
+		lighting += ShadeLight(u_Lights[ix], N, viewDir, specularPower);
+	}
+#endif
+
+	// Get the albedo from the diffuse / albedo map
+#ifdef TEXTURED
+	vec4 textureColor = texture(s_Diffuse, inUV);
+#else
+	vec4 textureColor = vec4(1.0);
+#endif
+	vec3 result = (
+		(u_AmbientCol * u_AmbientStrength) + // global ambient light
+		lighting // light factors from every light that reaches us
+		) * inColor * textureColor.rgb; // Object color
+
+	frag_color = vec4(result, textureColor.a);
+}
@@ -0,0 +1,8 @@
+// Uniforms that are shared by every instance in a draw, must match DrawUniforms in UniformBlocks.h
+layout(std140) uniform b_DrawData {
+	// How to decode packed vertex formats, see VertexDecodeInfo
+	vec3  u_PositionScale;
+	float u_Shininess;
+	vec3  u_PositionOffset;
+	bool  u_OctahedralNormals;
+};
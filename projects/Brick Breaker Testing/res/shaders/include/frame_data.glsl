@@ -0,0 +1,20 @@
+// Uniforms that are the same for every draw in a frame, must match FrameUniforms in UniformBlocks.h
+layout(std140) uniform b_FrameData {
+	mat4  u_View;
+	vec3  u_CamPos;
+	float u_AmbientStrength;
+	vec3  u_AmbientCol;
+	float u_SpecularLightStrength;
+	// See https://learnopengl.com/Lighting/Light-casters for a good reference on how this all works, or
+	// https://developer.valvesoftware.com/wiki/Constant-Linear-Quadratic_Falloff
+	float u_LightAttenuationConstant;
+	float u_LightAttenuationLinear;
+	float u_LightAttenuationQuadratic;
+	// The number of lights in u_Lights
+	uint  u_LightCount;
+	// The size of the cluster grid, and how to find a fragment's cluster (see LightClusterGrid)
+	uvec3 u_ClusterCount;
+	float u_ClusterDepthScale;
+	vec2  u_ClusterTileSize;
+	float u_ClusterDepthBias;
+};
@@ -0,0 +1,31 @@
+// The lights for the frame, and the cluster grid that sorts them by where they land in the view frustum.
+// Needs #version 430 for shader storage blocks, and b_FrameData to be included first
+
+// Must match PointLight in UniformBlocks.h
+struct PointLight {
+	vec3  Position;
+	float Radius;
+	vec3  Color;
+	float AmbientStrength;
+};
+
+// The bindings must match the *_BINDING constants in LightClusterGrid.h
+layout(std430, binding = 0) readonly buffer b_Lights {
+	PointLight u_Lights[];
+};
+// For every cluster, the offset of its first light in u_LightIndices (x) and how many lights it has (y)
+layout(std430, binding = 1) readonly buffer b_Clusters {
+	uvec2 u_Clusters[];
+};
+layout(std430, binding = 2) readonly buffer b_LightIndices {
+	uint u_LightIndices[];
+};
+
+// Gets the offset and count of the lights that could touch a fragment, from its window position and its
+// depth in view space. Clusters are split evenly across the screen, and exponentially along the depth
+uvec2 GetLightCluster(vec2 fragCoord, float viewDepth) {
+	uvec2 tile = min(uvec2(fragCoord / u_ClusterTileSize), u_ClusterCount.xy - 1);
+	float slice = log(max(viewDepth, 1e-5)) * u_ClusterDepthScale + u_ClusterDepthBias;
+	uint z = uint(clamp(slice, 0.0, float(u_ClusterCount.z - 1)));
+	return u_Clusters[(z * u_ClusterCount.y + tile.y) * u_ClusterCount.x + tile.x];
+}
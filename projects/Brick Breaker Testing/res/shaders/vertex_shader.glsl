@@ -4,29 +4,49 @@ layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec2 inUV;
+// Only used by packed vertex formats, see VertexDecodeInfo
+layout(location = 4) in vec2 inNormalOct;
 
 layout(location = 0) out vec3 outPos;
 layout(location = 1) out vec3 outColor;
 layout(location = 2) out vec3 outNormal;
 layout(location = 3) out vec2 outUV;
 
-uniform mat4 u_ModelViewProjection;
-uniform mat4 u_View;
-uniform mat4 u_Model;
-uniform mat3 u_ModelRotation;
-uniform vec3 u_LightPos;
-
+#include "include/frame_data.glsl"
+#include "include/draw_data.glsl"
+
+// Must match InstanceUniforms::MAX_INSTANCES
+#define MAX_INSTANCES 64
+
+// Uniforms that change with every instance, must match InstanceUniforms in UniformBlocks.h
+layout(std140) uniform b_InstanceData {
+	mat4  u_ModelViewProjection[MAX_INSTANCES];
+	mat4  u_Model[MAX_INSTANCES];
+	mat3  u_NormalMatrix[MAX_INSTANCES];
+};
+
+// Decodes a normal that was packed with OctEncode in VertexTypes.h
+vec3 OctDecode(vec2 encoded) {
+	vec3 result = vec3(encoded.xy, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float t = max(-result.z, 0.0);
+	result.x += result.x >= 0.0 ? -t : t;
+	result.y += result.y >= 0.0 ? -t : t;
+	return normalize(result);
+}
 
 void main() {
 
-	gl_Position = u_ModelViewProjection * vec4(inPosition, 1.0);
+	vec3 position = inPosition * u_PositionScale + u_PositionOffset;
+	vec3 normal = u_OctahedralNormals ? OctDecode(inNormalOct) : inNormal;
+
+	gl_Position = u_ModelViewProjection[gl_InstanceID] * vec4(position, 1.0);
 
 	// Lecture 5
 	// Pass vertex pos in world space to frag shader
-	outPos = (u_Model * vec4(inPosition, 1.0)).xyz;
+	outPos = (u_Model[gl_InstanceID] * vec4(position, 1.0)).xyz;
 
 	// Normals
-	outNormal = (u_Model * vec4(inNormal, 1.0f)).xyz;
+	outNormal = u_NormalMatrix[gl_InstanceID] * normal;
 
 	// Pass our UV coords to the fragment shader
 	outUV = inUV;
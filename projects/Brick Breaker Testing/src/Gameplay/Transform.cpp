@@ -1,10 +1,10 @@
 #include "Transform.h"
 
+#include <vector>
 #include <GLM/gtc/matrix_transform.hpp>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <GLM/gtx/quaternion.hpp>
-
-const glm::mat4 IDENTITY = glm::mat4(1.0f);
+#include "NOU/TransformBatch.h"
 
 Transform* Transform::SetLocalRotation(const glm::vec3 eulerDegrees) {
 	_rotationEulerDeg = eulerDegrees;
@@ -117,11 +117,48 @@ const glm::mat3& Transform::NormalMatrix() const {
 	return _normalMatrix;	
 }
 
+void Transform::UpdateDirty(const Transform* const* transforms, size_t count) {
+	// The kernel wants each input in its own array, so we gather the dirty transforms up first. These are kept
+	// between calls (per thread) so we aren't allocating every frame
+	static thread_local std::vector<const Transform*> dirty;
+	static thread_local std::vector<glm::vec3> positions;
+	static thread_local std::vector<glm::quat> rotations;
+	static thread_local std::vector<glm::vec3> scales;
+	static thread_local std::vector<glm::mat4> results;
+	static thread_local std::vector<glm::mat3> normals;
+	dirty.clear();
+	positions.clear();
+	rotations.clear();
+	scales.clear();
+	for (size_t ix = 0; ix < count; ix++) {
+		const Transform* transform = transforms[ix];
+		if (transform->_isLocalDirty) {
+			// Clearing the flag now means we only gather duplicates once
+			transform->_isLocalDirty = false;
+			dirty.push_back(transform);
+			positions.push_back(transform->_position);
+			rotations.push_back(transform->_rotation);
+			scales.push_back(transform->_scale);
+		}
+	}
+	if (dirty.empty()) {
+		return;
+	}
+
+	results.resize(dirty.size());
+	normals.resize(dirty.size());
+	nou::ComposeTransforms(positions.data(), rotations.data(), scales.data(), results.data(), normals.data(), dirty.size());
+	for (size_t ix = 0; ix < dirty.size(); ix++) {
+		dirty[ix]->_localTransform = results[ix];
+		dirty[ix]->_normalMatrix = normals[ix];
+	}
+}
+
 void Transform::_UpdateLocalTransformIfDirty() const {
 	if (_isLocalDirty) {
-		// TRS
-		_localTransform = glm::translate(IDENTITY, _position) * glm::toMat4(_rotation) * glm::scale(IDENTITY, _scale);
-		_normalMatrix = glm::transpose(glm::inverse(glm::mat3(_localTransform)));
+		// TRS, built straight from the rotation rather than multiplying 3 matrices. The normal matrix is the rotation
+		// divided by the scale, rather than a full inverse
+		nou::ComposeTransforms(&_position, &_rotation, &_scale, &_localTransform, &_normalMatrix, 1);
 
 		_isLocalDirty = false;
 	}
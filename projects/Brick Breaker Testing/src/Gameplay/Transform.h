@@ -172,6 +172,15 @@ public:
 	/// </summary>
 	const glm::mat3& NormalMatrix() const;
 
+	/// <summary>
+	/// Updates the local and normal matrices of every dirty transform in the list at once, using the SIMD batch
+	/// kernel from NOU. This is much faster than letting each transform update itself the first time it's used.
+	/// The list may contain the same transform more than once
+	/// </summary>
+	/// <param name="transforms">The transforms to update</param>
+	/// <param name="count">The number of transforms in the list</param>
+	static void UpdateDirty(const Transform* const* transforms, size_t count);
+
 private:
 	mutable bool _isLocalDirty;
 	mutable glm::mat4 _localTransform;
@@ -0,0 +1,240 @@
+#include "LightClusterGrid.h"
+#include "TTK/Profiler.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHT_CLUSTER_SSE
+#include <emmintrin.h>
+#endif
+
+static_assert(LightClusterGrid::TILES_X % 4 == 0, "TILES_X must be a multiple of 4");
+static_assert(LightClusterGrid::TILES_X <= 32, "A row of clusters must fit in a 32 bit mask");
+
+// Tests a sphere against 4 cluster bounds at once, returning a bit for each cluster the sphere touches
+static inline uint32_t __TestSphere4(const float* const* boundsMin, const float* const* boundsMax, uint32_t first, const glm::vec3& center, float radiusSq) {
+#ifdef LIGHT_CLUSTER_SSE
+	const __m128 zero = _mm_setzero_ps();
+	__m128 distSq = zero;
+	for (int axis = 0; axis < 3; axis++) {
+		// The distance along this axis from the center to the box, which is zero when the center is inside it
+		__m128 c = _mm_set1_ps(center[axis]);
+		__m128 below = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(boundsMin[axis] + first), c), zero);
+		__m128 above = _mm_max_ps(_mm_sub_ps(c, _mm_loadu_ps(boundsMax[axis] + first)), zero);
+		__m128 dist = _mm_add_ps(below, above);
+		distSq = _mm_add_ps(distSq, _mm_mul_ps(dist, dist));
+	}
+	return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(distSq, _mm_set1_ps(radiusSq))));
+#else
+	uint32_t result = 0;
+	for (uint32_t lane = 0; lane < 4; lane++) {
+		float distSq = 0.0f;
+		for (int axis = 0; axis < 3; axis++) {
+			float dist = std::max(boundsMin[axis][first + lane] - center[axis], 0.0f) + std::max(center[axis] - boundsMax[axis][first + lane], 0.0f);
+			distSq += dist * dist;
+		}
+		result |= (distSq <= radiusSq ? 1u : 0u) << lane;
+	}
+	return result;
+#endif
+}
+
+LightClusterGrid::LightClusterGrid() :
+	_projection(glm::mat4(0.0f)),
+	_nearPlane(0.0f),
+	_farPlane(0.0f),
+	_depthScale(0.0f),
+	_depthBias(0.0f),
+	_tileSize(glm::vec2(1.0f)),
+	_stats({ 0, 0, 0, 0.0 })
+{
+	_lightBuffer = ShaderStorageBuffer::Create();
+	_clusterBuffer = ShaderStorageBuffer::Create();
+	_indexBuffer = ShaderStorageBuffer::Create();
+	for (int axis = 0; axis < 3; axis++) {
+		_boundsMin[axis].resize(CLUSTER_COUNT);
+		_boundsMax[axis].resize(CLUSTER_COUNT);
+	}
+	_counts.resize(CLUSTER_COUNT);
+	_clusters.resize(CLUSTER_COUNT);
+}
+
+void LightClusterGrid::Build(const std::vector<PointLight>& lights, const Camera::sptr& camera, int width, int height) {
+	PROFILE_FUNCTION();
+	auto buildStart = std::chrono::high_resolution_clock::now();
+
+	const glm::mat4& projection = camera->GetProjection();
+	if (projection != _projection || camera->GetNearPlane() != _nearPlane || camera->GetFarPlane() != _farPlane) {
+		_RebuildBounds(projection, camera->GetNearPlane(), camera->GetFarPlane());
+	}
+	if (width > 0 && height > 0) {
+		_tileSize = glm::vec2(static_cast<float>(width) / TILES_X, static_cast<float>(height) / TILES_Y);
+	}
+
+	// Gather every (cluster, light) pair, then counting sort them so each cluster's lights end up next to each other
+	_refs.clear();
+	std::fill(_counts.begin(), _counts.end(), 0);
+	const glm::mat4& view = camera->GetView();
+	for (size_t ix = 0; ix < lights.size(); ix++) {
+		glm::vec3 viewPos = glm::vec3(view * glm::vec4(lights[ix].Position, 1.0f));
+		_AddLight(viewPos, lights[ix].Radius, static_cast<uint32_t>(ix));
+	}
+
+	uint32_t offset = 0;
+	uint32_t maxCount = 0;
+	for (uint32_t ix = 0; ix < CLUSTER_COUNT; ix++) {
+		_clusters[ix] = glm::uvec2(offset, 0);
+		offset += _counts[ix];
+		maxCount = std::max(maxCount, _counts[ix]);
+	}
+	_indices.resize(_refs.size());
+	for (const LightRef& ref : _refs) {
+		glm::uvec2& cluster = _clusters[ref.Cluster];
+		_indices[cluster.x + cluster.y] = ref.Light;
+		cluster.y++;
+	}
+
+	_lightBuffer->Update(lights.data(), lights.size());
+	_clusterBuffer->Update(_clusters.data(), _clusters.size());
+	_indexBuffer->Update(_indices.data(), _indices.size());
+
+	std::chrono::duration<double, std::milli> buildTime = std::chrono::high_resolution_clock::now() - buildStart;
+	_stats.Lights = lights.size();
+	_stats.LightIndices = _indices.size();
+	_stats.MaxLightsPerCluster = maxCount;
+	_stats.BuildTimeMs = buildTime.count();
+}
+
+void LightClusterGrid::Bind() {
+	_lightBuffer->Bind(LIGHT_BINDING);
+	_clusterBuffer->Bind(CLUSTER_BINDING);
+	_indexBuffer->Bind(INDEX_BINDING);
+}
+
+void LightClusterGrid::FillUniforms(FrameUniforms& uniforms) const {
+	uniforms.LightCount = static_cast<uint32_t>(_stats.Lights);
+	uniforms.ClusterCount = glm::uvec3(TILES_X, TILES_Y, SLICES);
+	uniforms.ClusterDepthScale = _depthScale;
+	uniforms.ClusterTileSize = _tileSize;
+	uniforms.ClusterDepthBias = _depthBias;
+}
+
+void LightClusterGrid::_RebuildBounds(const glm::mat4& projection, float nearPlane, float farPlane) {
+	_projection = projection;
+	_nearPlane = nearPlane;
+	_farPlane = farPlane;
+
+	// Slice s starts at near * (far / near)^(s / SLICES), so the slice for a depth is log(depth) * scale + bias
+	float logRange = std::log(farPlane / nearPlane);
+	_depthScale = SLICES / logRange;
+	_depthBias = -(SLICES * std::log(nearPlane)) / logRange;
+
+	// Find the line through the frustum under each corner of the tile grid. Working from the inverse projection
+	// rather than the field of view means this works for orthographic cameras too
+	glm::mat4 inverse = glm::inverse(projection);
+	std::vector<glm::vec3> nearPoints((TILES_X + 1) * (TILES_Y + 1));
+	std::vector<glm::vec3> farPoints(nearPoints.size());
+	for (uint32_t y = 0; y <= TILES_Y; y++) {
+		for (uint32_t x = 0; x <= TILES_X; x++) {
+			glm::vec2 ndc = glm::vec2(x / (float)TILES_X, y / (float)TILES_Y) * 2.0f - 1.0f;
+			glm::vec4 nearPoint = inverse * glm::vec4(ndc, -1.0f, 1.0f);
+			glm::vec4 farPoint = inverse * glm::vec4(ndc, 1.0f, 1.0f);
+			nearPoints[y * (TILES_X + 1) + x] = glm::vec3(nearPoint) / nearPoint.w;
+			farPoints[y * (TILES_X + 1) + x] = glm::vec3(farPoint) / farPoint.w;
+		}
+	}
+
+	for (uint32_t z = 0; z < SLICES; z++) {
+		float depths[2] = {
+			nearPlane * std::pow(farPlane / nearPlane, z / (float)SLICES),
+			nearPlane * std::pow(farPlane / nearPlane, (z + 1) / (float)SLICES)
+		};
+		for (uint32_t y = 0; y < TILES_Y; y++) {
+			for (uint32_t x = 0; x < TILES_X; x++) {
+				glm::vec3 boundsMin = glm::vec3(FLT_MAX);
+				glm::vec3 boundsMax = glm::vec3(-FLT_MAX);
+				for (uint32_t corner = 0; corner < 4; corner++) {
+					uint32_t point = (y + (corner >> 1)) * (TILES_X + 1) + x + (corner & 1);
+					const glm::vec3& a = nearPoints[point];
+					const glm::vec3& b = farPoints[point];
+					for (float depth : depths) {
+						glm::vec3 p = glm::mix(a, b, (depth + a.z) / (a.z - b.z));
+						boundsMin = glm::min(boundsMin, p);
+						boundsMax = glm::max(boundsMax, p);
+					}
+				}
+				uint32_t cluster = (z * TILES_Y + y) * TILES_X + x;
+				for (int axis = 0; axis < 3; axis++) {
+					_boundsMin[axis][cluster] = boundsMin[axis];
+					_boundsMax[axis][cluster] = boundsMax[axis];
+				}
+			}
+		}
+	}
+}
+
+uint32_t LightClusterGrid::_GetSlice(float viewDepth) const {
+	float slice = std::log(std::max(viewDepth, 1e-5f)) * _depthScale + _depthBias;
+	return static_cast<uint32_t>(glm::clamp(slice, 0.0f, (float)(SLICES - 1)));
+}
+
+void LightClusterGrid::_AddLight(const glm::vec3& viewPos, float radius, uint32_t lightIndex) {
+	// The camera looks down -Z, so depths are the negated Z
+	float minDepth = std::max(-viewPos.z - radius, _nearPlane);
+	float maxDepth = std::min(-viewPos.z + radius, _farPlane);
+	if (minDepth > maxDepth) {
+		return;
+	}
+
+	// Project the light's bounding box to find which tiles it could cover. The box is clipped to the near plane,
+	// so its corners on that plane give the widest extent on screen
+	glm::vec2 ndcMin = glm::vec2(FLT_MAX);
+	glm::vec2 ndcMax = glm::vec2(-FLT_MAX);
+	for (uint32_t corner = 0; corner < 8; corner++) {
+		glm::vec4 point = glm::vec4(
+			viewPos.x + ((corner & 1) ? radius : -radius),
+			viewPos.y + ((corner & 2) ? radius : -radius),
+			(corner & 4) ? -maxDepth : -minDepth,
+			1.0f);
+		glm::vec4 clip = _projection * point;
+		glm::vec2 ndc = glm::vec2(clip) / clip.w;
+		ndcMin = glm::min(ndcMin, ndc);
+		ndcMax = glm::max(ndcMax, ndc);
+	}
+	if (ndcMax.x < -1.0f || ndcMax.y < -1.0f || ndcMin.x > 1.0f || ndcMin.y > 1.0f) {
+		return;
+	}
+	glm::vec2 gridSize = glm::vec2(TILES_X, TILES_Y);
+	glm::uvec2 firstTile = glm::uvec2(glm::clamp((ndcMin * 0.5f + 0.5f) * gridSize, glm::vec2(0.0f), gridSize - 1.0f));
+	glm::uvec2 lastTile  = glm::uvec2(glm::clamp((ndcMax * 0.5f + 0.5f) * gridSize, glm::vec2(0.0f), gridSize - 1.0f));
+	uint32_t firstSlice = _GetSlice(minDepth);
+	uint32_t lastSlice = _GetSlice(maxDepth);
+
+	// Only keep the tiles in range from each group of 4 we test
+	uint32_t rangeMask = (lastTile.x == 31 ? ~0u : ((1u << (lastTile.x + 1)) - 1u)) & ~((1u << firstTile.x) - 1u);
+
+	const float* boundsMin[3] = { _boundsMin[0].data(), _boundsMin[1].data(), _boundsMin[2].data() };
+	const float* boundsMax[3] = { _boundsMax[0].data(), _boundsMax[1].data(), _boundsMax[2].data() };
+	float radiusSq = radius * radius;
+	for (uint32_t z = firstSlice; z <= lastSlice; z++) {
+		for (uint32_t y = firstTile.y; y <= lastTile.y; y++) {
+			uint32_t row = (z * TILES_Y + y) * TILES_X;
+			uint32_t mask = 0;
+			for (uint32_t x = firstTile.x & ~3u; x <= lastTile.x; x += 4) {
+				mask |= __TestSphere4(boundsMin, boundsMax, row + x, viewPos, radiusSq) << x;
+			}
+			mask &= rangeMask;
+			while (mask != 0) {
+				uint32_t x = 0;
+				while ((mask & (1u << x)) == 0) {
+					x++;
+				}
+				mask &= mask - 1;
+				_refs.push_back({ row + x, lightIndex });
+				_counts[row + x]++;
+			}
+		}
+	}
+}
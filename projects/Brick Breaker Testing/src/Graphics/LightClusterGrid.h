@@ -0,0 +1,130 @@
+#pragma once
+#include <memory>
+#include <cstdint>
+#include <vector>
+
+#include <GLM/glm.hpp>
+
+#include "Gameplay/Camera.h"
+#include "Graphics/ShaderStorageBuffer.h"
+#include "Graphics/UniformBlocks.h"
+
+/// <summary>
+/// Sorts the lights in a frame into a 3D grid of clusters (or froxels) over the view frustum, so that each fragment
+/// only has to shade with the handful of lights that can actually reach it. The grid is split evenly into tiles
+/// across the screen, and exponentially along the view depth so that clusters stay roughly cube shaped.
+///
+/// The grid is built on the CPU each frame. Each light is projected to find the block of clusters it could touch,
+/// then its bounding sphere is tested against every cluster in that block, 4 clusters at a time with SSE. The
+/// result is uploaded as 3 shader storage buffers, which are read by include/lights.glsl:
+///    b_Lights       - Every light, in the order they were given to Build
+///    b_Clusters     - The offset and count of each cluster's lights in b_LightIndices
+///    b_LightIndices - The light indices for every cluster, packed one after the other
+/// </summary>
+class LightClusterGrid final
+{
+public:
+	typedef std::shared_ptr<LightClusterGrid> sptr;
+	static inline sptr Create() {
+		return std::make_shared<LightClusterGrid>();
+	}
+
+public:
+	// We'll disallow moving and copying, since we want to manually control when the destructor is called
+	// We'll use these classes via pointers
+	LightClusterGrid(const LightClusterGrid& other) = delete;
+	LightClusterGrid(LightClusterGrid&& other) = delete;
+	LightClusterGrid& operator=(const LightClusterGrid& other) = delete;
+	LightClusterGrid& operator=(LightClusterGrid&& other) = delete;
+
+	/// <summary>
+	/// The number of clusters across the screen, up the screen, and into the screen. TILES_X must be a multiple of 4
+	/// so that each row of clusters can be tested with whole SSE registers
+	/// </summary>
+	static constexpr uint32_t TILES_X = 16;
+	static constexpr uint32_t TILES_Y = 9;
+	static constexpr uint32_t SLICES = 24;
+	static constexpr uint32_t CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+
+	/// <summary>
+	/// The shader storage block bindings, these must match the bindings in include/lights.glsl
+	/// </summary>
+	static const GLuint LIGHT_BINDING = 0;
+	static const GLuint CLUSTER_BINDING = 1;
+	static const GLuint INDEX_BINDING = 2;
+
+	/// <summary>
+	/// What happened during the last Build
+	/// </summary>
+	struct Stats
+	{
+		size_t   Lights;
+		// The total number of entries across every cluster's light list
+		size_t   LightIndices;
+		uint32_t MaxLightsPerCluster;
+		double   BuildTimeMs;
+	};
+
+public:
+	LightClusterGrid();
+	~LightClusterGrid() = default;
+
+	/// <summary>
+	/// Sorts the lights into clusters and uploads the results, this should be called once per frame after the
+	/// camera has moved
+	/// </summary>
+	/// <param name="lights">The lights to sort, in world space</param>
+	/// <param name="camera">The camera we are drawing from</param>
+	/// <param name="width">The width of the viewport, in pixels</param>
+	/// <param name="height">The height of the viewport, in pixels</param>
+	void Build(const std::vector<PointLight>& lights, const Camera::sptr& camera, int width, int height);
+
+	/// <summary>
+	/// Binds the light, cluster and index buffers to their binding points
+	/// </summary>
+	void Bind();
+
+	/// <summary>
+	/// Fills in the light count and cluster members of the frame uniforms, so shaders can find their cluster
+	/// </summary>
+	void FillUniforms(FrameUniforms& uniforms) const;
+
+	/// <summary>
+	/// Gets the statistics for the last build
+	/// </summary>
+	const Stats& GetStats() const { return _stats; }
+
+protected:
+	struct LightRef
+	{
+		uint32_t Cluster;
+		uint32_t Light;
+	};
+
+	ShaderStorageBuffer::sptr _lightBuffer;
+	ShaderStorageBuffer::sptr _clusterBuffer;
+	ShaderStorageBuffer::sptr _indexBuffer;
+
+	// The view space bounding box of every cluster, split into one array per axis so a row of clusters can be
+	// loaded straight into SSE registers
+	std::vector<float> _boundsMin[3];
+	std::vector<float> _boundsMax[3];
+	// The projection the bounds were built for, so we only rebuild them when it changes
+	glm::mat4 _projection;
+	float     _nearPlane;
+	float     _farPlane;
+	float     _depthScale;
+	float     _depthBias;
+	glm::vec2 _tileSize;
+
+	std::vector<LightRef>   _refs;
+	std::vector<uint32_t>   _counts;
+	std::vector<glm::uvec2> _clusters;
+	std::vector<uint32_t>   _indices;
+
+	Stats _stats;
+
+	void _RebuildBounds(const glm::mat4& projection, float nearPlane, float farPlane);
+	uint32_t _GetSlice(float viewDepth) const;
+	void _AddLight(const glm::vec3& viewPos, float radius, uint32_t lightIndex);
+};
@@ -0,0 +1,24 @@
+#include "Material.h"
+
+uint32_t Material::_nextId = 0;
+
+Material::Material() :
+	Albedo(nullptr),
+	Specular(nullptr),
+	Shininess(16.0f),
+	IsTransparent(false),
+	_id(_nextId++)
+{ }
+
+void Material::Apply() const {
+	if (Albedo != nullptr) {
+		Albedo->Bind(0);
+	} else {
+		Texture2D::UnBind(0);
+	}
+	if (Specular != nullptr) {
+		Specular->Bind(1);
+	} else {
+		Texture2D::UnBind(1);
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <memory>
+#include <cstdint>
+
+#include "Texture2D.h"
+
+/// <summary>
+/// The textures and surface properties that an object is drawn with. Each material gets a unique ID
+/// when it is created, which the RenderQueue uses to group together objects that share a material,
+/// so objects that look the same should share the same material rather than each having a copy
+/// </summary>
+class Material final
+{
+public:
+	typedef std::shared_ptr<Material> sptr;
+	static inline sptr Create() {
+		return std::make_shared<Material>();
+	}
+
+public:
+	// We'll disallow moving and copying, since the ID is what identifies a material
+	Material(const Material& other) = delete;
+	Material(Material&& other) = delete;
+	Material& operator=(const Material& other) = delete;
+	Material& operator=(Material&& other) = delete;
+
+	Material();
+	~Material() = default;
+
+	Texture2D::sptr Albedo;
+	Texture2D::sptr Specular;
+	float           Shininess;
+	// Transparent materials are drawn after all opaque objects, back to front and with blending enabled
+	bool            IsTransparent;
+
+	/// <summary>
+	/// Gets the unique ID of this material
+	/// </summary>
+	uint32_t GetId() const { return _id; }
+
+	/// <summary>
+	/// Binds this material's textures, the albedo goes in slot 0 and the specular map in slot 1
+	/// </summary>
+	void Apply() const;
+
+protected:
+	uint32_t _id;
+
+	static uint32_t _nextId;
+};
@@ -0,0 +1,233 @@
+#include "RenderQueue.h"
+#include "Logging.h"
+#include "TTK/GLStateCache.h"
+#include "TTK/Profiler.h"
+#include "NOU/Frustum.h"
+#include <chrono>
+#include <cstring>
+
+// The number of bits each field gets in the sort key, see the comment on RenderQueue
+static const int LAYER_BITS = 4;
+static const int ID_BITS = 12;
+static const int DEPTH_BITS = 23;
+static const uint64_t ID_MASK = (1ull << ID_BITS) - 1;
+static const uint64_t DEPTH_MASK = (1ull << DEPTH_BITS) - 1;
+
+RenderQueue::RenderQueue() :
+	_items(std::vector<Item>()),
+	_sorted(std::vector<SortEntry>()),
+	_scratch(std::vector<SortEntry>()),
+	_transforms(std::vector<const Transform*>()),
+	_bounds(std::vector<glm::vec4>()),
+	_visible(std::vector<uint8_t>()),
+	_drawData(nullptr),
+	_instanceData(nullptr),
+	_stats(Stats())
+{
+	_drawData = UniformRingBuffer::Create(sizeof(DrawUniforms));
+	// Instance blocks are big, but we only need one per draw call rather than one per object
+	_instanceData = UniformRingBuffer::Create(sizeof(InstanceUniforms), 32);
+}
+
+void RenderQueue::Submit(const VertexArrayObject::sptr& vao, const Material::sptr& material, const Transform::sptr& transform, const Shader::sptr& shader, uint8_t layer) {
+	LOG_ASSERT(layer < LAYER_COUNT, "Layer {} is out of range, there are only {} layers", layer, LAYER_COUNT);
+	_items.push_back({ vao.get(), material.get(), transform.get(), shader.get(), layer });
+}
+
+void RenderQueue::Flush(const Camera::sptr& camera) {
+	PROFILE_GPU_SCOPE("RenderQueue::Flush");
+	_stats = Stats();
+	_stats.Items = _items.size();
+	if (_items.empty()) {
+		return;
+	}
+
+	// Bring every transform's matrices up to date in one batch, rather than one at a time as we use them
+	{
+		PROFILE_SCOPE("Transforms");
+		_transforms.resize(_items.size());
+		for (size_t ix = 0; ix < _items.size(); ix++) {
+			_transforms[ix] = _items[ix].TransformPtr;
+		}
+		Transform::UpdateDirty(_transforms.data(), _transforms.size());
+	}
+
+	// Skip anything that is entirely outside of the camera's view, testing every item's bounds in one batch
+	{
+		PROFILE_SCOPE("Cull");
+		auto cullStart = std::chrono::high_resolution_clock::now();
+		_bounds.resize(_items.size());
+		_visible.resize(_items.size());
+		for (size_t ix = 0; ix < _items.size(); ix++) {
+			const MeshBounds& bounds = _items[ix].VaoPtr->GetBounds();
+			_bounds[ix] = nou::TransformSphere(_items[ix].TransformPtr->LocalTransform(), bounds.Center, bounds.Radius);
+		}
+		nou::Frustum frustum(camera->GetViewProjection());
+		_stats.Culled = _items.size() - frustum.CullSpheres(_bounds.data(), _bounds.size(), _visible.data());
+		std::chrono::duration<double, std::milli> cullTime = std::chrono::high_resolution_clock::now() - cullStart;
+		_stats.CullTimeMs = cullTime.count();
+	}
+
+	// Build and sort our keys for everything that's left
+	{
+		PROFILE_SCOPE("Sort");
+		auto sortStart = std::chrono::high_resolution_clock::now();
+		const glm::vec3& cameraPos = camera->GetPosition();
+		_sorted.clear();
+		for (size_t ix = 0; ix < _items.size(); ix++) {
+			if (!_visible[ix]) {
+				continue;
+			}
+			const Item& item = _items[ix];
+			glm::vec3 offset = glm::vec3(item.TransformPtr->LocalTransform()[3]) - cameraPos;
+			_sorted.push_back({ _MakeKey(item, glm::dot(offset, offset)), static_cast<uint32_t>(ix) });
+		}
+		if (_sorted.empty()) {
+			_items.clear();
+			return;
+		}
+		_RadixSort();
+		std::chrono::duration<double, std::milli> sortTime = std::chrono::high_resolution_clock::now() - sortStart;
+		_stats.SortTimeMs = sortTime.count();
+	}
+
+	_drawData->BeginFrame();
+	_instanceData->BeginFrame();
+
+	const glm::mat4& viewProjection = camera->GetViewProjection();
+	const VertexArrayObject* currentVao = nullptr;
+	const Material* currentMaterial = nullptr;
+	Shader* currentShader = nullptr;
+	bool isTransparentPass = false;
+
+	size_t start = 0;
+	while (start < _sorted.size()) {
+		const Item& first = _items[_sorted[start].Index];
+
+		// Grab every following item that can be drawn in the same call
+		size_t end = start + 1;
+		while (end < _sorted.size() && end - start < InstanceUniforms::MAX_INSTANCES) {
+			const Item& next = _items[_sorted[end].Index];
+			if (next.VaoPtr != first.VaoPtr || next.MaterialPtr != first.MaterialPtr || next.ShaderPtr != first.ShaderPtr) {
+				break;
+			}
+			end++;
+		}
+
+		if (first.MaterialPtr->IsTransparent != isTransparentPass) {
+			isTransparentPass = first.MaterialPtr->IsTransparent;
+			_SetTransparentPass(isTransparentPass);
+			_stats.StateChanges++;
+		}
+		if (first.ShaderPtr != currentShader) {
+			currentShader = first.ShaderPtr;
+			currentShader->Bind();
+			_stats.StateChanges++;
+		}
+		if (first.MaterialPtr != currentMaterial) {
+			currentMaterial = first.MaterialPtr;
+			currentMaterial->Apply();
+			_stats.StateChanges++;
+		}
+		if (first.VaoPtr != currentVao) {
+			currentVao = first.VaoPtr;
+			_stats.StateChanges++;
+		}
+
+		const VertexDecodeInfo& decode = currentVao->GetDecodeInfo();
+		DrawUniforms drawUniforms;
+		drawUniforms.PositionScale = decode.PositionScale;
+		drawUniforms.Shininess = currentMaterial->Shininess;
+		drawUniforms.PositionOffset = decode.PositionOffset;
+		drawUniforms.OctahedralNormals = decode.OctahedralNormals;
+		_drawData->Push(drawUniforms, DrawUniforms::BINDING);
+
+		// We write straight into the mapped ring, and only as many instances as we actually have
+		InstanceUniforms* instances = _instanceData->Allocate<InstanceUniforms>(InstanceUniforms::BINDING);
+		for (size_t ix = start; ix < end; ix++) {
+			const Transform* transform = _items[_sorted[ix].Index].TransformPtr;
+			const size_t instance = ix - start;
+			instances->ModelViewProjection[instance] = viewProjection * transform->LocalTransform();
+			instances->Model[instance] = transform->LocalTransform();
+			instances->NormalMatrix[instance] = glm::mat3x4(transform->NormalMatrix());
+		}
+
+		currentVao->Render(static_cast<uint32_t>(end - start));
+		_stats.DrawCalls++;
+		start = end;
+	}
+
+	if (isTransparentPass) {
+		_SetTransparentPass(false);
+	}
+
+	_drawData->EndFrame();
+	_instanceData->EndFrame();
+	_items.clear();
+}
+
+uint64_t RenderQueue::_MakeKey(const Item& item, float depth) {
+	// Positive floats sort the same way as their bits do, so we can just keep the top bits of the distance
+	uint32_t depthBits = 0;
+	memcpy(&depthBits, &depth, sizeof(float));
+	uint64_t depthKey = (depthBits >> (32 - 1 - DEPTH_BITS)) & DEPTH_MASK;
+
+	// These may collide if there are a lot of objects, which only means we might switch state more often,
+	// since batching compares the actual objects
+	uint64_t shaderKey = item.ShaderPtr->GetHandle() & ID_MASK;
+	uint64_t materialKey = item.MaterialPtr->GetId() & ID_MASK;
+	uint64_t meshKey = item.VaoPtr->GetHandle() & ID_MASK;
+
+	uint64_t key = (uint64_t)item.Layer << (64 - LAYER_BITS);
+	if (item.MaterialPtr->IsTransparent) {
+		// Transparent items go after the opaque ones, and are sorted back to front
+		key |= 1ull << (63 - LAYER_BITS);
+		key |= (DEPTH_MASK - depthKey) << (3 * ID_BITS);
+		key |= shaderKey << (2 * ID_BITS);
+		key |= materialKey << ID_BITS;
+		key |= meshKey;
+	} else {
+		// Opaque items are sorted by state, and then front to back so that the depth test can reject more fragments
+		key |= shaderKey << (2 * ID_BITS + DEPTH_BITS);
+		key |= materialKey << (ID_BITS + DEPTH_BITS);
+		key |= meshKey << DEPTH_BITS;
+		key |= depthKey;
+	}
+	return key;
+}
+
+void RenderQueue::_RadixSort() {
+	// Least significant digit radix sort, 8 bits at a time. Our keys tend to share a lot of bits (most scenes
+	// use few layers and shaders), so we skip any pass where every key has the same digit
+	_scratch.resize(_sorted.size());
+	for (int shift = 0; shift < 64; shift += 8) {
+		size_t counts[256] = { 0 };
+		for (const SortEntry& entry : _sorted) {
+			counts[(entry.Key >> shift) & 0xFF]++;
+		}
+		if (counts[(_sorted[0].Key >> shift) & 0xFF] == _sorted.size()) {
+			continue;
+		}
+
+		size_t offset = 0;
+		for (size_t& count : counts) {
+			size_t bucketSize = count;
+			count = offset;
+			offset += bucketSize;
+		}
+		for (const SortEntry& entry : _sorted) {
+			_scratch[counts[(entry.Key >> shift) & 0xFF]++] = entry;
+		}
+		_sorted.swap(_scratch);
+	}
+}
+
+void RenderQueue::_SetTransparentPass(bool isTransparent) {
+	TTK::GLStateCache& state = TTK::GLStateCache::Instance();
+	state.SetEnabled(GL_BLEND, isTransparent);
+	// Transparent objects still test against the depth buffer, but shouldn't hide anything behind them
+	state.SetDepthMask(!isTransparent);
+	if (isTransparent) {
+		state.SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
+}
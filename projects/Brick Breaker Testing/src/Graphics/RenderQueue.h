@@ -0,0 +1,118 @@
+#pragma once
+#include <memory>
+#include <cstdint>
+#include <vector>
+
+#include "Gameplay/Camera.h"
+#include "Gameplay/Transform.h"
+#include "Graphics/Material.h"
+#include "Graphics/Shader.h"
+#include "Graphics/UniformRingBuffer.h"
+#include "Graphics/VertexArrayObject.h"
+
+/// <summary>
+/// Collects everything that needs to be drawn in a frame, and draws it in an order that keeps state changes
+/// to a minimum. Each item gets a 64 bit sort key, made up of (from most to least significant):
+///    layer (4 bits) | transparent (1 bit) | shader (12) | material (12) | mesh (12) | depth (23)
+/// Transparent items move the depth up to just after the transparent bit, and invert it, so that they are
+/// drawn back to front after all the opaque items in their layer. Consecutive items that share a shader,
+/// material and mesh are drawn together with a single instanced draw call
+/// </summary>
+class RenderQueue final
+{
+public:
+	typedef std::shared_ptr<RenderQueue> sptr;
+	static inline sptr Create() {
+		return std::make_shared<RenderQueue>();
+	}
+
+public:
+	// We'll disallow moving and copying, since we want to manually control when the destructor is called
+	// We'll use these classes via pointers
+	RenderQueue(const RenderQueue& other) = delete;
+	RenderQueue(RenderQueue&& other) = delete;
+	RenderQueue& operator=(const RenderQueue& other) = delete;
+	RenderQueue& operator=(RenderQueue&& other) = delete;
+
+	/// <summary>
+	/// The number of layers that items can be put in, lower layers are drawn first
+	/// </summary>
+	static constexpr uint8_t LAYER_COUNT = 16;
+
+	/// <summary>
+	/// What happened during the last Flush
+	/// </summary>
+	struct Stats
+	{
+		size_t Items;
+		// The number of items that were skipped for being outside the camera's view
+		size_t Culled;
+		size_t DrawCalls;
+		// The number of shader, material, mesh and blend state switches
+		size_t StateChanges;
+		double SortTimeMs;
+		double CullTimeMs;
+	};
+
+public:
+	RenderQueue();
+	~RenderQueue() = default;
+
+	/// <summary>
+	/// Adds an item to be drawn when the queue is next flushed. The queue does not keep the objects alive,
+	/// they must stay around until Flush is called
+	/// </summary>
+	/// <param name="vao">The mesh to draw</param>
+	/// <param name="material">The material to draw the mesh with</param>
+	/// <param name="transform">The transform to place the mesh with</param>
+	/// <param name="shader">The shader to draw with, it must use our b_DrawData and b_InstanceData blocks</param>
+	/// <param name="layer">The layer to draw the item in, lower layers are drawn first</param>
+	void Submit(const VertexArrayObject::sptr& vao, const Material::sptr& material, const Transform::sptr& transform, const Shader::sptr& shader, uint8_t layer = 0);
+
+	/// <summary>
+	/// Culls, sorts and draws everything that has been submitted since the last flush, then clears the queue.
+	/// Items whose mesh bounds are entirely outside the camera's view are skipped.
+	/// This should be called once per frame, since each flush uses up a frame of our uniform ring buffers
+	/// </summary>
+	/// <param name="camera">The camera to draw from</param>
+	void Flush(const Camera::sptr& camera);
+
+	/// <summary>
+	/// Gets the statistics for the last flush
+	/// </summary>
+	const Stats& GetStats() const { return _stats; }
+
+protected:
+	struct Item
+	{
+		const VertexArrayObject* VaoPtr;
+		const Material*          MaterialPtr;
+		const Transform*         TransformPtr;
+		Shader*                  ShaderPtr;
+		uint8_t                  Layer;
+	};
+
+	struct SortEntry
+	{
+		uint64_t Key;
+		uint32_t Index;
+	};
+
+	std::vector<Item>      _items;
+	std::vector<SortEntry> _sorted;
+	std::vector<SortEntry> _scratch;
+	// The transform of every item, so they can all be updated in one batch
+	std::vector<const Transform*> _transforms;
+	// The world space bounding sphere of every item, and whether it passed the frustum test
+	std::vector<glm::vec4> _bounds;
+	std::vector<uint8_t>   _visible;
+
+	UniformRingBuffer::sptr _drawData;
+	UniformRingBuffer::sptr _instanceData;
+
+	Stats _stats;
+
+	static uint64_t _MakeKey(const Item& item, float depth);
+	void _RadixSort();
+	static void _SetTransparentPass(bool isTransparent);
+};
@@ -1,24 +1,40 @@
 #include "Shader.h"
 #include "Logging.h"
-#include <fstream>
-#include <sstream>
+#include "TTK/GLStateCache.h"
+#include "TTK/ProgramBinaryCache.h"
+
+std::unordered_map<std::string, UniformBlockLayout> Shader::_uniformBlocks;
 
 Shader::Shader() :
-	_vs(0),
-	_fs(0),
-	_handle(0)
+	_vsSource(""),
+	_fsSource(""),
+	_handle(0),
+	_uniformTable(std::vector<UniformSlot>(1, UniformSlot{ 0, -1 })),
+	_uniformSeed(1),
+	_uniformShift(32),
+	_missingUniforms(std::unordered_set<uint32_t>())
 {
 	_handle = glCreateProgram();
 }
 
 Shader::~Shader() {
 	if (_handle != 0) {
+		TTK::GLStateCache::Instance().OnProgramDeleted(_handle);
 		glDeleteProgram(_handle);
 		_handle = 0;
 	}
 }
 
 bool Shader::LoadShaderPart(const char* source, GLenum type)
+{
+	switch (type) {
+		case GL_VERTEX_SHADER: _vsSource = source; return true;
+		case GL_FRAGMENT_SHADER: _fsSource = source; return true;
+		default: LOG_WARN("Not implemented"); return false;
+	}
+}
+
+GLuint Shader::__CompilePart(const char* source, GLenum type)
 {
 	// Creates a new shader part (VS, FS, GS, etc...)
 	GLuint handle = glCreateShader(type);
@@ -47,50 +63,50 @@ bool Shader::LoadShaderPart(const char* source, GLenum type)
 
 		// Clean up our log memory
 		delete[] log;
-
-		// Delete the broken shader result
-		glDeleteShader(handle);
-		handle = 0;
 	}
 
-	switch (type) {
-		case GL_VERTEX_SHADER: _vs = handle; break;
-		case GL_FRAGMENT_SHADER: _fs = handle; break;
-		default: LOG_WARN("Not implemented"); break;
-	}
-
-	return status != GL_FALSE;
+	// We hand back the broken part anyways, the link will fail and report it
+	return handle;
 }
 
-bool Shader::LoadShaderPartFromFile(const char* path, GLenum type) {
-	std::ifstream file(path);
-	if (!file.is_open()) {
+bool Shader::LoadShaderPartFromFile(const char* path, GLenum type, ShaderKeyword keywords) {
+	std::string source;
+	std::vector<std::string> files;
+	if (!ShaderPreprocessor::Process(path, keywords, ShaderPreprocessor::ReadFile, source, files)) {
 		LOG_ERROR("File not found: {}", path);
 		throw std::runtime_error("File not found, see logs for more information");
 	}
-	std::stringstream stream;
-	stream << file.rdbuf();
-	bool result = LoadShaderPart(stream.str().c_str(), type);
-	file.close();
-	return result;
+	return LoadShaderPart(source.c_str(), type);
 }
 
 bool Shader::Link()
 {
-	LOG_ASSERT(_vs != 0 && _fs != 0, "Must attach both a vertex and fragment shader!");
+	LOG_ASSERT(!_vsSource.empty() && !_fsSource.empty(), "Must attach both a vertex and fragment shader!");
+
+	// If we've linked these sources on this driver before, we can skip compiling entirely
+	TTK::ProgramBinaryCache& cache = TTK::ProgramBinaryCache::Instance();
+	const char* sources[2] = { _vsSource.c_str(), _fsSource.c_str() };
+	uint64_t key = cache.MakeKey(sources, 2);
+	if (cache.TryLoad(_handle, key)) {
+		__ReflectUniforms();
+		return __ReflectUniformBlocks(_handle);
+	}
 
 	// Attach our two shaders
-	glAttachShader(_handle, _vs);
-	glAttachShader(_handle, _fs);
+	GLuint vs = __CompilePart(sources[0], GL_VERTEX_SHADER);
+	GLuint fs = __CompilePart(sources[1], GL_FRAGMENT_SHADER);
+	glAttachShader(_handle, vs);
+	glAttachShader(_handle, fs);
 
 	// Perform linking
+	TTK::ProgramBinaryCache::PrepareForLink(_handle);
 	glLinkProgram(_handle);
 
 	// Remove shader parts to save space (we can do this since we only needed the shader parts to compile an actual shader program)
-	glDetachShader(_handle, _vs);
-	glDeleteShader(_vs);
-	glDetachShader(_handle, _fs);
-	glDeleteShader(_fs);
+	glDetachShader(_handle, vs);
+	glDeleteShader(vs);
+	glDetachShader(_handle, fs);
+	glDeleteShader(fs);
 
 	GLint status = 0;
 	glGetProgramiv(_handle, GL_LINK_STATUS, &status);
@@ -111,16 +127,38 @@ bool Shader::Link()
 		else {
 			LOG_ERROR("Shader failed to link for an unknown reason!");
 		}
+		return false;
+	}
+	cache.Store(_handle, key);
+	__ReflectUniforms();
+	return __ReflectUniformBlocks(_handle);
+}
+
+bool Shader::__ReplaceProgram(GLuint program) {
+	// The blocks are checked before we let go of our program, so that one which doesn't match the C++ side
+	// never gets drawn with
+	if (!__ReflectUniformBlocks(program)) {
+		return false;
 	}
-	return status != GL_FALSE;
+	if (_handle != 0) {
+		TTK::GLStateCache::Instance().OnProgramDeleted(_handle);
+		glDeleteProgram(_handle);
+	}
+	_handle = program;
+	__ReflectUniforms();
+	return true;
+}
+
+void Shader::RegisterUniformBlock(const UniformBlockLayout& layout) {
+	_uniformBlocks[layout.Name] = layout;
 }
 
 void Shader::Bind() {
-	glUseProgram(_handle);
+	TTK::GLStateCache::Instance().UseProgram(_handle);
 }
 
 void Shader::UnBind() {
-	glUseProgram(0);
+	TTK::GLStateCache::Instance().UseProgram(0);
 }
 
 void Shader::SetUniformMatrix(int location, const glm::mat3* value, int count, bool transposed) {
@@ -157,39 +195,141 @@ void Shader::SetUniform(int location, const glm::ivec4* value, int count) {
 
 void Shader::SetUniform(int location, const bool* value, int count) {
 	LOG_ASSERT(count == 1, "SetUniform for bools only supports setting single values at a time!");
-	glProgramUniform1i(location, *value, 1);
+	glProgramUniform1i(_handle, location, *value);
 }
 void Shader::SetUniform(int location, const glm::bvec2* value, int count) {
 	LOG_ASSERT(count == 1, "SetUniform for bools only supports setting single values at a time!");
-	glProgramUniform2i(location, value->x, value->y, 1);
+	glProgramUniform2i(_handle, location, value->x, value->y);
 }
 void Shader::SetUniform(int location, const glm::bvec3* value, int count) {
 	LOG_ASSERT(count == 1, "SetUniform for bools only supports setting single values at a time!");
-	glProgramUniform3i(location, value->x, value->y, value->z, 1);
+	glProgramUniform3i(_handle, location, value->x, value->y, value->z);
 }
 void Shader::SetUniform(int location, const glm::bvec4* value, int count) {
 	LOG_ASSERT(count == 1, "SetUniform for bools only supports setting single values at a time!");
-	glProgramUniform4i(location, value->x, value->y, value->z, value->w, 1);
+	glProgramUniform4i(_handle, location, value->x, value->y, value->z, value->w);
 }
 
-int Shader::__GetUniformLocation(const std::string& name) {
-	// Search the map for the given name
-	std::unordered_map<std::string, int>::const_iterator it = _uniformLocs.find(name);
-	int result = -1;
+bool Shader::__ReflectUniformBlocks(GLuint program) {
+	bool result = true;
 
-	// If our entry was not found, we call glGetUniform and store it for next time
-	if (it == _uniformLocs.end()) {
-		result = glGetUniformLocation(_handle, name.c_str());
-		_uniformLocs[name] = result;
+	GLint blockCount = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+	for (GLint ix = 0; ix < blockCount; ix++) {
+		GLint nameLength = 0;
+		glGetActiveUniformBlockiv(program, ix, GL_UNIFORM_BLOCK_NAME_LENGTH, &nameLength);
+		std::string name(nameLength, '\0');
+		glGetActiveUniformBlockName(program, ix, nameLength, &nameLength, &name[0]);
+		name.resize(nameLength);
 
-		if (result == -1) {
-			LOG_WARN("Ignoring uniform \"{}\"", name);
+		auto it = _uniformBlocks.find(name);
+		if (it == _uniformBlocks.end()) {
+			LOG_WARN("Uniform block \"{}\" has not been registered, it will not be bound", name);
+			continue;
 		}
-	}
-	// Otherwise, we had a value in the map, return it
-	else {
-		result = it->second;
+		const UniformBlockLayout& layout = it->second;
+
+		// The C++ struct needs to cover everything the shader will read
+		GLint dataSize = 0;
+		glGetActiveUniformBlockiv(program, ix, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+		if (static_cast<size_t>(dataSize) > layout.Size) {
+			LOG_ERROR("Uniform block \"{}\" is {} bytes in GLSL, but only {} bytes in C++", name, dataSize, layout.Size);
+			result = false;
+		}
+
+		GLint memberCount = 0;
+		glGetActiveUniformBlockiv(program, ix, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &memberCount);
+		if (static_cast<size_t>(memberCount) != layout.Members.size()) {
+			LOG_ERROR("Uniform block \"{}\" has {} members in GLSL, but {} in C++", name, memberCount, layout.Members.size());
+			result = false;
+		}
+
+		// Make sure every member lines up with where the C++ side will write it
+		for (const UniformBlockLayout::Member& member : layout.Members) {
+			const char* memberName = member.Name.c_str();
+			GLuint index = GL_INVALID_INDEX;
+			glGetUniformIndices(program, 1, &memberName, &index);
+			if (index == GL_INVALID_INDEX) {
+				LOG_ERROR("Uniform block \"{}\" is missing member \"{}\"", name, member.Name);
+				result = false;
+				continue;
+			}
+			GLint offset = -1;
+			glGetActiveUniformsiv(program, 1, &index, GL_UNIFORM_OFFSET, &offset);
+			if (static_cast<size_t>(offset) != member.Offset) {
+				LOG_ERROR("Uniform \"{}\" in block \"{}\" is at offset {} in GLSL, but {} in C++", member.Name, name, offset, member.Offset);
+				result = false;
+			}
+		}
+
+		glUniformBlockBinding(program, ix, layout.Binding);
 	}
 
 	return result;
-}
\ No newline at end of file
+}
+
+void Shader::__WarnMissingUniform(const UniformId& id) {
+	// We only warn once per uniform, so that a missing uniform doesn't flood the log every frame
+	if (_missingUniforms.insert(id.Hash).second) {
+		LOG_WARN("Ignoring uniform \"{}\"", id.Name != nullptr ? id.Name : "<unknown>");
+	}
+}
+
+void Shader::__ReflectUniforms() {
+	// Gather the locations of all our active uniforms, block members don't have a location so they get skipped
+	std::vector<UniformSlot> uniforms;
+	GLint uniformCount = 0, maxNameLength = 0;
+	glGetProgramiv(_handle, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(_handle, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+	std::string name(maxNameLength, '\0');
+	for (GLint ix = 0; ix < uniformCount; ix++) {
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = GL_NONE;
+		glGetActiveUniform(_handle, ix, maxNameLength, &length, &size, &type, &name[0]);
+		int location = glGetUniformLocation(_handle, name.c_str());
+		if (location == -1) {
+			continue;
+		}
+		uniforms.push_back({ HashString32(name.c_str()), location });
+		// Arrays are reported as name[0], but we want to be able to set them by just their name
+		if (length > 3 && strcmp(&name[length - 3], "[0]") == 0) {
+			name[length - 3] = '\0';
+			uniforms.push_back({ HashString32(name.c_str()), location });
+		}
+	}
+
+	// Find a table size and multiplier that gives every uniform its own slot. With this few keys one of
+	// the first couple sizes will almost always work
+	uint32_t bits = 1;
+	while ((1u << bits) < uniforms.size() * 2) {
+		bits++;
+	}
+	for (; bits <= 16; bits++) {
+		std::vector<UniformSlot> table(static_cast<size_t>(1) << bits);
+		uint32_t seed = 0x9E3779B1u; // Knuth's multiplicative hash constant, any odd number will do
+		for (int attempt = 0; attempt < 16; attempt++, seed += 0x6A09E66Eu) {
+			std::fill(table.begin(), table.end(), UniformSlot{ 0, -1 });
+			bool collided = false;
+			for (const UniformSlot& uniform : uniforms) {
+				UniformSlot& slot = table[static_cast<uint64_t>(uniform.Hash * seed) >> (32 - bits)];
+				collided |= slot.Location != -1;
+				slot = uniform;
+			}
+			if (!collided) {
+				_uniformTable = std::move(table);
+				_uniformSeed = seed;
+				_uniformShift = 32 - bits;
+				_missingUniforms.clear();
+				LOG_TRACE("Built uniform table for {} uniforms with {} slots", uniforms.size(), _uniformTable.size());
+				return;
+			}
+		}
+	}
+	// Fall back to the one slot table we start with, so every lookup misses instead of reading the old program's locations
+	_uniformTable = std::vector<UniformSlot>(1, UniformSlot{ 0, -1 });
+	_uniformSeed = 1;
+	_uniformShift = 32;
+	_missingUniforms.clear();
+	LOG_ERROR("Failed to build a uniform table, do two uniform names hash to the same value?");
+}
@@ -4,9 +4,14 @@
 
 #include <string>               // for std::string
 #include <unordered_map>        // for std::unordered_map
+#include <unordered_set>        // for std::unordered_set
+#include <vector>               // for std::vector
 #include <GLM/glm.hpp>          // for our GLM types
 #include <GLM/gtc/type_ptr.hpp> // for glm::value_ptr
 #include "Logging.h"            // for the logging functions
+#include "UniformBlocks.h"      // for UniformBlockLayout
+#include "UniformId.h"          // for UniformId
+#include "ShaderPreprocessor.h" // for ShaderKeyword
 
 /// <summary>
 /// This class will wrap around an OpenGL shader program
@@ -37,26 +42,40 @@ public:
 	~Shader();
 
 	/// <summary>
-	/// Loads a single shader stage into this shader object (ex: Vertex Shader or Fragment Shader)
+	/// Loads a single shader stage into this shader object (ex: Vertex Shader or Fragment Shader). The stage is
+	/// not compiled until Link, and only if the program binary cache doesn't already have the linked program,
+	/// so compile errors are reported by Link
 	/// </summary>
 	/// <param name="source">The source code of the shader to load</param>
 	/// <param name="type">The stage to load (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)</param>
-	/// <returns>True if the shader is loaded, false if there was an issue</returns>
+	/// <returns>True if the shader is loaded, false if the stage is not supported</returns>
 	bool LoadShaderPart(const char* source, GLenum type);
 	/// <summary>
-	/// Loads a single shader stage into this shader object (ex: Vertex Shader or Fragment Shader) from an external file (in res)
+	/// Loads a single shader stage into this shader object (ex: Vertex Shader or Fragment Shader) from an external file (in res).
+	/// The file is run through the ShaderPreprocessor, so it can #include other files and use keywords
 	/// </summary>
 	/// <param name="path">The relative path to the file containing the source</param>
 	/// <param name="type">The stage to load (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)</param>
+	/// <param name="keywords">The keywords to define for this variant of the shader</param>
 	/// <returns>True if the shader is loaded, false if there was an issue</returns>
-	bool LoadShaderPartFromFile(const char* path, GLenum type);
+	bool LoadShaderPartFromFile(const char* path, GLenum type, ShaderKeyword keywords = ShaderKeyword::None);
 
 	/// <summary>
-	/// Links the vertex and fragment shader, and allows this shader program to be used
+	/// Links the vertex and fragment shader, and allows this shader program to be used. Any uniform blocks in the
+	/// shader are checked against the layouts given to RegisterUniformBlock, and attached to their binding points.
+	/// If the program binary cache has a binary for these sources it is loaded instead of compiling, otherwise
+	/// the sources are compiled and the result is added to the cache
 	/// </summary>
-	/// <returns>True if the linking was sucessful, false if otherwise</returns>
+	/// <returns>True if the linking was sucessful and all uniform blocks matched, false if otherwise</returns>
 	bool Link();
 
+	/// <summary>
+	/// Registers the C++ layout of a uniform block, so that shaders using a block with the same name will be
+	/// checked against it and bound to its binding point when they are linked
+	/// </summary>
+	/// <param name="layout">The layout of the block, see UniformBlocks.h</param>
+	static void RegisterUniformBlock(const UniformBlockLayout& layout);
+
 	/// <summary>
 	/// Binds this shader for use
 	/// </summary>
@@ -73,15 +92,15 @@ public:
 	
 public:
 	template <typename T>
-	void SetUniform(const std::string& name, const T& value) {
-		int location = __GetUniformLocation(name);
+	void SetUniform(const UniformId& id, const T& value) {
+		int location = __GetUniformLocation(id);
 		if (location != -1) {
 			SetUniform(location, &value, 1);
 		}
 	}
 	template <typename T>
-	void SetUniformMatrix(const std::string& name, const T& value, bool transposed = false) {
-		int location = __GetUniformLocation(name);
+	void SetUniformMatrix(const UniformId& id, const T& value, bool transposed = false) {
+		int location = __GetUniformLocation(id);
 		if (location != -1) {
 			SetUniformMatrix(location, &value, 1, transposed);
 		}
@@ -103,12 +122,46 @@ public:
 	void SetUniform(int location, const glm::bvec4* value, int count = 1);
 	
 protected:
-	GLuint _vs;
-	GLuint _fs;
+	// The shader library swaps in new programs when their source files change
+	friend class ShaderLibrary;
+
+	// The sources are kept until we link, since we don't know if we need to compile them until then
+	std::string _vsSource;
+	std::string _fsSource;
 	
 	GLuint _handle;
 
-	std::unordered_map<std::string, int> _uniformLocs;
+	// The locations of our uniforms, stored as a perfect hash table built when we link. Every uniform
+	// lands in its own slot, so a lookup is always a single probe
+	struct UniformSlot {
+		uint32_t Hash;
+		int      Location;
+	};
+	std::vector<UniformSlot>     _uniformTable;
+	uint32_t                     _uniformSeed;
+	uint32_t                     _uniformShift;
+	std::unordered_set<uint32_t> _missingUniforms;
+
+	static std::unordered_map<std::string, UniformBlockLayout> _uniformBlocks;
 	
-	int __GetUniformLocation(const std::string& name);
+	inline int __GetUniformLocation(const UniformId& id) {
+		const UniformSlot& slot = _uniformTable[static_cast<uint64_t>(id.Hash * _uniformSeed) >> _uniformShift];
+		int result = slot.Hash == id.Hash ? slot.Location : -1;
+		// Tracking which misses we've already warned about costs a set insert, so release builds skip it
+		#ifdef _DEBUG
+		if (result == -1) {
+			__WarnMissingUniform(id);
+		}
+		#endif
+		return result;
+	}
+	void __WarnMissingUniform(const UniformId& id);
+	static GLuint __CompilePart(const char* source, GLenum type);
+	void __ReflectUniforms();
+	// Checks that the program's uniform blocks match their C++ layouts, and assigns their bindings
+	static bool __ReflectUniformBlocks(GLuint program);
+	// Deletes our program and takes ownership of one that has already been linked successfully. If the new
+	// program's uniform blocks don't match C++, it returns false and we keep our program (the caller still
+	// owns the new one)
+	bool __ReplaceProgram(GLuint program);
 };
\ No newline at end of file
@@ -0,0 +1,300 @@
+#include "ShaderLibrary.h"
+#include "Logging.h"
+#include "TTK/ProgramBinaryCache.h"
+#include "TTK/Profiler.h"
+#include "Utilities/PathUtils.h"
+#include <GLFW/glfw3.h>
+#include <filesystem>
+#include <algorithm>
+
+// From GL_KHR_parallel_shader_compile, which shares its values with the ARB version
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+ShaderLibrary::ShaderLibrary() :
+	_programs(std::vector<ProgramEntry>()),
+	_files(std::unordered_map<std::string, std::string>()),
+	_changed(std::vector<ChangedFile>()),
+	_hasParallelCompile(false),
+	_stats(Stats()),
+	_watcher(nullptr)
+{
+	PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxCompilerThreads = nullptr;
+	if (glfwExtensionSupported("GL_KHR_parallel_shader_compile")) {
+		maxCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+	} else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile")) {
+		maxCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+	}
+	if (maxCompilerThreads != nullptr) {
+		// Let the driver pick how many threads to use
+		maxCompilerThreads(0xFFFFFFFF);
+		_hasParallelCompile = true;
+	}
+	LOG_INFO("Shader hot reloading enabled, parallel compiles are {}", _hasParallelCompile ? "supported" : "not supported");
+
+	_watcher = FileWatcher::Create([this](const std::string& path) { _OnFileChanged(path); });
+}
+
+ShaderLibrary::~ShaderLibrary() {
+	_watcher = nullptr;
+	for (ProgramEntry& entry : _programs) {
+		_CancelCompile(entry);
+	}
+}
+
+Shader::sptr ShaderLibrary::Load(const std::string& vsPath, const std::string& fsPath, ShaderKeyword keywords) {
+	return _GetOrCreate(vsPath, fsPath, keywords, true);
+}
+
+Shader::sptr ShaderLibrary::Prewarm(const std::string& vsPath, const std::string& fsPath, ShaderKeyword keywords) {
+	return _GetOrCreate(vsPath, fsPath, keywords, false);
+}
+
+void ShaderLibrary::Poll() {
+	PROFILE_FUNCTION();
+	Clock::time_point start = Clock::now();
+
+	std::vector<ChangedFile> changed;
+	{
+		std::lock_guard<std::mutex> lock(_changedLock);
+		changed.swap(_changed);
+	}
+
+	// Editors often write a file more than once when saving, so we only start one compile per program
+	for (const ChangedFile& file : changed) {
+		auto it = _files.find(file.Path);
+		if (it != _files.end() && it->second == file.Source) {
+			continue;
+		}
+		_files[file.Path] = file.Source;
+
+		for (ProgramEntry& entry : _programs) {
+			bool isDependency =
+				std::find(entry.VsFiles.begin(), entry.VsFiles.end(), file.Path) != entry.VsFiles.end() ||
+				std::find(entry.FsFiles.begin(), entry.FsFiles.end(), file.Path) != entry.FsFiles.end();
+			if (isDependency) {
+				if (!entry.IsDirty) {
+					entry.ChangedAt = file.ChangedAt;
+				}
+				entry.IsDirty = true;
+			}
+		}
+	}
+
+	for (ProgramEntry& entry : _programs) {
+		if (entry.IsDirty) {
+			entry.IsDirty = false;
+			// Saving a file without changing it (or changing it back) doesn't need a recompile
+			std::string vsSource, fsSource;
+			if (_Preprocess(entry, vsSource, fsSource) && (vsSource != entry.VsSource || fsSource != entry.FsSource)) {
+				entry.VsSource = std::move(vsSource);
+				entry.FsSource = std::move(fsSource);
+				_CancelCompile(entry);
+				_StartCompile(entry);
+			}
+		}
+		// Without parallel compiles, checking the status would block anyways, so we may as well finish now
+		if (entry.PendingProgram != 0) {
+			_TryFinishCompile(entry, false);
+		}
+	}
+
+	std::chrono::duration<double, std::milli> pollTime = Clock::now() - start;
+	_stats.LastPollMs = pollTime.count();
+	_stats.MaxPollMs = std::max(_stats.MaxPollMs, _stats.LastPollMs);
+}
+
+Shader::sptr ShaderLibrary::_GetOrCreate(const std::string& vsPath, const std::string& fsPath, ShaderKeyword keywords, bool wait) {
+	std::string vsKey = NormalizePath(vsPath);
+	std::string fsKey = NormalizePath(fsPath);
+	for (const ProgramEntry& entry : _programs) {
+		if (entry.VsPath == vsKey && entry.FsPath == fsKey && entry.Keywords == keywords) {
+			return entry.Program;
+		}
+	}
+
+	ProgramEntry entry = ProgramEntry();
+	entry.Program = Shader::Create();
+	entry.VsPath = vsKey;
+	entry.FsPath = fsKey;
+	entry.Keywords = keywords;
+
+	if (!_Preprocess(entry, entry.VsSource, entry.FsSource)) {
+		LOG_ERROR("Failed to load {}, it will be loaded once its files are fixed", _GetName(entry));
+	} else {
+		// Usually the binary cache already has the program from the last run
+		TTK::ProgramBinaryCache& cache = TTK::ProgramBinaryCache::Instance();
+		GLuint program = glCreateProgram();
+		// A cached program whose blocks don't match C++ is thrown away and rebuilt, the same as a cache miss
+		bool loaded = cache.TryLoad(program, _MakeKey(entry)) && entry.Program->__ReplaceProgram(program);
+		if (!loaded) {
+			glDeleteProgram(program);
+			_StartCompile(entry);
+			// Loads block, since there's nothing to draw with until it is done. Prewarms are picked up by Poll
+			if (wait) {
+				_TryFinishCompile(entry, true);
+			}
+		}
+	}
+
+	_programs.push_back(entry);
+	return entry.Program;
+}
+
+bool ShaderLibrary::_Preprocess(ProgramEntry& entry, std::string& vsSource, std::string& fsSource) {
+	ShaderPreprocessor::FileReader reader = [this](const std::string& path, std::string& source) { return _ReadCached(path, source); };
+	// We want to know every file either stage tried to read, even if the other one failed
+	bool hasVs = ShaderPreprocessor::Process(entry.VsPath, entry.Keywords, reader, vsSource, entry.VsFiles);
+	bool hasFs = ShaderPreprocessor::Process(entry.FsPath, entry.Keywords, reader, fsSource, entry.FsFiles);
+	return hasVs && hasFs;
+}
+
+bool ShaderLibrary::_ReadCached(const std::string& path, std::string& source) {
+	auto it = _files.find(path);
+	if (it != _files.end()) {
+		source = it->second;
+		return true;
+	}
+	// We watch the file even if it doesn't exist, so that we notice when it gets created
+	_watcher->Watch(path);
+	if (!ShaderPreprocessor::ReadFile(path, source)) {
+		return false;
+	}
+	_files[path] = source;
+	return true;
+}
+
+void ShaderLibrary::_OnFileChanged(const std::string& path) {
+	// This runs on the watcher thread, so the file read never stalls a frame
+	ChangedFile file;
+	file.Path = path;
+	file.ChangedAt = Clock::now();
+	// If the file is missing it's probably mid-save, we'll get another event once it's back
+	if (ShaderPreprocessor::ReadFile(path, file.Source) && !file.Source.empty()) {
+		std::lock_guard<std::mutex> lock(_changedLock);
+		_changed.push_back(std::move(file));
+	}
+}
+
+void ShaderLibrary::_StartCompile(ProgramEntry& entry) {
+	// None of these query any results, so the driver is free to do the work in the background
+	const char* vsSource = entry.VsSource.c_str();
+	entry.PendingVs = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(entry.PendingVs, 1, &vsSource, nullptr);
+	glCompileShader(entry.PendingVs);
+
+	const char* fsSource = entry.FsSource.c_str();
+	entry.PendingFs = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(entry.PendingFs, 1, &fsSource, nullptr);
+	glCompileShader(entry.PendingFs);
+
+	entry.PendingProgram = glCreateProgram();
+	glAttachShader(entry.PendingProgram, entry.PendingVs);
+	glAttachShader(entry.PendingProgram, entry.PendingFs);
+	TTK::ProgramBinaryCache::PrepareForLink(entry.PendingProgram);
+	glLinkProgram(entry.PendingProgram);
+}
+
+bool ShaderLibrary::_TryFinishCompile(ProgramEntry& entry, bool wait) {
+	if (!wait && _hasParallelCompile) {
+		GLint isComplete = GL_FALSE;
+		glGetProgramiv(entry.PendingProgram, GL_COMPLETION_STATUS_KHR, &isComplete);
+		if (isComplete == GL_FALSE) {
+			return false;
+		}
+	}
+
+	GLint status = GL_FALSE;
+	glGetProgramiv(entry.PendingProgram, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE) {
+		// Find out which part failed, a failed compile will also fail the link with a less useful message
+		for (GLuint part : { entry.PendingVs, entry.PendingFs }) {
+			GLint compiled = GL_FALSE;
+			glGetShaderiv(part, GL_COMPILE_STATUS, &compiled);
+			if (compiled == GL_FALSE) {
+				GLint length = 0;
+				glGetShaderiv(part, GL_INFO_LOG_LENGTH, &length);
+				std::string log(std::max(length, 1), '\0');
+				glGetShaderInfoLog(part, length, &length, &log[0]);
+				// Errors are reported as <file index>(<line>), where the index is into the list of files for that stage
+				const std::vector<std::string>& files = part == entry.PendingVs ? entry.VsFiles : entry.FsFiles;
+				std::string fileList;
+				for (size_t ix = 0; ix < files.size(); ix++) {
+					fileList += "\n  " + std::to_string(ix) + ": " + files[ix];
+				}
+				LOG_ERROR("Failed to compile {}:\n{}Files:{}", _GetName(entry), log, fileList);
+			}
+		}
+		GLint length = 0;
+		glGetProgramiv(entry.PendingProgram, GL_INFO_LOG_LENGTH, &length);
+		std::string log(std::max(length, 1), '\0');
+		glGetProgramInfoLog(entry.PendingProgram, length, &length, &log[0]);
+		LOG_ERROR("Failed to link {}, keeping the last working version:\n{}", _GetName(entry), log);
+		_CancelCompile(entry);
+		if (entry.ChangedAt != Clock::time_point()) {
+			_stats.FailedReloads++;
+		}
+		return false;
+	}
+
+	// The program keeps its compiled code, so the parts can go
+	glDetachShader(entry.PendingProgram, entry.PendingVs);
+	glDeleteShader(entry.PendingVs);
+	glDetachShader(entry.PendingProgram, entry.PendingFs);
+	glDeleteShader(entry.PendingFs);
+
+	// A program whose uniform blocks no longer match the C++ structs would read garbage, so it's treated
+	// the same as one that failed to link
+	if (!entry.Program->__ReplaceProgram(entry.PendingProgram)) {
+		LOG_ERROR("Uniform blocks in {} don't match C++, keeping the last working version", _GetName(entry));
+		glDeleteProgram(entry.PendingProgram);
+		entry.PendingProgram = entry.PendingVs = entry.PendingFs = 0;
+		if (entry.ChangedAt != Clock::time_point()) {
+			_stats.FailedReloads++;
+		}
+		return false;
+	}
+
+	// Storing the edited program means the next launch starts with it already compiled
+	TTK::ProgramBinaryCache::Instance().Store(entry.PendingProgram, _MakeKey(entry));
+	entry.PendingProgram = entry.PendingVs = entry.PendingFs = 0;
+
+	// Nothing has changed yet on the first load, so there's no latency to report
+	if (entry.ChangedAt != Clock::time_point()) {
+		std::chrono::duration<double, std::milli> latency = Clock::now() - entry.ChangedAt;
+		_stats.Reloads++;
+		_stats.LastReloadLatencyMs = latency.count();
+		LOG_INFO("Reloaded {} {:.1f}ms after the change was seen", _GetName(entry), _stats.LastReloadLatencyMs);
+	}
+	return true;
+}
+
+void ShaderLibrary::_CancelCompile(ProgramEntry& entry) {
+	if (entry.PendingProgram != 0) {
+		glDeleteProgram(entry.PendingProgram);
+		glDeleteShader(entry.PendingVs);
+		glDeleteShader(entry.PendingFs);
+		entry.PendingProgram = entry.PendingVs = entry.PendingFs = 0;
+	}
+}
+
+uint64_t ShaderLibrary::_MakeKey(const ProgramEntry& entry) {
+	const char* sources[2] = { entry.VsSource.c_str(), entry.FsSource.c_str() };
+	return TTK::ProgramBinaryCache::Instance().MakeKey(sources, 2);
+}
+
+std::string ShaderLibrary::_GetName(const ProgramEntry& entry) {
+	// Ex: "vertex_shader.glsl" + "frag_lit.glsl" [TEXTURED ATTENUATION]
+	std::string result = "\"" + std::filesystem::path(entry.VsPath).filename().string() + "\" + \"" + std::filesystem::path(entry.FsPath).filename().string() + "\" [";
+	for (uint32_t bit = 1; bit != 0 && bit <= *entry.Keywords; bit <<= 1) {
+		if ((*entry.Keywords & bit) != 0) {
+			result += ShaderPreprocessor::GetDefineName(static_cast<ShaderKeyword>(bit)) + " ";
+		}
+	}
+	if (result.back() == ' ') {
+		result.pop_back();
+	}
+	return result + "]";
+}
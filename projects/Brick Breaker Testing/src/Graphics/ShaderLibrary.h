@@ -0,0 +1,142 @@
+#pragma once
+#include <glad/glad.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+
+#include "Graphics/Shader.h"
+#include "Graphics/ShaderPreprocessor.h"
+#include "Utilities/FileWatcher.h"
+
+/// <summary>
+/// Loads shader programs from files, and reloads them while the game is running whenever one of their files
+/// changes on disk. Files are watched and re-read on a background thread, and programs are only recompiled on
+/// the main thread when Poll finds that something has changed. If the driver supports parallel shader compiles
+/// (GL_KHR_parallel_shader_compile or GL_ARB_parallel_shader_compile), the compile runs in the background and
+/// Poll only swaps the new program in once it is done, otherwise it is compiled and linked in a single Poll.
+///
+/// Every combination of files and keywords is its own variant, which is run through the ShaderPreprocessor and
+/// compiled the first time it is asked for. Changing a file that a variant #includes reloads that variant too.
+///
+/// The Shader objects handed out by Load stay the same across reloads, only the program inside of them is
+/// replaced, and only once the new one has compiled and linked successfully. Uniforms that are not in a block
+/// need to be set again after a reload, since they belong to the old program
+/// </summary>
+class ShaderLibrary final
+{
+public:
+	typedef std::shared_ptr<ShaderLibrary> sptr;
+	static inline sptr Create() {
+		return std::make_shared<ShaderLibrary>();
+	}
+
+public:
+	// We'll disallow moving and copying, since we want to manually control when the destructor is called
+	// We'll use these classes via pointers
+	ShaderLibrary(const ShaderLibrary& other) = delete;
+	ShaderLibrary(ShaderLibrary&& other) = delete;
+	ShaderLibrary& operator=(const ShaderLibrary& other) = delete;
+	ShaderLibrary& operator=(ShaderLibrary&& other) = delete;
+
+	struct Stats
+	{
+		size_t Reloads;
+		size_t FailedReloads;
+		// The time from the watcher seeing a change to the new program being swapped in, for the last reload
+		double LastReloadLatencyMs;
+		// How long the last Poll took on the main thread, and the longest any Poll has taken
+		double LastPollMs;
+		double MaxPollMs;
+	};
+
+public:
+	ShaderLibrary();
+	~ShaderLibrary();
+
+	/// <summary>
+	/// Gets a variant of a shader program, loading it from the program binary cache or compiling it if this is
+	/// the first time it has been asked for. Its files (and any files they include) are watched for changes.
+	/// Unlike Shader::LoadShaderPartFromFile, a missing file or compile error does not throw, the error is logged
+	/// and the program stays empty until the files are fixed
+	/// </summary>
+	/// <param name="vsPath">The path to the vertex shader source</param>
+	/// <param name="fsPath">The path to the fragment shader source</param>
+	/// <param name="keywords">The features to compile into this variant</param>
+	/// <returns>The shader, which will keep being updated as its files change</returns>
+	Shader::sptr Load(const std::string& vsPath, const std::string& fsPath, ShaderKeyword keywords = ShaderKeyword::None);
+	/// <summary>
+	/// Like Load, but does not wait for the variant to compile. With parallel shader compiles the driver works on
+	/// it in the background, and a later Poll swaps it in. Use this for variants that will be needed soon, so
+	/// that asking for them with Load later doesn't stall a frame
+	/// </summary>
+	/// <returns>The shader, which has no program until the compile finishes (unless it was in the binary cache)</returns>
+	Shader::sptr Prewarm(const std::string& vsPath, const std::string& fsPath, ShaderKeyword keywords = ShaderKeyword::None);
+
+	/// <summary>
+	/// Starts recompiling any programs whose files have changed, and swaps in any recompiled programs that are
+	/// ready. This should be called once per frame on the thread that owns the OpenGL context
+	/// </summary>
+	void Poll();
+
+	/// <summary>
+	/// Gets whether the driver lets us compile shaders in the background
+	/// </summary>
+	bool HasParallelCompile() const { return _hasParallelCompile; }
+	/// <summary>
+	/// Gets the reload and timing statistics for this library
+	/// </summary>
+	const Stats& GetStats() const { return _stats; }
+
+protected:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	struct ProgramEntry
+	{
+		Shader::sptr      Program;
+		std::string       VsPath;
+		std::string       FsPath;
+		ShaderKeyword     Keywords;
+		// The preprocessed sources, and every file that went into each of them
+		std::string       VsSource;
+		std::string       FsSource;
+		std::vector<std::string> VsFiles;
+		std::vector<std::string> FsFiles;
+		// Whether one of our files has changed since we last preprocessed them
+		bool              IsDirty;
+		Clock::time_point ChangedAt;
+		// The program we're compiling in the background, if any
+		GLuint            PendingProgram;
+		GLuint            PendingVs;
+		GLuint            PendingFs;
+	};
+
+	struct ChangedFile
+	{
+		std::string       Path;
+		std::string       Source;
+		Clock::time_point ChangedAt;
+	};
+
+	std::vector<ProgramEntry> _programs;
+	// The last known contents of every file we've read, keyed by normalized path. Only touched on the main thread
+	std::unordered_map<std::string, std::string> _files;
+	std::mutex                _changedLock;
+	std::vector<ChangedFile>  _changed;
+	bool                      _hasParallelCompile;
+	Stats                     _stats;
+	// Declared last, so that the watcher thread is stopped before anything it touches is destroyed
+	FileWatcher::sptr         _watcher;
+
+	Shader::sptr _GetOrCreate(const std::string& vsPath, const std::string& fsPath, ShaderKeyword keywords, bool wait);
+	bool _Preprocess(ProgramEntry& entry, std::string& vsSource, std::string& fsSource);
+	bool _ReadCached(const std::string& path, std::string& source);
+	void _OnFileChanged(const std::string& path);
+	void _StartCompile(ProgramEntry& entry);
+	bool _TryFinishCompile(ProgramEntry& entry, bool wait);
+	static void _CancelCompile(ProgramEntry& entry);
+	static uint64_t _MakeKey(const ProgramEntry& entry);
+	static std::string _GetName(const ProgramEntry& entry);
+};
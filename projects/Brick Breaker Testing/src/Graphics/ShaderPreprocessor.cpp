@@ -0,0 +1,129 @@
+#include "ShaderPreprocessor.h"
+#include "Logging.h"
+#include "Utilities/PathUtils.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+
+bool ShaderPreprocessor::Process(const std::string& path, ShaderKeyword keywords, const FileReader& reader, std::string& result, std::vector<std::string>& dependencies) {
+	result.clear();
+	dependencies.clear();
+
+	std::string header;
+	for (uint32_t bit = 1; bit != 0 && bit <= *keywords; bit <<= 1) {
+		if ((*keywords & bit) != 0) {
+			header += "#define " + GetDefineName(static_cast<ShaderKeyword>(bit)) + "\n";
+		}
+	}
+	return _Expand(NormalizePath(path), reader, result, dependencies, header);
+}
+
+bool ShaderPreprocessor::ReadFile(const std::string& path, std::string& source) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		return false;
+	}
+	std::stringstream stream;
+	stream << file.rdbuf();
+	source = stream.str();
+	return true;
+}
+
+std::string ShaderPreprocessor::GetDefineName(ShaderKeyword keyword) {
+	// SpecularMap -> SPECULAR_MAP
+	const std::string& name = ~keyword;
+	std::string result;
+	for (size_t ix = 0; ix < name.size(); ix++) {
+		if (ix > 0 && std::isupper(name[ix]) && std::islower(name[ix - 1])) {
+			result += '_';
+		}
+		result += static_cast<char>(std::toupper(name[ix]));
+	}
+	return result;
+}
+
+bool ShaderPreprocessor::_Expand(const std::string& path, const FileReader& reader, std::string& result, std::vector<std::string>& dependencies, const std::string& header) {
+	const bool isRoot = dependencies.empty();
+	const size_t fileIndex = dependencies.size();
+	dependencies.push_back(path);
+
+	std::string source;
+	if (!reader(path, source)) {
+		LOG_ERROR("Failed to read shader file \"{}\"", path);
+		return false;
+	}
+
+	// The #line directive can't come before #version, so the root file starts numbering on its own
+	if (!isRoot) {
+		result += "#line 1 " + std::to_string(fileIndex) + "\n";
+	}
+
+	std::istringstream stream(source);
+	std::string line;
+	int lineNumber = 0;
+	bool hasVersion = false;
+	while (std::getline(stream, line)) {
+		lineNumber++;
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+
+		// Pull out the directive name, if this line has one
+		std::string directive;
+		size_t start = line.find_first_not_of(" \t");
+		if (start != std::string::npos && line[start] == '#') {
+			size_t nameStart = line.find_first_not_of(" \t", start + 1);
+			size_t nameEnd = nameStart == std::string::npos ? std::string::npos : line.find_first_of(" \t", nameStart);
+			if (nameStart != std::string::npos) {
+				directive = line.substr(nameStart, nameEnd - nameStart);
+				start = nameEnd;
+			}
+		}
+
+		if (directive == "version") {
+			if (isRoot && !hasVersion) {
+				result += line + "\n" + header + "#line " + std::to_string(lineNumber + 1) + " 0\n";
+				hasVersion = true;
+			} else {
+				LOG_WARN("Ignoring #version in included file \"{}\"", path);
+				result += "\n";
+			}
+		}
+		else if (directive == "include") {
+			size_t open = start == std::string::npos ? std::string::npos : line.find('"', start);
+			size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+			if (close == std::string::npos) {
+				LOG_ERROR("{}({}): Expected #include \"path\"", path, lineNumber);
+				return false;
+			}
+			std::filesystem::path includePath = std::filesystem::path(path).parent_path() / line.substr(open + 1, close - open - 1);
+			std::string includeKey = NormalizePath(includePath.string());
+
+			// Files are only ever included once, which also stops include loops
+			if (std::find(dependencies.begin(), dependencies.end(), includeKey) != dependencies.end()) {
+				result += "\n";
+				continue;
+			}
+			if (!_Expand(includeKey, reader, result, dependencies, "")) {
+				LOG_ERROR("{}({}): Failed to include \"{}\"", path, lineNumber, includeKey);
+				return false;
+			}
+			result += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+		}
+		else if (directive == "pragma" && line.find("once", start) != std::string::npos) {
+			// Every file is only included once anyways
+			result += "\n";
+		}
+		else {
+			result += line + "\n";
+		}
+	}
+
+	// Without a #version the keywords still need to be defined, GLSL will default to version 110
+	if (isRoot && !hasVersion) {
+		result = header + "#line 1 0\n" + result;
+	}
+	return true;
+}
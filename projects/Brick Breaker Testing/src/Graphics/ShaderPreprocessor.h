@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <EnumToString.h>
+
+/// <summary>
+/// Keywords that turn optional features of a shader on, each one is passed to GLSL as a #define with the name in
+/// upper snake case (ex: SpecularMap becomes SPECULAR_MAP). Features that are turned off are compiled out of the
+/// variant entirely, rather than being branched over for every fragment
+/// </summary>
+ENUM_FLAGS(ShaderKeyword, uint32_t,
+	None        = 0,
+	Textured    = 1,
+	SpecularMap = 2,
+	Attenuation = 4,
+	Phong       = 8,
+	Clustered   = 16
+);
+
+/// <summary>
+/// A small GLSL preprocessor that runs before the source is handed to OpenGL. It supports:
+///   #include "path" - Pastes in another file, relative to the file including it. Every file is included at most
+///                      once per shader, so shared files don't need include guards
+///   keywords         - The #define for each keyword is inserted right after the #version line
+///
+/// #line directives are inserted around every include, so errors from the driver still point at the right line.
+/// The source string number in the error is the index of the file in the dependency list
+/// </summary>
+class ShaderPreprocessor final
+{
+public:
+	// Reads the contents of a file, returning false if the file could not be read
+	typedef std::function<bool(const std::string& path, std::string& source)> FileReader;
+
+	/// <summary>
+	/// Expands a shader file into a single source that can be given to OpenGL
+	/// </summary>
+	/// <param name="path">The path to the root file of the shader stage</param>
+	/// <param name="keywords">The keywords to define for this variant</param>
+	/// <param name="reader">Used to read the root file and any included files</param>
+	/// <param name="result">Will be set to the expanded source</param>
+	/// <param name="dependencies">Will be set to the normalized path of every file that was read, starting with the root</param>
+	/// <returns>True if every file could be read, false if otherwise</returns>
+	static bool Process(const std::string& path, ShaderKeyword keywords, const FileReader& reader, std::string& result, std::vector<std::string>& dependencies);
+
+	/// <summary>
+	/// Reads a file straight from disk, for use with Process
+	/// </summary>
+	static bool ReadFile(const std::string& path, std::string& source);
+
+	/// <summary>
+	/// Gets the name of the #define for a single keyword
+	/// </summary>
+	static std::string GetDefineName(ShaderKeyword keyword);
+
+protected:
+	ShaderPreprocessor() = default;
+
+	static bool _Expand(const std::string& path, const FileReader& reader, std::string& result, std::vector<std::string>& dependencies, const std::string& header);
+};
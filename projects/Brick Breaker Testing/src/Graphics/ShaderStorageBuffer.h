@@ -0,0 +1,73 @@
+#pragma once
+#include "IBuffer.h"
+#include <memory>
+#include "Logging.h"
+#include "TTK/GLStateCache.h"
+
+/// <summary>
+/// The shader storage buffer stores an array of structs that shaders can index into, unlike a uniform buffer
+/// its size is only limited by GPU memory. Layouts must follow the std430 rules on the GLSL side
+/// </summary>
+class ShaderStorageBuffer : public IBuffer
+{
+public:
+	typedef std::shared_ptr<ShaderStorageBuffer> sptr;
+	static inline sptr Create(GLenum usage = GL_DYNAMIC_DRAW) {
+		return std::make_shared<ShaderStorageBuffer>(usage);
+	}
+
+public:
+	/// <summary>
+	/// Creates a new shader storage buffer, with the given usage. Data will still need to be uploaded before it can be used
+	/// </summary>
+	/// <param name="usage">The usage hint for the buffer, default is GL_DYNAMIC_DRAW</param>
+	ShaderStorageBuffer(GLenum usage = GL_DYNAMIC_DRAW) : IBuffer(GL_SHADER_STORAGE_BUFFER, usage), _capacity(0) { }
+
+	/// <summary>
+	/// Replaces the start of this buffer with an array of elements. The buffer only gets re-allocated when it
+	/// needs to grow, so arrays that change size every frame don't cause an allocation every frame
+	/// </summary>
+	/// <typeparam name="T">The type of element to upload, must match the std430 layout in the shader</typeparam>
+	/// <param name="data">A pointer to the first element in the array</param>
+	/// <param name="count">The number of elements in the array</param>
+	template <typename T>
+	void Update(const T* data, size_t count) {
+		LOG_ASSERT(_capacity == 0 || sizeof(T) == _elementSize, "Element size does not match the buffer!");
+		if (count > _capacity) {
+			// Grow by at least half again, and never allocate an empty buffer since it can't be bound
+			_capacity = count + count / 2;
+			if (_capacity == 0) {
+				_capacity = 1;
+			}
+			glNamedBufferData(_handle, sizeof(T) * _capacity, nullptr, _usage);
+			_elementSize = sizeof(T);
+		}
+		if (count > 0) {
+			glNamedBufferSubData(_handle, 0, sizeof(T) * count, data);
+		}
+		_elementCount = count;
+	}
+
+	/// <summary>
+	/// Returns the number of elements the buffer can hold before it needs to re-allocate
+	/// </summary>
+	size_t GetCapacity() const { return _capacity; }
+
+	using IBuffer::Bind;
+	/// <summary>
+	/// Binds this buffer to the given shader storage block binding point
+	/// </summary>
+	/// <param name="binding">The binding point to attach the buffer to, this matches layout(binding = n) in GLSL</param>
+	void Bind(GLuint binding) {
+		TTK::GLStateCache::Instance().BindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, _handle);
+	}
+
+	/// <summary>
+	/// Unbinds the buffer attached to the given shader storage block binding point
+	/// </summary>
+	/// <param name="binding">The binding point to clear</param>
+	static void UnBind(GLuint binding) { TTK::GLStateCache::Instance().BindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0); }
+
+protected:
+	size_t _capacity; // The number of elements allocated on the GPU, may be more than _elementCount
+};
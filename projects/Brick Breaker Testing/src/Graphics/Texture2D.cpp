@@ -1,9 +1,11 @@
 #include "Texture2D.h"
+#include "TTK/GLStateCache.h"
 
 int Texture2D::MAX_TEXTURE_SIZE = 0;
+float Texture2D::MAX_ANISOTROPY = 0.0f;
 
 Texture2D::Texture2D(const Texture2DDescription& description) :
-	_handle(0), _description(description)
+	_handle(0), _description(description), _mipLevels(0)
 {
 	if (MAX_TEXTURE_SIZE == 0) {
 		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &MAX_TEXTURE_SIZE);
@@ -15,6 +17,7 @@ Texture2D::Texture2D(const Texture2DDescription& description) :
 
 Texture2D::~Texture2D() {
 	if (glIsTexture(_handle)) {
+		TTK::GLStateCache::Instance().OnTextureDeleted(_handle);
 		glDeleteTextures(1, &_handle);
 	}
 }
@@ -22,19 +25,28 @@ Texture2D::~Texture2D() {
 void Texture2D::_RecreateTexture() {
 	if (_handle != 0)
 	{
+		TTK::GLStateCache::Instance().OnTextureDeleted(_handle);
 		glDeleteTextures(1, &_handle);
 		_handle = 0;
 	}
 
 	glCreateTextures(GL_TEXTURE_2D, 1, &_handle);
+	_mipLevels = 0;
 
 	if (_description.Width * _description.Height > 0 && _description.Format != InternalFormat::Unknown)
 	{
-		glTextureStorage2D(_handle, 1, *_description.Format, _description.Width, _description.Height);
+		// Storage is immutable, so we need to allocate every mip level we'll ever use up front. Allocating only the
+		// base level while sampling with a mip filter leaves the texture incomplete
+		_mipLevels = _description.GetMipLevelCount();
+		glTextureStorage2D(_handle, _mipLevels, *_description.Format, _description.Width, _description.Height);
+		glTextureParameteri(_handle, GL_TEXTURE_MAX_LEVEL, _mipLevels - 1);
 		glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, (GLenum)_description.HorizontalWrap);
 		glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, (GLenum)_description.VerticalWrap);
 		glTextureParameteri(_handle, GL_TEXTURE_MIN_FILTER, (GLenum)_description.MinificationFilter);
 		glTextureParameteri(_handle, GL_TEXTURE_MAG_FILTER, (GLenum)_description.MagnificationFilter);
+		if (GetMaxSupportedAnisotropy() > 1.0f) {
+			glTextureParameterf(_handle, GL_TEXTURE_MAX_ANISOTROPY, std::clamp(_description.MaxAnisotropy, 1.0f, MAX_ANISOTROPY));
+		}
 	}
 
 }
@@ -55,12 +67,17 @@ void Texture2D::LoadData(const Texture2DData::sptr& data) {
 	// Align the data store to the size of a single component in
 	// See https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glPixelStore.xhtml
 	int componentSize = (GLint)GetTexelComponentSize(data->GetPixelType());
-	glPixelStorei(GL_PACK_ALIGNMENT, componentSize);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, componentSize);
 
 	// Upload our data to our image
 	glTextureSubImage2D(_handle, 0, 0, 0, _description.Width, _description.Height, *data->GetFormat(),
 		*data->GetPixelType(), data->GetDataPtr());
 
+	// Fill in the rest of the chain from the level we just uploaded
+	if (_mipLevels > 1) {
+		GenerateMipMaps();
+	}
+
 	// We can get better error logs by attaching an object label!
 	if (!data->DebugName.empty()) {
 		glObjectLabel(GL_TEXTURE, _handle, data->DebugName.length(), data->DebugName.c_str());
@@ -68,6 +85,55 @@ void Texture2D::LoadData(const Texture2DData::sptr& data) {
 
 }
 
+void Texture2D::LoadData(const std::vector<Texture2DData::sptr>& levels) {
+	LOG_ASSERT(!levels.empty(), "Need at least one level of texture data to load!");
+	const Texture2DData::sptr& base = levels[0];
+	if (_description.Format == InternalFormat::Unknown) {
+		_description.Format = base->GetRecommendedFormat();
+	}
+	if (_description.Width != base->GetWidth() ||
+		_description.Height != base->GetHeight() ||
+		_handle == 0 || _mipLevels == 0)
+	{
+		_description.Width = base->GetWidth();
+		_description.Height = base->GetHeight();
+
+		_RecreateTexture();
+	}
+
+	const uint32_t count = std::min(static_cast<uint32_t>(levels.size()), _mipLevels);
+	for (uint32_t ix = 0; ix < count; ix++) {
+		const Texture2DData::sptr& level = levels[ix];
+		LOG_ASSERT(level->GetWidth() == std::max(_description.Width >> ix, 1u) && level->GetHeight() == std::max(_description.Height >> ix, 1u),
+			"Mip level {} is {}x{}, which does not match the base level", ix, level->GetWidth(), level->GetHeight());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, (GLint)GetTexelComponentSize(level->GetPixelType()));
+		glTextureSubImage2D(_handle, ix, 0, 0, level->GetWidth(), level->GetHeight(), *level->GetFormat(),
+			*level->GetPixelType(), level->GetDataPtr());
+	}
+
+	// glGenerateTextureMipmap always starts from the base level, so if we were given a partial chain we'll have
+	// to rebuild the whole thing
+	if (count < _mipLevels) {
+		GenerateMipMaps();
+	}
+
+	if (!base->DebugName.empty()) {
+		glObjectLabel(GL_TEXTURE, _handle, base->DebugName.length(), base->DebugName.c_str());
+	}
+}
+
+void Texture2D::GenerateMipMaps() {
+	if (_handle != 0 && _mipLevels > 1) {
+		glGenerateTextureMipmap(_handle);
+	}
+}
+
+void Texture2D::__Swap(Texture2D& other) {
+	std::swap(_handle, other._handle);
+	std::swap(_description, other._description);
+	std::swap(_mipLevels, other._mipLevels);
+}
+
 void Texture2D::Clear(const glm::vec4 color) {
 	if (_handle != 0) {
 		glClearTexImage(_handle, 0, GL_RGBA, GL_FLOAT, &color[0]);
@@ -77,14 +143,12 @@ void Texture2D::Clear(const glm::vec4 color) {
 
 void Texture2D::Bind(int slot) {
 	if (_handle != 0) {
-		glActiveTexture(GL_TEXTURE0 + slot);
-		glBindTexture(GL_TEXTURE_2D, _handle);
+		TTK::GLStateCache::Instance().BindTexture(slot, _handle);
 	}
 }
 
 void Texture2D::UnBind(int slot) {
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	TTK::GLStateCache::Instance().BindTexture(slot, 0);
 }
 
 void Texture2D::SetMinFilter(MinFilter filter) {
@@ -114,3 +178,22 @@ void Texture2D::SetWrapT(WrapMode mode) {
 		glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, (GLenum)_description.VerticalWrap);
 	}
 }
+
+void Texture2D::SetMaxAnisotropy(float anisotropy) {
+	_description.MaxAnisotropy = anisotropy;
+	if (_handle != 0 && GetMaxSupportedAnisotropy() > 1.0f) {
+		glTextureParameterf(_handle, GL_TEXTURE_MAX_ANISOTROPY, std::clamp(_description.MaxAnisotropy, 1.0f, MAX_ANISOTROPY));
+	}
+}
+
+float Texture2D::GetMaxSupportedAnisotropy() {
+	if (MAX_ANISOTROPY == 0.0f) {
+		// Anisotropic filtering is core in 4.6, but almost every 4.x driver exposes it as an extension
+		if (GLAD_GL_VERSION_4_6 || GLAD_GL_ARB_texture_filter_anisotropic) {
+			glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &MAX_ANISOTROPY);
+		}
+		MAX_ANISOTROPY = std::max(MAX_ANISOTROPY, 1.0f);
+		LOG_INFO("Maximum anisotropy on this renderer is {}x", MAX_ANISOTROPY);
+	}
+	return MAX_ANISOTROPY;
+}
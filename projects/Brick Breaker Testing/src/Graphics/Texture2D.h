@@ -1,6 +1,8 @@
 #pragma once
 #include <memory>
 #include <cstdint>
+#include <vector>
+#include <algorithm>
 #include <GLM/glm.hpp>
 
 #include "TextureEnums.h"
@@ -15,6 +17,11 @@ struct Texture2DDescription
 	WrapMode       VerticalWrap;
 	MinFilter      MinificationFilter;
 	MagFilter      MagnificationFilter;
+	// The number of mip levels to allocate, 0 will use a full chain if the min filter samples mip maps
+	uint32_t       MipLevels;
+	// The most samples to take along the axis of anisotropy, 1 turns anisotropic filtering off. This is clamped
+	// to what the renderer supports
+	float          MaxAnisotropy;
 
 	Texture2DDescription() :
 		Width(0), Height(0),
@@ -22,8 +29,25 @@ struct Texture2DDescription
 		HorizontalWrap(WrapMode::Repeat),
 		VerticalWrap(WrapMode::Repeat),
 		MinificationFilter(MinFilter::NearestMipLinear),
-		MagnificationFilter(MagFilter::Linear)
+		MagnificationFilter(MagFilter::Linear),
+		MipLevels(0),
+		MaxAnisotropy(1.0f)
 	{ }
+
+	/// <summary>
+	/// Gets the number of mip levels a texture with this description will have. A full chain goes all the way
+	/// down to 1x1, which is floor(log2(max(width, height))) + 1 levels
+	/// </summary>
+	uint32_t GetMipLevelCount() const {
+		uint32_t fullChain = 1;
+		for (uint32_t size = std::max(Width, Height); size > 1; size >>= 1) {
+			fullChain++;
+		}
+		if (MipLevels != 0) {
+			return std::min(MipLevels, fullChain);
+		}
+		return UsesMipMaps(MinificationFilter) ? fullChain : 1;
+	}
 };
 
 /// <summary>
@@ -58,6 +82,16 @@ public:
 	/// <param name="data">The texture data to upload into this texture</param>
 	void LoadData(const Texture2DData::sptr& data);
 	/// <summary>
+	/// Uploads a mip chain that has already been built (ex: by Texture2DData::GenerateMipChain), the first level
+	/// sets the size of the texture. If the texture has more levels than are given, the rest are generated on the GPU
+	/// </summary>
+	/// <param name="levels">The texture data for each mip level, largest first</param>
+	void LoadData(const std::vector<Texture2DData::sptr>& levels);
+	/// <summary>
+	/// Regenerates every mip level below the base level on the GPU, this is done by LoadData automatically
+	/// </summary>
+	void GenerateMipMaps();
+	/// <summary>
 	/// Clears this texture to a given color
 	/// </summary>
 	/// <param name="color">The color to clear the texture to</param>
@@ -86,19 +120,38 @@ public:
 	MagFilter GetMagFilter() const { return _description.MagnificationFilter; }
 	WrapMode GetWrapS() const { return _description.HorizontalWrap; }
 	WrapMode GetWrapT() const { return _description.VerticalWrap; }
+	uint32_t GetMipLevels() const { return _mipLevels; }
+	float GetMaxAnisotropy() const { return _description.MaxAnisotropy; }
 	
+	/// <summary>
+	/// Sets the min filter. Note that the number of mip levels is fixed when the texture is created, so switching
+	/// to a mip mapped filter will not add levels to a texture that was created without them
+	/// </summary>
 	void SetMinFilter(MinFilter filter);
 	void SetMagFilter(MagFilter filter);
 	void SetWrapS(WrapMode mode);
 	void SetWrapT(WrapMode mode);
+	void SetMaxAnisotropy(float anisotropy);
+
+	/// <summary>
+	/// Gets the highest anisotropy the renderer supports, or 1 if it does not support anisotropic filtering
+	/// </summary>
+	static float GetMaxSupportedAnisotropy();
 
 	const Texture2DDescription& GetDescription() const { return _description; }
 	
 private:
+	// The streamer fills a second texture in the background, then swaps it in once it's resident
+	friend class TextureStreamer;
+
 	Texture2DDescription _description;
 	GLuint _handle;
+	uint32_t _mipLevels;
+
+	void __Swap(Texture2D& other);
 
 	void _RecreateTexture();
 	
 	static int MAX_TEXTURE_SIZE;
+	static float MAX_ANISOTROPY;
 };
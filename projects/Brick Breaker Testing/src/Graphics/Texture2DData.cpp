@@ -1,12 +1,56 @@
 #include "Texture2DData.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <stb_image.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTURE_DATA_SSE
+#include <emmintrin.h>
+#endif
+
+/*
+ * Averages 2x2 blocks of unsigned byte texels from two source rows into one destination row
+ * @param row0 The first source row
+ * @param row1 The second source row, this may be the same as row0 for the last row of an odd height image
+ * @param dst The destination row, which has dstWidth texels
+ * @param srcWidth The number of texels in the source rows
+ * @param dstWidth The number of texels in the destination row
+ * @param components The number of bytes in a texel
+ */
+static void __DownsampleRow(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, uint32_t srcWidth, uint32_t dstWidth, uint32_t components) {
+	uint32_t x = 0;
+	#ifdef TEXTURE_DATA_SSE
+	// RGBA rows are done 2 output texels (4 input texels, 16 bytes) at a time. The first row is widened to 16 bits
+	// and added to the second, then each texel is added to its neighbour to the right
+	if (components == 4) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i round = _mm_set1_epi16(2);
+		for (; x + 2 <= dstWidth && (x * 2 + 4) <= srcWidth; x += 2) {
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+			__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+			__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+			lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+			hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+			__m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), round), 2);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x * 4), _mm_packus_epi16(sum, zero));
+		}
+	}
+	#endif
+	for (; x < dstWidth; x++) {
+		const uint32_t left = x * 2 * components;
+		const uint32_t right = std::min(x * 2 + 1, srcWidth - 1) * components;
+		for (uint32_t c = 0; c < components; c++) {
+			dst[x * components + c] = static_cast<uint8_t>((row0[left + c] + row0[right + c] + row1[left + c] + row1[right + c] + 2) >> 2);
+		}
+	}
+}
+
 Texture2DData::Texture2DData(uint32_t width, uint32_t height, PixelFormat format, PixelType type, void* sourceData, InternalFormat recommendedFormat) :
-	_width(width), _height(height), _format(format), _type(type), _data(nullptr), _recommendedFormat(recommendedFormat)
+	_width(width), _height(height), _format(format), _type(type), _recommendedFormat(recommendedFormat), _data(nullptr), _freeFunc(free)
 {
-	LOG_ASSERT(width > 0 & height > 0, "Width and height must both be greater than zero! Got {}x{}", width, height);
+	LOG_ASSERT(width > 0 && height > 0, "Width and height must both be greater than zero! Got {}x{}", width, height);
 	_dataSize = width * (size_t)height * GetTexelSize(_format, _type);
 	_data = malloc(_dataSize);
 	LOG_ASSERT(_data != nullptr, "Failed to allocate texture data!");
@@ -15,9 +59,17 @@ Texture2DData::Texture2DData(uint32_t width, uint32_t height, PixelFormat format
 	}
 }
 
+Texture2DData::Texture2DData(uint32_t width, uint32_t height, PixelFormat format, PixelType type, void* ownedData, void(*freeFunc)(void*), InternalFormat recommendedFormat) :
+	_width(width), _height(height), _format(format), _type(type), _recommendedFormat(recommendedFormat), _data(ownedData), _freeFunc(freeFunc)
+{
+	LOG_ASSERT(width > 0 && height > 0, "Width and height must both be greater than zero! Got {}x{}", width, height);
+	LOG_ASSERT(ownedData != nullptr && freeFunc != nullptr, "Owned texture data needs both the data and a way to free it!");
+	_dataSize = width * (size_t)height * GetTexelSize(_format, _type);
+}
+
 Texture2DData::~Texture2DData()
 {
-	free(_data);
+	_freeFunc(_data);
 }
 
 Texture2DData::sptr Texture2DData::LoadFromFile(const std::string& file, bool forceRgba)
@@ -26,7 +78,8 @@ Texture2DData::sptr Texture2DData::LoadFromFile(const std::string& file, bool fo
 	int width, height, numChannels;
 	const int targetChannels = forceRgba ? 4 : 0;
 
-	// Use STBI to load the image
+	// Use STBI to load the image. The flip flag is shared by every thread in this version of stb_image, since every
+	// load sets it to the same value, loads on worker threads (see TextureStreamer) will always agree on it
 	stbi_set_flip_vertically_on_load(true);
 	uint8_t* data = stbi_load(file.c_str(), &width, &height, &numChannels, targetChannels);
 
@@ -72,13 +125,50 @@ Texture2DData::sptr Texture2DData::LoadFromFile(const std::string& file, bool fo
 		LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
 	}
 
-	// Create the result and store our image data in it
+	// Create the result and hand it STBI's buffer, which it will free with stbi_image_free when it's done with it
 	// Note that stbi will always give us an array of unsigned bytes (uint8_t)
-	Texture2DData::sptr result = std::make_shared<Texture2DData>(width, height, image_format, PixelType::UByte, data, internal_format);
+	Texture2DData::sptr result = std::make_shared<Texture2DData>(width, height, image_format, PixelType::UByte, data, stbi_image_free, internal_format);
 	result->DebugName = std::filesystem::path(file).filename().string();
-	
-	// We now have a copy in our ptr, we can free STBI's copy of it
-	stbi_image_free(data);
 
 	return result;
 }
+
+
+Texture2DData::sptr Texture2DData::Downsample() const
+{
+	if (_type != PixelType::UByte) {
+		LOG_WARN("Can only downsample unsigned byte texture data, got {}", _type);
+		return nullptr;
+	}
+
+	const uint32_t width = std::max(_width >> 1, 1u);
+	const uint32_t height = std::max(_height >> 1, 1u);
+	const uint32_t components = static_cast<uint32_t>(GetTexelComponentCount(_format));
+	const size_t srcStride = _width * (size_t)components;
+	const size_t dstStride = width * (size_t)components;
+
+	Texture2DData::sptr result = std::make_shared<Texture2DData>(width, height, _format, _type, nullptr, _recommendedFormat);
+	result->DebugName = DebugName;
+	const uint8_t* src = static_cast<const uint8_t*>(_data);
+	uint8_t* dst = static_cast<uint8_t*>(result->_data);
+	for (uint32_t y = 0; y < height; y++) {
+		const uint8_t* row0 = src + (y * 2) * srcStride;
+		const uint8_t* row1 = src + std::min(y * 2 + 1, _height - 1) * srcStride;
+		__DownsampleRow(row0, row1, dst + y * dstStride, _width, width, components);
+	}
+	return result;
+}
+
+std::vector<Texture2DData::sptr> Texture2DData::GenerateMipChain(const Texture2DData::sptr& base, uint32_t levels)
+{
+	std::vector<Texture2DData::sptr> result;
+	result.push_back(base);
+	while ((levels == 0 || result.size() < levels) && (result.back()->_width > 1 || result.back()->_height > 1)) {
+		Texture2DData::sptr next = result.back()->Downsample();
+		if (next == nullptr) {
+			break;
+		}
+		result.push_back(next);
+	}
+	return result;
+}
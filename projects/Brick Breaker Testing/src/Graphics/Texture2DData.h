@@ -1,6 +1,7 @@
 #pragma once
 #include <memory>
 #include <cstdint>
+#include <vector>
 
 #include "TextureEnums.h"
 
@@ -28,6 +29,17 @@ public:
 	/// <param name="sourceData">A pointer to the data to upload to this texture</param>
 	/// <param name="recommendedFormat">The recommended internal format to use when creating textures from this data</param>
 	Texture2DData(uint32_t width, uint32_t height, PixelFormat format, PixelType type, void* sourceData, InternalFormat recommendedFormat = InternalFormat::Unknown);
+	/// <summary>
+	/// Creates a new 2D texture data object that takes ownership of an existing allocation, rather than copying it
+	/// </summary>
+	/// <param name="width">The width of the texture, in pixels</param>
+	/// <param name="height">The height of the texture, in pixels</param>
+	/// <param name="format">The pixel format or layout of a pixel (ex: RGBA)</param>
+	/// <param name="type">The component type of the pixel (ex: uint8_t)</param>
+	/// <param name="ownedData">The pixels, which must be width * height texels. This object will free them</param>
+	/// <param name="freeFunc">The function used to free ownedData (ex: stbi_image_free)</param>
+	/// <param name="recommendedFormat">The recommended internal format to use when creating textures from this data</param>
+	Texture2DData(uint32_t width, uint32_t height, PixelFormat format, PixelType type, void* ownedData, void(*freeFunc)(void*), InternalFormat recommendedFormat = InternalFormat::Unknown);
 	~Texture2DData();
 
 	/// <summary>
@@ -38,6 +50,22 @@ public:
 	/// <returns>A pointer to the data loaded from the file, or nullptr if the file failed to load</returns>
 	static Texture2DData::sptr LoadFromFile(const std::string& file, bool forceRgba = false);
 
+	/// <summary>
+	/// Creates the next mip level down from this data, which is half the size on each axis (rounded down, but
+	/// never less than 1). Each texel is the average of the 2x2 block of texels above it, and odd edges repeat
+	/// their last row or column. Only unsigned byte data is supported
+	/// </summary>
+	/// <returns>The downsampled data, or nullptr if the pixel type is not supported</returns>
+	Texture2DData::sptr Downsample() const;
+	/// <summary>
+	/// Builds a mip chain on the CPU, this is meant for baking assets ahead of time or on a loading thread, where
+	/// we don't want to spend GPU time on glGenerateTextureMipmap
+	/// </summary>
+	/// <param name="base">The data for the largest level</param>
+	/// <param name="levels">The number of levels to build including the base, 0 will go all the way down to 1x1</param>
+	/// <returns>Every level in the chain, starting with base</returns>
+	static std::vector<Texture2DData::sptr> GenerateMipChain(const Texture2DData::sptr& base, uint32_t levels = 0);
+
 	/// <summary>
 	/// Gets the width of the texture data, in pixels
 	/// </summary>
@@ -75,4 +103,5 @@ private:
 	PixelType   _type;
 	InternalFormat _recommendedFormat;
 	void* _data;
+	void(*_freeFunc)(void*);
 };
\ No newline at end of file
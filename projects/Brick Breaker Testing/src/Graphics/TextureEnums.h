@@ -66,6 +66,14 @@ ENUM(MinFilter, GLint,
 	LinearMipLinear   = GL_LINEAR_MIPMAP_LINEAR
 );
 
+/*
+ * Gets whether the given min filter samples from the mip levels of a texture
+ */
+constexpr bool UsesMipMaps(MinFilter filter)
+{
+	return filter != MinFilter::Nearest && filter != MinFilter::Linear;
+}
+
 // These are our available options for the GL_TEXTURE_MAG_FILTER setting
 ENUM(MagFilter, GLint,
 	Nearest = GL_NEAREST,
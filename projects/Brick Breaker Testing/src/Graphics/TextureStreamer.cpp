@@ -0,0 +1,209 @@
+#include "TextureStreamer.h"
+#include "TTK/GLStateCache.h"
+#include "TTK/Profiler.h"
+#include <algorithm>
+
+TextureStreamer::TextureStreamer(const ThreadPool::sptr& pool, size_t bytesPerFrame) :
+	_pool(pool),
+	_segmentSize(0),
+	_stagingBuffer(0),
+	_stagingPtr(nullptr),
+	_segment(0),
+	_placeholderColor(glm::vec4(0.5f, 0.5f, 0.5f, 1.0f)),
+	_stats({ 0, 0, 0, 0, 0, 0 })
+{
+	LOG_ASSERT(pool != nullptr, "The texture streamer needs a thread pool to decode on!");
+
+	// Keep each segment aligned, so the start of every upload is aligned for any pixel type
+	_segmentSize = (std::max(bytesPerFrame, (size_t)1) + 255) & ~(size_t)255;
+	for (GLsync& fence : _fences) {
+		fence = nullptr;
+	}
+
+	// The buffer stays mapped for its whole life, so we can write into it while the GPU is reading other segments
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &_stagingBuffer);
+	glNamedBufferStorage(_stagingBuffer, _segmentSize * STAGING_SEGMENTS, nullptr, flags);
+	_stagingPtr = static_cast<uint8_t*>(glMapNamedBufferRange(_stagingBuffer, 0, _segmentSize * STAGING_SEGMENTS, flags));
+	LOG_ASSERT(_stagingPtr != nullptr, "Failed to map the texture staging buffer!");
+}
+
+TextureStreamer::~TextureStreamer() {
+	// Any decodes that are still running only hold on to their job, so they can finish without us
+	for (GLsync& fence : _fences) {
+		if (fence != nullptr) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+	if (_stagingBuffer != 0) {
+		glUnmapNamedBuffer(_stagingBuffer);
+		TTK::GLStateCache::Instance().OnBufferDeleted(_stagingBuffer);
+		glDeleteBuffers(1, &_stagingBuffer);
+		_stagingBuffer = 0;
+	}
+}
+
+Texture2D::sptr TextureStreamer::Load(const std::string& file, bool forceRgba, const Texture2DDescription& description) {
+	// The placeholder is a single texel, so it is complete without any mip maps
+	Texture2DDescription placeholder = Texture2DDescription();
+	placeholder.Width = 1;
+	placeholder.Height = 1;
+	placeholder.Format = InternalFormat::RGBA8;
+	placeholder.MinificationFilter = MinFilter::Nearest;
+	placeholder.MagnificationFilter = MagFilter::Nearest;
+	Texture2D::sptr result = Texture2D::Create(placeholder);
+	result->Clear(_placeholderColor);
+
+	Request request;
+	request.Job = std::make_shared<DecodeJob>();
+	request.Job->File = file;
+	request.Job->ForceRgba = forceRgba;
+	request.Job->Description = description;
+	request.Job->IsDone = false;
+	request.Description = description;
+	request.Target = result;
+	request.Level = 0;
+	request.RowsUploaded = 0;
+	_decoding.push_back(request);
+	_stats.Requested++;
+
+	std::shared_ptr<DecodeJob> job = request.Job;
+	_pool->Submit([job]() {
+		try {
+			Texture2DData::sptr data = Texture2DData::LoadFromFile(job->File, job->ForceRgba);
+			if (data != nullptr) {
+				// We're already off the main thread, so we build the mip chain here rather than on the GPU
+				job->Description.Width = data->GetWidth();
+				job->Description.Height = data->GetHeight();
+				job->Levels = Texture2DData::GenerateMipChain(data, job->Description.GetMipLevelCount());
+			}
+		} catch (...) {
+			job->Levels.clear();
+		}
+		job->IsDone = true;
+	});
+
+	return result;
+}
+
+void TextureStreamer::Update() {
+	PROFILE_FUNCTION();
+
+	// Pick up anything the pool has finished decoding, and make the textures we'll upload it into
+	auto decoded = std::stable_partition(_decoding.begin(), _decoding.end(), [](const Request& request) {
+		return !request.Job->IsDone;
+	});
+	for (auto it = decoded; it != _decoding.end(); it++) {
+		if (it->Job->Levels.empty()) {
+			LOG_WARN("Failed to stream texture \"{}\", it will keep its placeholder", it->Job->File);
+			_stats.Failed++;
+			continue;
+		}
+		const Texture2DData::sptr& data = it->Job->Levels[0];
+		Texture2DDescription description = it->Description;
+		description.Width = data->GetWidth();
+		description.Height = data->GetHeight();
+		if (description.Format == InternalFormat::Unknown) {
+			description.Format = data->GetRecommendedFormat();
+		}
+		it->Staging = Texture2D::Create(description);
+		_uploading.push_back(*it);
+	}
+	_decoding.erase(decoded, _decoding.end());
+
+	_stats.BytesLastFrame = 0;
+	_stats.Uploading = _uploading.size();
+	if (_uploading.empty()) {
+		return;
+	}
+
+	// If the GPU is still copying out of this segment, we'll try again next frame rather than wait on it
+	GLsync& fence = _fences[_segment];
+	if (fence != nullptr) {
+		if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+			_stats.Stalls++;
+			return;
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	// Rows are packed tightly in the staging buffer, so they may not be 4 byte aligned. We put the alignment back
+	// once we're done, so uploads from the rest of the frame don't have to know about us
+	const size_t segmentStart = _segment * _segmentSize;
+	size_t offset = 0;
+	GLint previousAlignment = 4;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousAlignment);
+	TTK::GLStateCache::Instance().BindBuffer(GL_PIXEL_UNPACK_BUFFER, _stagingBuffer);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	while (!_uploading.empty()) {
+		Request& request = _uploading.front();
+		const Texture2DData& data = *request.Job->Levels[request.Level];
+		const size_t rowSize = data.GetDataSize() / data.GetHeight();
+
+		size_t rows = std::min<size_t>((_segmentSize - offset) / rowSize, data.GetHeight() - request.RowsUploaded);
+		if (rows == 0) {
+			if (offset > 0) {
+				// Out of budget for this frame
+				break;
+			}
+			// A single row doesn't fit in a segment, so we have no choice but to upload it directly. Rows only get
+			// smaller further down the chain, so this will always happen on the base level, before anything else
+			// has been uploaded. LoadData fills in any levels we couldn't build
+			TTK::GLStateCache::Instance().BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			request.Staging->LoadData(request.Job->Levels);
+			TTK::GLStateCache::Instance().BindBuffer(GL_PIXEL_UNPACK_BUFFER, _stagingBuffer);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			for (const Texture2DData::sptr& level : request.Job->Levels) {
+				_stats.BytesLastFrame += level->GetDataSize();
+			}
+			_Finish(request);
+			_uploading.pop_front();
+			break;
+		}
+
+		const size_t size = rows * rowSize;
+		memcpy(_stagingPtr + segmentStart + offset, static_cast<const uint8_t*>(data.GetDataPtr()) + request.RowsUploaded * rowSize, size);
+		// With a buffer bound to GL_PIXEL_UNPACK_BUFFER, the data pointer is an offset into the buffer
+		glTextureSubImage2D(request.Staging->GetHandle(), request.Level, 0, request.RowsUploaded, data.GetWidth(), static_cast<GLsizei>(rows),
+			*data.GetFormat(), *data.GetPixelType(), reinterpret_cast<const void*>(segmentStart + offset));
+		request.RowsUploaded += static_cast<uint32_t>(rows);
+		offset = (offset + size + 3) & ~(size_t)3;
+		_stats.BytesLastFrame += size;
+
+		if (request.RowsUploaded == data.GetHeight()) {
+			request.Level++;
+			request.RowsUploaded = 0;
+		}
+		if (request.Level == request.Job->Levels.size()) {
+			// If the CPU couldn't build the whole chain, the GPU builds it from the base level instead
+			if (request.Level < request.Staging->GetMipLevels()) {
+				request.Staging->GenerateMipMaps();
+			}
+			_Finish(request);
+			_uploading.pop_front();
+		}
+	}
+	TTK::GLStateCache::Instance().BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, previousAlignment);
+
+	if (offset > 0) {
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		_segment = (_segment + 1) % STAGING_SEGMENTS;
+	}
+	_stats.Uploading = _uploading.size();
+}
+
+void TextureStreamer::_Finish(Request& request) {
+	// Commands on one context run in order, so anything drawn with the target from here on will see the whole image
+	request.Target->__Swap(*request.Staging);
+	const std::string& name = request.Job->Levels[0]->DebugName;
+	if (!name.empty()) {
+		glObjectLabel(GL_TEXTURE, request.Target->GetHandle(), static_cast<GLsizei>(name.length()), name.c_str());
+	}
+	// This drops the placeholder, and the decoded image
+	request.Staging = nullptr;
+	request.Job->Levels.clear();
+	_stats.Resident++;
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <memory>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <atomic>
+
+#include "Graphics/Texture2D.h"
+#include "Graphics/Texture2DData.h"
+#include "Utilities/ThreadPool.h"
+
+/// <summary>
+/// Loads textures in the background, so that the game can start drawing before every image has been decoded.
+///
+/// Load hands back a texture straight away, which shows a small placeholder color until its image is ready. The
+/// image is decoded on a thread pool, which also builds its mip chain (see Texture2DData::GenerateMipChain). Update
+/// then copies each level into a persistently mapped staging buffer (a pixel buffer object) and has OpenGL copy it
+/// into a new texture from there. Update only copies up to a set number of
+/// bytes each frame, so large images are split across a few frames rather than causing a hitch. Once every row
+/// has been uploaded, the new texture is swapped in behind the one that Load returned.
+///
+/// The staging buffer is split into one segment per frame in flight. Each segment is fenced once the copies from
+/// it are issued, and we skip uploading for a frame rather than wait on a segment that the GPU is still reading
+/// </summary>
+class TextureStreamer final
+{
+public:
+	typedef std::shared_ptr<TextureStreamer> sptr;
+	static inline sptr Create(const ThreadPool::sptr& pool, size_t bytesPerFrame = DEFAULT_BYTES_PER_FRAME) {
+		return std::make_shared<TextureStreamer>(pool, bytesPerFrame);
+	}
+
+public:
+	// We'll disallow moving and copying, since we want to manually control when the destructor is called
+	// We'll use these classes via pointers
+	TextureStreamer(const TextureStreamer& other) = delete;
+	TextureStreamer(TextureStreamer&& other) = delete;
+	TextureStreamer& operator=(const TextureStreamer& other) = delete;
+	TextureStreamer& operator=(TextureStreamer&& other) = delete;
+
+	/// <summary>
+	/// The default number of bytes we upload each frame
+	/// </summary>
+	static constexpr size_t DEFAULT_BYTES_PER_FRAME = 8 * 1024 * 1024;
+	/// <summary>
+	/// The number of frames that can be reading from the staging buffer at once
+	/// </summary>
+	static constexpr uint32_t STAGING_SEGMENTS = 3;
+
+	struct Stats
+	{
+		size_t Requested;
+		size_t Resident;
+		size_t Failed;
+		// The number of textures that have been decoded, but not fully uploaded
+		size_t Uploading;
+		size_t BytesLastFrame;
+		// The number of frames we skipped uploading because the GPU was still using the staging segment
+		size_t Stalls;
+	};
+
+public:
+	/// <summary>
+	/// Creates a new texture streamer
+	/// </summary>
+	/// <param name="pool">The thread pool to decode images on</param>
+	/// <param name="bytesPerFrame">The most texture data to upload in a single frame</param>
+	TextureStreamer(const ThreadPool::sptr& pool, size_t bytesPerFrame = DEFAULT_BYTES_PER_FRAME);
+	~TextureStreamer();
+
+	/// <summary>
+	/// Starts loading a texture from a file, and returns a texture that will show the placeholder color until
+	/// the file has been loaded. If the file fails to load, the texture keeps the placeholder
+	/// </summary>
+	/// <param name="file">The path of the image to load</param>
+	/// <param name="forceRgba">True to force STBI to load 4 component texture data</param>
+	/// <param name="description">The wrap and filter settings to use, the size and format come from the image if not set</param>
+	Texture2D::sptr Load(const std::string& file, bool forceRgba = false, const Texture2DDescription& description = Texture2DDescription());
+
+	/// <summary>
+	/// Uploads the next part of any decoded images, and swaps in any textures that have finished uploading.
+	/// This must be called once per frame on the thread that owns the OpenGL context
+	/// </summary>
+	void Update();
+
+	/// <summary>
+	/// Gets whether every texture that has been requested is either resident or has failed to load
+	/// </summary>
+	bool IsIdle() const { return _stats.Resident + _stats.Failed == _stats.Requested; }
+
+	/// <summary>
+	/// Sets the color shown by textures that are still loading, this only affects textures loaded afterwards
+	/// </summary>
+	void SetPlaceholderColor(const glm::vec4& color) { _placeholderColor = color; }
+
+	const Stats& GetStats() const { return _stats; }
+
+protected:
+	// The part of a request that the pool works on. This never holds OpenGL objects, since the last reference to
+	// it may be dropped on a worker thread
+	struct DecodeJob
+	{
+		std::string          File;
+		bool                 ForceRgba;
+		Texture2DDescription Description;
+		// The decoded image followed by its mip levels, empty if the image failed to load. This may be shorter
+		// than the texture's chain if the image can't be downsampled on the CPU
+		std::vector<Texture2DData::sptr> Levels;
+		std::atomic<bool>    IsDone;
+	};
+
+	struct Request
+	{
+		std::shared_ptr<DecodeJob> Job;
+		Texture2DDescription       Description;
+		// The texture we gave back from Load, which holds the placeholder until we're done
+		Texture2D::sptr            Target;
+		// The texture we're uploading into, which is created once we know the size of the image
+		Texture2D::sptr            Staging;
+		// The mip level we're uploading, and how much of it is done
+		uint32_t                   Level;
+		uint32_t                   RowsUploaded;
+	};
+
+	ThreadPool::sptr _pool;
+	size_t           _segmentSize;
+	GLuint           _stagingBuffer;
+	uint8_t*         _stagingPtr;
+	GLsync           _fences[STAGING_SEGMENTS];
+	uint32_t         _segment;
+	glm::vec4        _placeholderColor;
+
+	// Requests that are still being decoded
+	std::vector<Request> _decoding;
+	// Requests that are being uploaded, in the order they were decoded
+	std::deque<Request>  _uploading;
+
+	Stats _stats;
+
+	void _Finish(Request& request);
+};
@@ -0,0 +1,133 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// Describes how a uniform block is laid out in C++, so that Shader::Link can check it against what
+/// the GLSL compiler came up with
+/// </summary>
+struct UniformBlockLayout
+{
+	struct Member {
+		std::string Name;
+		size_t      Offset;
+	};
+
+	std::string         Name;    // The name of the block in GLSL
+	GLuint              Binding; // The binding point the block will be attached to
+	size_t              Size;    // The size of the C++ struct, in bytes
+	std::vector<Member> Members;
+};
+
+// Shorthand for listing a member of a block in a GetLayout function
+#define UNIFORM_BLOCK_MEMBER(type, glslName, member) { glslName, offsetof(type, member) }
+
+/// <summary>
+/// The uniforms that are the same for every draw in a frame, this matches b_FrameData in our shaders.
+/// All members follow the std140 rules, so vec3s are always followed by a float to pad them out
+/// </summary>
+struct FrameUniforms
+{
+	static const GLuint BINDING = 0;
+
+	glm::mat4  View;
+	glm::vec3  CamPos;
+	float      AmbientStrength;
+	glm::vec3  AmbientCol;
+	float      SpecularLightStrength;
+	float      LightAttenuationConstant;
+	float      LightAttenuationLinear;
+	float      LightAttenuationQuadratic;
+	// The number of lights in the light buffer, see LightClusterGrid
+	uint32_t   LightCount;
+	// The number of clusters along each axis, and how to turn a view space depth into a depth slice
+	glm::uvec3 ClusterCount;
+	float      ClusterDepthScale;
+	// The size of a cluster's tile on the screen, in pixels
+	glm::vec2  ClusterTileSize;
+	float      ClusterDepthBias;
+	float      _padding;
+
+	static UniformBlockLayout GetLayout() {
+		return { "b_FrameData", BINDING, sizeof(FrameUniforms), {
+			UNIFORM_BLOCK_MEMBER(FrameUniforms, "u_View", View),
+			UNIFORM_BLOCK_MEMBER(FrameUniforms, "u_CamPos", CamPos),
+			UNIFORM_BLOCK_MEMBER(FrameUniforms, "u_AmbientStrength", AmbientStrength),
+			UNIFORM_BLOCK_MEMBER(FrameUniforms, "u_AmbientCol", AmbientCol),
+			UNIFORM_BLOCK_MEMBER(FrameUniforms, "u_SpecularLightStrength", SpecularLightStrength),
+			UNIFORM_BLOCK_MEMBER(FrameUniforms, "u_LightAttenuationConstant", LightAttenuationConstant),
+			UNIFORM_BLOCK_MEMBER(FrameUniforms, "u_LightAttenuationLinear", LightAttenuationLinear),
+			UNIFORM_BLOCK_MEMBER(FrameUniforms, "u_LightAttenuationQuadratic", LightAttenuationQuadratic),
+			UNIFORM_BLOCK_MEMBER(FrameUniforms, "u_LightCount", LightCount),
+			UNIFORM_BLOCK_MEMBER(FrameUniforms, "u_ClusterCount", ClusterCount),
+			UNIFORM_BLOCK_MEMBER(FrameUniforms, "u_ClusterDepthScale", ClusterDepthScale),
+			UNIFORM_BLOCK_MEMBER(FrameUniforms, "u_ClusterTileSize", ClusterTileSize),
+			UNIFORM_BLOCK_MEMBER(FrameUniforms, "u_ClusterDepthBias", ClusterDepthBias)
+		} };
+	}
+};
+
+/// <summary>
+/// A single point light, this matches PointLight in include/lights.glsl. Lights are stored in a shader storage
+/// buffer with the std430 rules, so each one is exactly 2 vec4s
+/// </summary>
+struct PointLight
+{
+	glm::vec3 Position;
+	// The light has no effect past this distance, which is what lets us sort lights into clusters
+	float     Radius;
+	glm::vec3 Color;
+	float     AmbientStrength;
+};
+
+/// <summary>
+/// The uniforms that are shared by every instance in a draw, this matches b_DrawData in our shaders.
+/// These are pushed into a UniformRingBuffer, one block per draw call
+/// </summary>
+struct DrawUniforms
+{
+	static const GLuint BINDING = 1;
+
+	glm::vec3   PositionScale;
+	float       Shininess;
+	glm::vec3   PositionOffset;
+	uint32_t    OctahedralNormals;
+
+	static UniformBlockLayout GetLayout() {
+		return { "b_DrawData", BINDING, sizeof(DrawUniforms), {
+			UNIFORM_BLOCK_MEMBER(DrawUniforms, "u_PositionScale", PositionScale),
+			UNIFORM_BLOCK_MEMBER(DrawUniforms, "u_Shininess", Shininess),
+			UNIFORM_BLOCK_MEMBER(DrawUniforms, "u_PositionOffset", PositionOffset),
+			UNIFORM_BLOCK_MEMBER(DrawUniforms, "u_OctahedralNormals", OctahedralNormals)
+		} };
+	}
+};
+
+/// <summary>
+/// The uniforms that change with every instance, this matches b_InstanceData in our vertex shader, which
+/// indexes it with gl_InstanceID. Each member is its own array (rather than an array of structs) so that
+/// a draw only needs to fill in as many entries as it has instances
+/// </summary>
+struct InstanceUniforms
+{
+	static const GLuint BINDING = 2;
+	// Must match MAX_INSTANCES in vertex_shader.glsl, 64 instances keeps us well under the 16KB minimum block size
+	static const size_t MAX_INSTANCES = 64;
+
+	glm::mat4   ModelViewProjection[MAX_INSTANCES];
+	glm::mat4   Model[MAX_INSTANCES];
+	// A std140 mat3 is stored as 3 vec4 columns
+	glm::mat3x4 NormalMatrix[MAX_INSTANCES];
+
+	static UniformBlockLayout GetLayout() {
+		return { "b_InstanceData", BINDING, sizeof(InstanceUniforms), {
+			UNIFORM_BLOCK_MEMBER(InstanceUniforms, "u_ModelViewProjection", ModelViewProjection),
+			UNIFORM_BLOCK_MEMBER(InstanceUniforms, "u_Model", Model),
+			UNIFORM_BLOCK_MEMBER(InstanceUniforms, "u_NormalMatrix", NormalMatrix)
+		} };
+	}
+};
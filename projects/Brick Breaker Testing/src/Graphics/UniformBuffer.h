@@ -0,0 +1,56 @@
+#pragma once
+#include "IBuffer.h"
+#include <memory>
+#include "Logging.h"
+#include "TTK/GLStateCache.h"
+
+/// <summary>
+/// The uniform buffer stores a block of uniforms that can be shared between any number of shaders,
+/// see UniformBlocks.h for the layouts we use
+/// </summary>
+class UniformBuffer : public IBuffer
+{
+public:
+	typedef std::shared_ptr<UniformBuffer> sptr;
+	static inline sptr Create(GLenum usage = GL_DYNAMIC_DRAW) {
+		return std::make_shared<UniformBuffer>(usage);
+	}
+
+public:
+	/// <summary>
+	/// Creates a new uniform buffer, with the given usage. Data will still need to be uploaded before it can be used
+	/// </summary>
+	/// <param name="usage">The usage hint for the buffer, default is GL_DYNAMIC_DRAW</param>
+	UniformBuffer(GLenum usage = GL_DYNAMIC_DRAW) : IBuffer(GL_UNIFORM_BUFFER, usage) { }
+
+	/// <summary>
+	/// Replaces the contents of this buffer with a single block of data. The first call will allocate the
+	/// buffer, after that the block must be the same size
+	/// </summary>
+	/// <typeparam name="T">The type of block to upload, must match the std140 layout in the shader</typeparam>
+	/// <param name="data">The block to upload</param>
+	template <typename T>
+	void Update(const T& data) {
+		if (_elementCount == 0) {
+			IBuffer::LoadData(&data, 1);
+		} else {
+			LOG_ASSERT(sizeof(T) == _elementSize, "Uniform block size does not match the buffer!");
+			glNamedBufferSubData(_handle, 0, sizeof(T), &data);
+		}
+	}
+
+	using IBuffer::Bind;
+	/// <summary>
+	/// Binds this buffer to the given uniform block binding point
+	/// </summary>
+	/// <param name="binding">The binding point to attach the buffer to, see UniformBlocks.h</param>
+	void Bind(GLuint binding) {
+		TTK::GLStateCache::Instance().BindBufferBase(GL_UNIFORM_BUFFER, binding, _handle);
+	}
+
+	/// <summary>
+	/// Unbinds the buffer attached to the given uniform block binding point
+	/// </summary>
+	/// <param name="binding">The binding point to clear</param>
+	static void UnBind(GLuint binding) { TTK::GLStateCache::Instance().BindBufferBase(GL_UNIFORM_BUFFER, binding, 0); }
+};
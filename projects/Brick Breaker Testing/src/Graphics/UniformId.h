@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "Utilities/HashUtils.h"
+
+/// <summary>
+/// Identifies a uniform by the hash of its name, so that looking up a uniform's location doesn't need to
+/// build or compare any strings. Passing a string literal straight to SetUniform works, but the compiler
+/// may still hash it at runtime. In hot code, declare the ID as constexpr so the hash is always worked out
+/// at compile time:
+///    static constexpr UniformId u_Shininess = "u_Shininess";
+/// </summary>
+struct UniformId
+{
+	// The 32 bit FNV-1a hash of the uniform's name
+	uint32_t    Hash;
+	// The name the ID was made from, only used for logging. Only valid for as long as the string it was made from
+	const char* Name;
+
+	constexpr UniformId(const char* name) : Hash(HashString32(name)), Name(name) { }
+	UniformId(const std::string& name) : UniformId(name.c_str()) { }
+
+	constexpr bool operator ==(const UniformId& other) const { return Hash == other.Hash; }
+	constexpr bool operator !=(const UniformId& other) const { return Hash != other.Hash; }
+};
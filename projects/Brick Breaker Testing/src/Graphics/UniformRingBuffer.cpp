@@ -0,0 +1,93 @@
+#include "UniformRingBuffer.h"
+#include "Logging.h"
+#include "TTK/GLStateCache.h"
+#include "TTK/GLFence.h"
+#include <cstring>
+#include <algorithm>
+
+UniformRingBuffer::UniformRingBuffer(size_t blockSize, size_t blocksPerFrame) :
+	_handle(0),
+	_mapped(nullptr),
+	_stride(0),
+	_blocksPerFrame(0),
+	_frameIndex(0),
+	_blockIndex(0),
+	_fences(),
+	_bytesStreamed(0),
+	_fencesWaited(0)
+{
+	// Every range we bind has to start on a multiple of this, usually 256 bytes
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	alignment = std::max(alignment, 1);
+	_stride = (blockSize + alignment - 1) / alignment * alignment;
+	_Allocate(std::max(blocksPerFrame, (size_t)1));
+}
+
+UniformRingBuffer::~UniformRingBuffer() {
+	for (GLsync& fence : _fences) {
+		if (fence != nullptr) {
+			glDeleteSync(fence);
+		}
+	}
+	_Free();
+}
+
+void UniformRingBuffer::BeginFrame() {
+	_frameIndex = (_frameIndex + 1) % FRAMES_IN_FLIGHT;
+	_blockIndex = 0;
+
+	// The GPU has to be done with this frame's section before we write over it
+	if (TTK::WaitForFence(_fences[_frameIndex])) {
+		_fencesWaited++;
+	}
+}
+
+void UniformRingBuffer::EndFrame() {
+	if (_fences[_frameIndex] != nullptr) {
+		glDeleteSync(_fences[_frameIndex]);
+	}
+	_fences[_frameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void UniformRingBuffer::Push(const void* data, size_t size, GLuint binding) {
+	memcpy(Allocate(size, binding), data, size);
+}
+
+void* UniformRingBuffer::Allocate(size_t size, GLuint binding) {
+	LOG_ASSERT(size <= _stride, "Block is larger than the ring buffer was created for!");
+	if (_blockIndex == _blocksPerFrame) {
+		// Growing mid-frame is fine, see TTK::Context::__AllocateRing
+		LOG_WARN("Uniform ring buffer overflowed, growing to {} blocks per frame", _blocksPerFrame * 2);
+		_Allocate(_blocksPerFrame * 2);
+	}
+
+	size_t offset = (_frameIndex * _blocksPerFrame + _blockIndex) * _stride;
+	TTK::GLStateCache::Instance().BindBufferRange(GL_UNIFORM_BUFFER, binding, _handle, offset, size);
+
+	_blockIndex++;
+	_bytesStreamed += size;
+	return _mapped + offset;
+}
+
+void UniformRingBuffer::_Allocate(size_t blocksPerFrame) {
+	_Free();
+	_blocksPerFrame = blocksPerFrame;
+
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	const GLsizeiptr size = _stride * _blocksPerFrame * FRAMES_IN_FLIGHT;
+	glCreateBuffers(1, &_handle);
+	glNamedBufferStorage(_handle, size, nullptr, flags);
+	_mapped = static_cast<uint8_t*>(glMapNamedBufferRange(_handle, 0, size, flags));
+	LOG_ASSERT(_mapped != nullptr, "Failed to map uniform ring buffer!");
+}
+
+void UniformRingBuffer::_Free() {
+	if (_handle != 0) {
+		glUnmapNamedBuffer(_handle);
+		TTK::GLStateCache::Instance().OnBufferDeleted(_handle);
+		glDeleteBuffers(1, &_handle);
+		_handle = 0;
+		_mapped = nullptr;
+	}
+}
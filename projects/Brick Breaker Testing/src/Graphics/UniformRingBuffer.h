@@ -0,0 +1,101 @@
+#pragma once
+#include <glad/glad.h>
+#include <memory>
+#include <cstdint>
+
+/// <summary>
+/// Streams small blocks of uniforms that change every draw (like the model matrix) into one big persistently
+/// mapped buffer. Each block gets its own aligned slice of the buffer, which is attached to a binding point
+/// with glBindBufferRange, so we never have to wait for the GPU to finish with a block before writing the next.
+/// The buffer is split into a section per frame in flight, with a fence guarding each section
+/// </summary>
+class UniformRingBuffer final
+{
+public:
+	typedef std::shared_ptr<UniformRingBuffer> sptr;
+	static inline sptr Create(size_t blockSize, size_t blocksPerFrame = 256) {
+		return std::make_shared<UniformRingBuffer>(blockSize, blocksPerFrame);
+	}
+
+public:
+	// We'll disallow moving and copying, since we want to manually control when the destructor is called
+	// We'll use these classes via pointers
+	UniformRingBuffer(const UniformRingBuffer& other) = delete;
+	UniformRingBuffer(UniformRingBuffer&& other) = delete;
+	UniformRingBuffer& operator=(const UniformRingBuffer& other) = delete;
+	UniformRingBuffer& operator=(UniformRingBuffer&& other) = delete;
+
+	/// <summary>
+	/// The number of frames the GPU is allowed to fall behind before we wait for it
+	/// </summary>
+	static const size_t FRAMES_IN_FLIGHT = 3;
+
+public:
+	/// <summary>
+	/// Creates a new ring buffer for blocks of up to the given size
+	/// </summary>
+	/// <param name="blockSize">The largest block that will be pushed, in bytes</param>
+	/// <param name="blocksPerFrame">The initial number of blocks a frame can hold, the buffer grows if this is exceeded</param>
+	UniformRingBuffer(size_t blockSize, size_t blocksPerFrame);
+	~UniformRingBuffer();
+
+	/// <summary>
+	/// Starts writing into the next section of the ring, waiting for the GPU if it is still reading it
+	/// </summary>
+	void BeginFrame();
+	/// <summary>
+	/// Marks the current section of the ring as in use until all the draws issued so far have completed
+	/// </summary>
+	void EndFrame();
+
+	/// <summary>
+	/// Copies a block of uniforms into the ring, and attaches it to a uniform block binding point
+	/// </summary>
+	/// <typeparam name="T">The type of block to push, must match the std140 layout in the shader</typeparam>
+	/// <param name="data">The block to push</param>
+	/// <param name="binding">The binding point to attach the block to, see UniformBlocks.h</param>
+	template <typename T>
+	void Push(const T& data, GLuint binding) {
+		static_assert(sizeof(T) % 16 == 0, "Uniform blocks should be padded to a multiple of 16 bytes");
+		Push(&data, sizeof(T), binding);
+	}
+	void Push(const void* data, size_t size, GLuint binding);
+
+	/// <summary>
+	/// Reserves space for a block in the ring and attaches it to a uniform block binding point, returning a
+	/// pointer that the block can be written to directly. This saves a copy when only part of a large block
+	/// is used (like InstanceUniforms), the pointer is only valid until the next Push, Allocate or BeginFrame
+	/// </summary>
+	/// <typeparam name="T">The type of block to allocate, must match the std140 layout in the shader</typeparam>
+	/// <param name="binding">The binding point to attach the block to, see UniformBlocks.h</param>
+	template <typename T>
+	T* Allocate(GLuint binding) {
+		static_assert(sizeof(T) % 16 == 0, "Uniform blocks should be padded to a multiple of 16 bytes");
+		return static_cast<T*>(Allocate(sizeof(T), binding));
+	}
+	void* Allocate(size_t size, GLuint binding);
+
+	/// <summary>
+	/// Gets the total number of bytes that have been pushed into the ring
+	/// </summary>
+	size_t GetBytesStreamed() const { return _bytesStreamed; }
+	/// <summary>
+	/// Gets the number of times BeginFrame had to wait for the GPU to catch up
+	/// </summary>
+	size_t GetFencesWaited() const { return _fencesWaited; }
+
+protected:
+	GLuint   _handle;
+	uint8_t* _mapped;
+	size_t   _stride;          // The size of a block, rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	size_t   _blocksPerFrame;
+	size_t   _frameIndex;
+	size_t   _blockIndex;      // The next block to write within the current frame
+	GLsync   _fences[FRAMES_IN_FLIGHT];
+
+	size_t   _bytesStreamed;
+	size_t   _fencesWaited;
+
+	void _Allocate(size_t blocksPerFrame);
+	void _Free();
+};
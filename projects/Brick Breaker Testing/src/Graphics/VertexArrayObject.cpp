@@ -1,12 +1,14 @@
 #include "VertexArrayObject.h"
 #include "IndexBuffer.h"
 #include "Logging.h"
+#include "TTK/GLStateCache.h"
 #include "VertexBuffer.h"
 
 VertexArrayObject::VertexArrayObject() :
 	_indexBuffer(nullptr),
 	_handle(0),
-	_vertexCount(0)
+	_vertexCount(0),
+	_decodeInfo(VertexDecodeInfo())
 {
 	glCreateVertexArrays(1, &_handle);
 }
@@ -14,6 +16,7 @@ VertexArrayObject::VertexArrayObject() :
 VertexArrayObject::~VertexArrayObject()
 {
 	if (_handle != 0) {
+		TTK::GLStateCache::Instance().OnVertexArrayDeleted(_handle);
 		glDeleteVertexArrays(1, &_handle);
 		_handle = 0;
 	}
@@ -54,19 +57,19 @@ void VertexArrayObject::AddVertexBuffer(const VertexBuffer::sptr& buffer, const
 }
 
 void VertexArrayObject::Bind() const {
-	glBindVertexArray(_handle);
+	TTK::GLStateCache::Instance().BindVertexArray(_handle);
 }
 
 void VertexArrayObject::UnBind() {
-	glBindVertexArray(0);
+	TTK::GLStateCache::Instance().BindVertexArray(0);
 }
 
-void VertexArrayObject::Render() const {
+void VertexArrayObject::Render(uint32_t instanceCount) const {
+	// We leave the VAO bound after drawing, so that drawing the same VAO again doesn't need to re-bind it
 	Bind();
 	if (_indexBuffer != nullptr) {
-		glDrawElements(GL_TRIANGLES, _indexBuffer->GetElementCount(), _indexBuffer->GetElementType(), nullptr);
+		glDrawElementsInstanced(GL_TRIANGLES, _indexBuffer->GetElementCount(), _indexBuffer->GetElementType(), nullptr, instanceCount);
 	} else {
-		glDrawArrays(GL_TRIANGLES, 0, _vertexCount / 3);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, _vertexCount / 3, instanceCount);
 	}
-	UnBind();
 }
@@ -3,6 +3,8 @@
 #include <cstdint>
 #include <vector>
 #include <memory>
+#include <cmath>
+#include <GLM/glm.hpp>
 
 #include "VertexBuffer.h"
 #include "IndexBuffer.h"
@@ -70,6 +72,39 @@ struct BufferAttribute
 		Slot(slot), Size(size), Type(type), Normalized(normalized), Stride(stride), Offset(offset), Usage(usage) { }
 };
 
+/// <summary>
+/// Describes how the vertex shader needs to decode the data in a VAO that was baked from a packed
+/// vertex format (see VertexTypes.h). The defaults mean that no decoding is needed
+/// </summary>
+struct VertexDecodeInfo
+{
+	/// <summary>
+	/// Quantized positions are stored in the -1 to 1 range, and are decoded as pos * PositionScale + PositionOffset
+	/// </summary>
+	glm::vec3 PositionScale = glm::vec3(1.0f);
+	glm::vec3 PositionOffset = glm::vec3(0.0f);
+	/// <summary>
+	/// True if normals are octahedral encoded as a vec2 in slot 4, rather than a vec3 in slot 2
+	/// </summary>
+	bool      OctahedralNormals = false;
+};
+
+/// <summary>
+/// The bounds of a mesh in its local space, worked out when the mesh is baked so that we can skip
+/// drawing it when it is off screen
+/// </summary>
+struct MeshBounds
+{
+	glm::vec3 Min = glm::vec3(0.0f);
+	glm::vec3 Max = glm::vec3(0.0f);
+	/// <summary>
+	/// The bounding sphere is centered on the box, and is just big enough to hold every vertex. Meshes that
+	/// were never given bounds have an infinite radius, so they are always drawn
+	/// </summary>
+	glm::vec3 Center = glm::vec3(0.0f);
+	float     Radius = INFINITY;
+};
+
 /// <summary>
 /// The Vertex Array Object wraps around an OpenGL VAO and basically represents all of the data for a mesh
 /// </summary>
@@ -115,6 +150,26 @@ public:
 	/// <param name="attributes">A list of vertex attributes that will be fed by this buffer</param>
 	void AddVertexBuffer(const VertexBuffer::sptr& buffer, const std::vector<BufferAttribute>& attributes);
 
+	/// <summary>
+	/// Sets how the vertex data in this VAO needs to be decoded, shaders should apply this when rendering
+	/// </summary>
+	/// <param name="info">The decoding info for the packed vertex format used by this VAO</param>
+	void SetDecodeInfo(const VertexDecodeInfo& info) { _decodeInfo = info; }
+	/// <summary>
+	/// Gets how the vertex data in this VAO needs to be decoded by the vertex shader
+	/// </summary>
+	const VertexDecodeInfo& GetDecodeInfo() const { return _decodeInfo; }
+
+	/// <summary>
+	/// Sets the local space bounds of the mesh in this VAO, used for culling
+	/// </summary>
+	/// <param name="bounds">The bounds of the vertex positions</param>
+	void SetBounds(const MeshBounds& bounds) { _bounds = bounds; }
+	/// <summary>
+	/// Gets the local space bounds of the mesh in this VAO
+	/// </summary>
+	const MeshBounds& GetBounds() const { return _bounds; }
+
 	/// <summary>
 	/// Binds this VAO as the source of data for draw operations
 	/// </summary>
@@ -129,7 +184,12 @@ public:
 	/// </summary>
 	GLuint GetHandle() const { return _handle; }
 
-	void Render() const;
+	/// <summary>
+	/// Draws this VAO, leaving it bound afterwards. Anything that modifies VAO state with bind calls
+	/// (like SetIndexBuffer) must bind its own VAO first
+	/// </summary>
+	/// <param name="instanceCount">The number of instances to draw, shaders can tell them apart with gl_InstanceID</param>
+	void Render(uint32_t instanceCount = 1) const;
 	
 protected:
 	// Helper structure to store a buffer and the attributes
@@ -145,6 +205,9 @@ protected:
 	std::vector<VertexBufferBinding> _vertexBuffers;
 
 	GLsizei _vertexCount;
+
+	VertexDecodeInfo _decodeInfo;
+	MeshBounds _bounds;
 	
 	// The underlying OpenGL handle that this class is wrapping around
 	GLuint _handle;
@@ -0,0 +1,131 @@
+#include "FileWatcher.h"
+#include "Logging.h"
+#include "PathUtils.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+FileWatcher::FileWatcher(const ChangedCallback& onChanged) :
+	_onChanged(onChanged),
+	_isStopping(false),
+	_files(std::unordered_map<std::string, WatchedFile>()),
+	_inotify(-1),
+	_directories(std::unordered_map<int, std::filesystem::path>())
+{
+#ifdef __linux__
+	_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (_inotify == -1) {
+		LOG_WARN("Failed to create an inotify instance, falling back to polling for file changes");
+	}
+#endif
+	_thread = std::thread(&FileWatcher::_WatcherMain, this);
+}
+
+FileWatcher::~FileWatcher() {
+	_isStopping = true;
+	_thread.join();
+#ifdef __linux__
+	if (_inotify != -1) {
+		close(_inotify);
+	}
+#endif
+}
+
+void FileWatcher::Watch(const std::string& path) {
+	std::lock_guard<std::mutex> lock(_filesLock);
+	std::string key = NormalizePath(path);
+	if (_files.find(key) != _files.end()) {
+		return;
+	}
+	std::error_code error;
+	WatchedFile& file = _files[key];
+	file = { path, std::filesystem::last_write_time(path, error), true };
+
+#ifdef __linux__
+	if (_inotify != -1) {
+		// We watch the directory rather than the file, since a lot of editors replace the file when saving
+		std::filesystem::path directory = std::filesystem::path(key).parent_path();
+		int descriptor = inotify_add_watch(_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if (descriptor == -1) {
+			// Usually we've hit the inotify watch limit, or the directory is on a file system that doesn't support it
+			LOG_WARN("Failed to watch directory \"{}\" for changes, falling back to polling \"{}\"", directory.string(), path);
+		} else {
+			_directories[descriptor] = directory;
+			file.IsPolled = false;
+		}
+	}
+#endif
+}
+
+void FileWatcher::_WatcherMain() {
+	while (!_isStopping) {
+#ifdef __linux__
+		if (_inotify != -1) {
+			pollfd request = { _inotify, POLLIN, 0 };
+			if (poll(&request, 1, POLL_INTERVAL_MS) <= 0) {
+				// Nothing from inotify, but any files it couldn't watch still need checking
+				_PollFiles();
+				continue;
+			}
+
+			// Events are variable length, since they include the name of the file within the directory
+			alignas(inotify_event) char buffer[4096];
+			ssize_t length = 0;
+			while ((length = read(_inotify, buffer, sizeof(buffer))) > 0) {
+				for (char* ptr = buffer; ptr < buffer + length; ) {
+					const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+					ptr += sizeof(inotify_event) + event->len;
+					if (event->len == 0) {
+						continue;
+					}
+
+					std::string path;
+					{
+						std::lock_guard<std::mutex> lock(_filesLock);
+						auto directory = _directories.find(event->wd);
+						if (directory == _directories.end()) {
+							continue;
+						}
+						auto file = _files.find(NormalizePath(directory->second / event->name));
+						if (file == _files.end()) {
+							continue;
+						}
+						path = file->second.Path;
+					}
+					_onChanged(path);
+				}
+			}
+			_PollFiles();
+			continue;
+		}
+#endif
+		_PollFiles();
+		std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+	}
+}
+
+void FileWatcher::_PollFiles() {
+	std::vector<std::string> changed;
+	{
+		std::lock_guard<std::mutex> lock(_filesLock);
+		for (auto& [key, file] : _files) {
+			if (!file.IsPolled) {
+				continue;
+			}
+			std::error_code error;
+			std::filesystem::file_time_type lastWrite = std::filesystem::last_write_time(file.Path, error);
+			// A file that can't be read right now is probably in the middle of being saved, we'll catch it next time
+			if (!error && lastWrite != file.LastWrite) {
+				file.LastWrite = lastWrite;
+				changed.push_back(file.Path);
+			}
+		}
+	}
+	// We call out without holding the lock, so that the callback is free to call Watch
+	for (const std::string& path : changed) {
+		_onChanged(path);
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <filesystem>
+
+/// <summary>
+/// Watches a set of files on a background thread, and invokes a callback (on that same thread) whenever one
+/// of them is written to. On Linux this uses inotify on the containing directories, so that editors which save
+/// by writing a new file and renaming it over the old one are still picked up. Elsewhere (or for any file whose
+/// directory inotify can't watch) we poll the last write time of each file a few times a second
+/// </summary>
+class FileWatcher final
+{
+public:
+	typedef std::shared_ptr<FileWatcher> sptr;
+	// Invoked on the watcher thread with the path of the file that changed, as it was passed to Watch
+	typedef std::function<void(const std::string&)> ChangedCallback;
+
+	static inline sptr Create(const ChangedCallback& onChanged) {
+		return std::make_shared<FileWatcher>(onChanged);
+	}
+
+public:
+	// We'll disallow moving and copying, since we want to manually control when the destructor is called
+	// We'll use these classes via pointers
+	FileWatcher(const FileWatcher& other) = delete;
+	FileWatcher(FileWatcher&& other) = delete;
+	FileWatcher& operator=(const FileWatcher& other) = delete;
+	FileWatcher& operator=(FileWatcher&& other) = delete;
+
+	/// <summary>
+	/// How often the polling fallback checks files, and how often the watcher thread checks if it should stop
+	/// </summary>
+	static const int POLL_INTERVAL_MS = 250;
+
+public:
+	FileWatcher(const ChangedCallback& onChanged);
+	~FileWatcher();
+
+	/// <summary>
+	/// Starts watching the given file, watching the same file twice has no effect
+	/// </summary>
+	/// <param name="path">The path to the file to watch</param>
+	void Watch(const std::string& path);
+
+private:
+	struct WatchedFile {
+		std::string                     Path;
+		std::filesystem::file_time_type LastWrite;
+		// True if inotify isn't watching this file's directory, so we have to check its last write time ourselves
+		bool                            IsPolled;
+	};
+
+	ChangedCallback   _onChanged;
+	std::thread       _thread;
+	std::atomic<bool> _isStopping;
+	std::mutex        _filesLock;
+	// Keyed by the normalized absolute path, so that the same file is never watched twice
+	std::unordered_map<std::string, WatchedFile> _files;
+
+	// The inotify instance and a watch descriptor per directory, only used on Linux
+	int _inotify;
+	std::unordered_map<int, std::filesystem::path> _directories;
+
+	void _WatcherMain();
+	void _PollFiles();
+};
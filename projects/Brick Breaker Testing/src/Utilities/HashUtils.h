@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+// Constants for the 64 bit FNV-1a hash, see http://www.isthe.com/chongo/tech/comp/fnv/
+static constexpr uint64_t FNV1A_64_OFFSET = 14695981039346656037ull;
+static constexpr uint64_t FNV1A_64_PRIME  = 1099511628211ull;
+// Constants for the 32 bit FNV-1a hash
+static constexpr uint32_t FNV1A_32_OFFSET = 2166136261u;
+static constexpr uint32_t FNV1A_32_PRIME  = 16777619u;
+
+/// <summary>
+/// Hashes a block of memory using a word-at-a-time variant of FNV-1a. This is NOT a
+/// cryptographic hash, it's only intended to detect when source data has changed
+/// </summary>
+/// <param name="data">A pointer to the start of the data to hash</param>
+/// <param name="size">The size of the data, in bytes</param>
+/// <param name="seed">The hash to continue from, allows for chaining calls</param>
+/// <returns>The 64 bit hash of the data</returns>
+static inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed = FNV1A_64_OFFSET) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t hash = seed;
+
+	// Consume 8 bytes at a time, memcpy keeps us safe on unaligned input
+	size_t ix = 0;
+	for (; ix + sizeof(uint64_t) <= size; ix += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, bytes + ix, sizeof(uint64_t));
+		hash = (hash ^ word) * FNV1A_64_PRIME;
+	}
+	// Handle any trailing bytes one at a time
+	for (; ix < size; ix++) {
+		hash = (hash ^ bytes[ix]) * FNV1A_64_PRIME;
+	}
+	return hash;
+}
+
+/// <summary>
+/// Hashes a null terminated string with the 32 bit FNV-1a hash. This is constexpr, so when it is given
+/// a string literal the hash can be worked out at compile time
+/// </summary>
+/// <param name="str">The string to hash</param>
+/// <returns>The 32 bit hash of the string, not including the null terminator</returns>
+static constexpr uint32_t HashString32(const char* str) {
+	uint32_t hash = FNV1A_32_OFFSET;
+	for (; *str != '\0'; str++) {
+		hash = (hash ^ static_cast<uint8_t>(*str)) * FNV1A_32_PRIME;
+	}
+	return hash;
+}
+
+/// <summary>
+/// Scrambles the bits of a 64 bit value so that every input bit affects every output bit,
+/// useful for turning structured keys (like indices) into well distributed hashes. This is
+/// the finalizer from MurmurHash3
+/// </summary>
+/// <param name="value">The value to mix</param>
+/// <returns>The mixed value</returns>
+static inline uint64_t MixHash64(uint64_t value) {
+	value ^= value >> 33;
+	value *= 0xff51afd7ed558ccdull;
+	value ^= value >> 33;
+	value *= 0xc4ceb9fe1a85ec53ull;
+	value ^= value >> 33;
+	return value;
+}
@@ -0,0 +1,119 @@
+#include "MappedFile.h"
+
+#ifdef WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::sptr MappedFile::Open(const std::string& path) {
+	MappedFile::sptr result = std::make_shared<MappedFile>();
+	if (!result->_Map(path)) {
+		return nullptr;
+	}
+	return result;
+}
+
+MappedFile::MappedFile() :
+	_data(nullptr),
+	_size(0),
+	_fileHandle(nullptr),
+	_mappingHandle(nullptr)
+{ }
+
+MappedFile::~MappedFile() {
+	_Unmap();
+}
+
+#ifdef WINDOWS
+
+bool MappedFile::_Map(const std::string& path) {
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	_fileHandle = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		_Unmap();
+		return false;
+	}
+	_size = static_cast<size_t>(size.QuadPart);
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		_Unmap();
+		return false;
+	}
+	_mappingHandle = mapping;
+
+	_data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (_data == nullptr) {
+		_Unmap();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::_Unmap() {
+	if (_data != nullptr) {
+		UnmapViewOfFile(_data);
+		_data = nullptr;
+	}
+	if (_mappingHandle != nullptr) {
+		CloseHandle(_mappingHandle);
+		_mappingHandle = nullptr;
+	}
+	if (_fileHandle != nullptr) {
+		CloseHandle(_fileHandle);
+		_fileHandle = nullptr;
+	}
+	_size = 0;
+}
+
+#else
+
+bool MappedFile::_Map(const std::string& path) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	// We store the descriptor offset by one so that nullptr still means "no file"
+	_fileHandle = reinterpret_cast<void*>(static_cast<intptr_t>(fd) + 1);
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		_Unmap();
+		return false;
+	}
+	_size = static_cast<size_t>(info.st_size);
+
+	void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED) {
+		_Unmap();
+		return false;
+	}
+	madvise(data, _size, MADV_SEQUENTIAL);
+	_data = static_cast<const uint8_t*>(data);
+	return true;
+}
+
+void MappedFile::_Unmap() {
+	if (_data != nullptr) {
+		munmap(const_cast<uint8_t*>(_data), _size);
+		_data = nullptr;
+	}
+	if (_fileHandle != nullptr) {
+		close(static_cast<int>(reinterpret_cast<intptr_t>(_fileHandle) - 1));
+		_fileHandle = nullptr;
+	}
+	_size = 0;
+}
+
+#endif
@@ -1,6 +1,10 @@
 #pragma once
 #include <vector>
+#include <cfloat>
+#include <type_traits>
 #include "Graphics/VertexArrayObject.h"
+#include "MeshOptimizer.h"
+#include "Logging.h"
 
 template <typename VertType>
 class MeshBuilder
@@ -43,7 +47,6 @@ public:
 	/// <param name="c">The index of the third vertex</param>
 	void AddIndexTri(uint32_t a, uint32_t b, uint32_t c)
 	{
-		ReserveIndexSpace(3);
 		_indices.push_back(a);
 		_indices.push_back(b);
 		_indices.push_back(c);
@@ -66,6 +69,28 @@ public:
 		_indices.reserve(_indices.size() + extendAmount);
 	}
 
+	/// <summary>
+	/// Appends a block of default constructed vertices to the mesh, so that they can be filled
+	/// in directly (for instance, by several threads writing to separate ranges)
+	/// </summary>
+	/// <param name="count">The number of vertices to append</param>
+	/// <returns>A pointer to the first new vertex, valid only until the mesh is next resized</returns>
+	VertType* AllocateVertices(size_t count) {
+		size_t offset = _vertices.size();
+		_vertices.resize(offset + count);
+		return _vertices.data() + offset;
+	}
+	/// <summary>
+	/// Appends a block of indices to the mesh, so that they can be filled in directly
+	/// </summary>
+	/// <param name="count">The number of indices to append</param>
+	/// <returns>A pointer to the first new index, valid only until the mesh is next resized</returns>
+	uint32_t* AllocateIndices(size_t count) {
+		size_t offset = _indices.size();
+		_indices.resize(offset + count);
+		return _indices.data() + offset;
+	}
+
 	/// <summary>
 	/// Returns the number of vertices in this mesh
 	/// </summary>
@@ -81,16 +106,88 @@ public:
 	/// </summary>
 	size_t GetTriangleCount() const { return _indices.size() > 0 ? _indices.size() / 3 : _vertices.size() / 3; }
 
+	/// <summary>
+	/// Reorders the triangles and vertices in this mesh to render more efficiently, without changing
+	/// what the mesh looks like. This will first optimize for the vertex cache, then sort clusters of
+	/// triangles to reduce overdraw, then sort the vertices into the order they are first used.
+	/// Call this after all geometry has been added, and before Bake
+	/// </summary>
+	/// <param name="overdrawThreshold">How much vertex cache efficiency we will give up to reduce overdraw, 1.05 allows the ACMR to grow by 5%</param>
+	/// <returns>The vertex cache statistics after optimizing</returns>
+	VertexCacheStats Optimize(float overdrawThreshold = 1.05f) {
+		VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(_indices.data(), _indices.size(), _vertices.size());
+
+		MeshOptimizer::OptimizeVertexCache(_indices.data(), _indices.size(), _vertices.size());
+		if (!_vertices.empty()) {
+			MeshOptimizer::OptimizeOverdraw(_indices.data(), _indices.size(), &_vertices[0].Position.x,
+				_vertices.size(), sizeof(VertType), overdrawThreshold);
+		}
+		std::vector<uint32_t> order = MeshOptimizer::OptimizeVertexFetch(_indices.data(), _indices.size(), _vertices.size());
+		std::vector<VertType> vertices;
+		vertices.reserve(_vertices.size());
+		for (uint32_t oldIndex : order) {
+			vertices.push_back(_vertices[oldIndex]);
+		}
+		_vertices = std::move(vertices);
+
+		VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(_indices.data(), _indices.size(), _vertices.size());
+		LOG_INFO("Optimized mesh with {} triangles: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+			GetTriangleCount(), before.ACMR, after.ACMR, before.ATVR, after.ATVR);
+		return after;
+	}
+
+	/// <summary>
+	/// Uploads this mesh to the GPU
+	/// </summary>
+	/// <typeparam name="GpuVertType">The vertex format to store on the GPU, can be one of the packed formats from VertexTypes.h to save memory</typeparam>
+	template <typename GpuVertType = VertType>
 	VertexArrayObject::sptr Bake() {
+		return Bake<GpuVertType>(GetVertexDataPtr(), _vertices.size(), GetIndexDataPtr(), _indices.size());
+	}
+
+	// The signature of the static Bake function, so that loaders can be told which vertex format to bake to
+	typedef VertexArrayObject::sptr(*BakeFunc)(const VertType*, size_t, const uint32_t*, size_t);
+
+	/// <summary>
+	/// Creates a VAO directly from existing vertex and index data, without needing to copy it
+	/// into a mesh builder first (for instance, data that was memory mapped from a file)
+	/// </summary>
+	/// <typeparam name="GpuVertType">The vertex format to store on the GPU, can be one of the packed formats from VertexTypes.h to save memory</typeparam>
+	/// <param name="vertices">A pointer to the first vertex to upload</param>
+	/// <param name="vertexCount">The number of vertices to upload</param>
+	/// <param name="indices">A pointer to the first index to upload</param>
+	/// <param name="indexCount">The number of indices to upload</param>
+	template <typename GpuVertType = VertType>
+	static VertexArrayObject::sptr Bake(const VertType* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount) {
+		// Every mesh gets its bounds worked out here (whether it came from a builder, a loader or the cache),
+		// so that it can be culled when it is off screen
+		MeshBounds bounds = _CalculateBounds(vertices, vertexCount);
+
 		VertexBuffer::sptr vbo = VertexBuffer::Create();
-		vbo->LoadData(GetVertexDataPtr(), _vertices.size());
+		VertexDecodeInfo decode;
+		if constexpr (std::is_same_v<VertType, GpuVertType>) {
+			vbo->LoadData(vertices, vertexCount);
+		} else {
+			// Packed formats may quantize positions within the bounds of the mesh
+			decode = GpuVertType::GetDecodeInfo(bounds.Min, bounds.Max);
+
+			std::vector<GpuVertType> packed(vertexCount);
+			for (size_t ix = 0; ix < vertexCount; ix++) {
+				packed[ix] = GpuVertType::Pack(vertices[ix], decode);
+			}
+			vbo->LoadData(packed.data(), vertexCount);
+			LOG_INFO("Packed {} vertices from {} to {} bytes per vertex, saving {:.1f}KB", vertexCount, sizeof(VertType), sizeof(GpuVertType),
+				(sizeof(VertType) - sizeof(GpuVertType)) * vertexCount / 1024.0);
+		}
 
 		IndexBuffer::sptr ebo = IndexBuffer::Create();
-		ebo->LoadData(GetIndexDataPtr(), _indices.size());
+		ebo->LoadData(indices, indexCount);
 
 		VertexArrayObject::sptr result = VertexArrayObject::Create();
-		result->AddVertexBuffer(vbo, VertType::V_DECL);
+		result->AddVertexBuffer(vbo, GpuVertType::V_DECL);
 		result->SetIndexBuffer(ebo);
+		result->SetDecodeInfo(decode);
+		result->SetBounds(bounds);
 
 		return result;
 	}
@@ -112,6 +209,28 @@ public:
 	
 protected:
 	friend class MeshFactory;
+
+	static MeshBounds _CalculateBounds(const VertType* vertices, size_t vertexCount) {
+		MeshBounds bounds;
+		if (vertexCount == 0) {
+			return bounds;
+		}
+		bounds.Min = glm::vec3(FLT_MAX);
+		bounds.Max = glm::vec3(-FLT_MAX);
+		for (size_t ix = 0; ix < vertexCount; ix++) {
+			bounds.Min = glm::min(bounds.Min, vertices[ix].Position);
+			bounds.Max = glm::max(bounds.Max, vertices[ix].Position);
+		}
+		// Centering the sphere on the box isn't the tightest fit possible, but it's close and only needs one more pass
+		bounds.Center = (bounds.Min + bounds.Max) * 0.5f;
+		float radiusSq = 0.0f;
+		for (size_t ix = 0; ix < vertexCount; ix++) {
+			glm::vec3 offset = vertices[ix].Position - bounds.Center;
+			radiusSq = glm::max(radiusSq, glm::dot(offset, offset));
+		}
+		bounds.Radius = sqrtf(radiusSq);
+		return bounds;
+	}
 	
 	std::vector<VertType> _vertices;
 	std::vector<uint32_t> _indices;
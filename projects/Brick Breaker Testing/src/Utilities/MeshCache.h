@@ -0,0 +1,130 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+#include "MeshBuilder.h"
+#include "MappedFile.h"
+
+/// <summary>
+/// The header at the start of every baked mesh file, it is immediately followed by
+/// VertexCount interleaved vertices, then IndexCount uint32_t indices
+/// </summary>
+struct BakedMeshHeader
+{
+	char     Magic[4];     // Always "BMSH"
+	uint32_t Version;      // Bumped whenever the layout or the loader output changes
+	uint64_t SourceHash;   // Hash of the contents of the source file this was baked from
+	uint64_t SettingsHash; // Hash of the load settings that were baked into the mesh (ex: vertex color)
+	uint64_t SourceSize;   // The size of the source file when it was last checked, in bytes
+	int64_t  SourceTime;   // The last write time of the source file when it was last checked
+	uint32_t VertexStride; // The size of a single vertex, in bytes
+	uint32_t VertexCount;  // The number of vertices following the header
+	uint32_t IndexCount;   // The number of indices following the vertices
+	uint32_t Reserved;     // Padding, keeps the vertex data 8 byte aligned
+};
+static_assert(sizeof(BakedMeshHeader) == 56, "Baked mesh header must be tightly packed");
+
+/// <summary>
+/// Handles reading and writing baked binary copies of meshes, so that text formats only
+/// need to be parsed the first time they are loaded
+/// 
+/// A baked mesh is matched to its source by the source's size and last write time, so a warm
+/// load never has to read the source. If only the write time has changed (ex: the file was
+/// checked out again) we fall back to hashing the source, and keep the baked mesh if the
+/// contents are the same
+/// </summary>
+class MeshCache
+{
+public:
+	static const uint32_t VERSION = 4;
+
+	/// <summary>
+	/// What we know about a source file without reading it
+	/// </summary>
+	struct SourceStamp
+	{
+		uint64_t Size; // The size of the file, in bytes
+		int64_t  Time; // The last write time of the file, in filesystem clock ticks
+	};
+
+	/// <summary>
+	/// Gets the size and last write time of a source file
+	/// </summary>
+	/// <param name="sourceFile">The path to the source mesh</param>
+	/// <param name="stamp">Receives the file's stamp</param>
+	/// <returns>True if the file exists and could be queried, false if otherwise</returns>
+	static bool GetSourceStamp(const std::string& sourceFile, SourceStamp& stamp);
+
+	/// <summary>
+	/// Gets the path that the baked copy of the given source file will be stored at
+	/// </summary>
+	/// <param name="sourceFile">The path to the source mesh (ex: an .obj file)</param>
+	static std::string GetCachePath(const std::string& sourceFile);
+
+	/// <summary>
+	/// Attempts to load a baked mesh, uploading the memory mapped data directly to the GPU
+	/// </summary>
+	/// <typeparam name="VertType">The type of vertex that was stored in the file</typeparam>
+	/// <param name="path">The path to the baked mesh file</param>
+	/// <param name="sourceFile">The path to the source mesh the file was baked from</param>
+	/// <param name="settingsHash">The hash of the load settings, the file is rejected if it does not match</param>
+	/// <param name="bake">The function used to upload the data, defaults to uploading VertType as-is</param>
+	/// <returns>The loaded mesh, or nullptr if the file does not exist or is out of date</returns>
+	template <typename VertType>
+	static VertexArrayObject::sptr TryLoad(const std::string& path, const std::string& sourceFile, uint64_t settingsHash, typename MeshBuilder<VertType>::BakeFunc bake = nullptr) {
+		bool restamp = false;
+		SourceStamp stamp;
+		MappedFile::sptr file = _OpenValidated(path, sourceFile, settingsHash, sizeof(VertType), restamp, stamp);
+		if (file == nullptr) {
+			return nullptr;
+		}
+
+		const BakedMeshHeader* header = reinterpret_cast<const BakedMeshHeader*>(file->GetData());
+		const VertType* vertices = reinterpret_cast<const VertType*>(file->GetData() + sizeof(BakedMeshHeader));
+		const uint32_t* indices = reinterpret_cast<const uint32_t*>(vertices + header->VertexCount);
+
+		// The mapping only needs to outlive the upload, OpenGL makes its own copy
+		if (bake == nullptr) {
+			bake = &MeshBuilder<VertType>::template Bake<VertType>;
+		}
+		VertexArrayObject::sptr result = bake(vertices, header->VertexCount, indices, header->IndexCount);
+
+		// The source was touched but not changed, so we store its new stamp to skip hashing it
+		// next time. The file has to be unmapped before we can write to it
+		if (restamp) {
+			BakedMeshHeader updated = *header;
+			file = nullptr;
+			_Restamp(path, sourceFile, stamp, updated);
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Writes the contents of a mesh builder to a baked mesh file
+	/// </summary>
+	/// <typeparam name="VertType">The type of vertex stored in the mesh</typeparam>
+	/// <param name="path">The path to write the baked mesh file to</param>
+	/// <param name="sourceFile">The path to the source mesh, the file is not written if its stamp no longer matches</param>
+	/// <param name="stamp">The stamp of the source file, taken before it was read</param>
+	/// <param name="sourceHash">The hash of the contents of the source file, taken from the same read as the mesh</param>
+	/// <param name="settingsHash">The hash of the load settings the mesh was built with</param>
+	/// <param name="mesh">The mesh to write</param>
+	/// <returns>True if the file was written, false if otherwise</returns>
+	template <typename VertType>
+	static bool Save(const std::string& path, const std::string& sourceFile, const SourceStamp& stamp, uint64_t sourceHash, uint64_t settingsHash, const MeshBuilder<VertType>& mesh) {
+		return _Write(path, sourceFile, stamp, sourceHash, settingsHash, sizeof(VertType),
+			mesh.GetVertexDataPtr(), mesh.GetVertexCount(),
+			mesh.GetIndexDataPtr(), mesh.GetIndexCount());
+	}
+
+protected:
+	MeshCache() = default;
+	~MeshCache() = default;
+
+	// True if the source file still has the given stamp, ie: nothing has written to it since the stamp was taken
+	static bool _IsStampCurrent(const std::string& sourceFile, const SourceStamp& stamp);
+	static MappedFile::sptr _OpenValidated(const std::string& path, const std::string& sourceFile, uint64_t settingsHash, size_t vertexStride, bool& restamp, SourceStamp& stamp);
+	static void _Restamp(const std::string& path, const std::string& sourceFile, const SourceStamp& stamp, BakedMeshHeader& header);
+	static bool _Write(const std::string& path, const std::string& sourceFile, const SourceStamp& stamp, uint64_t sourceHash, uint64_t settingsHash, size_t vertexStride,
+		const void* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount);
+};
@@ -0,0 +1,323 @@
+#include "MeshOptimizer.h"
+
+#include <cmath>
+#include <algorithm>
+#include <GLM/glm.hpp>
+
+// Tuning values from Tom Forsyth's original article
+static constexpr float CACHE_DECAY_POWER   = 1.5f;
+static constexpr float LAST_TRI_SCORE      = 0.75f;
+static constexpr float VALENCE_BOOST_SCALE = 2.0f;
+static constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+// Simulates a single vertex going through a FIFO cache, where a vertex is considered cached if fewer
+// than cacheSize misses have happened since it was last loaded. Returns 1 on a miss, 0 on a hit
+static inline uint32_t SimulateFifo(uint32_t vertex, std::vector<uint32_t>& timestamps, uint32_t& time, size_t cacheSize) {
+	if (time - timestamps[vertex] > cacheSize) {
+		timestamps[vertex] = time++;
+		return 1;
+	}
+	return 0;
+}
+
+static inline glm::vec3 GetPosition(const float* positions, size_t positionStride, uint32_t vertex) {
+	const float* position = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + vertex * positionStride);
+	return glm::vec3(position[0], position[1], position[2]);
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize) {
+	VertexCacheStats result;
+	if (indexCount < 3) {
+		return result;
+	}
+
+	// Start far enough ahead that every vertex begins outside the cache
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time = static_cast<uint32_t>(cacheSize) + 1;
+	uint32_t misses = 0;
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		misses += SimulateFifo(indices[ix], timestamps, time, cacheSize);
+	}
+
+	// Only vertices that are actually used count towards ATVR
+	size_t usedVertices = 0;
+	for (uint32_t timestamp : timestamps) {
+		usedVertices += timestamp != 0 ? 1 : 0;
+	}
+
+	result.ACMR = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+	result.ATVR = static_cast<float>(misses) / static_cast<float>(usedVertices);
+	return result;
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount) {
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// Pre-calculate the score for each cache position, as well as for the common valences
+	const size_t VALENCE_TABLE_SIZE = 32;
+	float cacheScores[OPTIMIZE_CACHE_SIZE];
+	float valenceScores[VALENCE_TABLE_SIZE];
+	for (size_t ix = 0; ix < OPTIMIZE_CACHE_SIZE; ix++) {
+		// The most recent triangle gets a fixed score, so that we don't favour the vertices within
+		// it based on the order they were added
+		if (ix < 3) {
+			cacheScores[ix] = LAST_TRI_SCORE;
+		} else {
+			float scaler = 1.0f - (ix - 3) / static_cast<float>(OPTIMIZE_CACHE_SIZE - 3);
+			cacheScores[ix] = std::pow(scaler, CACHE_DECAY_POWER);
+		}
+	}
+	for (size_t ix = 0; ix < VALENCE_TABLE_SIZE; ix++) {
+		valenceScores[ix] = ix == 0 ? 0.0f : VALENCE_BOOST_SCALE * std::pow(static_cast<float>(ix), -VALENCE_BOOST_POWER);
+	}
+	auto getVertexScore = [&](int32_t cachePosition, uint32_t liveTriangles) {
+		// Vertices with nothing left to draw are worthless
+		if (liveTriangles == 0) {
+			return -1.0f;
+		}
+		float score = cachePosition >= 0 ? cacheScores[cachePosition] : 0.0f;
+		score += liveTriangles < VALENCE_TABLE_SIZE ? valenceScores[liveTriangles] :
+			VALENCE_BOOST_SCALE * std::pow(static_cast<float>(liveTriangles), -VALENCE_BOOST_POWER);
+		return score;
+	};
+
+	// Build a list of the triangles that use each vertex, stored contiguously per vertex
+	std::vector<uint32_t> liveTriangles(vertexCount, 0);
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		liveTriangles[indices[ix]]++;
+	}
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		adjacencyOffsets[ix + 1] = adjacencyOffsets[ix] + liveTriangles[ix];
+	}
+	std::vector<uint32_t> adjacency(indexCount);
+	{
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t ix = 0; ix < indexCount; ix++) {
+			adjacency[fill[indices[ix]]++] = static_cast<uint32_t>(ix / 3);
+		}
+	}
+
+	std::vector<int32_t> cachePositions(vertexCount, -1);
+	std::vector<float>   vertexScores(vertexCount);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		vertexScores[ix] = getVertexScore(-1, liveTriangles[ix]);
+	}
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool>  triangleAdded(triangleCount, false);
+	for (size_t ix = 0; ix < triangleCount; ix++) {
+		triangleScores[ix] = vertexScores[indices[ix * 3]] + vertexScores[indices[ix * 3 + 1]] + vertexScores[indices[ix * 3 + 2]];
+	}
+
+	// The simulated LRU cache, with room for the 3 vertices that get pushed past the end each step
+	std::vector<uint32_t> cache;
+	cache.reserve(OPTIMIZE_CACHE_SIZE + 3);
+	std::vector<uint32_t> nextCache;
+	nextCache.reserve(OPTIMIZE_CACHE_SIZE + 3);
+
+	std::vector<uint32_t> result(indexCount);
+	uint32_t bestTriangle = static_cast<uint32_t>(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin());
+	size_t deadEndCursor = 0;
+
+	for (size_t outIx = 0; outIx < triangleCount; outIx++) {
+		// If none of the cached vertices have triangles left, we've hit a dead end and just move on
+		// to the next triangle we haven't drawn yet
+		if (bestTriangle == INVALID_INDEX) {
+			while (triangleAdded[deadEndCursor]) {
+				deadEndCursor++;
+			}
+			bestTriangle = static_cast<uint32_t>(deadEndCursor);
+		}
+
+		// Emit the triangle, and remove it from each of it's vertices' lists of live triangles
+		const uint32_t* triangle = indices + bestTriangle * 3;
+		triangleAdded[bestTriangle] = true;
+		nextCache.clear();
+		for (int corner = 0; corner < 3; corner++) {
+			uint32_t vertex = triangle[corner];
+			result[outIx * 3 + corner] = vertex;
+
+			uint32_t* begin = adjacency.data() + adjacencyOffsets[vertex];
+			uint32_t* end = begin + liveTriangles[vertex];
+			uint32_t* found = std::find(begin, end, bestTriangle);
+			std::swap(*found, *(end - 1));
+			liveTriangles[vertex]--;
+
+			if (std::find(nextCache.begin(), nextCache.end(), vertex) == nextCache.end()) {
+				nextCache.push_back(vertex);
+			}
+		}
+
+		// The triangle's vertices move to the front of the cache, everything else shifts back
+		for (uint32_t vertex : cache) {
+			if (std::find(nextCache.begin(), nextCache.end(), vertex) == nextCache.end()) {
+				nextCache.push_back(vertex);
+			}
+		}
+		std::swap(cache, nextCache);
+
+		// Update the scores of everything that's in (or just fell out of) the cache. A triangle can
+		// touch several of these vertices, so every score has to be updated before we compare any
+		for (size_t cacheIx = 0; cacheIx < cache.size(); cacheIx++) {
+			uint32_t vertex = cache[cacheIx];
+			cachePositions[vertex] = cacheIx < OPTIMIZE_CACHE_SIZE ? static_cast<int32_t>(cacheIx) : -1;
+
+			float score = getVertexScore(cachePositions[vertex], liveTriangles[vertex]);
+			float delta = score - vertexScores[vertex];
+			vertexScores[vertex] = score;
+
+			for (uint32_t ix = 0; ix < liveTriangles[vertex]; ix++) {
+				triangleScores[adjacency[adjacencyOffsets[vertex] + ix]] += delta;
+			}
+		}
+
+		// Then find the best triangle touching those vertices
+		float bestScore = -1.0f;
+		bestTriangle = INVALID_INDEX;
+		for (uint32_t vertex : cache) {
+			for (uint32_t ix = 0; ix < liveTriangles[vertex]; ix++) {
+				uint32_t triangleIx = adjacency[adjacencyOffsets[vertex] + ix];
+				if (triangleScores[triangleIx] > bestScore) {
+					bestScore = triangleScores[triangleIx];
+					bestTriangle = triangleIx;
+				}
+			}
+		}
+		if (cache.size() > OPTIMIZE_CACHE_SIZE) {
+			cache.resize(OPTIMIZE_CACHE_SIZE);
+		}
+	}
+
+	std::copy(result.begin(), result.end(), indices);
+}
+
+void MeshOptimizer::OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, float threshold) {
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time = ANALYZE_CACHE_SIZE + 1;
+	// Moves time forward far enough that the cache appears empty
+	auto resetCache = [&]() { time += ANALYZE_CACHE_SIZE + 1; };
+	auto simulateTriangle = [&](size_t triangleIx) {
+		return SimulateFifo(indices[triangleIx * 3], timestamps, time, ANALYZE_CACHE_SIZE) +
+			SimulateFifo(indices[triangleIx * 3 + 1], timestamps, time, ANALYZE_CACHE_SIZE) +
+			SimulateFifo(indices[triangleIx * 3 + 2], timestamps, time, ANALYZE_CACHE_SIZE);
+	};
+
+	// Hard boundaries are where the cache optimizer hit a dead end (every vertex missed the cache),
+	// splitting there costs us nothing
+	std::vector<size_t> hardClusters;
+	for (size_t ix = 0; ix < triangleCount; ix++) {
+		if (simulateTriangle(ix) == 3 || ix == 0) {
+			hardClusters.push_back(ix);
+		}
+	}
+	hardClusters.push_back(triangleCount);
+
+	// Soft boundaries split the hard clusters further, wherever the cluster so far is still within
+	// our threshold of the cache efficiency of the whole hard cluster
+	std::vector<size_t> clusters;
+	for (size_t clusterIx = 0; clusterIx + 1 < hardClusters.size(); clusterIx++) {
+		size_t start = hardClusters[clusterIx];
+		size_t end = hardClusters[clusterIx + 1];
+
+		resetCache();
+		uint32_t misses = 0;
+		for (size_t ix = start; ix < end; ix++) {
+			misses += simulateTriangle(ix);
+		}
+		float target = threshold * static_cast<float>(misses) / static_cast<float>(end - start);
+
+		resetCache();
+		clusters.push_back(start);
+		size_t softStart = start;
+		misses = 0;
+		for (size_t ix = start; ix < end; ix++) {
+			misses += simulateTriangle(ix);
+			if (ix + 1 < end && static_cast<float>(misses) / static_cast<float>(ix + 1 - softStart) <= target) {
+				clusters.push_back(ix + 1);
+				softStart = ix + 1;
+				misses = 0;
+				resetCache();
+			}
+		}
+	}
+	clusters.push_back(triangleCount);
+
+	// Find the middle of the mesh, clusters that face away from it are more likely to be in
+	// front of the rest of the mesh, so they should be drawn first
+	glm::vec3 meshCenter = glm::vec3(0.0f);
+	for (uint32_t ix = 0; ix < vertexCount; ix++) {
+		meshCenter += GetPosition(positions, positionStride, ix);
+	}
+	meshCenter /= static_cast<float>(std::max(vertexCount, (size_t)1));
+
+	const size_t clusterCount = clusters.size() - 1;
+	std::vector<float> sortKeys(clusterCount);
+	for (size_t clusterIx = 0; clusterIx < clusterCount; clusterIx++) {
+		glm::vec3 center = glm::vec3(0.0f);
+		glm::vec3 normal = glm::vec3(0.0f);
+		float totalArea = 0.0f;
+		for (size_t ix = clusters[clusterIx]; ix < clusters[clusterIx + 1]; ix++) {
+			glm::vec3 a = GetPosition(positions, positionStride, indices[ix * 3]);
+			glm::vec3 b = GetPosition(positions, positionStride, indices[ix * 3 + 1]);
+			glm::vec3 c = GetPosition(positions, positionStride, indices[ix * 3 + 2]);
+			// The cross product's length is twice the area, so it weights both sums by area
+			glm::vec3 cross = glm::cross(b - a, c - a);
+			float area = glm::length(cross);
+			center += (a + b + c) * (area / 3.0f);
+			normal += cross;
+			totalArea += area;
+		}
+		float normalLength = glm::length(normal);
+		if (totalArea > 0.0f && normalLength > 0.0f) {
+			sortKeys[clusterIx] = glm::dot(center / totalArea - meshCenter, normal / normalLength);
+		} else {
+			sortKeys[clusterIx] = 0.0f;
+		}
+	}
+
+	std::vector<uint32_t> order(clusterCount);
+	for (size_t ix = 0; ix < clusterCount; ix++) {
+		order[ix] = static_cast<uint32_t>(ix);
+	}
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<uint32_t> result;
+	result.reserve(triangleCount * 3);
+	for (uint32_t clusterIx : order) {
+		result.insert(result.end(), indices + clusters[clusterIx] * 3, indices + clusters[clusterIx + 1] * 3);
+	}
+	std::copy(result.begin(), result.end(), indices);
+}
+
+std::vector<uint32_t> MeshOptimizer::OptimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t vertexCount) {
+	std::vector<uint32_t> newIndices(vertexCount, INVALID_INDEX);
+	std::vector<uint32_t> order;
+	order.reserve(vertexCount);
+
+	// Number vertices in the order they are first referenced
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		uint32_t& newIndex = newIndices[indices[ix]];
+		if (newIndex == INVALID_INDEX) {
+			newIndex = static_cast<uint32_t>(order.size());
+			order.push_back(indices[ix]);
+		}
+		indices[ix] = newIndex;
+	}
+	// Keep any unreferenced vertices, but move them out of the way
+	for (uint32_t ix = 0; ix < vertexCount; ix++) {
+		if (newIndices[ix] == INVALID_INDEX) {
+			order.push_back(ix);
+		}
+	}
+	return order;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// Describes how well an index buffer makes use of the GPU's post-transform vertex cache
+/// </summary>
+struct VertexCacheStats
+{
+	// Average cache miss ratio, the number of vertex shader invocations per triangle. 0.5 is the
+	// best possible for a large regular grid, 3.0 means no vertex was ever reused
+	float ACMR = 0.0f;
+	// Average transform to vertex ratio, the number of vertex shader invocations per referenced
+	// vertex. 1.0 is ideal, meaning every vertex was transformed exactly once
+	float ATVR = 0.0f;
+};
+
+/// <summary>
+/// Reorders triangle lists to make better use of the vertex cache, reduce overdraw, and keep vertex
+/// fetches sequential. These functions work on raw index and position data so that they can be
+/// used on any vertex type, see MeshBuilder::Optimize for the usual entry point
+/// </summary>
+class MeshOptimizer
+{
+public:
+	// The cache size we simulate when measuring a mesh, most desktop GPUs behave roughly like a
+	// FIFO of around this size
+	static const size_t ANALYZE_CACHE_SIZE = 16;
+	// The cache size we optimize for, the Forsyth scoring works best with an LRU of this size
+	static const size_t OPTIMIZE_CACHE_SIZE = 32;
+
+	/// <summary>
+	/// Simulates a FIFO post-transform cache to measure how efficient an index buffer is
+	/// </summary>
+	/// <param name="indices">The triangle list to measure</param>
+	/// <param name="indexCount">The number of indices, must be a multiple of 3</param>
+	/// <param name="vertexCount">The number of vertices the indices refer to</param>
+	/// <param name="cacheSize">The number of entries in the simulated cache</param>
+	static VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize = ANALYZE_CACHE_SIZE);
+
+	/// <summary>
+	/// Reorders triangles in place to improve vertex cache hits, using Tom Forsyth's linear-speed
+	/// vertex cache optimisation (https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html)
+	/// </summary>
+	/// <param name="indices">The triangle list to reorder</param>
+	/// <param name="indexCount">The number of indices, must be a multiple of 3</param>
+	/// <param name="vertexCount">The number of vertices the indices refer to</param>
+	static void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	/// <summary>
+	/// Reorders clusters of triangles in place so that outward facing parts of the mesh are drawn
+	/// first, reducing overdraw. Clusters are only split where doing so costs less than the given
+	/// ratio of cache efficiency, so this should be run after OptimizeVertexCache
+	/// </summary>
+	/// <param name="indices">The triangle list to reorder</param>
+	/// <param name="indexCount">The number of indices, must be a multiple of 3</param>
+	/// <param name="positions">A pointer to the first vertex position, as 3 floats</param>
+	/// <param name="vertexCount">The number of vertices the indices refer to</param>
+	/// <param name="positionStride">The distance between vertex positions, in bytes</param>
+	/// <param name="threshold">How much worse the ACMR is allowed to get, 1.05 allows it to grow by 5%</param>
+	static void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, float threshold = 1.05f);
+
+	/// <summary>
+	/// Works out a new order for vertices so that they are stored in the order they are first used,
+	/// and rewrites the indices to match. Unreferenced vertices are moved to the end
+	/// </summary>
+	/// <param name="indices">The triangle list to rewrite</param>
+	/// <param name="indexCount">The number of indices</param>
+	/// <param name="vertexCount">The number of vertices the indices refer to</param>
+	/// <returns>For each new vertex index, the old index of the vertex that should be stored there</returns>
+	static std::vector<uint32_t> OptimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+protected:
+	MeshOptimizer() = default;
+	~MeshOptimizer() = default;
+};
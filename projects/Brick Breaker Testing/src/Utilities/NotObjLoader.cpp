@@ -7,7 +7,7 @@
 
 #include "StringUtils.h"
 
-VertexArrayObject::sptr NotObjLoader::LoadFromFile(const std::string& filename)
+VertexArrayObject::sptr NotObjLoader::LoadFromFile(const std::string& filename, bool optimize)
 {
 	// Open our file in binary mode
 	std::ifstream file;
@@ -108,5 +108,9 @@ VertexArrayObject::sptr NotObjLoader::LoadFromFile(const std::string& filename)
 	// You'll need to keep track of these and create vertex entries for each vertex in the face
 	// If you want to get fancy, you can track which vertices you've already added
 
+	if (optimize) {
+		mesh.Optimize();
+	}
+
 	return mesh.Bake();
 }
@@ -4,7 +4,7 @@
 class NotObjLoader
 {
 public:
-	static VertexArrayObject::sptr LoadFromFile(const std::string& filename);
+	static VertexArrayObject::sptr LoadFromFile(const std::string& filename, bool optimize = false);
 
 protected:
 	NotObjLoader() = default;
@@ -1,131 +1,436 @@
 #include "ObjLoader.h"
 
 #include <string>
-#include <sstream>
-#include <fstream>
-#include <iostream>
-#include <unordered_map>
+#include <cstring>
+#include <charconv>
+#include <stdexcept>
+#include <chrono>
 
-#include "StringUtils.h"
+#include "HashUtils.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "VertexIndexMap.h"
+#include "Logging.h"
 
-VertexArrayObject::sptr ObjLoader::LoadFromFile(const std::string& filename, const glm::vec4& inColor)
-{	
-	// Open our file in binary mode
-	std::ifstream file;
-	file.open(filename, std::ios::binary);
+// Chunks smaller than this aren't worth handing to another thread
+static constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+// We split into a few more chunks than we have threads, since attribute and face records
+// tend to be bunched together in the file and take different amounts of time to parse
+static constexpr size_t CHUNKS_PER_THREAD = 4;
 
-	// If our file fails to open, we will throw an error
-	if (!file) {
-		throw std::runtime_error("Failed to open file");
+size_t ObjLoader::_threadCount = 0;
+ThreadPool::sptr ObjLoader::_threadPool = nullptr;
+
+// These helpers walk a cursor over the raw file contents, they never allocate and never
+// read past end. Note that std::from_chars is locale independent, unlike iostreams
+
+static inline bool IsSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Skips spaces and tabs, but not newlines
+static inline const char* SkipSpaces(const char* p, const char* end) {
+	while (p < end && IsSpace(*p)) { p++; }
+	return p;
+}
+
+// Moves to the start of the next line
+static inline const char* SkipLine(const char* p, const char* end) {
+	const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+	return newline != nullptr ? newline + 1 : end;
+}
+
+// Reads a float, leaving out untouched (as 0) if there is no number at the cursor
+static inline const char* ParseFloat(const char* p, const char* end, float& out) {
+	p = SkipSpaces(p, end);
+	if (p < end && *p == '+') { p++; }
+	std::from_chars_result result = std::from_chars(p, end, out);
+	return result.ec == std::errc() ? result.ptr : p;
+}
+
+// Reads an integer, returning false if there is no number at the cursor
+static inline bool ParseInt(const char*& p, const char* end, int32_t& out) {
+	if (p < end && *p == '+') { p++; }
+	std::from_chars_result result = std::from_chars(p, end, out);
+	if (result.ec != std::errc()) {
+		return false;
 	}
+	p = result.ptr;
+	return true;
+}
 
-	// Stores attributes
-	std::vector<glm::vec3> positions;
-	std::vector<glm::vec3> normals;
-	std::vector<glm::vec2> textureCoords;
+// Picks which dedup shard a corner belongs to, shardBits may be 0 for a single shard. We use the
+// top bits of the hash, since the map inside each shard uses the bottom bits to pick a slot
+static inline size_t GetShard(const glm::ivec3& vertexIndices, uint32_t shardBits) {
+	return shardBits == 0 ? 0 : static_cast<size_t>(VertexIndexMap::Hash(vertexIndices) >> (64 - shardBits));
+}
 
-	// We'll use bitmask keys and a map to avoid duplicate vertices
-	std::unordered_map<uint64_t, uint32_t> indexMap;
+/// <summary>
+/// Stores everything parsed out of one line-aligned section of an OBJ file
+/// </summary>
+struct ObjChunk
+{
+	const char* Begin;
+	const char* End;
 
-	// We'll leverage the mesh builder class
-	MeshBuilder<VertexPosNormTexCol> mesh;
+	std::vector<glm::vec3> Positions;
+	std::vector<glm::vec3> Normals;
+	std::vector<glm::vec2> TextureCoords;
+
+	// Every face corner in the order it appeared, as 1 based attribute indices (0 for missing)
+	std::vector<glm::ivec3> Corners;
+	// The number of corners in each face
+	std::vector<uint32_t>   FaceSizes;
+	// Corners that used negative indices, and which components did. These are stored relative to
+	// the start of the chunk, since we don't know how many attributes came before us until all
+	// chunks are parsed
+	std::vector<std::pair<uint32_t, uint8_t>> RelativeCorners;
+	size_t TriangleCount = 0;
+
+	// Where this chunk's data lands in the combined arrays, filled in once all chunks are parsed
+	size_t PositionOffset = 0;
+	size_t NormalOffset = 0;
+	size_t TextureCoordOffset = 0;
+	size_t CornerOffset = 0;
+	size_t CornerCount = 0;
+	size_t TriangleOffset = 0;
+	size_t VertexOffset = 0;
+	size_t VertexCount = 0;
+};
 
-	// Temporaries for loading data
-	glm::vec3 temp;
-	glm::ivec3 vertexIndices;
-	
-	std::string line;
-	// Iterate as long as there is content to read
-	while (file.peek() != EOF) {
-		std::string command;
-		file >> command;
+// Tokenizes a single chunk of the file, without looking at any other chunk
+static void ParseChunk(ObjChunk& chunk) {
+	const char* p = chunk.Begin;
+	const char* end = chunk.End;
+
+	// Iterate over the chunk one line at a time
+	while (p < end) {
+		p = SkipSpaces(p, end);
+		if (p == end) {
+			break;
+		}
 
 		// Load in vertex positions
-		if (command == "v") {
-			file >> temp.x >> temp.y >> temp.z;
-			positions.push_back(temp);
+		if (p[0] == 'v' && p + 1 < end && IsSpace(p[1])) {
+			glm::vec3 temp(0.0f);
+			p = ParseFloat(p + 1, end, temp.x);
+			p = ParseFloat(p, end, temp.y);
+			p = ParseFloat(p, end, temp.z);
+			chunk.Positions.push_back(temp);
 		}
 		// Load in vertex normals
-		else if (command == "vn") {
-			file >> temp.x >> temp.y >> temp.z;
-			normals.push_back(temp);
+		else if (p[0] == 'v' && p + 2 < end && p[1] == 'n' && IsSpace(p[2])) {
+			glm::vec3 temp(0.0f);
+			p = ParseFloat(p + 2, end, temp.x);
+			p = ParseFloat(p, end, temp.y);
+			p = ParseFloat(p, end, temp.z);
+			chunk.Normals.push_back(temp);
 		}
-		// Load in UV coordinates
-		else if (command == "vt") {
-			file >> temp.x >> temp.y;
-			textureCoords.push_back(temp);
+		// Load in UV coordinates (any third component is ignored)
+		else if (p[0] == 'v' && p + 2 < end && p[1] == 't' && IsSpace(p[2])) {
+			glm::vec2 temp(0.0f);
+			p = ParseFloat(p + 2, end, temp.x);
+			p = ParseFloat(p, end, temp.y);
+			chunk.TextureCoords.push_back(temp);
 		}
-		// Load in face lines
-		else if (command == "f") {
-			// Read the entire line, trim it, and stuff it into a string stream
-			std::string line;
-			std::getline(file, line);
-			trim(line);			
-			std::stringstream stream = std::stringstream(line);
-
-			// We'll store the edges in case we added a quad
-			uint32_t edges[4];
-			int ix = 0;
-			// Iterate over up to 4 sets of attributes
-			for (; ix < 4; ix++) {
-				if (stream.peek() != EOF) {
-					// Load in the faces, split up by slashes
-					char tempChar;
-					vertexIndices = glm::ivec3(0);
-					stream >> vertexIndices.x >> tempChar >> vertexIndices.y >> tempChar >> vertexIndices.z;
-					
-					// The OBJ format can have negative values, which are a reference from the last added attributes
-					if (vertexIndices.x < 0) { vertexIndices.x = positions.size() - 1 + vertexIndices.x; }
-					if (vertexIndices.y < 0) { vertexIndices.y = textureCoords.size() - 1 + vertexIndices.y; }
-					if (vertexIndices.z < 0) { vertexIndices.z = normals.size() - 1 + vertexIndices.z; }
-					
-					// We can construct a key using a bitmask of the attribute indices
-					// This let's us quickly look up a combination of attributes to see if it's already been added
-					// Note that this limits us to 2,097,150 unique attributes for positions, normals and textures
-					const uint64_t mask = 0b0'000000000000000000000'000000000000000000000'111111111111111111111;
-					uint64_t key = ((vertexIndices.x & mask) << 42) | ((vertexIndices.y & mask) << 21) | (vertexIndices.z & mask);
-
-					// Find the index associated with the combination of attributes
-					auto it = indexMap.find(key);
-
-					// If it exists, we push the index to our indices
-					if (it != indexMap.end()) {
-						edges[ix] = it->second;
+		// Load in face lines, supporting v, v/vt, v//vn and v/vt/vn with any number of corners
+		else if (p[0] == 'f' && p + 1 < end && IsSpace(p[1])) {
+			p++;
+			uint32_t cornerCount = 0;
+
+			while (true) {
+				p = SkipSpaces(p, end);
+				glm::ivec3 vertexIndices = glm::ivec3(0);
+				if (!ParseInt(p, end, vertexIndices.x)) {
+					break;
+				}
+				if (p < end && *p == '/') {
+					p++;
+					// UV is optional when there's a normal (v//vn)
+					if (p < end && *p != '/') {
+						ParseInt(p, end, vertexIndices.y);
 					}
-					else {
-						// Construct a new vertex using the indices for the vertex
-						VertexPosNormTexCol vertex;
-						vertex.Position = positions[vertexIndices.x - 1];
-						vertex.UV = vertexIndices.y != 0 ? textureCoords[vertexIndices.y - 1] : glm::vec2(0.0f);
-						vertex.Normal = vertexIndices.z != 0 ? normals[vertexIndices.z - 1] : glm::vec3(0.0f, 0.0f, 1.0f);
-						vertex.Color = inColor;
-
-						// Add to the mesh, get index of the added vertex
-						uint32_t index = mesh.AddVertex(vertex);
-						// Cache the index based on our key
-						indexMap[key] = index;
-						// Add index to mesh, and add to edges list for if we are using quads
-						edges[ix] = index;
+					if (p < end && *p == '/') {
+						p++;
+						ParseInt(p, end, vertexIndices.z);
 					}
-				} else {
-					break;
 				}
+
+				// The OBJ format can have negative values, which are a reference from the last added attributes
+				uint8_t relative = 0;
+				if (vertexIndices.x < 0) { vertexIndices.x += (int32_t)chunk.Positions.size() + 1;     relative |= 0b001; }
+				if (vertexIndices.y < 0) { vertexIndices.y += (int32_t)chunk.TextureCoords.size() + 1; relative |= 0b010; }
+				if (vertexIndices.z < 0) { vertexIndices.z += (int32_t)chunk.Normals.size() + 1;       relative |= 0b100; }
+				if (relative != 0) {
+					chunk.RelativeCorners.emplace_back(static_cast<uint32_t>(chunk.Corners.size()), relative);
+				}
+
+				chunk.Corners.push_back(vertexIndices);
+				cornerCount++;
 			}
-			// Handling for trangle faces
-			if (ix == 3) {
-				mesh.AddIndexTri(edges[0], edges[1], edges[2]);
-			}
-			// Handling for quad faces
-			else if (ix == 4) {
-				mesh.AddIndexTri(edges[0], edges[1], edges[2]);
-				mesh.AddIndexTri(edges[0], edges[2], edges[3]);
+
+			// Polygons will be triangulated as a fan around the first corner
+			chunk.FaceSizes.push_back(cornerCount);
+			chunk.TriangleCount += cornerCount > 2 ? cornerCount - 2 : 0;
+		}
+		// Anything else (comments, o, g, usemtl, mtllib, s) doesn't affect the geometry, since
+		// everything is baked into a single draw
+
+		p = SkipLine(p, end);
+	}
+}
+
+void ObjLoader::SetThreadCount(size_t threadCount) {
+	if (threadCount != _threadCount) {
+		_threadCount = threadCount;
+		_threadPool = nullptr;
+	}
+}
+
+VertexArrayObject::sptr ObjLoader::_LoadFromFile(const std::string& filename, const glm::vec4& inColor, bool useCache, bool optimize,
+	MeshBuilder<VertexPosNormTexCol>::BakeFunc bake)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	// The baked copy is only valid if neither the source nor the settings we are baking into the
+	// mesh have changed. The cache checks the source itself, without reading it if it can
+	uint64_t settingsHash = HashBytes(&inColor, sizeof(glm::vec4));
+	settingsHash = HashBytes(&optimize, sizeof(bool), settingsHash);
+
+	std::string cachePath = MeshCache::GetCachePath(filename);
+	if (useCache) {
+		VertexArrayObject::sptr result = MeshCache::TryLoad<VertexPosNormTexCol>(cachePath, filename, settingsHash, bake);
+		if (result != nullptr) {
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+			LOG_INFO("Loaded \"{}\" from baked cache in {:.3f}ms", filename, elapsed.count());
+			return result;
+		}
+	}
+
+	// We stamp the source before reading it, and hash it before parsing it, so the stamp, hash
+	// and mesh all come from the same read. If it changes while we're loading, the stamp won't
+	// match anymore and Save leaves the mesh uncached
+	MeshCache::SourceStamp stamp = { 0, 0 };
+	MappedFile::sptr source = MappedFile::Open(filename);
+	if (source == nullptr || !MeshCache::GetSourceStamp(filename, stamp)) {
+		throw std::runtime_error("Failed to open file");
+	}
+	uint64_t sourceHash = useCache ? HashBytes(source->GetData(), source->GetSize()) : 0;
+
+	if (_threadPool == nullptr) {
+		_threadPool = ThreadPool::Create(_threadCount);
+	}
+
+	// We parse straight out of the mapping we already have open
+	auto parseStart = std::chrono::high_resolution_clock::now();
+	MeshBuilder<VertexPosNormTexCol> mesh;
+	_ParseObj(reinterpret_cast<const char*>(source->GetData()), source->GetSize(), inColor, mesh);
+	std::chrono::duration<double> parseTime = std::chrono::high_resolution_clock::now() - parseStart;
+	double sizeMb = source->GetSize() / (1024.0 * 1024.0);
+	source = nullptr;
+
+	if (optimize) {
+		mesh.Optimize();
+	}
+
+	if (useCache) {
+		MeshCache::Save(cachePath, filename, stamp, sourceHash, settingsHash, mesh);
+	}
+
+	VertexArrayObject::sptr result = bake(mesh.GetVertexDataPtr(), mesh.GetVertexCount(), mesh.GetIndexDataPtr(), mesh.GetIndexCount());
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+	LOG_INFO("Parsed \"{}\" ({} vertices, {} triangles) in {:.3f}ms, {:.1f}MB/s on {} threads", filename, mesh.GetVertexCount(), mesh.GetTriangleCount(),
+		elapsed.count(), parseTime.count() > 0.0 ? sizeMb / parseTime.count() : 0.0, _threadPool->GetThreadCount());
+	return result;
+}
+
+void ObjLoader::_ParseObj(const char* data, size_t size, const glm::vec4& inColor, MeshBuilder<VertexPosNormTexCol>& mesh)
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	auto phaseStart = Clock::now();
+	std::chrono::duration<double, std::milli> tokenizeTime, mergeTime, dedupTime, buildTime;
+
+	ThreadPool& pool = *_threadPool;
+	const char* end = data + size;
+
+	// Split the file into chunks, moving each split forward to the start of the next line so
+	// no record ever straddles two chunks
+	size_t chunkCount = std::min(std::max(size / MIN_CHUNK_SIZE, (size_t)1), pool.GetThreadCount() * CHUNKS_PER_THREAD);
+	std::vector<ObjChunk> chunks(chunkCount);
+	const char* p = data;
+	for (size_t ix = 0; ix < chunkCount; ix++) {
+		chunks[ix].Begin = p;
+		p = ix + 1 == chunkCount ? end : SkipLine(std::max(p, data + size * (ix + 1) / chunkCount), end);
+		chunks[ix].End = p;
+	}
+
+	// Phase 1: tokenize every chunk independently
+	pool.ParallelFor(chunkCount, [&](size_t ix) { ParseChunk(chunks[ix]); });
+	tokenizeTime = Clock::now() - phaseStart;
+	phaseStart = Clock::now();
+
+	// Phase 2: work out where each chunk lands in the combined arrays, then stitch them together
+	size_t positionCount = 0, normalCount = 0, textureCoordCount = 0, cornerCount = 0, triangleCount = 0;
+	for (ObjChunk& chunk : chunks) {
+		chunk.PositionOffset = positionCount;
+		chunk.NormalOffset = normalCount;
+		chunk.TextureCoordOffset = textureCoordCount;
+		chunk.CornerOffset = cornerCount;
+		chunk.CornerCount = chunk.Corners.size();
+		chunk.TriangleOffset = triangleCount;
+		positionCount += chunk.Positions.size();
+		normalCount += chunk.Normals.size();
+		textureCoordCount += chunk.TextureCoords.size();
+		cornerCount += chunk.Corners.size();
+		triangleCount += chunk.TriangleCount;
+	}
+
+	std::vector<glm::vec3> positions(positionCount);
+	std::vector<glm::vec3> normals(normalCount);
+	std::vector<glm::vec2> textureCoords(textureCoordCount);
+	std::vector<glm::ivec3> corners(cornerCount);
+
+	pool.ParallelFor(chunkCount, [&](size_t ix) {
+		ObjChunk& chunk = chunks[ix];
+		std::copy(chunk.Positions.begin(), chunk.Positions.end(), positions.begin() + chunk.PositionOffset);
+		std::copy(chunk.Normals.begin(), chunk.Normals.end(), normals.begin() + chunk.NormalOffset);
+		std::copy(chunk.TextureCoords.begin(), chunk.TextureCoords.end(), textureCoords.begin() + chunk.TextureCoordOffset);
+		std::copy(chunk.Corners.begin(), chunk.Corners.end(), corners.begin() + chunk.CornerOffset);
+		// Release the chunk's copies as soon as we can, they can be quite large
+		chunk.Positions = std::vector<glm::vec3>();
+		chunk.Normals = std::vector<glm::vec3>();
+		chunk.TextureCoords = std::vector<glm::vec2>();
+		chunk.Corners = std::vector<glm::ivec3>();
+
+		// Negative indices can now be made absolute
+		for (const auto& [localIx, relative] : chunk.RelativeCorners) {
+			glm::ivec3& vertexIndices = corners[chunk.CornerOffset + localIx];
+			if (relative & 0b001) { vertexIndices.x += (int32_t)chunk.PositionOffset; }
+			if (relative & 0b010) { vertexIndices.y += (int32_t)chunk.TextureCoordOffset; }
+			if (relative & 0b100) { vertexIndices.z += (int32_t)chunk.NormalOffset; }
+		}
+
+		for (size_t cornerIx = chunk.CornerOffset; cornerIx < chunk.CornerOffset + chunk.CornerCount; cornerIx++) {
+			const glm::ivec3& vertexIndices = corners[cornerIx];
+			if (vertexIndices.x < 1 || vertexIndices.x > (int32_t)positionCount ||
+				vertexIndices.y < 0 || vertexIndices.y > (int32_t)textureCoordCount ||
+				vertexIndices.z < 0 || vertexIndices.z > (int32_t)normalCount) {
+				throw std::runtime_error("Face references an attribute that does not exist");
 			}
 		}
+	});
+	mergeTime = Clock::now() - phaseStart;
+	phaseStart = Clock::now();
+
+	// Phase 3: find the first corner that uses each combination of attributes. Keys are split
+	// into shards by hash so that each shard can be searched on its own thread, and each shard
+	// sees its corners in file order so it always picks the same corner the serial path would
+	uint32_t shardBits = 0;
+	while (chunkCount > 1 && ((size_t)1 << shardBits) < pool.GetThreadCount() * CHUNKS_PER_THREAD) {
+		shardBits++;
+	}
+	size_t shardCount = (size_t)1 << shardBits;
+
+	// Count how many corners from each chunk land in each shard, so we can bucket them without
+	// any extra allocations
+	std::vector<size_t> bucketOffsets(shardCount * chunkCount, 0);
+	pool.ParallelFor(chunkCount, [&](size_t ix) {
+		ObjChunk& chunk = chunks[ix];
+		for (size_t cornerIx = chunk.CornerOffset; cornerIx < chunk.CornerOffset + chunk.CornerCount; cornerIx++) {
+			bucketOffsets[GetShard(corners[cornerIx], shardBits) * chunkCount + ix]++;
+		}
+	});
+	std::vector<size_t> shardOffsets(shardCount + 1, 0);
+	size_t runningTotal = 0;
+	for (size_t shard = 0; shard < shardCount; shard++) {
+		shardOffsets[shard] = runningTotal;
+		for (size_t ix = 0; ix < chunkCount; ix++) {
+			size_t count = bucketOffsets[shard * chunkCount + ix];
+			bucketOffsets[shard * chunkCount + ix] = runningTotal;
+			runningTotal += count;
+		}
+	}
+	shardOffsets[shardCount] = runningTotal;
+
+	std::vector<uint32_t> bucketedCorners(cornerCount);
+	pool.ParallelFor(chunkCount, [&](size_t ix) {
+		ObjChunk& chunk = chunks[ix];
+		for (size_t cornerIx = chunk.CornerOffset; cornerIx < chunk.CornerOffset + chunk.CornerCount; cornerIx++) {
+			size_t bucket = GetShard(corners[cornerIx], shardBits) * chunkCount + ix;
+			bucketedCorners[bucketOffsets[bucket]++] = static_cast<uint32_t>(cornerIx);
+		}
+	});
+
+	// For each corner, stores the first corner with the same attributes (possibly itself)
+	std::vector<uint32_t> firstCorner(cornerCount);
+	pool.ParallelFor(shardCount, [&](size_t shard) {
+		// Most meshes end up with somewhere between 1 and 1.5 vertices per position, so we size
+		// the map for that up front to avoid having to grow it
+		size_t shardCorners = shardOffsets[shard + 1] - shardOffsets[shard];
+		VertexIndexMap indexMap(std::min(shardCorners, (positionCount + positionCount / 2) / shardCount));
+		for (size_t ix = shardOffsets[shard]; ix < shardOffsets[shard + 1]; ix++) {
+			uint32_t cornerIx = bucketedCorners[ix];
+			firstCorner[cornerIx] = indexMap.FindOrInsert(corners[cornerIx], cornerIx);
+		}
+	});
+	bucketedCorners = std::vector<uint32_t>();
+	dedupTime = Clock::now() - phaseStart;
+	phaseStart = Clock::now();
+
+	// Phase 4: vertices are numbered in the order their first corner appears, so count up how
+	// many new vertices each chunk introduces
+	pool.ParallelFor(chunkCount, [&](size_t ix) {
+		ObjChunk& chunk = chunks[ix];
+		for (size_t cornerIx = chunk.CornerOffset; cornerIx < chunk.CornerOffset + chunk.CornerCount; cornerIx++) {
+			chunk.VertexCount += firstCorner[cornerIx] == cornerIx ? 1 : 0;
+		}
+	});
+	size_t vertexCount = 0;
+	for (ObjChunk& chunk : chunks) {
+		chunk.VertexOffset = vertexCount;
+		vertexCount += chunk.VertexCount;
 	}
 
-	// Note: with actual OBJ files you're going to run into the issue where faces are composited of different indices
-	// You'll need to keep track of these and create vertex entries for each vertex in the face
-	// If you want to get fancy, you can track which vertices you've already added
+	// Construct the new vertices, and remember which vertex each corner ended up as
+	VertexPosNormTexCol* vertices = mesh.AllocateVertices(vertexCount);
+	std::vector<uint32_t> cornerVertex(cornerCount);
+	pool.ParallelFor(chunkCount, [&](size_t ix) {
+		ObjChunk& chunk = chunks[ix];
+		uint32_t index = static_cast<uint32_t>(chunk.VertexOffset);
+		for (size_t cornerIx = chunk.CornerOffset; cornerIx < chunk.CornerOffset + chunk.CornerCount; cornerIx++) {
+			if (firstCorner[cornerIx] != cornerIx) {
+				continue;
+			}
+			const glm::ivec3& vertexIndices = corners[cornerIx];
+			VertexPosNormTexCol& vertex = vertices[index];
+			vertex.Position = positions[vertexIndices.x - 1];
+			vertex.UV = vertexIndices.y != 0 ? textureCoords[vertexIndices.y - 1] : glm::vec2(0.0f);
+			vertex.Normal = vertexIndices.z != 0 ? normals[vertexIndices.z - 1] : glm::vec3(0.0f, 0.0f, 1.0f);
+			vertex.Color = inColor;
+			cornerVertex[cornerIx] = index++;
+		}
+	});
+
+	// Finally, triangulate each face as a fan around its first corner
+	uint32_t* indices = mesh.AllocateIndices(triangleCount * 3);
+	pool.ParallelFor(chunkCount, [&](size_t ix) {
+		ObjChunk& chunk = chunks[ix];
+		size_t cornerIx = chunk.CornerOffset;
+		uint32_t* out = indices + chunk.TriangleOffset * 3;
+		for (uint32_t faceSize : chunk.FaceSizes) {
+			if (faceSize > 2) {
+				uint32_t first = cornerVertex[firstCorner[cornerIx]];
+				for (uint32_t corner = 2; corner < faceSize; corner++) {
+					*out++ = first;
+					*out++ = cornerVertex[firstCorner[cornerIx + corner - 1]];
+					*out++ = cornerVertex[firstCorner[cornerIx + corner]];
+				}
+			}
+			cornerIx += faceSize;
+		}
+	});
+	buildTime = Clock::now() - phaseStart;
 
-	return mesh.Bake();
+	LOG_TRACE("OBJ phases over {} chunks: tokenize {:.3f}ms, merge {:.3f}ms, dedup {:.3f}ms ({} shards), build {:.3f}ms",
+		chunkCount, tokenizeTime.count(), mergeTime.count(), dedupTime.count(), shardCount, buildTime.count());
 }
@@ -1,12 +1,38 @@
 #pragma once
 #include "MeshFactory.h"
+#include "ThreadPool.h"
 
 class ObjLoader
 {
 public:
-	static VertexArrayObject::sptr LoadFromFile(const std::string& filename, const glm::vec4& inColor = glm::vec4(1.0f));
+	/// <summary>
+	/// Loads a mesh from an OBJ file. The first time a file is loaded, a baked binary copy is written
+	/// next to it, later loads will upload straight from that copy as long as the source is unchanged
+	/// </summary>
+	/// <param name="filename">The path to the OBJ file to load</param>
+	/// <param name="inColor">The color to assign to all vertices in the mesh</param>
+	/// <param name="useCache">True to read and write the baked copy, false to always parse the source</param>
+	/// <param name="optimize">True to reorder the mesh for the vertex cache and overdraw (see MeshBuilder::Optimize), this is baked into the cached copy</param>
+	/// <typeparam name="GpuVertType">The vertex format to store on the GPU, can be one of the packed formats from VertexTypes.h to save memory</typeparam>
+	template <typename GpuVertType = VertexPosNormTexCol>
+	static VertexArrayObject::sptr LoadFromFile(const std::string& filename, const glm::vec4& inColor = glm::vec4(1.0f), bool useCache = true, bool optimize = false) {
+		return _LoadFromFile(filename, inColor, useCache, optimize, &MeshBuilder<VertexPosNormTexCol>::template Bake<GpuVertType>);
+	}
+
+	/// <summary>
+	/// Sets how many threads large OBJ files will be parsed on. Small files are always parsed on the calling thread
+	/// </summary>
+	/// <param name="threadCount">The number of threads to use, or 0 to use one per hardware thread</param>
+	static void SetThreadCount(size_t threadCount);
 
 protected:
 	ObjLoader() = default;
 	~ObjLoader() = default;
+
+	static size_t           _threadCount;
+	static ThreadPool::sptr _threadPool;
+
+	static VertexArrayObject::sptr _LoadFromFile(const std::string& filename, const glm::vec4& inColor, bool useCache, bool optimize,
+		MeshBuilder<VertexPosNormTexCol>::BakeFunc bake);
+	static void _ParseObj(const char* data, size_t size, const glm::vec4& inColor, MeshBuilder<VertexPosNormTexCol>& mesh);
 };
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+#include <filesystem>
+#include <string>
+
+// Converts a path to an absolute path with no . or .. parts, so that two spellings of the same path can be compared.
+// Anything that keys a map on file paths (ShaderLibrary, FileWatcher, ShaderPreprocessor dependencies) should go through
+// this, so that the keys all match
+static inline std::string NormalizePath(const std::filesystem::path& path) {
+	std::error_code error;
+	return std::filesystem::absolute(path, error).lexically_normal().string();
+}
@@ -0,0 +1,110 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <exception>
+
+ThreadPool::ThreadPool(size_t threadCount) :
+	_workers(std::vector<std::thread>()),
+	_queue(std::deque<std::function<void()>>()),
+	_isStopping(false)
+{
+	if (threadCount == 0) {
+		threadCount = std::thread::hardware_concurrency();
+	}
+	// The calling thread counts as one of our threads
+	for (size_t ix = 1; ix < threadCount; ix++) {
+		_workers.emplace_back(&ThreadPool::_WorkerMain, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_queueLock);
+		_isStopping = true;
+	}
+	_queueSignal.notify_all();
+	for (std::thread& worker : _workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& func) {
+	if (count == 0) {
+		return;
+	}
+
+	// Rather than queuing every iteration, we queue a few runners that pull iterations off of a
+	// shared counter until there's nothing left. This keeps things balanced when iterations vary in cost
+	std::atomic<size_t> next(0);
+	std::atomic<size_t> finished(0);
+	std::exception_ptr error = nullptr;
+	std::mutex errorLock;
+	std::mutex doneLock;
+	std::condition_variable doneSignal;
+
+	auto runner = [&]() {
+		for (size_t ix = next++; ix < count; ix = next++) {
+			try {
+				func(ix);
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(errorLock);
+				if (error == nullptr) {
+					error = std::current_exception();
+				}
+			}
+		}
+	};
+
+	size_t helpers = std::min(_workers.size(), count - 1);
+	if (helpers > 0) {
+		std::lock_guard<std::mutex> lock(_queueLock);
+		for (size_t ix = 0; ix < helpers; ix++) {
+			_queue.push_back([&]() {
+				runner();
+				// Signal under the lock, so the caller can't return (and destroy our state) before we're done with it
+				std::lock_guard<std::mutex> doneGuard(doneLock);
+				finished++;
+				doneSignal.notify_one();
+			});
+		}
+	}
+	_queueSignal.notify_all();
+
+	runner();
+
+	std::unique_lock<std::mutex> lock(doneLock);
+	doneSignal.wait(lock, [&]() { return finished == helpers; });
+	lock.unlock();
+
+	if (error != nullptr) {
+		std::rethrow_exception(error);
+	}
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+	if (_workers.empty()) {
+		task();
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(_queueLock);
+		_queue.push_back(std::move(task));
+	}
+	_queueSignal.notify_one();
+}
+
+void ThreadPool::_WorkerMain() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(_queueLock);
+			_queueSignal.wait(lock, [this]() { return _isStopping || !_queue.empty(); });
+			if (_isStopping && _queue.empty()) {
+				return;
+			}
+			task = std::move(_queue.front());
+			_queue.pop_front();
+		}
+		task();
+	}
+}
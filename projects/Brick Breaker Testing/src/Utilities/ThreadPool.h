@@ -0,0 +1,66 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+
+/// <summary>
+/// A fixed set of worker threads that can split loops across cores. The calling thread
+/// always helps out with the work, so a pool with no workers simply runs everything inline
+/// </summary>
+class ThreadPool final
+{
+public:
+	typedef std::shared_ptr<ThreadPool> sptr;
+	/// <summary>
+	/// Creates a new thread pool
+	/// </summary>
+	/// <param name="threadCount">The total number of threads to run work on, including the caller. 0 will use one per hardware thread</param>
+	static sptr Create(size_t threadCount = 0) {
+		return std::make_shared<ThreadPool>(threadCount);
+	}
+
+public:
+	// We'll disallow moving and copying, since we want to manually control when the destructor is called
+	// We'll use these classes via pointers
+	ThreadPool(const ThreadPool& other) = delete;
+	ThreadPool(ThreadPool&& other) = delete;
+	ThreadPool& operator=(const ThreadPool& other) = delete;
+	ThreadPool& operator=(ThreadPool&& other) = delete;
+
+public:
+	ThreadPool(size_t threadCount = 0);
+	~ThreadPool();
+
+	/// <summary>
+	/// Gets the number of threads that work is spread across, including the calling thread
+	/// </summary>
+	size_t GetThreadCount() const { return _workers.size() + 1; }
+
+	/// <summary>
+	/// Invokes func(ix) for every ix in [0, count), spread across the pool. Blocks until every
+	/// call has completed. If any call throws, the first exception is rethrown on the calling thread
+	/// </summary>
+	/// <param name="count">The number of iterations to run</param>
+	/// <param name="func">The function to invoke for each iteration</param>
+	void ParallelFor(size_t count, const std::function<void(size_t)>& func);
+
+	/// <summary>
+	/// Queues a task to run on one of the workers, and returns without waiting for it. The task must not
+	/// throw, and must not wait on a ParallelFor from the same pool. A pool with no workers runs the task inline
+	/// </summary>
+	/// <param name="task">The task to run</param>
+	void Submit(std::function<void()> task);
+
+private:
+	std::vector<std::thread>           _workers;
+	std::deque<std::function<void()>>  _queue;
+	std::mutex                         _queueLock;
+	std::condition_variable            _queueSignal;
+	bool                               _isStopping;
+
+	void _WorkerMain();
+};
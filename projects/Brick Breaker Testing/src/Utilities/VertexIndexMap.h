@@ -0,0 +1,108 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+#include "HashUtils.h"
+
+/// <summary>
+/// An open addressing hash map from a triple of 1 based attribute indices (position, UV, normal)
+/// to a vertex index, used to find vertices that share the same attributes when building meshes.
+/// Each component can use the full 32 bits, and keys and values are stored side by side so a
+/// lookup is usually a single cache miss
+/// </summary>
+class VertexIndexMap
+{
+public:
+	/// <summary>
+	/// Creates a new map, sized so that the expected number of keys can be inserted without growing
+	/// </summary>
+	/// <param name="expectedCount">The number of unique keys the map is expected to hold</param>
+	VertexIndexMap(size_t expectedCount = 0) :
+		_slots(std::vector<Slot>()),
+		_mask(0),
+		_count(0)
+	{
+		_Resize(_GetCapacityFor(expectedCount));
+	}
+	~VertexIndexMap() = default;
+
+	/// <summary>
+	/// Looks up the value stored for a key, inserting the given value if it is not yet in the map
+	/// </summary>
+	/// <param name="key">The attribute indices to look up, the position index (x) must be at least 1</param>
+	/// <param name="value">The value to insert if the key is not found</param>
+	/// <returns>The value associated with the key, which is value if the key was just inserted</returns>
+	uint32_t FindOrInsert(const glm::ivec3& key, uint32_t value) {
+		for (size_t ix = _Hash(key) & _mask; ; ix = (ix + 1) & _mask) {
+			Slot& slot = _slots[ix];
+			if (slot.Key.x == EMPTY) {
+				// Grow once we're 70% full, probe lengths climb quickly past that point
+				if ((_count + 1) * 10 > _slots.size() * 7) {
+					_Resize(_slots.size() * 2);
+					return FindOrInsert(key, value);
+				}
+				slot.Key = key;
+				slot.Value = value;
+				_count++;
+				return value;
+			}
+			if (slot.Key == key) {
+				return slot.Value;
+			}
+		}
+	}
+
+	/// <summary>
+	/// Gets the number of keys stored in the map
+	/// </summary>
+	size_t GetCount() const { return _count; }
+
+	/// <summary>
+	/// Hashes a set of attribute indices. The low bits pick a slot, so callers that split keys
+	/// between several maps should use the high bits to do so
+	/// </summary>
+	static uint64_t Hash(const glm::ivec3& key) { return _Hash(key); }
+
+protected:
+	// OBJ indices are 1 based, so a position index of 0 can never be a valid key
+	static constexpr int32_t EMPTY = 0;
+
+	struct Slot {
+		glm::ivec3 Key;
+		uint32_t   Value;
+	};
+
+	std::vector<Slot> _slots;
+	size_t            _mask;
+	size_t            _count;
+
+	static inline uint64_t _Hash(const glm::ivec3& key) {
+		uint64_t packed = ((uint64_t)(uint32_t)key.x << 32) | (uint32_t)key.y;
+		return MixHash64(packed ^ MixHash64((uint32_t)key.z));
+	}
+
+	static size_t _GetCapacityFor(size_t count) {
+		size_t capacity = 16;
+		while (capacity * 7 < count * 10) {
+			capacity *= 2;
+		}
+		return capacity;
+	}
+
+	void _Resize(size_t capacity) {
+		std::vector<Slot> oldSlots = std::move(_slots);
+		_slots = std::vector<Slot>(capacity, Slot{ glm::ivec3(EMPTY), 0 });
+		_mask = capacity - 1;
+		for (const Slot& slot : oldSlots) {
+			if (slot.Key.x != EMPTY) {
+				for (size_t ix = _Hash(slot.Key) & _mask; ; ix = (ix + 1) & _mask) {
+					if (_slots[ix].Key.x == EMPTY) {
+						_slots[ix] = slot;
+						break;
+					}
+				}
+			}
+		}
+	}
+};
@@ -5,6 +5,8 @@ VertexPosCol* VPC = nullptr;
 VertexPosNormCol* VPNC = nullptr;
 VertexPosNormTex* VPNT = nullptr;
 VertexPosNormTexCol* VPNTC = nullptr;
+VertexPosNormTexColPacked* VPNTCP = nullptr;
+VertexPosNormTexColQuantized* VPNTCQ = nullptr;
 
 const std::vector<BufferAttribute> VertexPosCol::V_DECL = {
 	BufferAttribute(0, 3, GL_FLOAT, false, sizeof(VertexPosCol), (size_t)&VPC->Position, AttribUsage::Position),
@@ -26,4 +28,17 @@ const std::vector<BufferAttribute> VertexPosNormTexCol::V_DECL = {
 	BufferAttribute(2, 3, GL_FLOAT, false, sizeof(VertexPosNormTexCol), (size_t)&VPNTC->Normal, AttribUsage::Normal),
 	BufferAttribute(3, 2, GL_FLOAT, false, sizeof(VertexPosNormTexCol), (size_t)&VPNTC->UV, AttribUsage::Texture),
 };
+// Packed normals go into slot 4 rather than 2, since they need to be decoded in the shader
+const std::vector<BufferAttribute> VertexPosNormTexColPacked::V_DECL = {
+	BufferAttribute(0, 3, GL_FLOAT, false, sizeof(VertexPosNormTexColPacked), (size_t)&VPNTCP->Position, AttribUsage::Position),
+	BufferAttribute(1, 4, GL_UNSIGNED_BYTE, true, sizeof(VertexPosNormTexColPacked), (size_t)&VPNTCP->Color, AttribUsage::Color),
+	BufferAttribute(4, 2, GL_SHORT, true, sizeof(VertexPosNormTexColPacked), (size_t)&VPNTCP->Normal, AttribUsage::Normal),
+	BufferAttribute(3, 2, GL_HALF_FLOAT, false, sizeof(VertexPosNormTexColPacked), (size_t)&VPNTCP->UV, AttribUsage::Texture),
+};
+const std::vector<BufferAttribute> VertexPosNormTexColQuantized::V_DECL = {
+	BufferAttribute(0, 3, GL_SHORT, true, sizeof(VertexPosNormTexColQuantized), (size_t)&VPNTCQ->Position, AttribUsage::Position),
+	BufferAttribute(1, 4, GL_UNSIGNED_BYTE, true, sizeof(VertexPosNormTexColQuantized), (size_t)&VPNTCQ->Color, AttribUsage::Color),
+	BufferAttribute(4, 2, GL_SHORT, true, sizeof(VertexPosNormTexColQuantized), (size_t)&VPNTCQ->Normal, AttribUsage::Normal),
+	BufferAttribute(3, 2, GL_HALF_FLOAT, false, sizeof(VertexPosNormTexColQuantized), (size_t)&VPNTCQ->UV, AttribUsage::Texture),
+};
 #pragma warning(pop)
\ No newline at end of file
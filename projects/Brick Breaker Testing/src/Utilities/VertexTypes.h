@@ -1,6 +1,8 @@
 #pragma once
 
 #include <GLM/glm.hpp>
+#include <GLM/gtc/packing.hpp>
+#include <GLM/gtc/type_precision.hpp>
 #include "Graphics/VertexArrayObject.h"
 
 struct VertexPosCol {
@@ -57,4 +59,100 @@ struct VertexPosNormTexCol {
 		Position({ x, y, z }), Normal({ nX, nY, nZ }), UV({ u, v }), Color({r, g, b, a}) {}
 
 	static const std::vector<BufferAttribute> V_DECL;
-};
\ No newline at end of file
+};
+
+/*
+ * Packed vertex formats, these are never built directly. Instead, build a mesh using VertexPosNormTexCol
+ * and select one of these when baking (ex: mesh.Bake<VertexPosNormTexColPacked>()). Shaders must apply
+ * the VAO's VertexDecodeInfo to read them correctly
+ */
+
+/// <summary>
+/// Encodes a unit vector into 2 components in the -1 to 1 range, by projecting it onto an octahedron
+/// and unfolding that into a square. See "A Survey of Efficient Representations for Independent Unit Vectors"
+/// </summary>
+inline glm::vec2 OctEncode(const glm::vec3& normal) {
+	float sum = glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z);
+	if (sum == 0.0f) {
+		return glm::vec2(0.0f);
+	}
+	glm::vec2 result = glm::vec2(normal.x, normal.y) / sum;
+	// The bottom half of the octahedron gets folded out over the corners
+	if (normal.z < 0.0f) {
+		glm::vec2 signs = glm::vec2(result.x >= 0.0f ? 1.0f : -1.0f, result.y >= 0.0f ? 1.0f : -1.0f);
+		result = (1.0f - glm::abs(glm::vec2(result.y, result.x))) * signs;
+	}
+	return result;
+}
+/// <summary>
+/// Decodes a unit vector encoded with OctEncode, this matches the decoding done in our shaders
+/// </summary>
+inline glm::vec3 OctDecode(const glm::vec2& encoded) {
+	glm::vec3 result = glm::vec3(encoded.x, encoded.y, 1.0f - glm::abs(encoded.x) - glm::abs(encoded.y));
+	float t = glm::max(-result.z, 0.0f);
+	result.x += result.x >= 0.0f ? -t : t;
+	result.y += result.y >= 0.0f ? -t : t;
+	return glm::normalize(result);
+}
+
+/// <summary>
+/// A 24 byte version of VertexPosNormTexCol, with an octahedral encoded normal, half float UVs
+/// and an 8 bit per channel color
+/// </summary>
+struct VertexPosNormTexColPacked {
+	glm::vec3 Position;
+	uint32_t  Normal; // 2x snorm16, octahedral encoded
+	uint32_t  UV;     // 2x half float
+	uint32_t  Color;  // 4x unorm8
+
+	static VertexDecodeInfo GetDecodeInfo(const glm::vec3& /*boundsMin*/, const glm::vec3& /*boundsMax*/) {
+		VertexDecodeInfo result;
+		result.OctahedralNormals = true;
+		return result;
+	}
+	static VertexPosNormTexColPacked Pack(const VertexPosNormTexCol& vertex, const VertexDecodeInfo& /*decode*/) {
+		VertexPosNormTexColPacked result;
+		result.Position = vertex.Position;
+		result.Normal = glm::packSnorm2x16(OctEncode(vertex.Normal));
+		result.UV = glm::packHalf2x16(vertex.UV);
+		result.Color = glm::packUnorm4x8(vertex.Color);
+		return result;
+	}
+
+	static const std::vector<BufferAttribute> V_DECL;
+};
+
+/// <summary>
+/// A 20 byte version of VertexPosNormTexCol, which additionally stores positions as 16 bit values
+/// within the bounds of the mesh. Best suited to meshes that are not too large, since the precision
+/// of the positions depends on the size of the mesh
+/// </summary>
+struct VertexPosNormTexColQuantized {
+	glm::i16vec4 Position; // 3x snorm16 within the mesh bounds, w is padding
+	uint32_t     Normal;   // 2x snorm16, octahedral encoded
+	uint32_t     UV;       // 2x half float
+	uint32_t     Color;    // 4x unorm8
+
+	static VertexDecodeInfo GetDecodeInfo(const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+		VertexDecodeInfo result;
+		result.PositionOffset = (boundsMin + boundsMax) * 0.5f;
+		// Avoid a zero scale for flat meshes, so that we never divide by zero when packing
+		result.PositionScale = glm::max((boundsMax - boundsMin) * 0.5f, glm::vec3(1e-6f));
+		result.OctahedralNormals = true;
+		return result;
+	}
+	static VertexPosNormTexColQuantized Pack(const VertexPosNormTexCol& vertex, const VertexDecodeInfo& decode) {
+		VertexPosNormTexColQuantized result;
+		glm::vec3 local = glm::clamp((vertex.Position - decode.PositionOffset) / decode.PositionScale, -1.0f, 1.0f);
+		result.Position = glm::i16vec4(glm::round(local * 32767.0f), 0);
+		result.Normal = glm::packSnorm2x16(OctEncode(vertex.Normal));
+		result.UV = glm::packHalf2x16(vertex.UV);
+		result.Color = glm::packUnorm4x8(vertex.Color);
+		return result;
+	}
+
+	static const std::vector<BufferAttribute> V_DECL;
+};
+
+static_assert(sizeof(VertexPosNormTexColPacked) == 24, "Packed vertex should be 24 bytes");
+static_assert(sizeof(VertexPosNormTexColQuantized) == 20, "Quantized vertex should be 20 bytes");
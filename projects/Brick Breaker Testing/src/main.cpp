@@ -16,6 +16,16 @@
 #include "Graphics/VertexBuffer.h"
 #include "Graphics/VertexArrayObject.h"
 #include "Graphics/Shader.h"
+#include "Graphics/ShaderLibrary.h"
+#include "Graphics/UniformBlocks.h"
+#include "Graphics/UniformBuffer.h"
+#include "Graphics/Material.h"
+#include "Graphics/RenderQueue.h"
+#include "Graphics/LightClusterGrid.h"
+#include "TTK/GLStateCache.h"
+#include "TTK/ProgramBinaryCache.h"
+#include "TTK/GraphicsUtils.h"
+#include "TTK/Profiler.h"
 #include "Gameplay/Camera.h"
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
@@ -23,6 +33,7 @@
 #include "Gameplay/Transform.h"
 #include "Graphics/Texture2D.h"
 #include "Graphics/Texture2DData.h"
+#include "Graphics/TextureStreamer.h"
 #include "Utilities/InputHelpers.h"
 #include "Utilities/MeshBuilder.h"
 #include "Utilities/MeshFactory.h"
@@ -67,6 +78,8 @@ void GlDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsi
 
 GLFWwindow* window;
 Camera::sptr camera = nullptr;
+int windowWidth = 1200;
+int windowHeight = 900;
 
 int score = 0;
 int timer = 0;
@@ -80,6 +93,8 @@ void Output(int score, int lives)
 void GlfwWindowResizedCallback(GLFWwindow* window, int width, int height) {
 	glViewport(0, 0, width, height);
 	camera->ResizeWindow(width, height);
+	windowWidth = width;
+	windowHeight = height;
 }
 
 bool initGLFW() {
@@ -93,7 +108,7 @@ bool initGLFW() {
 #endif
 
 	//Create a new GLFW window
-	window = glfwCreateWindow(1200, 900, "Brick Breaker", nullptr, nullptr);
+	window = glfwCreateWindow(windowWidth, windowHeight, "Brick Breaker", nullptr, nullptr);
 	glfwMakeContextCurrent(window);
 
 	// Set our window resized callback
@@ -211,25 +226,6 @@ float checkCollisionBallXSpeed(Transform::sptr ball, Transform::sptr paddle, flo
 
 	return ballXSpeed;
 }
-void RenderVAO(
-	const Shader::sptr& shader,
-	const VertexArrayObject::sptr& vao,
-	const Camera::sptr& camera,
-	const Transform::sptr& transform)
-{
-	shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection() * transform->LocalTransform());
-	shader->SetUniformMatrix("u_Model", transform->LocalTransform());
-	shader->SetUniformMatrix("u_NormalMatrix", transform->NormalMatrix());
-	vao->Render();
-}
-
-struct Material
-{
-	Texture2D::sptr Albedo;
-	Texture2D::sptr Specular;
-	float           Shininess;
-};
-
 int main() {
 	Logger::Init(); // We'll borrow the logger from the toolkit, but we need to initialize it
 
@@ -245,43 +241,55 @@ int main() {
 	glEnable(GL_DEBUG_OUTPUT);
 	glDebugMessageCallback(GlDebugMessage, nullptr);
 
+	// The profiler window is drawn with ImGui
+	TTK::Graphics::InitImGUI(window);
+
 	// Enable texturing
 	glEnable(GL_TEXTURE_2D);
 
 	int lives = 3;
 
-	// Load our shaders
-	Shader::sptr shader = Shader::Create();
-	shader->LoadShaderPartFromFile("shaders/vertex_shader.glsl", GL_VERTEX_SHADER);
-	shader->LoadShaderPartFromFile("shaders/frag_blinn_phong_textured.glsl", GL_FRAGMENT_SHADER);
-	shader->Link();
-
-	glm::vec3 lightPos = glm::vec3(0.0f, -10.0f, 10.0f);
-	glm::vec3 lightCol = glm::vec3(0.3f, 0.2f, 0.5f);
-	float     lightAmbientPow = 5.0f;
+	// Let our shaders know how our uniform blocks are laid out, so they can be checked when linking
+	Shader::RegisterUniformBlock(FrameUniforms::GetLayout());
+	Shader::RegisterUniformBlock(DrawUniforms::GetLayout());
+	Shader::RegisterUniformBlock(InstanceUniforms::GetLayout());
+
+	// Load our shaders, the library will recompile them whenever their files are saved
+	double shaderStart = glfwGetTime();
+	ShaderLibrary::sptr shaderLibrary = ShaderLibrary::Create();
+	// Everything in the scene has an albedo and specular map, and is lit by the lights in its cluster
+	Shader::sptr shader = shaderLibrary->Load("shaders/vertex_shader.glsl", "shaders/frag_lit.glsl",
+		ShaderKeyword::Textured | ShaderKeyword::SpecularMap | ShaderKeyword::Attenuation | ShaderKeyword::Clustered);
+	const TTK::ProgramBinaryCache::Stats& programCache = TTK::ProgramBinaryCache::Instance().GetStats();
+	LOG_INFO("Loaded shaders in {:.2f}ms ({} cached, {} compiled)", (glfwGetTime() - shaderStart) * 1000.0, programCache.Hits, programCache.Misses + programCache.Rejected);
+
+	// Our point lights, these get sorted into clusters every frame so we can have as many as we like
+	std::vector<PointLight> lights;
+	lights.push_back({ glm::vec3(0.0f, -10.0f, 10.0f), 30.0f, glm::vec3(0.3f, 0.2f, 0.5f), 5.0f });
 	float     lightSpecularPow = 1.0f;
 	glm::vec3 ambientCol = glm::vec3(1.0f);
 	float     ambientPow = 0.5f;
-	float     shininess = 4.0f;
 	float     lightLinearFalloff = 0.09f;
 	float     lightQuadraticFalloff = 0.032f;
 
-	// These are our application / scene level uniforms that don't necessarily update
-	// every frame
-	shader->SetUniform("u_LightPos", lightPos);
-	shader->SetUniform("u_LightCol", lightCol);
-	shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-	shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
-	shader->SetUniform("u_AmbientCol", ambientCol);
-	shader->SetUniform("u_AmbientStrength", ambientPow);
-	shader->SetUniform("u_Shininess", shininess);
-	shader->SetUniform("u_LightAttenuationConstant", 1.0f);
-	shader->SetUniform("u_LightAttenuationLinear", lightLinearFalloff);
-	shader->SetUniform("u_LightAttenuationQuadratic", lightQuadraticFalloff);
+	// These are our application / scene level uniforms, they live in a uniform buffer that we
+	// update once per frame along with the camera
+	FrameUniforms frameUniforms = FrameUniforms();
+	frameUniforms.SpecularLightStrength = lightSpecularPow;
+	frameUniforms.AmbientCol = ambientCol;
+	frameUniforms.AmbientStrength = ambientPow;
+	frameUniforms.LightAttenuationConstant = 1.0f;
+	frameUniforms.LightAttenuationLinear = lightLinearFalloff;
+	frameUniforms.LightAttenuationQuadratic = lightQuadraticFalloff;
+	UniformBuffer::sptr frameData = UniformBuffer::Create();
+	LightClusterGrid::sptr lightGrid = LightClusterGrid::Create();
+
+	// The render queue sorts our objects to cut down on state changes, and batches them into instanced draws
+	RenderQueue::sptr renderQueue = RenderQueue::Create();
 
 	// GL states
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
+	TTK::GLStateCache::Instance().SetEnabled(GL_DEPTH_TEST, true);
+	TTK::GLStateCache::Instance().SetEnabled(GL_CULL_FACE, true);
 
 
 	//Bricks
@@ -345,9 +353,9 @@ int main() {
 
 	// We'll store all our VAOs into a nice array for easy access
 		//VAOS
-	VertexArrayObject::sptr vao0 = ObjLoader::LoadFromFile("Player.obj");
-	VertexArrayObject::sptr vao1 = ObjLoader::LoadFromFile("ball.obj");
-	VertexArrayObject::sptr vao2 = ObjLoader::LoadFromFile("wall.obj");
+	VertexArrayObject::sptr vao0 = ObjLoader::LoadFromFile<VertexPosNormTexColPacked>("Player.obj");
+	VertexArrayObject::sptr vao1 = ObjLoader::LoadFromFile<VertexPosNormTexColPacked>("ball.obj");
+	VertexArrayObject::sptr vao2 = ObjLoader::LoadFromFile<VertexPosNormTexColPacked>("wall.obj");
 
 	VertexArrayObject::sptr vao[7];
 	vao[0] = vao0;
@@ -366,28 +374,20 @@ int main() {
 		vaoB[num] = vao0;
 	}
 
-	// TODO: load textures
-	// Load our texture data from a file
-	Texture2DData::sptr blueMap = Texture2DData::LoadFromFile("images/blue.png", true);
-	Texture2DData::sptr diffuseMap = Texture2DData::LoadFromFile("images/sample.png");
-	Texture2DData::sptr specularMap = Texture2DData::LoadFromFile("images/Stone_001_Specular.png");
-	Texture2DData::sptr woodwallMap = Texture2DData::LoadFromFile("images/woodwall.png", true);
-	Texture2DData::sptr yellowMap = Texture2DData::LoadFromFile("images/yellow.png", true);
-	Texture2DData::sptr blackMap = Texture2DData::LoadFromFile("images/black.png", true);
-
-	// Create a texture from the data
-	Texture2D::sptr blue = Texture2D::Create();
-	blue->LoadData(blueMap);
-	Texture2D::sptr woodwall = Texture2D::Create();
-	woodwall->LoadData(woodwallMap);
-	Texture2D::sptr yellow = Texture2D::Create();
-	yellow->LoadData(yellowMap);
-	Texture2D::sptr black = Texture2D::Create();
-	black->LoadData(blackMap);
-	Texture2D::sptr diffuse = Texture2D::Create();
-	diffuse->LoadData(diffuseMap);
-	Texture2D::sptr specular = Texture2D::Create();
-	specular->LoadData(specularMap);
+	// Textures are decoded in the background and uploaded a little each frame, so we can start drawing right away.
+	// Until each one is ready it shows a flat placeholder color
+	ThreadPool::sptr texturePool = ThreadPool::Create();
+	TextureStreamer::sptr textureStreamer = TextureStreamer::Create(texturePool);
+	// Trilinear and anisotropic filtering, so the walls stay sharp at glancing angles without shimmering
+	Texture2DDescription textureDesc = Texture2DDescription();
+	textureDesc.MinificationFilter = MinFilter::LinearMipLinear;
+	textureDesc.MaxAnisotropy = 8.0f;
+	Texture2D::sptr blue = textureStreamer->Load("images/blue.png", true, textureDesc);
+	Texture2D::sptr woodwall = textureStreamer->Load("images/woodwall.png", true, textureDesc);
+	Texture2D::sptr yellow = textureStreamer->Load("images/yellow.png", true, textureDesc);
+	Texture2D::sptr black = textureStreamer->Load("images/black.png", true, textureDesc);
+	Texture2D::sptr diffuse = textureStreamer->Load("images/sample.png", false, textureDesc);
+	Texture2D::sptr specular = textureStreamer->Load("images/Stone_001_Specular.png", false, textureDesc);
 
 
 	// Creating an empty texture
@@ -398,48 +398,48 @@ int main() {
 	Texture2D::sptr texture2 = Texture2D::Create(desc);
 	texture2->Clear();
 
-	// TODO: store some info about our materials for each object
-	Material materials[7];
-	materials[0].Albedo = woodwall;
-	materials[0].Specular = specular;
-	materials[0].Shininess = 40.0f;
-	materials[1].Albedo = yellow;
-	materials[1].Specular = specular;
-	materials[1].Shininess = 16.0f;
-	materials[2].Albedo = blue;
-	materials[2].Specular = specular;
-	materials[2].Shininess = 5.0f;
-	materials[3].Albedo = woodwall;
-	materials[3].Specular = specular;
-	materials[3].Shininess = 16.0f;
-	materials[4].Albedo = woodwall;
-	materials[4].Specular = specular;
-	materials[4].Shininess = 16.0f;
-	materials[5].Albedo = woodwall;
-	materials[5].Specular = specular;
-	materials[5].Shininess = 16.0f;
-	materials[6].Albedo = black;
-	materials[6].Specular = specular;
-	materials[6].Shininess = 16.0f;
+	// Objects that look the same share a material, so that the render queue can draw them together
+	Material::sptr paddleMaterial = Material::Create();
+	paddleMaterial->Albedo = woodwall;
+	paddleMaterial->Specular = specular;
+	paddleMaterial->Shininess = 40.0f;
+	Material::sptr wallMaterial = Material::Create();
+	wallMaterial->Albedo = woodwall;
+	wallMaterial->Specular = specular;
+	wallMaterial->Shininess = 16.0f;
+
+	Material::sptr materials[7];
+	materials[0] = paddleMaterial;
+	materials[1] = Material::Create();
+	materials[1]->Albedo = yellow;
+	materials[1]->Specular = specular;
+	materials[1]->Shininess = 16.0f;
+	materials[2] = Material::Create();
+	materials[2]->Albedo = blue;
+	materials[2]->Specular = specular;
+	materials[2]->Shininess = 5.0f;
+	materials[3] = wallMaterial;
+	materials[4] = wallMaterial;
+	materials[5] = wallMaterial;
+	materials[6] = Material::Create();
+	materials[6]->Albedo = black;
+	materials[6]->Specular = specular;
+	materials[6]->Shininess = 16.0f;
 
 	//Brick Materials
-	Texture2DData::sptr brickMap = Texture2DData::LoadFromFile("images/brick.png");
-	Texture2DData::sptr brick2Map = Texture2DData::LoadFromFile("images/brick2.png");
-
-	Texture2D::sptr brick = Texture2D::Create();
-	brick->LoadData(brickMap);
+	Texture2D::sptr brick = textureStreamer->Load("images/brick.png", false, textureDesc);
+	Texture2D::sptr brick2 = textureStreamer->Load("images/brick2.png", false, textureDesc);
 
-	Texture2D::sptr brick2 = Texture2D::Create();
-	brick2->LoadData(brick2Map);
 
-
-	Material materialsBrick[2];
-	materialsBrick[0].Albedo = brick;
-	materialsBrick[0].Specular = specular;
-	materialsBrick[0].Shininess = 16.0f;
-	materialsBrick[1].Albedo = brick2;
-	materialsBrick[1].Specular = specular;
-	materialsBrick[1].Shininess = 16.0f;
+	Material::sptr materialsBrick[2];
+	materialsBrick[0] = Material::Create();
+	materialsBrick[0]->Albedo = brick;
+	materialsBrick[0]->Specular = specular;
+	materialsBrick[0]->Shininess = 16.0f;
+	materialsBrick[1] = Material::Create();
+	materialsBrick[1]->Albedo = brick2;
+	materialsBrick[1]->Specular = specular;
+	materialsBrick[1]->Shininess = 16.0f;
 
 	camera = Camera::Create();
 	camera->SetPosition(glm::vec3(0, 2, 3)); // Set initial position
@@ -450,10 +450,13 @@ int main() {
 
 	// Our high-precision timer
 	double lastFrame = glfwGetTime();
+	bool isFirstFrame = true;
+	bool isStreaming = true;
 
 	///// Game loop /////
 	while (!glfwWindowShouldClose(window)) {
 		glfwPollEvents();
+		TTK::Profiler::Instance().BeginFrame();
 		timer++;
 		// Calculate the time since our last frame (dt)
 		double thisFrame = glfwGetTime();
@@ -471,77 +474,112 @@ int main() {
 
 
 
+		// Swap in any shaders that have finished recompiling since last frame
+		shaderLibrary->Poll();
+		// Upload the next slice of any textures that have finished decoding
+		textureStreamer->Update();
+
 		glClearColor(0.08f, 0.17f, 0.31f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		shader->Bind();
 		// These are the uniforms that update only once per frame
-		shader->SetUniformMatrix("u_View", camera->GetView());
-		shader->SetUniform("u_CamPos", camera->GetPosition());
+		{
+			PROFILE_GPU_SCOPE("Frame Uniforms");
+			frameUniforms.View = camera->GetView();
+			frameUniforms.CamPos = camera->GetPosition();
+			lightGrid->Build(lights, camera, windowWidth, windowHeight);
+			lightGrid->FillUniforms(frameUniforms);
+			lightGrid->Bind();
+			frameData->Update(frameUniforms);
+			frameData->Bind(FrameUniforms::BINDING);
+		}
 
 		// Tell OpenGL that slot 0 will hold the diffuse, and slot 1 will hold the specular
-		shader->SetUniform("s_Diffuse", 0);
-		shader->SetUniform("s_Specular", 1);
+		static constexpr UniformId s_Diffuse = "s_Diffuse";
+		static constexpr UniformId s_Specular = "s_Specular";
+		shader->SetUniform(s_Diffuse, 0);
+		shader->SetUniform(s_Specular, 1);
 
-		ballYSpeed = checkCollisionBallYSpeed(transform[1], transform[0], ballYSpeed);
-		ballXSpeed = checkCollisionBallXSpeed(transform[1], transform[0], ballXSpeed);
-		if(timer > 5 )
 		{
-			timer = 0;
-			std::cout << "Timer" << timer << "\n";
-
-			for (int i = 0; i < numB; i++)
+			PROFILE_SCOPE("Gameplay");
+			ballYSpeed = checkCollisionBallYSpeed(transform[1], transform[0], ballYSpeed);
+			ballXSpeed = checkCollisionBallXSpeed(transform[1], transform[0], ballXSpeed);
+			if(timer > 5 )
 			{
-				ballYSpeed = checkCollisionBrickY(transform[1], transformB[i], ballYSpeed, lives);
+				timer = 0;
+				std::cout << "Timer" << timer << "\n";
 
-			}
-		}
+				for (int i = 0; i < numB; i++)
+				{
+					ballYSpeed = checkCollisionBrickY(transform[1], transformB[i], ballYSpeed, lives);
 
-		//Ball
-		transform[1]->MoveLocal(ballXSpeed, ballYSpeed, 0.f);//Remove Multiple
+				}
+			}
 
-		if (transform[1]->GetLocalPosition().y >= (transform[0]->GetLocalPosition().y + (transform[0]->GetLocalScale().y * 2)))
-		{
-			lives = life_Death(lives);
-		}
+			//Ball
+			transform[1]->MoveLocal(ballXSpeed, ballYSpeed, 0.f);//Remove Multiple
 
-		// Render all VAOs in our scene
-		for (int ix = 0; ix <= 6; ix++) {
-			// TODO: Apply materials
-			materials[ix].Albedo->Bind(0);
-			materials[ix].Specular->Bind(1);
-			shader->SetUniform("u_Shininess", materials[ix].Shininess);
-			RenderVAO(shader, vao[ix], camera, transform[ix]);
+			if (transform[1]->GetLocalPosition().y >= (transform[0]->GetLocalPosition().y + (transform[0]->GetLocalScale().y * 2)))
+			{
+				lives = life_Death(lives);
+			}
 		}
 
-		//Render all VAO for bricks in our scene
-		for (int ixB = 0; ixB < numB; ixB++)
 		{
-			// TODO: Apply materials
-			
-			if (transformB[ixB]->GetLives() != 2.f)
-			{
-				materialsBrick[1].Albedo->Bind(0);
-				materialsBrick[1].Specular->Bind(1);
-				shader->SetUniform("u_Shininess", materialsBrick[1].Shininess);
+			PROFILE_SCOPE("Submit");
+			// Submit all VAOs in our scene
+			for (int ix = 0; ix <= 6; ix++) {
+				renderQueue->Submit(vao[ix], materials[ix], transform[ix], shader);
 			}
-			else
+
+			//Submit all VAO for bricks in our scene
+			for (int ixB = 0; ixB < numB; ixB++)
 			{
-				materialsBrick[0].Albedo->Bind(0);
-				materialsBrick[0].Specular->Bind(1);
-				shader->SetUniform("u_Shininess", materialsBrick[0].Shininess);
+				const Material::sptr& material = transformB[ixB]->GetLives() != 2.f ? materialsBrick[1] : materialsBrick[0];
+				renderQueue->Submit(vaoB[ixB], material, transformB[ixB], shader);
 			}
-				
-			RenderVAO(shader, vaoB[ixB], camera, transformB[ixB]);
-
 		}
 
+		renderQueue->Flush(camera);
 
+		{
+			PROFILE_GPU_SCOPE("ImGui");
+			TTK::Graphics::BeginGUI();
+			TTK::Profiler::Instance().DrawImGui();
+
+			// What the render queue did this frame, so we can see what sorting and instancing are saving us
+			const RenderQueue::Stats& queueStats = renderQueue->GetStats();
+			ImGui::Begin("Render Queue");
+			ImGui::Text("%zu items in %zu draw calls", queueStats.Items, queueStats.DrawCalls);
+			ImGui::Text("%zu visible, %zu culled", queueStats.Items - queueStats.Culled, queueStats.Culled);
+			ImGui::Text("%zu state changes", queueStats.StateChanges);
+			ImGui::Text("Culled in %.3f ms, sorted in %.3f ms", queueStats.CullTimeMs, queueStats.SortTimeMs);
+			ImGui::End();
+
+			TTK::Graphics::EndGUI();
+			// ImGui makes its own OpenGL calls, so the state cache can't trust what it knew
+			TTK::GLStateCache::Instance().Invalidate();
+		}
+		TTK::GLStateCache::Instance().EndFrame();
 
+		TTK::Profiler::Instance().EndFrame();
 		glfwSwapBuffers(window);
 		lastFrame = thisFrame;
+
+		if (isFirstFrame) {
+			LOG_INFO("First frame presented {:.2f}ms after startup", glfwGetTime() * 1000.0);
+			isFirstFrame = false;
+		}
+		if (isStreaming && textureStreamer->IsIdle()) {
+			const TextureStreamer::Stats& stats = textureStreamer->GetStats();
+			LOG_INFO("All textures resident {:.2f}ms after startup ({} loaded, {} failed, {} stalls)",
+				glfwGetTime() * 1000.0, stats.Resident, stats.Failed, stats.Stalls);
+			isStreaming = false;
+		}
 	}
 
+	TTK::Graphics::ShutdownImGUI();
+
 	// Clean up the toolkit logger so we don't leak memory
 	Logger::Uninitialize();
 	return 0;
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+// Constants for the 64 bit FNV-1a hash, see http://www.isthe.com/chongo/tech/comp/fnv/
+static constexpr uint64_t FNV1A_64_OFFSET = 14695981039346656037ull;
+static constexpr uint64_t FNV1A_64_PRIME  = 1099511628211ull;
+
+/// <summary>
+/// Hashes a block of memory using a word-at-a-time variant of FNV-1a. This is NOT a
+/// cryptographic hash, it's only intended to detect when source data has changed
+/// </summary>
+/// <param name="data">A pointer to the start of the data to hash</param>
+/// <param name="size">The size of the data, in bytes</param>
+/// <param name="seed">The hash to continue from, allows for chaining calls</param>
+/// <returns>The 64 bit hash of the data</returns>
+static inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed = FNV1A_64_OFFSET) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t hash = seed;
+
+	// Consume 8 bytes at a time, memcpy keeps us safe on unaligned input
+	size_t ix = 0;
+	for (; ix + sizeof(uint64_t) <= size; ix += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, bytes + ix, sizeof(uint64_t));
+		hash = (hash ^ word) * FNV1A_64_PRIME;
+	}
+	// Handle any trailing bytes one at a time
+	for (; ix < size; ix++) {
+		hash = (hash ^ bytes[ix]) * FNV1A_64_PRIME;
+	}
+	return hash;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <cstdint>
+
+/// <summary>
+/// Wraps a read-only memory mapping of a file on disk, so that the contents can be
+/// read directly without copying them into an intermediate buffer
+/// </summary>
+class MappedFile final
+{
+public:
+	typedef std::shared_ptr<MappedFile> sptr;
+	/// <summary>
+	/// Opens and maps the given file into memory
+	/// </summary>
+	/// <param name="path">The path of the file to map</param>
+	/// <returns>The mapped file, or nullptr if the file could not be opened or is empty</returns>
+	static sptr Open(const std::string& path);
+
+public:
+	// We'll disallow moving and copying, since we want to manually control when the destructor is called
+	// We'll use these classes via pointers
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile(MappedFile&& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+	MappedFile& operator=(MappedFile&& other) = delete;
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	/// <summary>
+	/// Gets a pointer to the start of the mapped data, valid for the lifetime of this object
+	/// </summary>
+	const uint8_t* GetData() const { return _data; }
+	/// <summary>
+	/// Gets the size of the mapped data, in bytes
+	/// </summary>
+	size_t GetSize() const { return _size; }
+
+private:
+	const uint8_t* _data;
+	size_t         _size;
+
+	// Platform handles, on Windows these are the file and mapping HANDLEs, elsewhere
+	// only the file descriptor is used
+	void* _fileHandle;
+	void* _mappingHandle;
+
+	bool _Map(const std::string& path);
+	void _Unmap();
+};
@@ -82,11 +82,23 @@ public:
 	size_t GetTriangleCount() const { return _indices.size() > 0 ? _indices.size() / 3 : _vertices.size() / 3; }
 
 	VertexArrayObject::sptr Bake() {
+		return Bake(GetVertexDataPtr(), _vertices.size(), GetIndexDataPtr(), _indices.size());
+	}
+
+	/// <summary>
+	/// Creates a VAO directly from existing vertex and index data, without needing to copy it
+	/// into a mesh builder first (for instance, data that was memory mapped from a file)
+	/// </summary>
+	/// <param name="vertices">A pointer to the first vertex to upload</param>
+	/// <param name="vertexCount">The number of vertices to upload</param>
+	/// <param name="indices">A pointer to the first index to upload</param>
+	/// <param name="indexCount">The number of indices to upload</param>
+	static VertexArrayObject::sptr Bake(const VertType* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount) {
 		VertexBuffer::sptr vbo = VertexBuffer::Create();
-		vbo->LoadData(GetVertexDataPtr(), _vertices.size());
+		vbo->LoadData(vertices, vertexCount);
 
 		IndexBuffer::sptr ebo = IndexBuffer::Create();
-		ebo->LoadData(GetIndexDataPtr(), _indices.size());
+		ebo->LoadData(indices, indexCount);
 
 		VertexArrayObject::sptr result = VertexArrayObject::Create();
 		result->AddVertexBuffer(vbo, VertType::V_DECL);
@@ -0,0 +1,151 @@
+#include "MeshCache.h"
+
+#include <fstream>
+#include <filesystem>
+#include <iostream>
+
+#include "HashUtils.h"
+
+static const char BAKED_MESH_MAGIC[4] = { 'B', 'M', 'S', 'H' };
+
+std::string MeshCache::GetCachePath(const std::string& sourceFile) {
+	return sourceFile + ".bmesh";
+}
+
+bool MeshCache::GetSourceStamp(const std::string& sourceFile, SourceStamp& stamp) {
+	std::error_code error;
+	uintmax_t size = std::filesystem::file_size(sourceFile, error);
+	if (error) {
+		return false;
+	}
+	std::filesystem::file_time_type time = std::filesystem::last_write_time(sourceFile, error);
+	if (error) {
+		return false;
+	}
+	stamp.Size = static_cast<uint64_t>(size);
+	stamp.Time = static_cast<int64_t>(time.time_since_epoch().count());
+	return true;
+}
+
+bool MeshCache::_IsStampCurrent(const std::string& sourceFile, const SourceStamp& stamp) {
+	SourceStamp current;
+	return GetSourceStamp(sourceFile, current) && current.Size == stamp.Size && current.Time == stamp.Time;
+}
+
+MappedFile::sptr MeshCache::_OpenValidated(const std::string& path, const std::string& sourceFile, uint64_t settingsHash, size_t vertexStride, bool& restamp, SourceStamp& stamp) {
+	restamp = false;
+	if (!GetSourceStamp(sourceFile, stamp)) {
+		return nullptr;
+	}
+
+	MappedFile::sptr file = MappedFile::Open(path);
+	if (file == nullptr) {
+		return nullptr;
+	}
+
+	if (file->GetSize() < sizeof(BakedMeshHeader)) {
+		std::cout << "Baked mesh \"" << path << "\" is truncated, ignoring" << std::endl;
+		return nullptr;
+	}
+
+	const BakedMeshHeader* header = reinterpret_cast<const BakedMeshHeader*>(file->GetData());
+	if (memcmp(header->Magic, BAKED_MESH_MAGIC, sizeof(BAKED_MESH_MAGIC)) != 0 || header->Version != VERSION) {
+		std::cout << "Baked mesh \"" << path << "\" is from an incompatible version, it will be rebuilt" << std::endl;
+		return nullptr;
+	}
+	if (header->SettingsHash != settingsHash || header->VertexStride != vertexStride || header->SourceSize != stamp.Size) {
+		std::cout << "Baked mesh \"" << path << "\" is out of date, it will be rebuilt" << std::endl;
+		return nullptr;
+	}
+
+	size_t expectedSize = sizeof(BakedMeshHeader) +
+		header->VertexCount * (size_t)header->VertexStride +
+		header->IndexCount * sizeof(uint32_t);
+	if (file->GetSize() != expectedSize) {
+		std::cout << "Baked mesh \"" << path << "\" is " << file->GetSize() << " bytes, expected " << expectedSize << ", ignoring" << std::endl;
+		return nullptr;
+	}
+
+	// The size is the same but the file has been written to since, so we have to look at the
+	// contents to find out if anything actually changed
+	if (header->SourceTime != stamp.Time) {
+		MappedFile::sptr source = MappedFile::Open(sourceFile);
+		if (source == nullptr || HashBytes(source->GetData(), source->GetSize()) != header->SourceHash) {
+			std::cout << "Baked mesh \"" << path << "\" is out of date, it will be rebuilt" << std::endl;
+			return nullptr;
+		}
+		restamp = true;
+	}
+
+	return file;
+}
+
+void MeshCache::_Restamp(const std::string& path, const std::string& sourceFile, const SourceStamp& stamp, BakedMeshHeader& header) {
+	// The hash we matched was taken under this stamp, if the source has been written to since then
+	// storing either stamp could pair it with contents we never hashed
+	if (!_IsStampCurrent(sourceFile, stamp)) {
+		std::cout << "Source of baked mesh \"" << path << "\" changed while it was being checked, it will be hashed again next time" << std::endl;
+		return;
+	}
+	header.SourceSize = stamp.Size;
+	header.SourceTime = stamp.Time;
+
+	// Only the header changes, so we overwrite it in place
+	std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+	if (file) {
+		file.write(reinterpret_cast<const char*>(&header), sizeof(BakedMeshHeader));
+	}
+	if (!file) {
+		std::cout << "Failed to update the source stamp of baked mesh \"" << path << "\", the source will be hashed again next time" << std::endl;
+	}
+}
+
+bool MeshCache::_Write(const std::string& path, const std::string& sourceFile, const SourceStamp& stamp, uint64_t sourceHash, uint64_t settingsHash, size_t vertexStride,
+	const void* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount)
+{
+	// If the source was written to while it was being loaded, the mesh and hash may not match the
+	// stamp, so we leave it uncached and load it from scratch next time
+	if (!_IsStampCurrent(sourceFile, stamp)) {
+		std::cout << "\"" << sourceFile << "\" changed while it was being loaded, mesh will not be cached" << std::endl;
+		return false;
+	}
+
+	BakedMeshHeader header;
+	memcpy(header.Magic, BAKED_MESH_MAGIC, sizeof(BAKED_MESH_MAGIC));
+	header.Version = VERSION;
+	header.SourceHash = sourceHash;
+	header.SettingsHash = settingsHash;
+	header.SourceSize = stamp.Size;
+	header.SourceTime = stamp.Time;
+	header.VertexStride = static_cast<uint32_t>(vertexStride);
+	header.VertexCount = static_cast<uint32_t>(vertexCount);
+	header.IndexCount = static_cast<uint32_t>(indexCount);
+	header.Reserved = 0;
+
+	// We write to a temporary file and swap it in, so a crash mid-write never leaves behind
+	// a file that looks valid
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			std::cout << "Could not open \"" << tempPath << "\" for writing, mesh will not be cached" << std::endl;
+			return false;
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(BakedMeshHeader));
+		file.write(reinterpret_cast<const char*>(vertices), vertexCount * vertexStride);
+		file.write(reinterpret_cast<const char*>(indices), indexCount * sizeof(uint32_t));
+		if (!file) {
+			std::cout << "Failed to write baked mesh \"" << tempPath << "\"" << std::endl;
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+	if (error) {
+		std::cout << "Failed to move baked mesh into place at \"" << path << "\": " << error.message() << std::endl;
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
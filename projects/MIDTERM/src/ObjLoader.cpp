@@ -1,129 +1,205 @@
 #include "ObjLoader.h"
 
 #include <string>
-#include <sstream>
-#include <fstream>
+#include <cstring>
+#include <charconv>
+#include <chrono>
+#include <stdexcept>
 #include <iostream>
+#include <unordered_map>
+
+#include "HashUtils.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
 
 //Burrowed from GDW Project
 
-// Borrowed from https://stackoverflow.com/questions/216823/whats-the-best-way-to-trim-stdstring
-#pragma region String Trimming
+// These helpers walk a cursor over the raw file contents, they never allocate and never
+// read past end. Note that std::from_chars is locale independent, unlike iostreams
+
+static inline bool IsSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Skips spaces and tabs, but not newlines
+static inline const char* SkipSpaces(const char* p, const char* end) {
+	while (p < end && IsSpace(*p)) { p++; }
+	return p;
+}
 
-// trim from start (in place)
-static inline void ltrim(std::string& s) {
-	s.erase(s.begin(), std::find_if(s.begin(), s.end(), [](int ch) {
-		return !std::isspace(ch);
-		}));
+// Moves to the start of the next line
+static inline const char* SkipLine(const char* p, const char* end) {
+	const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+	return newline != nullptr ? newline + 1 : end;
 }
 
-// trim from end (in place)
-static inline void rtrim(std::string& s) {
-	s.erase(std::find_if(s.rbegin(), s.rend(), [](int ch) {
-		return !std::isspace(ch);
-		}).base(), s.end());
+// Reads a float, leaving out untouched (as 0) if there is no number at the cursor
+static inline const char* ParseFloat(const char* p, const char* end, float& out) {
+	p = SkipSpaces(p, end);
+	if (p < end && *p == '+') { p++; }
+	std::from_chars_result result = std::from_chars(p, end, out);
+	return result.ec == std::errc() ? result.ptr : p;
 }
 
-// trim from both ends (in place)
-static inline void trim(std::string& s) {
-	ltrim(s);
-	rtrim(s);
+// Reads an integer, returning false if there is no number at the cursor
+static inline bool ParseInt(const char*& p, const char* end, int32_t& out) {
+	if (p < end && *p == '+') { p++; }
+	std::from_chars_result result = std::from_chars(p, end, out);
+	if (result.ec != std::errc()) {
+		return false;
+	}
+	p = result.ptr;
+	return true;
 }
 
-#pragma endregion 
+// Hashes the position, UV and normal index of a face corner, so corners can be deduplicated
+struct CornerHash {
+	size_t operator()(const glm::ivec3& vertexIndices) const {
+		return static_cast<size_t>(HashBytes(&vertexIndices, sizeof(glm::ivec3)));
+	}
+};
 
-VertexArrayObject::sptr ObjLoader::LoadFromFile(const std::string& filename)
+VertexArrayObject::sptr ObjLoader::LoadFromFile(const std::string& filename, bool useCache)
 {
-	std::ifstream file;
-	file.open(filename, std::ios::binary);
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	// There aren't any load settings that change the mesh yet
+	const uint64_t settingsHash = 0;
+
+	std::string cachePath = MeshCache::GetCachePath(filename);
+	if (useCache) {
+		VertexArrayObject::sptr result = MeshCache::TryLoad<VertexPosNormTexCol>(cachePath, filename, settingsHash);
+		if (result != nullptr) {
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+			std::cout << "Loaded \"" << filename << "\" from baked cache in " << elapsed.count() << "ms" << std::endl;
+			return result;
+		}
+	}
 
-	if (!file)
+	// We stamp the source before reading it, and hash it before parsing it, so the stamp, hash
+	// and mesh all come from the same read. If it changes while we're loading, the stamp won't
+	// match anymore and Save leaves the mesh uncached
+	MeshCache::SourceStamp stamp = { 0, 0 };
+	MappedFile::sptr source = MappedFile::Open(filename);
+	if (source == nullptr || !MeshCache::GetSourceStamp(filename, stamp)) {
 		throw std::runtime_error("Failed to open file");
+	}
+	uint64_t sourceHash = useCache ? HashBytes(source->GetData(), source->GetSize()) : 0;
 
 	MeshBuilder<VertexPosNormTexCol> mesh;
-	std::string line;
-
-	std::vector<float> vertexPos, texture, normal;
-	std::string smoothing;
-	std::istringstream ss;
-
-	while (std::getline(file, line))
-	{
-		trim(line);
-
-		if (line.substr(0, 1) != "#")
-		{
-			if (line.substr(0, 2) == "v ")
-			{
-				ss = std::istringstream(line.substr(2));
-
-				vertexPos.push_back(0.0f);
-				vertexPos.push_back(0.0f);
-				vertexPos.push_back(0.0f);
-				ss >> vertexPos[vertexPos.size() - 3] >> vertexPos[vertexPos.size() - 2] >> vertexPos[vertexPos.size() - 1];
-			}
-			else if (line.substr(0, 2) == "vt")
-			{
-				ss = std::istringstream(line.substr(3));
-
-				texture.push_back(0.0f);
-				texture.push_back(0.0f);
-				ss >> texture[texture.size() - 2] >> texture[texture.size() - 1];
-			}
-			else if (line.substr(0, 2) == "vn")
-			{
-				ss = std::istringstream(line.substr(3));
-
-				normal.push_back(0.0f);
-				normal.push_back(0.0f);
-				normal.push_back(0.0f);
-				ss >> normal[normal.size() - 3] >> normal[normal.size() - 2] >> normal[normal.size() - 1];
-			}
-			else if (line.substr(0, 2) == "f ")
-			{
-				std::string FaceInfo = line.substr(2);
-
-				for (int i = 0; i < FaceInfo.size(); i++)
-				{
-					if (FaceInfo.at(i) == '/')
-						FaceInfo = FaceInfo.substr(0, i) + " " + FaceInfo.substr(i + 1);
-				}
+	_ParseObj(reinterpret_cast<const char*>(source->GetData()), source->GetSize(), mesh);
+	source = nullptr;
 
-				ss = std::istringstream(FaceInfo);
-
-				glm::vec3 p1Info, p2Info, p3Info;
-
-				ss >> p1Info.x >> p1Info.y >> p1Info.z
-					>> p2Info.x >> p2Info.y >> p2Info.z
-					>> p3Info.x >> p3Info.y >> p3Info.z;
+	if (useCache) {
+		MeshCache::Save(cachePath, filename, stamp, sourceHash, settingsHash, mesh);
+	}
 
-				glm::vec3 v1 = glm::vec3(vertexPos[(p1Info.x - 1) * 3], vertexPos[((p1Info.x - 1) * 3) + 1], vertexPos[((p1Info.x - 1) * 3) + 2]);
-				glm::vec2 vt1 = glm::vec2(texture[(p1Info.y - 1) * 2], texture[((p1Info.y - 1) * 2) + 1]);
-				glm::vec3 vn1 = glm::vec3(-normal[(p1Info.z - 1) * 3], -normal[((p1Info.z - 1) * 3) + 1], -normal[((p1Info.z - 1) * 3) + 2]);;
+	VertexArrayObject::sptr result = mesh.Bake();
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+	std::cout << "Parsed \"" << filename << "\" (" << mesh.GetVertexCount() << " vertices, " << mesh.GetTriangleCount() << " triangles) in "
+		<< elapsed.count() << "ms" << std::endl;
+	return result;
+}
 
-				glm::vec3 v2 = glm::vec3(vertexPos[(p2Info.x - 1) * 3], vertexPos[((p2Info.x - 1) * 3) + 1], vertexPos[((p2Info.x - 1) * 3) + 2]);
-				glm::vec2 vt2 = glm::vec2(texture[(p2Info.y - 1) * 2], texture[((p2Info.y - 1) * 2) + 1]);
-				glm::vec3 vn2 = glm::vec3(-normal[(p2Info.z - 1) * 3], -normal[((p2Info.z - 1) * 3) + 1], -normal[((p2Info.z - 1) * 3) + 2]);;
+void ObjLoader::_ParseObj(const char* data, size_t size, MeshBuilder<VertexPosNormTexCol>& mesh)
+{
+	const char* p = data;
+	const char* end = data + size;
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> textureCoords;
+
+	// Maps each combination of attributes we have seen to the vertex we made for it
+	std::unordered_map<glm::ivec3, uint32_t, CornerHash> vertexMap;
+	std::vector<uint32_t> faceVertices;
+
+	// Iterate over the file one line at a time
+	while (p < end) {
+		p = SkipSpaces(p, end);
+		if (p == end) {
+			break;
+		}
 
-				glm::vec3 v3 = glm::vec3(vertexPos[(p3Info.x - 1) * 3], vertexPos[((p3Info.x - 1) * 3) + 1], vertexPos[((p3Info.x - 1) * 3) + 2]);
-				glm::vec2 vt3 = glm::vec2(texture[(p3Info.y - 1) * 2], texture[((p3Info.y - 1) * 2) + 1]);
-				glm::vec3 vn3 = glm::vec3(-normal[(p3Info.z - 1) * 3], -normal[((p3Info.z - 1) * 3) + 1], -normal[((p3Info.z - 1) * 3) + 2]);;
+		// Load in vertex positions
+		if (p[0] == 'v' && p + 1 < end && IsSpace(p[1])) {
+			glm::vec3 temp(0.0f);
+			p = ParseFloat(p + 1, end, temp.x);
+			p = ParseFloat(p, end, temp.y);
+			p = ParseFloat(p, end, temp.z);
+			positions.push_back(temp);
+		}
+		// Load in vertex normals
+		else if (p[0] == 'v' && p + 2 < end && p[1] == 'n' && IsSpace(p[2])) {
+			glm::vec3 temp(0.0f);
+			p = ParseFloat(p + 2, end, temp.x);
+			p = ParseFloat(p, end, temp.y);
+			p = ParseFloat(p, end, temp.z);
+			normals.push_back(temp);
+		}
+		// Load in UV coordinates (any third component is ignored)
+		else if (p[0] == 'v' && p + 2 < end && p[1] == 't' && IsSpace(p[2])) {
+			glm::vec2 temp(0.0f);
+			p = ParseFloat(p + 2, end, temp.x);
+			p = ParseFloat(p, end, temp.y);
+			textureCoords.push_back(temp);
+		}
+		// Load in face lines, supporting v, v/vt, v//vn and v/vt/vn with any number of corners
+		else if (p[0] == 'f' && p + 1 < end && IsSpace(p[1])) {
+			p++;
+			faceVertices.clear();
+
+			while (true) {
+				p = SkipSpaces(p, end);
+				glm::ivec3 vertexIndices = glm::ivec3(0);
+				if (!ParseInt(p, end, vertexIndices.x)) {
+					break;
+				}
+				if (p < end && *p == '/') {
+					p++;
+					// UV is optional when there's a normal (v//vn)
+					if (p < end && *p != '/') {
+						ParseInt(p, end, vertexIndices.y);
+					}
+					if (p < end && *p == '/') {
+						p++;
+						ParseInt(p, end, vertexIndices.z);
+					}
+				}
 
-				for (int i = 0; i < vertexPos.size(); i++)
-				{
-					const uint32_t p1 = mesh.AddVertex(v1, glm::vec3(vt1.x, vt1.y, 0.0f), vn1, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
-					const uint32_t p2 = mesh.AddVertex(v2, glm::vec3(vt2.x, vt2.y, 0.0f), vn2, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
-					const uint32_t p3 = mesh.AddVertex(v3, glm::vec3(vt3.x, vt3.y, 0.0f), vn3, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+				// The OBJ format can have negative values, which are a reference from the last added attributes
+				if (vertexIndices.x < 0) { vertexIndices.x += (int32_t)positions.size() + 1; }
+				if (vertexIndices.y < 0) { vertexIndices.y += (int32_t)textureCoords.size() + 1; }
+				if (vertexIndices.z < 0) { vertexIndices.z += (int32_t)normals.size() + 1; }
+				if (vertexIndices.x < 1 || vertexIndices.x > (int32_t)positions.size() ||
+					vertexIndices.y < 0 || vertexIndices.y > (int32_t)textureCoords.size() ||
+					vertexIndices.z < 0 || vertexIndices.z > (int32_t)normals.size()) {
+					throw std::runtime_error("Face references an attribute that does not exist");
+				}
 
-					mesh.AddIndexTri(p1, p3, p2);
+				// Corners that share all their attributes share a vertex
+				auto it = vertexMap.find(vertexIndices);
+				if (it != vertexMap.end()) {
+					faceVertices.push_back(it->second);
+				} else {
+					// Our shaders expect the normals to be flipped from how they are exported
+					glm::vec3 normal = vertexIndices.z != 0 ? -normals[vertexIndices.z - 1] : glm::vec3(0.0f, 0.0f, 1.0f);
+					glm::vec2 uv = vertexIndices.y != 0 ? textureCoords[vertexIndices.y - 1] : glm::vec2(0.0f);
+					uint32_t index = mesh.AddVertex(positions[vertexIndices.x - 1], normal, uv, glm::vec4(1.0f));
+					vertexMap[vertexIndices] = index;
+					faceVertices.push_back(index);
 				}
 			}
-			else if (line.substr(0, 2) == "s ")
-			{
-				smoothing = line.substr(2);
+
+			// Polygons are triangulated as a fan around the first corner. We wind them clockwise, since
+			// that is our front face
+			for (size_t ix = 2; ix < faceVertices.size(); ix++) {
+				mesh.AddIndexTri(faceVertices[0], faceVertices[ix], faceVertices[ix - 1]);
 			}
 		}
-	}
+		// Anything else (comments, o, g, usemtl, mtllib, s) doesn't affect the geometry, since
+		// everything is baked into a single draw
 
-	return mesh.Bake();
+		p = SkipLine(p, end);
+	}
 }
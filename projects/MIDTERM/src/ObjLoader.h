@@ -6,9 +6,17 @@
 class ObjLoader
 {
 public:
-	static VertexArrayObject::sptr LoadFromFile(const std::string& filename);
+	/// <summary>
+	/// Loads a mesh from an OBJ file. The first time a file is loaded, a baked binary copy is written
+	/// next to it, later loads will upload straight from that copy as long as the source is unchanged
+	/// </summary>
+	/// <param name="filename">The path to the OBJ file to load</param>
+	/// <param name="useCache">True to read and write the baked copy, false to always parse the source</param>
+	static VertexArrayObject::sptr LoadFromFile(const std::string& filename, bool useCache = true);
 
 protected:
 	ObjLoader() = default;
 	~ObjLoader() = default;
-};
\ No newline at end of file
+
+	static void _ParseObj(const char* data, size_t size, MeshBuilder<VertexPosNormTexCol>& mesh);
+};
@@ -9,6 +9,7 @@ Really simple demo showing off entity creation + model rendering.
 #include "NOU/App.h"
 #include "NOU/Input.h"
 #include "NOU/Entity.h"
+#include "NOU/World.h"
 #include "NOU/CCamera.h"
 #include "NOU/CMeshRenderer.h"
 #include "NOU/Shader.h"
@@ -112,6 +113,22 @@ int main()
 	duckEntity.transform.m_rotation = glm::angleAxis(glm::radians(-30.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 	float duckRotateSpeed = 45.0f;
 
+	//Rather than updating and drawing each entity by hand, we let the world
+	//do it for us with systems. They run in the order we add them, so we
+	//spin the duck first, then update transforms, cameras, and draw.
+	World& world = World::Default();
+	world.AddSystem("Spin duck", [&](World&, float deltaTime)
+	{
+		//Spin the duck.
+		//Always spin the duck.
+		float duckSpin = deltaTime * duckRotateSpeed;
+		duckEntity.transform.m_rotation *= glm::angleAxis(glm::radians(duckSpin), glm::vec3(0.0f, 1.0f, 0.0f));
+	});
+	world.AddDefaultSystems();
+
+	//How long it's been since we last said what the world drew.
+	float statsTimer = 0.0f;
+
 	//Tick right before we enter our main loop (to make sure we don't have a huge
 	//delta time jump during resource loading).
 	App::Tick();
@@ -121,25 +138,19 @@ int main()
 		App::FrameStart();
 		float deltaTime = App::GetDeltaTime();
 
-		//Update camera to get the current VP matrix.
-		camEntity.Get<CCamera>().Update();
-
-		//Spin the duck.
-		//Always spin the duck.
-		float duckSpin = deltaTime * duckRotateSpeed;
-		duckEntity.transform.m_rotation *= glm::angleAxis(glm::radians(duckSpin), glm::vec3(0.0f, 1.0f, 0.0f));
-
-		//Update all our entity transforms (if we move things around,
-		//we need to make sure that our transform matrices are up to date
-		//so that objects will be drawn correctly!)
-		triangleEntity.transform.RecomputeGlobal();
-		duckEntity.transform.RecomputeGlobal();
-		boxEntity.transform.RecomputeGlobal();
-
-		//Draw all our entities.
-		triangleEntity.Get<CMeshRenderer>().Draw();
-		duckEntity.Get<CMeshRenderer>().Draw();
-		boxEntity.Get<CMeshRenderer>().Draw();
+		//Runs all of our systems - this updates every transform
+		//and camera, then draws every entity with a mesh renderer.
+		world.Update(deltaTime);
+
+		//Once a second, report how many meshes were drawn, and how many
+		//were skipped for being outside the camera's view.
+		statsTimer += deltaTime;
+		if (statsTimer >= 1.0f)
+		{
+			const World::RenderStats& stats = world.GetRenderStats();
+			LOG_INFO("Drew {} meshes, culled {}", stats.drawn, stats.culled);
+			statsTimer = 0.0f;
+		}
 
 		//This sticks all the drawing we just did on the screen.
 		App::SwapBuffers();
@@ -0,0 +1,195 @@
+#include "Tests.h"
+#include "TestContext.h"
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "Gameplay/Camera.h"
+#include "Graphics/Shader.h"
+#include "Graphics/UniformBlocks.h"
+#include "Graphics/UniformBuffer.h"
+#include "Graphics/LightClusterGrid.h"
+#include "Utilities/MeshBuilder.h"
+#include "Utilities/MeshFactory.h"
+#include "TTK/GLStateCache.h"
+
+static const int FRAME_WIDTH = 960;
+static const int FRAME_HEIGHT = 540;
+
+/// <summary>
+/// Everything needed to draw the benchmark scene, a large ground plane lit by scattered point lights
+/// </summary>
+struct LightingScene {
+	Shader::sptr            Naive;
+	Shader::sptr            Clustered;
+	VertexArrayObject::sptr Ground;
+	Camera::sptr            MainCamera;
+	LightClusterGrid::sptr  Grid;
+	UniformBuffer::sptr     FrameData;
+	UniformBuffer::sptr     DrawData;
+	UniformBuffer::sptr     InstanceData;
+	FrameUniforms           Frame;
+};
+
+/// <summary>
+/// The result of drawing the scene a few times with one of the shaders
+/// </summary>
+struct LightingResult {
+	double             FrameTimeMs;
+	double             BuildTimeMs;
+	std::vector<float> Image;
+};
+
+// Draws the scene a few times with the given shader, and reads back the last frame
+static LightingResult DrawScene(LightingScene& scene, const Shader::sptr& shader, const std::vector<PointLight>& lights, int frames) {
+	typedef std::chrono::high_resolution_clock Clock;
+	LightingResult result{};
+	shader->Bind();
+
+	auto draw = [&]() {
+		auto buildStart = Clock::now();
+		scene.Grid->Build(lights, scene.MainCamera, FRAME_WIDTH, FRAME_HEIGHT);
+		scene.Grid->FillUniforms(scene.Frame);
+		scene.Grid->Bind();
+		result.BuildTimeMs += std::chrono::duration<double, std::milli>(Clock::now() - buildStart).count();
+
+		scene.FrameData->Update(scene.Frame);
+		scene.FrameData->Bind(FrameUniforms::BINDING);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		scene.Ground->Render();
+	};
+
+	// The first frame pays for any lazy driver work, so we leave it out
+	draw();
+	glFinish();
+	result.BuildTimeMs = 0.0;
+
+	auto start = Clock::now();
+	for (int ix = 0; ix < frames; ix++) {
+		draw();
+	}
+	glFinish();
+	result.FrameTimeMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+	result.BuildTimeMs /= frames;
+
+	result.Image.resize(FRAME_WIDTH * FRAME_HEIGHT * 4);
+	glReadPixels(0, 0, FRAME_WIDTH, FRAME_HEIGHT, GL_RGBA, GL_FLOAT, result.Image.data());
+	return result;
+}
+
+// Draws the same scene with frag_lit's naive light loop and with its clustered light lists, checking that they
+// give the same image and timing both as the number of lights grows
+bool BenchClusteredLighting() {
+	TEST_CHECK(InitTestContext(), "Could not create an OpenGL context");
+
+	Shader::RegisterUniformBlock(FrameUniforms::GetLayout());
+	Shader::RegisterUniformBlock(DrawUniforms::GetLayout());
+	Shader::RegisterUniformBlock(InstanceUniforms::GetLayout());
+
+	LightingScene scene;
+	scene.Naive = Shader::Create();
+	scene.Naive->LoadShaderPartFromFile("shaders/vertex_shader.glsl", GL_VERTEX_SHADER);
+	scene.Naive->LoadShaderPartFromFile("shaders/frag_lit.glsl", GL_FRAGMENT_SHADER, ShaderKeyword::Attenuation);
+	TEST_CHECK(scene.Naive->Link(), "The naive lighting shader failed to link");
+	scene.Clustered = Shader::Create();
+	scene.Clustered->LoadShaderPartFromFile("shaders/vertex_shader.glsl", GL_VERTEX_SHADER);
+	scene.Clustered->LoadShaderPartFromFile("shaders/frag_lit.glsl", GL_FRAGMENT_SHADER, ShaderKeyword::Attenuation | ShaderKeyword::Clustered);
+	TEST_CHECK(scene.Clustered->Link(), "The clustered lighting shader failed to link");
+
+	// We render into our own float framebuffer, so the images can be compared exactly
+	GLuint framebuffer, color, depth;
+	glCreateFramebuffers(1, &framebuffer);
+	glCreateRenderbuffers(1, &color);
+	glNamedRenderbufferStorage(color, GL_RGBA32F, FRAME_WIDTH, FRAME_HEIGHT);
+	glCreateRenderbuffers(1, &depth);
+	glNamedRenderbufferStorage(depth, GL_DEPTH_COMPONENT24, FRAME_WIDTH, FRAME_HEIGHT);
+	glNamedFramebufferRenderbuffer(framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+	glNamedFramebufferRenderbuffer(framebuffer, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, FRAME_WIDTH, FRAME_HEIGHT);
+	TTK::GLStateCache::Instance().SetEnabled(GL_DEPTH_TEST, true);
+
+	MeshBuilder<VertexPosNormTexCol> ground;
+	MeshFactory::AddPlane(ground, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(100.0f));
+	scene.Ground = ground.Bake();
+
+	scene.MainCamera = Camera::Create();
+	scene.MainCamera->SetPosition(glm::vec3(0.0f, -30.0f, 14.0f));
+	scene.MainCamera->SetUp(glm::vec3(0.0f, 0.0f, 1.0f));
+	scene.MainCamera->LookAt(glm::vec3(0.0f, 10.0f, 0.0f));
+	scene.MainCamera->SetFovDegrees(70.0f);
+	scene.MainCamera->ResizeWindow(FRAME_WIDTH, FRAME_HEIGHT);
+	scene.Grid = LightClusterGrid::Create();
+
+	scene.Frame = FrameUniforms();
+	scene.Frame.AmbientStrength = 0.1f;
+	scene.Frame.AmbientCol = glm::vec3(1.0f);
+	scene.Frame.SpecularLightStrength = 1.0f;
+	scene.Frame.LightAttenuationConstant = 1.0f;
+	scene.Frame.LightAttenuationLinear = 0.09f;
+	scene.Frame.LightAttenuationQuadratic = 0.032f;
+
+	DrawUniforms draw = DrawUniforms();
+	draw.PositionScale = glm::vec3(1.0f);
+	draw.Shininess = 16.0f;
+	scene.DrawData = UniformBuffer::Create();
+	scene.DrawData->Update(draw);
+	scene.DrawData->Bind(DrawUniforms::BINDING);
+	scene.InstanceData = UniformBuffer::Create();
+	scene.FrameData = UniformBuffer::Create();
+
+	// Every light count is drawn in perspective, and the largest again with the orthographic camera
+	struct Run { size_t Lights; bool Ortho; };
+	const Run runs[] = { { 1, false }, { 16, false }, { 256, false }, { 1024, false }, { 256, true } };
+	for (const Run& run : runs) {
+		scene.MainCamera->SetIsOrtho(run.Ortho);
+		if (run.Ortho) {
+			scene.MainCamera->SetOrthoHeight(25.0f);
+		}
+		scene.Frame.View = scene.MainCamera->GetView();
+		scene.Frame.CamPos = scene.MainCamera->GetPosition();
+
+		InstanceUniforms instance = InstanceUniforms();
+		instance.ModelViewProjection[0] = scene.MainCamera->GetViewProjection();
+		instance.Model[0] = glm::mat4(1.0f);
+		instance.NormalMatrix[0] = glm::mat3x4(glm::mat3(1.0f));
+		scene.InstanceData->Update(instance);
+		scene.InstanceData->Bind(InstanceUniforms::BINDING);
+
+		// Lights of radius 8 scattered just above the ground, the same ones every run
+		std::mt19937 random(42);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::vector<PointLight> lights;
+		for (size_t ix = 0; ix < run.Lights; ix++) {
+			glm::vec3 position = glm::vec3(-50.0f + 100.0f * unit(random), -50.0f + 100.0f * unit(random), 0.5f + 2.0f * unit(random));
+			glm::vec3 lightColor = glm::vec3(unit(random), unit(random), unit(random));
+			lights.push_back({ position, 8.0f, lightColor, 0.05f });
+		}
+
+		// The naive shader gets slow quickly, so we draw fewer frames as the light count grows
+		int frames = run.Lights >= 256 ? 3 : 10;
+		LightingResult naive = DrawScene(scene, scene.Naive, lights, frames);
+		LightingResult clustered = DrawScene(scene, scene.Clustered, lights, frames);
+
+		// Matching images don't tell us much if nothing got drawn, so we also make sure the lights reached the ground
+		float maxDifference = 0.0f, brightest = 0.0f;
+		for (size_t ix = 0; ix < naive.Image.size(); ix++) {
+			maxDifference = glm::max(maxDifference, glm::abs(naive.Image[ix] - clustered.Image[ix]));
+			brightest = glm::max(brightest, clustered.Image[ix]);
+		}
+
+		const LightClusterGrid::Stats& stats = scene.Grid->GetStats();
+		LOG_INFO("  {:4} lights{}: naive {:8.2f}ms, clustered {:8.2f}ms, build {:.3f}ms, {} light indices (at most {} per cluster), max difference {}",
+			run.Lights, run.Ortho ? " (ortho)" : "", naive.FrameTimeMs, clustered.FrameTimeMs, clustered.BuildTimeMs,
+			stats.LightIndices, stats.MaxLightsPerCluster, maxDifference);
+		TEST_CHECK(brightest > 0.1f, "Nothing was lit with {} lights", run.Lights);
+		TEST_CHECK(maxDifference <= 1e-5f, "Clustered lighting differs from naive lighting by {} with {} lights", maxDifference, run.Lights);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &color);
+	glDeleteRenderbuffers(1, &depth);
+	return true;
+}
@@ -0,0 +1,94 @@
+#include "Tests.h"
+
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+#include "Graphics/Texture2DData.h"
+
+// Makes an image full of random unsigned bytes
+static Texture2DData::sptr MakeNoiseImage(uint32_t width, uint32_t height, PixelFormat format, uint32_t seed) {
+	std::mt19937 random(seed);
+	std::vector<uint8_t> pixels(width * (size_t)height * GetTexelComponentCount(format));
+	for (uint8_t& value : pixels) {
+		value = static_cast<uint8_t>(random());
+	}
+	return std::make_shared<Texture2DData>(width, height, format, PixelType::UByte, pixels.data());
+}
+
+// Builds the next mip level one texel at a time, the plain way Texture2DData::Downsample is meant to behave
+static std::vector<uint8_t> DownsampleReference(const uint8_t* src, uint32_t width, uint32_t height, uint32_t components) {
+	const uint32_t dstWidth = std::max(width >> 1, 1u);
+	const uint32_t dstHeight = std::max(height >> 1, 1u);
+	std::vector<uint8_t> result(dstWidth * (size_t)dstHeight * components);
+	for (uint32_t y = 0; y < dstHeight; y++) {
+		const uint32_t y0 = y * 2, y1 = std::min(y * 2 + 1, height - 1);
+		for (uint32_t x = 0; x < dstWidth; x++) {
+			const uint32_t x0 = x * 2, x1 = std::min(x * 2 + 1, width - 1);
+			for (uint32_t c = 0; c < components; c++) {
+				uint32_t sum =
+					src[(y0 * (size_t)width + x0) * components + c] + src[(y0 * (size_t)width + x1) * components + c] +
+					src[(y1 * (size_t)width + x0) * components + c] + src[(y1 * (size_t)width + x1) * components + c];
+				result[(y * (size_t)dstWidth + x) * components + c] = static_cast<uint8_t>((sum + 2) / 4);
+			}
+		}
+	}
+	return result;
+}
+
+// Checks the (SSE accelerated) CPU mip chain against a scalar box filter, level by level, on images with odd sizes
+// and every component count. Then it times building a full chain for a large texture
+bool TestMipChain() {
+	struct Case { uint32_t Width; uint32_t Height; PixelFormat Format; };
+	const Case cases[] = {
+		{ 256, 256, PixelFormat::RGBA },
+		{ 257, 131, PixelFormat::RGBA },
+		{ 3,   1,   PixelFormat::RGBA },
+		{ 100, 61,  PixelFormat::RGB },
+		{ 1,   37,  PixelFormat::RG },
+		{ 300, 1,   PixelFormat::Red },
+	};
+	uint32_t seed = 1;
+	for (const Case& test : cases) {
+		Texture2DData::sptr base = MakeNoiseImage(test.Width, test.Height, test.Format, seed++);
+		std::vector<Texture2DData::sptr> chain = Texture2DData::GenerateMipChain(base);
+
+		uint32_t expectedLevels = 1;
+		for (uint32_t size = std::max(test.Width, test.Height); size > 1; size >>= 1) {
+			expectedLevels++;
+		}
+		TEST_CHECK(chain.size() == expectedLevels, "A {}x{} image got {} levels, expected {}", test.Width, test.Height, chain.size(), expectedLevels);
+
+		const uint32_t components = static_cast<uint32_t>(GetTexelComponentCount(test.Format));
+		for (size_t level = 1; level < chain.size(); level++) {
+			const Texture2DData& above = *chain[level - 1];
+			const Texture2DData& actual = *chain[level];
+			std::vector<uint8_t> expected = DownsampleReference(static_cast<const uint8_t*>(above.GetDataPtr()), above.GetWidth(), above.GetHeight(), components);
+			TEST_CHECK(actual.GetWidth() == std::max(above.GetWidth() >> 1, 1u) && actual.GetHeight() == std::max(above.GetHeight() >> 1, 1u),
+				"Level {} of a {}x{} image is {}x{}", level, test.Width, test.Height, actual.GetWidth(), actual.GetHeight());
+			TEST_CHECK(actual.GetDataSize() == expected.size() && memcmp(actual.GetDataPtr(), expected.data(), expected.size()) == 0,
+				"Level {} of a {}x{} {} image does not match the scalar box filter", level, test.Width, test.Height, test.Format);
+		}
+	}
+
+	// A partial chain stops at the requested number of levels
+	TEST_CHECK(Texture2DData::GenerateMipChain(MakeNoiseImage(64, 64, PixelFormat::RGBA, 99), 3).size() == 3, "Asking for 3 levels gave a different number");
+
+	typedef std::chrono::high_resolution_clock Clock;
+	Texture2DData::sptr large = MakeNoiseImage(2048, 2048, PixelFormat::RGBA, 7);
+	auto start = Clock::now();
+	std::vector<Texture2DData::sptr> chain = Texture2DData::GenerateMipChain(large);
+	std::chrono::duration<double, std::milli> chainTime = Clock::now() - start;
+
+	start = Clock::now();
+	std::vector<uint8_t> level = DownsampleReference(static_cast<const uint8_t*>(large->GetDataPtr()), 2048, 2048, 4);
+	for (uint32_t size = 1024; size > 1; size >>= 1) {
+		level = DownsampleReference(level.data(), size, size, 4);
+	}
+	std::chrono::duration<double, std::milli> referenceTime = Clock::now() - start;
+
+	LOG_INFO("  Full chain for 2048x2048 RGBA: {:.2f}ms, scalar reference {:.2f}ms ({} levels)", chainTime.count(), referenceTime.count(), chain.size());
+	return true;
+}
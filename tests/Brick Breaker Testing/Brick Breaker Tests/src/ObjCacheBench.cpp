@@ -0,0 +1,62 @@
+#include "Tests.h"
+#include "TestContext.h"
+#include "ObjTestUtils.h"
+
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+
+#include "Utilities/MeshCache.h"
+
+static const char* BENCH_OBJ = "obj_cache_bench.obj";
+
+bool BenchObjCache() {
+	typedef std::chrono::high_resolution_clock Clock;
+	TEST_CHECK(InitTestContext(), "Could not create an OpenGL context");
+
+	// Write out a mesh that is big enough for the startup cost to matter
+	std::string data = MakeGridObj(512);
+	{
+		std::ofstream file(BENCH_OBJ, std::ios::binary | std::ios::trunc);
+		file.write(data.data(), data.size());
+		TEST_CHECK(file.good(), "Failed to write {}", BENCH_OBJ);
+	}
+	std::string cachePath = MeshCache::GetCachePath(BENCH_OBJ);
+	std::error_code error;
+	std::filesystem::remove(cachePath, error);
+
+	// A cold start parses the source and writes the baked copy
+	auto start = Clock::now();
+	VertexArrayObject::sptr cold = ObjLoader::LoadFromFile(BENCH_OBJ);
+	std::chrono::duration<double, std::milli> coldTime = Clock::now() - start;
+	TEST_CHECK(std::filesystem::exists(cachePath), "Loading {} did not write a baked copy", BENCH_OBJ);
+
+	// Every warm start after that maps the baked copy, we take the best of a few since the first
+	// one may still be waiting on the disk
+	const int WARM_LOADS = 5;
+	VertexArrayObject::sptr warm;
+	double warmTime = INFINITY;
+	for (int ix = 0; ix < WARM_LOADS; ix++) {
+		start = Clock::now();
+		warm = ObjLoader::LoadFromFile(BENCH_OBJ);
+		warmTime = std::min(warmTime, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+	}
+
+	// Without the cache at all, for comparison
+	start = Clock::now();
+	VertexArrayObject::sptr uncached = ObjLoader::LoadFromFile(BENCH_OBJ, glm::vec4(1.0f), false);
+	std::chrono::duration<double, std::milli> uncachedTime = Clock::now() - start;
+
+	const MeshBounds& coldBounds = cold->GetBounds();
+	const MeshBounds& warmBounds = warm->GetBounds();
+	TEST_CHECK(coldBounds.Min == warmBounds.Min && coldBounds.Max == warmBounds.Max, "The baked copy has different bounds than the source");
+
+	LOG_INFO("  {:.1f}MB: no cache {:.2f}ms, cold {:.2f}ms, warm {:.2f}ms ({:.1f}x faster than no cache)", data.size() / (1024.0 * 1024.0),
+		uncachedTime.count(), coldTime.count(), warmTime, uncachedTime.count() / warmTime);
+
+	std::filesystem::remove(BENCH_OBJ, error);
+	std::filesystem::remove(cachePath, error);
+	return true;
+}
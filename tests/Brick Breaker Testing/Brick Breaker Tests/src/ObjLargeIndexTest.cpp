@@ -0,0 +1,99 @@
+#include "Tests.h"
+#include "ObjTestUtils.h"
+
+#include <chrono>
+#include <unordered_map>
+
+#include "Utilities/VertexIndexMap.h"
+
+// The old dedup key packed each attribute index into 21 bits, so meshes with more than 2,097,150 positions had
+// different corners collide and silently pick up the wrong vertices. This parses a triangle strip that goes past
+// that limit, and checks that every corner still ends up with its own position
+bool TestObjLargeIndices() {
+	typedef std::chrono::high_resolution_clock Clock;
+	const size_t positionCount = 2300000;
+
+	// Each position stores its own (1 based) index in x, which floats can hold exactly at this size
+	std::string data;
+	data.reserve(positionCount * 48);
+	char line[64];
+	for (size_t ix = 1; ix <= positionCount; ix++) {
+		snprintf(line, sizeof(line), "v %zu 0 0\n", ix);
+		data += line;
+	}
+	for (size_t ix = 1; ix + 2 <= positionCount; ix++) {
+		snprintf(line, sizeof(line), "f %zu %zu %zu\n", ix, ix + 1, ix + 2);
+		data += line;
+	}
+
+	const size_t threadCounts[] = { 1, 4, 16 };
+	for (size_t threadCount : threadCounts) {
+		MeshBuilder<VertexPosNormTexCol> mesh;
+		auto start = Clock::now();
+		ObjParser::Parse(data, mesh, threadCount);
+		std::chrono::duration<double, std::milli> parseTime = Clock::now() - start;
+
+		TEST_CHECK(mesh.GetVertexCount() == positionCount, "Expected {} vertices on {} threads, got {}", positionCount, threadCount, mesh.GetVertexCount());
+		TEST_CHECK(mesh.GetTriangleCount() == positionCount - 2, "Expected {} triangles on {} threads, got {}", positionCount - 2, threadCount, mesh.GetTriangleCount());
+
+		const VertexPosNormTexCol* vertices = mesh.GetVertexDataPtr();
+		const uint32_t* indices = mesh.GetIndexDataPtr();
+		size_t wrong = 0;
+		for (size_t ix = 0; ix < mesh.GetIndexCount(); ix++) {
+			// Triangle t uses positions t + 1, t + 2 and t + 3
+			float expected = (float)(ix / 3 + ix % 3 + 1);
+			wrong += vertices[indices[ix]].Position.x != expected ? 1 : 0;
+		}
+		TEST_CHECK(wrong == 0, "{} of {} corners point at the wrong position on {} threads", wrong, mesh.GetIndexCount(), threadCount);
+		LOG_INFO("  {} threads: {} vertices in {:.1f}ms, every corner correct", threadCount, mesh.GetVertexCount(), parseTime.count());
+	}
+	return true;
+}
+
+// Times the dedup map against the unordered_map with packed 21 bit keys that it replaced, on the corners of a
+// grid with about 5M unique vertices (each of which is used by up to 4 quads). The old keys collide at this size,
+// so only its timing is worth looking at
+bool BenchVertexIndexMap() {
+	typedef std::chrono::high_resolution_clock Clock;
+	const size_t size = 2250, side = size + 1;
+
+	std::vector<glm::ivec3> corners;
+	corners.reserve(size * size * 4);
+	for (size_t y = 0; y < size; y++) {
+		for (size_t x = 0; x < size; x++) {
+			int32_t a = (int32_t)(y * side + x + 1), b = a + 1, c = b + (int32_t)side, d = a + (int32_t)side;
+			corners.emplace_back(a, a, a);
+			corners.emplace_back(b, b, b);
+			corners.emplace_back(c, c, c);
+			corners.emplace_back(d, d, d);
+		}
+	}
+
+	auto start = Clock::now();
+	std::unordered_map<uint64_t, uint32_t> oldMap;
+	uint32_t oldCount = 0;
+	for (const glm::ivec3& corner : corners) {
+		const uint64_t mask = 0b111111111111111111111;
+		uint64_t key = ((corner.x & mask) << 42) | ((corner.y & mask) << 21) | (corner.z & mask);
+		if (oldMap.emplace(key, oldCount).second) {
+			oldCount++;
+		}
+	}
+	std::chrono::duration<double, std::milli> oldTime = Clock::now() - start;
+
+	// Like the loader, we size the map from the number of positions
+	start = Clock::now();
+	VertexIndexMap map(side * side * 3 / 2);
+	uint32_t count = 0;
+	for (const glm::ivec3& corner : corners) {
+		if (map.FindOrInsert(corner, count) == count) {
+			count++;
+		}
+	}
+	std::chrono::duration<double, std::milli> mapTime = Clock::now() - start;
+
+	TEST_CHECK(count == side * side && map.GetCount() == count, "Expected {} unique vertices, got {}", side * side, count);
+	LOG_INFO("  {} corners, {} unique: unordered_map {:.1f}ms, VertexIndexMap {:.1f}ms ({:.1f}x)", corners.size(), count,
+		oldTime.count(), mapTime.count(), oldTime.count() / mapTime.count());
+	return true;
+}
@@ -0,0 +1,38 @@
+#include "Tests.h"
+#include "ObjTestUtils.h"
+
+#include <chrono>
+
+// Checks that parsing on more threads gives exactly the same mesh as parsing on one, and reports how the
+// parse time scales. The timings only mean something on a machine with that many cores
+bool BenchObjParallel() {
+	typedef std::chrono::high_resolution_clock Clock;
+
+	// A large grid, plus the records that are hardest to split across chunks: faces with no UVs, and an
+	// n-gon using negative indices, which point back into attributes that were parsed in earlier chunks
+	std::string data = MakeGridObj(512);
+	data += "f 1//1 2//2 3//3\n";
+	data += "f -1//-1 -2//-2 -3//-3 -4//-4 -5//-5\n";
+	data += "vn 0 0 1\n";
+	data += "f -7/-7/-1 -8/-8/-1 -9/-9/-1\n";
+	double sizeMb = data.size() / (1024.0 * 1024.0);
+
+	MeshBuilder<VertexPosNormTexCol> expected;
+	auto start = Clock::now();
+	ObjParser::Parse(data, expected, 1);
+	std::chrono::duration<double, std::milli> serialTime = Clock::now() - start;
+	LOG_INFO("  {:.1f}MB, {} vertices, {} triangles: 1 thread {:.1f}ms", sizeMb, expected.GetVertexCount(), expected.GetTriangleCount(), serialTime.count());
+
+	const size_t threadCounts[] = { 2, 4, 8, 16 };
+	for (size_t threadCount : threadCounts) {
+		MeshBuilder<VertexPosNormTexCol> actual;
+		start = Clock::now();
+		ObjParser::Parse(data, actual, threadCount);
+		std::chrono::duration<double, std::milli> parseTime = Clock::now() - start;
+
+		TEST_CHECK(IsSameMesh(expected, actual), "Parsing on {} threads gave a different mesh than parsing on 1", threadCount);
+		LOG_INFO("  {} threads {:.1f}ms ({:.2f}x)", threadCount, parseTime.count(), serialTime.count() / parseTime.count());
+	}
+
+	return true;
+}
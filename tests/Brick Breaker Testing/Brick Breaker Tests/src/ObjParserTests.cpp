@@ -0,0 +1,194 @@
+#include "Tests.h"
+#include "ObjTestUtils.h"
+
+#include <sstream>
+#include <fstream>
+#include <chrono>
+#include <unordered_map>
+#include <stdexcept>
+
+#include "Utilities/StringUtils.h"
+
+std::string MakeGridObj(size_t size) {
+	std::string result;
+	char line[128];
+	const size_t side = size + 1;
+	for (size_t y = 0; y < side; y++) {
+		for (size_t x = 0; x < side; x++) {
+			snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", x / (float)size - 0.5f, y / (float)size - 0.5f, 0.01f * ((x * 7 + y * 13) % 17));
+			result += line;
+		}
+	}
+	for (size_t y = 0; y < side; y++) {
+		for (size_t x = 0; x < side; x++) {
+			snprintf(line, sizeof(line), "vt %.6f %.6f\n", x / (float)size, y / (float)size);
+			result += line;
+		}
+	}
+	for (size_t y = 0; y < side; y++) {
+		for (size_t x = 0; x < side; x++) {
+			snprintf(line, sizeof(line), "vn %.4f %.4f %.4f\n", 0.1f * ((x % 5) - 2.0f), 0.1f * ((y % 5) - 2.0f), 0.9f);
+			result += line;
+		}
+	}
+	for (size_t y = 0; y < size; y++) {
+		for (size_t x = 0; x < size; x++) {
+			size_t a = y * side + x + 1, b = a + 1, c = b + side, d = a + side;
+			snprintf(line, sizeof(line), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, a, b, b, b, c, c, c, d, d, d);
+			result += line;
+		}
+	}
+	return result;
+}
+
+std::string ReadTextFile(const std::string& filename) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open " + filename);
+	}
+	std::stringstream stream;
+	stream << file.rdbuf();
+	return stream.str();
+}
+
+// The parser the loader used before it moved to from_chars, kept as-is so that the new one has something to
+// be compared against. It only handles triangles and quads using v/vt/vn corners, and its negative index
+// handling is off by two, so the meshes we compare on stick to what it gets right
+static void ParseObjReference(std::istream& file, MeshBuilder<VertexPosNormTexCol>& mesh) {
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> textureCoords;
+	std::unordered_map<uint64_t, uint32_t> indexMap;
+
+	glm::vec3 temp;
+	glm::ivec3 vertexIndices;
+	while (file.peek() != EOF) {
+		std::string command;
+		file >> command;
+
+		if (command == "v") {
+			file >> temp.x >> temp.y >> temp.z;
+			positions.push_back(temp);
+		}
+		else if (command == "vn") {
+			file >> temp.x >> temp.y >> temp.z;
+			normals.push_back(temp);
+		}
+		else if (command == "vt") {
+			file >> temp.x >> temp.y;
+			textureCoords.push_back(temp);
+		}
+		else if (command == "f") {
+			std::string line;
+			std::getline(file, line);
+			trim(line);
+			std::stringstream stream = std::stringstream(line);
+
+			uint32_t edges[4];
+			int ix = 0;
+			for (; ix < 4; ix++) {
+				if (stream.peek() != EOF) {
+					char tempChar;
+					vertexIndices = glm::ivec3(0);
+					stream >> vertexIndices.x >> tempChar >> vertexIndices.y >> tempChar >> vertexIndices.z;
+
+					if (vertexIndices.x < 0) { vertexIndices.x = positions.size() - 1 + vertexIndices.x; }
+					if (vertexIndices.y < 0) { vertexIndices.y = textureCoords.size() - 1 + vertexIndices.y; }
+					if (vertexIndices.z < 0) { vertexIndices.z = normals.size() - 1 + vertexIndices.z; }
+
+					const uint64_t mask = 0b0'000000000000000000000'000000000000000000000'111111111111111111111;
+					uint64_t key = ((vertexIndices.x & mask) << 42) | ((vertexIndices.y & mask) << 21) | (vertexIndices.z & mask);
+
+					auto it = indexMap.find(key);
+					if (it != indexMap.end()) {
+						edges[ix] = it->second;
+					}
+					else {
+						VertexPosNormTexCol vertex;
+						vertex.Position = positions[vertexIndices.x - 1];
+						vertex.UV = vertexIndices.y != 0 ? textureCoords[vertexIndices.y - 1] : glm::vec2(0.0f);
+						vertex.Normal = vertexIndices.z != 0 ? normals[vertexIndices.z - 1] : glm::vec3(0.0f, 0.0f, 1.0f);
+						vertex.Color = glm::vec4(1.0f);
+
+						uint32_t index = mesh.AddVertex(vertex);
+						indexMap[key] = index;
+						edges[ix] = index;
+					}
+				} else {
+					break;
+				}
+			}
+			if (ix == 3) {
+				mesh.AddIndexTri(edges[0], edges[1], edges[2]);
+			}
+			else if (ix == 4) {
+				mesh.AddIndexTri(edges[0], edges[1], edges[2]);
+				mesh.AddIndexTri(edges[0], edges[2], edges[3]);
+			}
+		}
+	}
+}
+
+// Checks that the parser gives exactly the same mesh as the old one did, for every mesh the game ships with
+bool TestObjParser() {
+	const char* files[] = { "Player.obj", "ball.obj", "wall.obj", "models/monkey.obj", "models/monkey_quads.obj" };
+	for (const char* filename : files) {
+		std::string data = ReadTextFile(filename);
+
+		MeshBuilder<VertexPosNormTexCol> expected;
+		std::stringstream stream(data);
+		ParseObjReference(stream, expected);
+
+		MeshBuilder<VertexPosNormTexCol> actual;
+		ObjParser::Parse(data, actual, 1);
+		TEST_CHECK(IsSameMesh(expected, actual), "\"{}\" parsed differently ({} vertices, {} indices, expected {} and {})", filename,
+			actual.GetVertexCount(), actual.GetIndexCount(), expected.GetVertexCount(), expected.GetIndexCount());
+		LOG_INFO("  {}: {} vertices, {} triangles match", filename, actual.GetVertexCount(), actual.GetTriangleCount());
+	}
+
+	// The parser also takes polygons with more than 4 corners, which the old one cut off
+	MeshBuilder<VertexPosNormTexCol> polygon;
+	ObjParser::Parse("v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0.5 1.5 0\nv 0 1 0\nf 1 2 3 4 5\n", polygon, 1);
+	TEST_CHECK(polygon.GetVertexCount() == 5 && polygon.GetTriangleCount() == 3, "A pentagon should become 3 triangles, got {}", polygon.GetTriangleCount());
+
+	// As well as negative indices, which count back from the last attribute (-1 is the one just added)
+	MeshBuilder<VertexPosNormTexCol> relative;
+	ObjParser::Parse("v 0 0 0\nv 1 0 0\nv 1 1 0\nf -3 -2 -1\n", relative, 1);
+	TEST_CHECK(relative.GetVertexCount() == 3 && relative.GetVertexDataPtr()[2].Position == glm::vec3(1.0f, 1.0f, 0.0f),
+		"Negative indices did not resolve to the right positions");
+
+	// And faces that point past the attributes we have should be rejected rather than read out of bounds
+	bool threw = false;
+	try {
+		MeshBuilder<VertexPosNormTexCol> broken;
+		ObjParser::Parse("v 0 0 0\nv 1 0 0\nf 1 2 3\n", broken, 1);
+	}
+	catch (const std::runtime_error&) {
+		threw = true;
+	}
+	TEST_CHECK(threw, "A face referencing a missing position should throw");
+	return true;
+}
+
+// Compares how fast the old and new parsers get through a large file, on one thread so that it's just the tokenizer
+bool BenchObjParser() {
+	typedef std::chrono::high_resolution_clock Clock;
+	std::string data = MakeGridObj(512);
+	double sizeMb = data.size() / (1024.0 * 1024.0);
+
+	auto start = Clock::now();
+	MeshBuilder<VertexPosNormTexCol> expected;
+	std::stringstream stream(data);
+	ParseObjReference(stream, expected);
+	std::chrono::duration<double> referenceTime = Clock::now() - start;
+
+	start = Clock::now();
+	MeshBuilder<VertexPosNormTexCol> actual;
+	ObjParser::Parse(data, actual, 1);
+	std::chrono::duration<double> parseTime = Clock::now() - start;
+
+	TEST_CHECK(IsSameMesh(expected, actual), "The parsers disagree on the benchmark mesh");
+	LOG_INFO("  {:.1f}MB, {} vertices: old parser {:.1f}MB/s, new parser {:.1f}MB/s ({:.1f}x)", sizeMb, actual.GetVertexCount(),
+		sizeMb / referenceTime.count(), sizeMb / parseTime.count(), referenceTime.count() / parseTime.count());
+	return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <cstring>
+#include "Utilities/ObjLoader.h"
+
+/// <summary>
+/// Gives the tests direct access to the OBJ parser, without going through the mesh cache or the GPU
+/// </summary>
+class ObjParser : public ObjLoader
+{
+public:
+	/// <summary>
+	/// Parses an OBJ file that has already been loaded into memory
+	/// </summary>
+	/// <param name="data">The contents of the OBJ file</param>
+	/// <param name="mesh">The mesh to add the parsed geometry to</param>
+	/// <param name="threadCount">The number of threads to parse on, or 0 to use one per hardware thread</param>
+	static void Parse(const std::string& data, MeshBuilder<VertexPosNormTexCol>& mesh, size_t threadCount = 0) {
+		SetThreadCount(threadCount);
+		if (_threadPool == nullptr) {
+			_threadPool = ThreadPool::Create(_threadCount);
+		}
+		_ParseObj(data.data(), data.size(), glm::vec4(1.0f), mesh);
+	}
+};
+
+/// <summary>
+/// Builds an OBJ file in memory, for tests that need more data than the meshes in res. The grid is made
+/// of quads with a position, UV and normal per corner, and each attribute is shared by every quad that touches it
+/// </summary>
+/// <param name="size">The number of quads along each side of the grid</param>
+std::string MakeGridObj(size_t size);
+
+/// <summary>
+/// Reads a whole file into memory, throwing if it can't be opened
+/// </summary>
+std::string ReadTextFile(const std::string& filename);
+
+/// <summary>
+/// Returns true if two meshes have exactly the same vertices and indices, down to the byte
+/// </summary>
+template <typename VertType>
+bool IsSameMesh(const MeshBuilder<VertType>& a, const MeshBuilder<VertType>& b) {
+	return a.GetVertexCount() == b.GetVertexCount() && a.GetIndexCount() == b.GetIndexCount() &&
+		memcmp(a.GetVertexDataPtr(), b.GetVertexDataPtr(), a.GetVertexCount() * sizeof(VertType)) == 0 &&
+		memcmp(a.GetIndexDataPtr(), b.GetIndexDataPtr(), a.GetIndexCount() * sizeof(uint32_t)) == 0;
+}
@@ -0,0 +1,87 @@
+#include "Tests.h"
+#include "ObjTestUtils.h"
+
+#include <cfloat>
+
+/// <summary>
+/// The worst error seen while round-tripping vertices through one of the packed formats
+/// </summary>
+struct PackingError {
+	float NormalDegrees = 0.0f;
+	float UV = 0.0f;
+	float Color = 0.0f;
+	// Relative to the size of the mesh
+	float Position = 0.0f;
+};
+
+// The angle between two unit vectors, in degrees
+static float AngleBetween(const glm::vec3& a, const glm::vec3& b) {
+	return glm::degrees(acosf(glm::clamp(glm::dot(a, b), -1.0f, 1.0f)));
+}
+
+// Decodes the packed attributes the same way the GPU and vertex_shader.glsl do, and records how far they drifted
+template <typename PackedType>
+static void MeasurePacking(const PackedType& packed, const VertexPosNormTexCol& vertex, const glm::vec3& position, float extent, PackingError& error) {
+	glm::vec3 normal = OctDecode(glm::unpackSnorm2x16(packed.Normal));
+	error.NormalDegrees = glm::max(error.NormalDegrees, AngleBetween(normal, glm::normalize(vertex.Normal)));
+	glm::vec2 uv = glm::unpackHalf2x16(packed.UV);
+	error.UV = glm::max(error.UV, glm::max(glm::abs(uv.x - vertex.UV.x), glm::abs(uv.y - vertex.UV.y)));
+	glm::vec4 color = glm::unpackUnorm4x8(packed.Color);
+	glm::vec4 colorError = glm::abs(color - vertex.Color);
+	error.Color = glm::max(error.Color, glm::max(glm::max(colorError.x, colorError.y), glm::max(colorError.z, colorError.w)));
+	glm::vec3 positionError = glm::abs(position - vertex.Position) / extent;
+	error.Position = glm::max(error.Position, glm::max(positionError.x, glm::max(positionError.y, positionError.z)));
+}
+
+// Checks how much precision the packed vertex formats lose, on every mesh the game ships with
+bool TestPackedVertices() {
+	const char* files[] = { "Player.obj", "ball.obj", "wall.obj", "models/monkey.obj", "models/monkey_quads.obj" };
+	PackingError packedError, quantizedError;
+	for (const char* filename : files) {
+		MeshBuilder<VertexPosNormTexCol> mesh;
+		ObjParser::Parse(ReadTextFile(filename), mesh, 1);
+
+		// Give every vertex a different color, so that we test more than the default white
+		std::vector<VertexPosNormTexCol> vertices(mesh.GetVertexDataPtr(), mesh.GetVertexDataPtr() + mesh.GetVertexCount());
+		glm::vec3 boundsMin = glm::vec3(FLT_MAX), boundsMax = glm::vec3(-FLT_MAX);
+		for (size_t ix = 0; ix < vertices.size(); ix++) {
+			vertices[ix].Color = glm::vec4((ix % 7) / 6.0f, (ix % 11) / 10.0f, (ix % 13) / 12.0f, 1.0f - (ix % 3) / 3.0f);
+			boundsMin = glm::min(boundsMin, vertices[ix].Position);
+			boundsMax = glm::max(boundsMax, vertices[ix].Position);
+		}
+		float extent = glm::max(boundsMax.x - boundsMin.x, glm::max(boundsMax.y - boundsMin.y, boundsMax.z - boundsMin.z));
+
+		VertexDecodeInfo packedDecode = VertexPosNormTexColPacked::GetDecodeInfo(boundsMin, boundsMax);
+		VertexDecodeInfo quantizedDecode = VertexPosNormTexColQuantized::GetDecodeInfo(boundsMin, boundsMax);
+		for (const VertexPosNormTexCol& vertex : vertices) {
+			VertexPosNormTexColPacked packed = VertexPosNormTexColPacked::Pack(vertex, packedDecode);
+			MeasurePacking(packed, vertex, packed.Position, extent, packedError);
+
+			VertexPosNormTexColQuantized quantized = VertexPosNormTexColQuantized::Pack(vertex, quantizedDecode);
+			glm::vec3 local = glm::max(glm::vec3(quantized.Position) / 32767.0f, glm::vec3(-1.0f));
+			MeasurePacking(quantized, vertex, local * quantizedDecode.PositionScale + quantizedDecode.PositionOffset, extent, quantizedError);
+		}
+	}
+
+	// A dense sweep over the sphere, for the normals our meshes don't happen to have
+	for (int y = 0; y <= 180; y++) {
+		for (int x = 0; x < 360; x++) {
+			float pitch = glm::radians(y - 90.0f), yaw = glm::radians((float)x);
+			glm::vec3 normal = glm::vec3(cosf(pitch) * cosf(yaw), cosf(pitch) * sinf(yaw), sinf(pitch));
+			glm::vec3 decoded = OctDecode(glm::unpackSnorm2x16(glm::packSnorm2x16(OctEncode(normal))));
+			packedError.NormalDegrees = glm::max(packedError.NormalDegrees, AngleBetween(decoded, normal));
+		}
+	}
+
+	LOG_INFO("  Packed:    normal {:.4f} deg, UV {:.2e}, color {:.2e}, position {:.2e}", packedError.NormalDegrees, packedError.UV, packedError.Color, packedError.Position);
+	LOG_INFO("  Quantized: normal {:.4f} deg, UV {:.2e}, color {:.2e}, position {:.2e}", quantizedError.NormalDegrees, quantizedError.UV, quantizedError.Color, quantizedError.Position);
+
+	for (const PackingError& error : { packedError, quantizedError }) {
+		TEST_CHECK(error.NormalDegrees < 0.05f, "Normals are off by up to {} degrees", error.NormalDegrees);
+		TEST_CHECK(error.UV < 1e-3f, "UVs are off by up to {}", error.UV);
+		TEST_CHECK(error.Color <= 0.5f / 255.0f + 1e-6f, "Colors are off by up to {}", error.Color);
+	}
+	TEST_CHECK(packedError.Position == 0.0f, "The packed format should keep full precision positions");
+	TEST_CHECK(quantizedError.Position < 2e-5f, "Quantized positions are off by up to {} of the mesh size", quantizedError.Position);
+	return true;
+}
@@ -0,0 +1,36 @@
+#include "TestContext.h"
+
+#include <cstdlib>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <Logging.h>
+
+static GLFWwindow* window = nullptr;
+
+bool InitTestContext() {
+	if (window != nullptr) {
+		return true;
+	}
+
+	if (glfwInit() == GLFW_FALSE) {
+		LOG_WARN("Failed to initialize GLFW");
+		return false;
+	}
+	atexit(glfwTerminate);
+
+	// We never draw to the window, we just need its context
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	window = glfwCreateWindow(64, 64, "Brick Breaker Tests", nullptr, nullptr);
+	if (window == nullptr) {
+		LOG_WARN("Failed to create a window");
+		return false;
+	}
+	glfwMakeContextCurrent(window);
+
+	if (gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) == 0) {
+		LOG_WARN("Failed to initialize Glad");
+		return false;
+	}
+	LOG_INFO("  Using {} ({})", (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+	return true;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+/// <summary>
+/// Makes sure there is an OpenGL context on the calling thread, for tests that need to talk to the GPU. The
+/// context belongs to a hidden window that is created on the first call and lives until the program exits
+/// </summary>
+/// <returns>True if the context is ready, false if there's no GPU (or driver) that we can use</returns>
+bool InitTestContext();
@@ -0,0 +1,39 @@
+#pragma once
+#include <Logging.h>
+
+// Fails the test that is currently running, logging why, if x is false
+#define TEST_CHECK(x, ...) { if (!(x)) { LOG_WARN(__VA_ARGS__); return false; } }
+
+// Each test returns true if it passed, see main.cpp for the list that gets run
+
+// ObjParserTests.cpp
+bool TestObjParser();
+bool BenchObjParser();
+
+// ObjCacheBench.cpp
+bool BenchObjCache();
+
+// ObjParallelBench.cpp
+bool BenchObjParallel();
+
+// ObjLargeIndexTest.cpp
+bool TestObjLargeIndices();
+bool BenchVertexIndexMap();
+
+// PackedVertexTests.cpp
+bool TestPackedVertices();
+
+// UniformIdBench.cpp
+bool BenchUniformId();
+
+// ClusteredLightingBench.cpp
+bool BenchClusteredLighting();
+
+// MipChainTests.cpp
+bool TestMipChain();
+
+// TextureFilteringBench.cpp
+bool BenchTextureFiltering();
+
+// MeshOptimizerTests.cpp
+bool TestMeshOptimizer();
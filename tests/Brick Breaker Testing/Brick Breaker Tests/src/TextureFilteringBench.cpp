@@ -0,0 +1,176 @@
+#include "Tests.h"
+#include "TestContext.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Gameplay/Camera.h"
+#include "Graphics/Shader.h"
+#include "Graphics/Texture2D.h"
+#include "Graphics/Texture2DData.h"
+#include "Utilities/MeshBuilder.h"
+#include "Utilities/MeshFactory.h"
+#include "TTK/GLStateCache.h"
+
+static const int FRAME_WIDTH = 1280;
+static const int FRAME_HEIGHT = 720;
+static const uint32_t TEXTURE_SIZE = 2048;
+
+static const char* FLOOR_VS = R"(
+#version 430
+layout(location = 0) in vec3 inPosition;
+layout(location = 3) in vec2 inUV;
+layout(location = 0) out vec2 outUV;
+uniform mat4 u_ModelViewProjection;
+uniform float u_Tiling;
+void main() {
+	gl_Position = u_ModelViewProjection * vec4(inPosition, 1.0);
+	outUV = inUV * u_Tiling;
+}
+)";
+
+static const char* FLOOR_FS = R"(
+#version 430
+layout(location = 0) in vec2 inUV;
+layout(binding = 0) uniform sampler2D s_Texture;
+out vec4 frag_color;
+void main() {
+	frag_color = texture(s_Texture, inUV);
+}
+)";
+
+// Makes a stone-like RGBA texture, a coarse grid of tiles with per-texel noise on top, so every mip level has detail
+static Texture2DData::sptr MakeFloorImage() {
+	std::mt19937 random(11);
+	std::vector<uint8_t> pixels(TEXTURE_SIZE * (size_t)TEXTURE_SIZE * 4);
+	for (uint32_t y = 0; y < TEXTURE_SIZE; y++) {
+		for (uint32_t x = 0; x < TEXTURE_SIZE; x++) {
+			uint8_t tile = ((x / 128) + (y / 128)) % 2 == 0 ? 160 : 96;
+			uint8_t* texel = &pixels[(y * (size_t)TEXTURE_SIZE + x) * 4];
+			for (int c = 0; c < 3; c++) {
+				texel[c] = static_cast<uint8_t>(tile + (random() % 64));
+			}
+			texel[3] = 255;
+		}
+	}
+	return std::make_shared<Texture2DData>(TEXTURE_SIZE, TEXTURE_SIZE, PixelFormat::RGBA, PixelType::UByte, pixels.data(), InternalFormat::RGBA8);
+}
+
+// Makes a texture from the chain with the given filtering, the chain is cut short if the filter doesn't use mips
+static Texture2D::sptr MakeFloorTexture(const std::vector<Texture2DData::sptr>& chain, MinFilter filter, float anisotropy) {
+	Texture2DDescription description = Texture2DDescription();
+	description.MinificationFilter = filter;
+	description.MagnificationFilter = MagFilter::Linear;
+	description.MaxAnisotropy = anisotropy;
+	Texture2D::sptr result = Texture2D::Create(description);
+	result->LoadData(chain);
+	return result;
+}
+
+// Draws a 1280x720 floor that recedes into the distance, tiling a 2048x2048 texture, with each of the filtering
+// modes Texture2D supports. Distant texels are far smaller than a pixel, so without mips every pixel reads from
+// widely spaced texels in the base level, and with them it reads from a small level that fits in the texture cache.
+// It also checks that a chain built on the CPU and uploaded with LoadData is close to one the GPU generates
+bool BenchTextureFiltering() {
+	typedef std::chrono::high_resolution_clock Clock;
+	TEST_CHECK(InitTestContext(), "Could not create an OpenGL context");
+
+	Shader::sptr shader = Shader::Create();
+	shader->LoadShaderPart(FLOOR_VS, GL_VERTEX_SHADER);
+	shader->LoadShaderPart(FLOOR_FS, GL_FRAGMENT_SHADER);
+	TEST_CHECK(shader->Link(), "The floor shader failed to link");
+
+	GLuint framebuffer, color;
+	glCreateFramebuffers(1, &framebuffer);
+	glCreateRenderbuffers(1, &color);
+	glNamedRenderbufferStorage(color, GL_RGBA8, FRAME_WIDTH, FRAME_HEIGHT);
+	glNamedFramebufferRenderbuffer(framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, FRAME_WIDTH, FRAME_HEIGHT);
+	TTK::GLStateCache::Instance().SetEnabled(GL_DEPTH_TEST, false);
+
+	MeshBuilder<VertexPosNormTexCol> floor;
+	MeshFactory::AddPlane(floor, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(400.0f));
+	VertexArrayObject::sptr floorVao = floor.Bake();
+
+	// A low camera looking along the floor, so the texel density changes a lot from the bottom of the screen to the top
+	Camera::sptr camera = Camera::Create();
+	camera->SetPosition(glm::vec3(0.0f, -190.0f, 2.0f));
+	camera->SetUp(glm::vec3(0.0f, 0.0f, 1.0f));
+	camera->LookAt(glm::vec3(0.0f, 0.0f, 0.0f));
+	camera->SetFovDegrees(70.0f);
+	camera->ResizeWindow(FRAME_WIDTH, FRAME_HEIGHT);
+
+	shader->Bind();
+	shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection());
+	shader->SetUniform("u_Tiling", 100.0f);
+
+	Texture2DData::sptr image = MakeFloorImage();
+	auto start = Clock::now();
+	std::vector<Texture2DData::sptr> chain = Texture2DData::GenerateMipChain(image);
+	std::chrono::duration<double, std::milli> chainTime = Clock::now() - start;
+	TEST_CHECK(chain.size() == 12, "A {0}x{0} texture should have 12 mip levels, got {1}", TEXTURE_SIZE, chain.size());
+
+	// The CPU chain should look like the one the driver builds, so that it doesn't matter which one a texture got
+	{
+		Texture2D::sptr cpu = MakeFloorTexture(chain, MinFilter::LinearMipLinear, 1.0f);
+		Texture2D::sptr gpu = MakeFloorTexture({ chain[0] }, MinFilter::LinearMipLinear, 1.0f);
+		TEST_CHECK(cpu->GetMipLevels() == chain.size(), "The texture has {} levels, expected {}", cpu->GetMipLevels(), chain.size());
+		int worst = 0;
+		for (uint32_t level = 1; level < cpu->GetMipLevels(); level++) {
+			const size_t size = chain[level]->GetDataSize();
+			std::vector<uint8_t> cpuPixels(size), gpuPixels(size);
+			glPixelStorei(GL_PACK_ALIGNMENT, 1);
+			glGetTextureImage(cpu->GetHandle(), level, GL_RGBA, GL_UNSIGNED_BYTE, static_cast<GLsizei>(size), cpuPixels.data());
+			glGetTextureImage(gpu->GetHandle(), level, GL_RGBA, GL_UNSIGNED_BYTE, static_cast<GLsizei>(size), gpuPixels.data());
+			TEST_CHECK(memcmp(cpuPixels.data(), chain[level]->GetDataPtr(), size) == 0, "Mip level {} did not upload as given", level);
+			for (size_t ix = 0; ix < size; ix++) {
+				worst = std::max(worst, std::abs(cpuPixels[ix] - gpuPixels[ix]));
+			}
+		}
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		LOG_INFO("  CPU mip chain built in {:.2f}ms, differs from the GPU's by at most {}/255", chainTime.count(), worst);
+		// Drivers are free to use any filter for glGenerateMipmap, but every one we know of uses a box filter
+		TEST_CHECK(worst <= 8, "The CPU mip chain differs from the GPU's by {}/255", worst);
+	}
+
+	struct Run { const char* Name; MinFilter Filter; float Anisotropy; };
+	const Run runs[] = {
+		{ "base level only (Linear)",  MinFilter::Linear,           1.0f },
+		{ "bilinear with mips",        MinFilter::LinearMipNearest, 1.0f },
+		{ "trilinear",                 MinFilter::LinearMipLinear,  1.0f },
+		{ "trilinear + 4x anisotropy", MinFilter::LinearMipLinear,  4.0f },
+		{ "trilinear + 16x anisotropy", MinFilter::LinearMipLinear, 16.0f },
+	};
+	const int FRAMES = 20;
+	for (const Run& run : runs) {
+		Texture2D::sptr texture = MakeFloorTexture(chain, run.Filter, run.Anisotropy);
+		texture->Bind(0);
+
+		// The first frame pays for any lazy driver work, so we leave it out, then keep the best frame
+		glClear(GL_COLOR_BUFFER_BIT);
+		floorVao->Render();
+		glFinish();
+		double best = INFINITY;
+		for (int ix = 0; ix < FRAMES; ix++) {
+			start = Clock::now();
+			glClear(GL_COLOR_BUFFER_BIT);
+			floorVao->Render();
+			glFinish();
+			best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+		}
+
+		LOG_INFO("  {:27} {:7.2f}ms ({} levels, {}x anisotropy)", run.Name, best, texture->GetMipLevels(),
+			std::min(run.Anisotropy, Texture2D::GetMaxSupportedAnisotropy()));
+	}
+
+	Texture2D::UnBind(0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &color);
+	return true;
+}
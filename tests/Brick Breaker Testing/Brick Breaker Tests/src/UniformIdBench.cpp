@@ -0,0 +1,149 @@
+#include "Tests.h"
+#include "TestContext.h"
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <GLM/gtc/type_ptr.hpp>
+
+#include "Graphics/Shader.h"
+
+static const char* UNIFORM_VS = R"(
+#version 410
+layout(location = 0) in vec3 inPosition;
+uniform mat4 u_ModelViewProjection;
+uniform mat4 u_Model;
+uniform float u_Time;
+uniform vec3 u_LightPos;
+uniform vec3 u_Offsets[4];
+void main() {
+	vec3 offset = u_Offsets[0] + u_Offsets[1] + u_Offsets[2] + u_Offsets[3];
+	gl_Position = u_ModelViewProjection * u_Model * vec4(inPosition + offset + u_LightPos * u_Time, 1.0);
+}
+)";
+
+static const char* UNIFORM_FS = R"(
+#version 410
+uniform vec4 u_TintColor;
+out vec4 frag_color;
+void main() {
+	frag_color = u_TintColor;
+}
+)";
+
+// Reads a float uniform back from the driver, looking it up by name the slow way
+static float ReadUniform(GLuint program, const char* name, int component = 0) {
+	float values[16] = { 0.0f };
+	glGetUniformfv(program, glGetUniformLocation(program, name), values);
+	return values[component];
+}
+
+// Checks that uniforms set by UniformId land where the driver says they are, then times a batch of five
+// SetUniform calls through each of the ways a uniform can be looked up
+bool BenchUniformId() {
+	TEST_CHECK(InitTestContext(), "Could not create an OpenGL context");
+
+	Shader::sptr shader = Shader::Create();
+	shader->LoadShaderPart(UNIFORM_VS, GL_VERTEX_SHADER);
+	shader->LoadShaderPart(UNIFORM_FS, GL_FRAGMENT_SHADER);
+	TEST_CHECK(shader->Link(), "The test shader failed to link");
+	GLuint program = shader->GetHandle();
+
+	// Give every uniform a different value, and make sure we get the same ones back
+	shader->SetUniformMatrix("u_ModelViewProjection", glm::mat4(2.0f));
+	shader->SetUniformMatrix("u_Model", glm::mat4(3.0f));
+	shader->SetUniform("u_Time", 4.0f);
+	shader->SetUniform("u_LightPos", glm::vec3(5.0f));
+	shader->SetUniform("u_TintColor", glm::vec4(6.0f));
+	// Arrays can be set by their bare name, which is their first element
+	shader->SetUniform("u_Offsets", glm::vec3(7.0f));
+	// Missing uniforms should be skipped (with a warning in debug builds), not land on some other uniform
+	shader->SetUniform("u_DoesNotExist", 8.0f);
+
+	TEST_CHECK(ReadUniform(program, "u_ModelViewProjection") == 2.0f, "u_ModelViewProjection was not set");
+	TEST_CHECK(ReadUniform(program, "u_Model") == 3.0f, "u_Model was not set");
+	TEST_CHECK(ReadUniform(program, "u_Time") == 4.0f, "u_Time was not set");
+	TEST_CHECK(ReadUniform(program, "u_LightPos") == 5.0f, "u_LightPos was not set");
+	TEST_CHECK(ReadUniform(program, "u_TintColor") == 6.0f, "u_TintColor was not set");
+	TEST_CHECK(ReadUniform(program, "u_Offsets[0]") == 7.0f && ReadUniform(program, "u_Offsets[1]") == 0.0f, "u_Offsets was not set by its bare name");
+
+	typedef std::chrono::high_resolution_clock Clock;
+	const int iterations = 1000000;
+	const glm::mat4 mvp = glm::mat4(1.0f), model = glm::mat4(1.0f);
+	const glm::vec3 lightPos = glm::vec3(1.0f);
+	const glm::vec4 tint = glm::vec4(1.0f);
+
+	// What Shader used to do, look the name up in a map of strings, building a string for every call
+	std::unordered_map<std::string, int> locations;
+	for (const char* name : { "u_ModelViewProjection", "u_Model", "u_Time", "u_LightPos", "u_TintColor" }) {
+		locations[name] = glGetUniformLocation(program, name);
+	}
+	auto setByString = [&](const std::string& name, auto value) {
+		auto it = locations.find(name);
+		if (it != locations.end()) {
+			shader->SetUniform(it->second, &value);
+		}
+	};
+	auto setMatrixByString = [&](const std::string& name, const glm::mat4& value) {
+		auto it = locations.find(name);
+		if (it != locations.end()) {
+			shader->SetUniformMatrix(it->second, &value);
+		}
+	};
+
+	auto start = Clock::now();
+	for (int ix = 0; ix < iterations; ix++) {
+		setMatrixByString("u_ModelViewProjection", mvp);
+		setMatrixByString("u_Model", model);
+		setByString("u_Time", (float)ix);
+		setByString("u_LightPos", lightPos);
+		setByString("u_TintColor", tint);
+	}
+	std::chrono::duration<double, std::nano> stringTime = Clock::now() - start;
+
+	start = Clock::now();
+	for (int ix = 0; ix < iterations; ix++) {
+		shader->SetUniformMatrix("u_ModelViewProjection", mvp);
+		shader->SetUniformMatrix("u_Model", model);
+		shader->SetUniform("u_Time", (float)ix);
+		shader->SetUniform("u_LightPos", lightPos);
+		shader->SetUniform("u_TintColor", tint);
+	}
+	std::chrono::duration<double, std::nano> literalTime = Clock::now() - start;
+
+	static constexpr UniformId u_ModelViewProjection = "u_ModelViewProjection";
+	static constexpr UniformId u_Model = "u_Model";
+	static constexpr UniformId u_Time = "u_Time";
+	static constexpr UniformId u_LightPos = "u_LightPos";
+	static constexpr UniformId u_TintColor = "u_TintColor";
+	start = Clock::now();
+	for (int ix = 0; ix < iterations; ix++) {
+		shader->SetUniformMatrix(u_ModelViewProjection, mvp);
+		shader->SetUniformMatrix(u_Model, model);
+		shader->SetUniform(u_Time, (float)ix);
+		shader->SetUniform(u_LightPos, lightPos);
+		shader->SetUniform(u_TintColor, tint);
+	}
+	std::chrono::duration<double, std::nano> idTime = Clock::now() - start;
+
+	// The floor, with no lookup at all
+	int mvpLocation = locations["u_ModelViewProjection"], modelLocation = locations["u_Model"], timeLocation = locations["u_Time"];
+	int lightLocation = locations["u_LightPos"], tintLocation = locations["u_TintColor"];
+	start = Clock::now();
+	for (int ix = 0; ix < iterations; ix++) {
+		float time = (float)ix;
+		shader->SetUniformMatrix(mvpLocation, &mvp);
+		shader->SetUniformMatrix(modelLocation, &model);
+		shader->SetUniform(timeLocation, &time);
+		shader->SetUniform(lightLocation, &lightPos);
+		shader->SetUniform(tintLocation, &tint);
+	}
+	std::chrono::duration<double, std::nano> locationTime = Clock::now() - start;
+
+	const double calls = iterations * 5.0;
+	LOG_INFO("  string + unordered_map {:.1f}ns/call", stringTime.count() / calls);
+	LOG_INFO("  literal                {:.1f}ns/call", literalTime.count() / calls);
+	LOG_INFO("  constexpr UniformId    {:.1f}ns/call", idTime.count() / calls);
+	LOG_INFO("  raw location           {:.1f}ns/call", locationTime.count() / calls);
+	return true;
+}
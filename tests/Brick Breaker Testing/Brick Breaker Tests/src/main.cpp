@@ -0,0 +1,76 @@
+#include <Logging.h>
+#include <cstring>
+#include <stdexcept>
+
+#include "Tests.h"
+
+/// <summary>
+/// A check or benchmark that can be picked by name on the command line
+/// </summary>
+struct TestCase {
+	const char* Name;
+	bool(*Run)();
+};
+
+static const TestCase Tests[] = {
+	{ "ObjParser",      TestObjParser },
+	{ "ObjParserSpeed", BenchObjParser },
+	{ "ObjCacheSpeed",  BenchObjCache },
+	{ "ObjParallel",    BenchObjParallel },
+	{ "ObjLargeIndex",  TestObjLargeIndices },
+	{ "VertexIndexMap", BenchVertexIndexMap },
+	{ "PackedVertices", TestPackedVertices },
+	{ "UniformId",      BenchUniformId },
+	{ "ClusteredLighting", BenchClusteredLighting },
+	{ "MipChain",       TestMipChain },
+	{ "TextureFiltering", BenchTextureFiltering },
+	{ "MeshOptimizer",  TestMeshOptimizer },
+};
+
+// Runs every test, or only the ones named on the command line. The exit code is the number of failures
+int main(int argc, char** argv) {
+	Logger::Init(); // We'll borrow the logger from the toolkit, but we need to initialize it
+
+	int failures = 0;
+	// A typo on the command line shouldn't look like a pass
+	for (int ix = 1; ix < argc; ix++) {
+		bool found = false;
+		for (const TestCase& test : Tests) {
+			found |= strcmp(argv[ix], test.Name) == 0;
+		}
+		if (!found) {
+			LOG_WARN("There is no test named \"{}\"", argv[ix]);
+			failures++;
+		}
+	}
+
+	for (const TestCase& test : Tests) {
+		bool selected = argc < 2;
+		for (int ix = 1; ix < argc && !selected; ix++) {
+			selected = strcmp(argv[ix], test.Name) == 0;
+		}
+		if (!selected) {
+			continue;
+		}
+
+		LOG_INFO("Running {}", test.Name);
+		bool passed = false;
+		try {
+			passed = test.Run();
+		}
+		catch (const std::exception& e) {
+			LOG_WARN("{} threw: {}", test.Name, e.what());
+		}
+
+		if (passed) {
+			LOG_INFO("{} passed", test.Name);
+		} else {
+			LOG_WARN("{} FAILED", test.Name);
+			failures++;
+		}
+	}
+
+	LOG_INFO("{} test(s) failed", failures);
+	Logger::Uninitialize();
+	return failures;
+}
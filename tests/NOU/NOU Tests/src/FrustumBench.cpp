@@ -0,0 +1,158 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+FrustumBench.cpp
+Checks frustum culling against a plain loop and against clip space,
+and times it on a large scene.
+*/
+
+#include "Tests.h"
+
+#include "NOU/Frustum.h"
+#include "GLM/gtc/matrix_transform.hpp"
+#include "GLM/gtc/quaternion.hpp"
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+using namespace nou;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//Whether any corner of a [-1, 1] cube ends up inside clip space, i.e. whether
+//some of the cube is definitely on screen.
+static bool IsCornerVisible(const glm::mat4& modelViewProj)
+{
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		glm::vec4 local = glm::vec4(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f, 1.0f);
+		glm::vec4 clip = modelViewProj * local;
+
+		if (fabsf(clip.x) <= clip.w && fabsf(clip.y) <= clip.w && fabsf(clip.z) <= clip.w)
+			return true;
+	}
+
+	return false;
+}
+
+//Checks a few spheres we know the answer for, and that CullSpheres agrees
+//with ContainsSphere for every count from 1 to 9 (so the leftover spheres
+//after the SSE loop are covered).
+bool TestFrustum()
+{
+	glm::mat4 viewProj = glm::perspective(glm::radians(90.0f), 1.0f, 1.0f, 100.0f) *
+		glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum(viewProj);
+
+	TEST_CHECK(frustum.ContainsSphere(glm::vec3(0.0f, 0.0f, -10.0f), 1.0f), "A sphere straight ahead was culled");
+	TEST_CHECK(!frustum.ContainsSphere(glm::vec3(0.0f, 0.0f, 10.0f), 1.0f), "A sphere behind the camera wasn't culled");
+	TEST_CHECK(!frustum.ContainsSphere(glm::vec3(0.0f, 0.0f, -150.0f), 1.0f), "A sphere past the far plane wasn't culled");
+	TEST_CHECK(!frustum.ContainsSphere(glm::vec3(20.0f, 0.0f, -10.0f), 1.0f), "A sphere off to the side wasn't culled");
+	//Outside the left plane, but close enough to poke into it.
+	TEST_CHECK(frustum.ContainsSphere(glm::vec3(-11.0f, 0.0f, -10.0f), 1.0f), "A sphere crossing a plane was culled");
+
+	//A scaled cube has a sphere big enough for its largest axis.
+	glm::vec4 sphere = TransformSphere(glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, 4.0f, 2.0f)),
+		glm::vec3(0.0f), 1.0f);
+	TEST_CHECK(sphere == glm::vec4(1.0f, 2.0f, 3.0f, 4.0f), "Expected the sphere (1, 2, 3) radius 4, got (%g, %g, %g) radius %g", sphere.x, sphere.y, sphere.z, sphere.w);
+
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> position(-30.0f, 30.0f);
+	std::vector<glm::vec4> spheres;
+
+	for (size_t count = 1; count <= 9; ++count)
+	{
+		spheres.push_back(glm::vec4(position(random), position(random), position(random), 2.0f));
+		std::vector<uint8_t> visible(count, 2);
+		size_t passed = frustum.CullSpheres(spheres.data(), count, visible.data());
+		size_t expected = 0;
+
+		for (size_t ix = 0; ix < count; ++ix)
+		{
+			bool contains = frustum.ContainsSphere(glm::vec3(spheres[ix]), spheres[ix].w);
+			TEST_CHECK(visible[ix] == (contains ? 1 : 0), "Sphere %zu of %zu was %d, expected %d", ix, count, (int)visible[ix], (int)contains);
+			expected += contains ? 1 : 0;
+		}
+
+		TEST_CHECK(passed == expected, "CullSpheres said %zu of %zu passed, expected %zu", passed, count, expected);
+	}
+
+	return true;
+}
+
+//50k randomly placed, rotated and scaled cubes in a 200 unit box, seen by a
+//60 degree camera at the center that turns a full circle over 200 frames.
+//Times building the world space spheres, culling them with CullSpheres and
+//culling them one at a time with ContainsSphere. Checks that the two agree,
+//and that nothing with a corner on screen ever gets culled.
+bool BenchFrustumCull()
+{
+	const size_t count = 50000;
+	const int frames = 200;
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f), scale(0.2f, 3.0f), angle(0.0f, 6.28f);
+	std::vector<glm::mat4> models(count);
+
+	for (glm::mat4& model : models)
+	{
+		model = glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random))) *
+			glm::mat4_cast(glm::angleAxis(angle(random), glm::normalize(glm::vec3(1.0f, 2.0f, 3.0f)))) *
+			glm::scale(glm::mat4(1.0f), glm::vec3(scale(random), scale(random), scale(random)));
+	}
+
+	//The bounds of a unit cube, as a mesh would compute them when it's baked.
+	const glm::vec3 center = glm::vec3(0.0f);
+	const float radius = sqrtf(3.0f);
+	const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f);
+
+	std::vector<glm::vec4> spheres(count);
+	std::vector<uint8_t> visible(count);
+	double boundsTime = 0.0, cullTime = 0.0, scalarTime = 0.0;
+	size_t drawn = 0, mismatched = 0, wronglyCulled = 0;
+
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		float turn = frame * 6.2832f / frames;
+		glm::mat4 viewProj = projection * glm::lookAt(glm::vec3(0.0f), glm::vec3(sinf(turn), 0.2f, -cosf(turn)), glm::vec3(0.0f, 1.0f, 0.0f));
+
+		auto start = Clock::now();
+		for (size_t ix = 0; ix < count; ++ix)
+			spheres[ix] = TransformSphere(models[ix], center, radius);
+		auto boundsEnd = Clock::now();
+
+		Frustum frustum(viewProj);
+		size_t passed = frustum.CullSpheres(spheres.data(), count, visible.data());
+		auto cullEnd = Clock::now();
+
+		size_t scalarPassed = 0;
+		for (size_t ix = 0; ix < count; ++ix)
+			scalarPassed += frustum.ContainsSphere(glm::vec3(spheres[ix]), spheres[ix].w) ? 1 : 0;
+		auto scalarEnd = Clock::now();
+
+		boundsTime += std::chrono::duration<double, std::milli>(boundsEnd - start).count();
+		cullTime += std::chrono::duration<double, std::milli>(cullEnd - boundsEnd).count();
+		scalarTime += std::chrono::duration<double, std::milli>(scalarEnd - cullEnd).count();
+		drawn += passed;
+
+		for (size_t ix = 0; ix < count; ++ix)
+		{
+			bool contains = frustum.ContainsSphere(glm::vec3(spheres[ix]), spheres[ix].w);
+			mismatched += (visible[ix] != 0) != contains ? 1 : 0;
+
+			if (visible[ix] == 0 && IsCornerVisible(viewProj * models[ix]))
+				++wronglyCulled;
+		}
+
+		mismatched += passed != scalarPassed ? 1 : 0;
+	}
+
+	printf("  %zu objects, %.0f drawn per frame on average\n", count, (double)drawn / frames);
+	printf("  per frame: world spheres %.3fms, CullSpheres %.3fms, ContainsSphere loop %.3fms (%.1fx)\n",
+		boundsTime / frames, cullTime / frames, scalarTime / frames, scalarTime / cullTime);
+	TEST_CHECK(mismatched == 0, "CullSpheres and ContainsSphere disagreed %zu times", mismatched);
+	TEST_CHECK(wronglyCulled == 0, "%zu objects with a corner on screen were culled", wronglyCulled);
+	TEST_CHECK(drawn > 0 && drawn < count * frames, "Expected some objects to be culled and some drawn, %zu of %zu were drawn", drawn, count * frames);
+	return true;
+}
@@ -0,0 +1,115 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+ShaderCacheBench.cpp
+Times creating NOU's textured lit shader program with an empty program
+binary cache (compile, link and store) and with a full one (load).
+*/
+
+#include "Tests.h"
+
+#include "NOU/Shader.h"
+#include "TTK/ProgramBinaryCache.h"
+#include "GLFW/glfw3.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+using namespace nou;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static const char* BENCH_CACHE_DIR = "shader_cache_bench";
+
+//Makes a hidden window so that we have a context to compile shaders with.
+//None of the other NOU tests need one, so this lives here.
+static bool InitHiddenContext()
+{
+	static GLFWwindow* window = nullptr;
+
+	if (window != nullptr)
+		return true;
+
+	if (glfwInit() == GLFW_FALSE)
+		return false;
+
+	atexit(glfwTerminate);
+
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	window = glfwCreateWindow(64, 64, "NOU Tests", nullptr, nullptr);
+
+	if (window == nullptr)
+		return false;
+
+	glfwMakeContextCurrent(window);
+
+	return gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) != 0;
+}
+
+//Builds the program the same way the NOU sample does, the shader files come
+//from NOU's res folder, which gets copied next to every project.
+static std::unique_ptr<ShaderProgram> MakeTexturedLit()
+{
+	Shader vert("shaders/texturedlit.vert", GL_VERTEX_SHADER);
+	Shader frag("shaders/texturedlit.frag", GL_FRAGMENT_SHADER);
+
+	return std::make_unique<ShaderProgram>(std::vector<Shader*>{ &vert, &frag });
+}
+
+//The cold run starts from an empty cache directory, so it has to compile both
+//shaders, link them and write the binary. Every warm run after that should
+//load the binary without compiling anything. Drivers often keep their own
+//shader cache as well, which makes the cold run look better than a true
+//first run on a new machine, so treat the speedup as a lower bound.
+bool BenchShaderCache()
+{
+	TEST_CHECK(InitHiddenContext(), "Could not create an OpenGL context");
+
+	TTK::ProgramBinaryCache& cache = TTK::ProgramBinaryCache::Instance();
+
+	if (!cache.IsSupported())
+	{
+		printf("  The driver has no program binary formats, skipping\n");
+		return true;
+	}
+
+	cache.SetDirectory(BENCH_CACHE_DIR);
+	std::error_code error;
+	std::filesystem::remove_all(BENCH_CACHE_DIR, error);
+
+	TTK::ProgramBinaryCache::Stats before = cache.GetStats();
+
+	auto start = Clock::now();
+	MakeTexturedLit();
+	std::chrono::duration<double, std::milli> coldTime = Clock::now() - start;
+
+	TTK::ProgramBinaryCache::Stats afterCold = cache.GetStats();
+	TEST_CHECK(afterCold.Hits == before.Hits && afterCold.Stored == before.Stored + 1,
+		"The cold run should miss and store one binary (%u hits, %u stored)", afterCold.Hits - before.Hits, afterCold.Stored - before.Stored);
+
+	const int WARM_RUNS = 5;
+	double warmTime = INFINITY;
+
+	for (int ix = 0; ix < WARM_RUNS; ++ix)
+	{
+		start = Clock::now();
+		MakeTexturedLit();
+		warmTime = fmin(warmTime, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+	}
+
+	TTK::ProgramBinaryCache::Stats afterWarm = cache.GetStats();
+	TEST_CHECK(afterWarm.Hits == afterCold.Hits + WARM_RUNS && afterWarm.Rejected == afterCold.Rejected,
+		"Every warm run should load from the cache (%u of %d hit, %u rejected)", afterWarm.Hits - afterCold.Hits, WARM_RUNS,
+		afterWarm.Rejected - afterCold.Rejected);
+
+	printf("  texturedlit on %s: cold %.2fms, warm %.2fms (%.1fx faster)\n", (const char*)glGetString(GL_RENDERER),
+		coldTime.count(), warmTime, coldTime.count() / warmTime);
+
+	cache.SetDirectory("shader_cache");
+	std::filesystem::remove_all(BENCH_CACHE_DIR, error);
+	return true;
+}
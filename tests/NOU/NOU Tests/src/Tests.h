@@ -0,0 +1,39 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+Tests.h
+Correctness checks and benchmarks for the NOU module.
+*/
+
+#pragma once
+
+#include <cstdio>
+
+//Fails the test that is currently running, printing why, if x is false.
+#define TEST_CHECK(x, ...) { if (!(x)) { printf("  FAILED: "); printf(__VA_ARGS__); printf("\n"); return false; } }
+
+//Each test returns true if it passed, see main.cpp for the list that gets run.
+
+//TransformBench.cpp
+bool TestTransformHierarchy();
+bool BenchTransformHierarchy();
+
+//TransformBatchBench.cpp
+bool TestTransformBatch();
+bool BenchTransformBatch();
+
+//WorldBench.cpp
+bool TestWorld();
+bool BenchWorldSystems();
+
+//WorldParallelBench.cpp
+bool TestJobSystem();
+bool TestWorldException();
+bool BenchWorldParallel();
+
+//FrustumBench.cpp
+bool TestFrustum();
+bool BenchFrustumCull();
+
+//ShaderCacheBench.cpp
+bool BenchShaderCache();
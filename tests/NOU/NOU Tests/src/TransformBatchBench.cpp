@@ -0,0 +1,161 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+TransformBatchBench.cpp
+Checks ComposeTransforms against building each matrix with GLM,
+and times the two.
+*/
+
+#include "Tests.h"
+
+#include "NOU/TransformBatch.h"
+#include "GLM/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//The way Transform used to build its matrices, one GLM call at a time.
+static glm::mat4 ReferenceTransform(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+	const glm::mat4 identity = glm::mat4(1.0f);
+	return glm::translate(identity, position) * glm::toMat4(glm::normalize(rotation)) * glm::scale(identity, scale);
+}
+
+static glm::mat3 ReferenceNormal(const glm::mat4& transform)
+{
+	return glm::transpose(glm::inverse(glm::mat3(transform)));
+}
+
+//The largest difference between two matrices, relative to the size of the values.
+template<typename Matrix>
+static float MatrixError(const Matrix& a, const Matrix& b)
+{
+	float error = 0.0f;
+
+	for (int col = 0; col < Matrix::length(); ++col)
+	{
+		for (int row = 0; row < Matrix::col_type::length(); ++row)
+			error = std::max(error, std::abs(a[col][row] - b[col][row]) / std::max(1.0f, std::abs(a[col][row])));
+	}
+
+	return error;
+}
+
+static double MicrosecondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+//Checks every count from 1 to 13, so that the SIMD path and the leftover
+//objects after it are both covered, with rotations that aren't normalized.
+//The arrays are allocated at exactly the size given, so that the address
+//sanitizer (or debug heap) catches anything written past the end.
+bool TestTransformBatch()
+{
+	float matrixError = 0.0f, normalError = 0.0f;
+
+	for (size_t count = 1; count <= 13; ++count)
+	{
+		auto positions = std::make_unique<glm::vec3[]>(count);
+		auto rotations = std::make_unique<glm::quat[]>(count);
+		auto scales = std::make_unique<glm::vec3[]>(count);
+		auto transforms = std::make_unique<glm::mat4[]>(count);
+		auto normals = std::make_unique<glm::mat3[]>(count);
+
+		for (size_t ix = 0; ix < count; ++ix)
+		{
+			float value = (float)ix;
+			positions[ix] = glm::vec3(value, 2.0f * value, -value);
+			rotations[ix] = glm::quat(1.0f + value, 0.1f * value, -0.2f, 0.3f);
+			scales[ix] = glm::vec3(1.0f + value, 2.0f, 0.5f);
+		}
+
+		nou::ComposeTransforms(positions.get(), rotations.get(), scales.get(), transforms.get(), normals.get(), count);
+
+		for (size_t ix = 0; ix < count; ++ix)
+		{
+			glm::mat4 expected = ReferenceTransform(positions[ix], rotations[ix], scales[ix]);
+			matrixError = std::max(matrixError, MatrixError(expected, transforms[ix]));
+			normalError = std::max(normalError, MatrixError(ReferenceNormal(expected), normals[ix]));
+		}
+
+		//Either output can be left out.
+		nou::ComposeTransforms(positions.get(), rotations.get(), scales.get(), nullptr, normals.get(), count);
+		nou::ComposeTransforms(positions.get(), rotations.get(), scales.get(), transforms.get(), nullptr, count);
+	}
+
+	printf("  max relative error: matrix %.1e, normal matrix %.1e\n", matrixError, normalError);
+	TEST_CHECK(matrixError <= 2e-6f, "Transforms are off by up to %g", matrixError);
+	TEST_CHECK(normalError <= 2e-6f, "Normal matrices are off by up to %g", normalError);
+	return true;
+}
+
+//Times building the transform and normal matrix of 1k, 10k and 100k random
+//objects with GLM (translate * rotate * scale, then an inverse transpose),
+//against ComposeTransforms.
+bool BenchTransformBatch()
+{
+	const int runs = 15;
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	for (size_t count : { 1000, 10000, 100000 })
+	{
+		std::vector<glm::vec3> positions(count), scales(count);
+		std::vector<glm::quat> rotations(count);
+
+		for (size_t ix = 0; ix < count; ++ix)
+		{
+			positions[ix] = glm::vec3(unit(random), unit(random), unit(random)) * 10.0f;
+			scales[ix] = glm::vec3(1.0f + unit(random) * 0.4f, 1.0f + unit(random) * 0.5f, 1.2f + unit(random) * 0.5f);
+			rotations[ix] = glm::normalize(glm::quat(unit(random), unit(random), unit(random), unit(random)));
+		}
+
+		std::vector<glm::mat4> expected(count), transforms(count);
+		std::vector<glm::mat3> expectedNormals(count), normals(count);
+		double glmBoth = 1e18, glmMatrix = 1e18, batchBoth = 1e18, batchMatrix = 1e18;
+
+		for (int run = 0; run < runs; ++run)
+		{
+			auto start = Clock::now();
+			for (size_t ix = 0; ix < count; ++ix)
+			{
+				expected[ix] = ReferenceTransform(positions[ix], rotations[ix], scales[ix]);
+				expectedNormals[ix] = ReferenceNormal(expected[ix]);
+			}
+			glmBoth = std::min(glmBoth, MicrosecondsSince(start));
+
+			start = Clock::now();
+			for (size_t ix = 0; ix < count; ++ix)
+				expected[ix] = ReferenceTransform(positions[ix], rotations[ix], scales[ix]);
+			glmMatrix = std::min(glmMatrix, MicrosecondsSince(start));
+
+			start = Clock::now();
+			nou::ComposeTransforms(positions.data(), rotations.data(), scales.data(), transforms.data(), normals.data(), count);
+			batchBoth = std::min(batchBoth, MicrosecondsSince(start));
+
+			start = Clock::now();
+			nou::ComposeTransforms(positions.data(), rotations.data(), scales.data(), transforms.data(), nullptr, count);
+			batchMatrix = std::min(batchMatrix, MicrosecondsSince(start));
+		}
+
+		float matrixError = 0.0f, normalError = 0.0f;
+		for (size_t ix = 0; ix < count; ++ix)
+		{
+			matrixError = std::max(matrixError, MatrixError(expected[ix], transforms[ix]));
+			normalError = std::max(normalError, MatrixError(expectedNormals[ix], normals[ix]));
+		}
+
+		printf("  %6zu objects | with normals: glm %8.1fus, batch %7.1fus (%.1fx) | matrix only: glm %8.1fus, batch %7.1fus (%.1fx) | error %.1e, %.1e\n",
+			count, glmBoth, batchBoth, glmBoth / batchBoth, glmMatrix, batchMatrix, glmMatrix / batchMatrix, matrixError, normalError);
+		TEST_CHECK(matrixError <= 2e-6f, "Transforms of %zu objects are off by up to %g", count, matrixError);
+		TEST_CHECK(normalError <= 2e-6f, "Normal matrices of %zu objects are off by up to %g", count, normalError);
+	}
+
+	return true;
+}
@@ -0,0 +1,290 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+TransformBench.cpp
+Checks the flat transform hierarchy against the recursive one it replaced,
+and times the two on large rigs.
+*/
+
+#include "Tests.h"
+
+#include "NOU/Transform.h"
+#include "GLM/gtx/transform.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+using nou::Transform;
+using nou::TransformHierarchy;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//A copy of how Transform used to work, with each node holding
+//pointers to its parent and children.
+struct ReferenceNode
+{
+	glm::vec3 pos = glm::vec3(0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);
+	glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	ReferenceNode* parent = nullptr;
+	std::vector<ReferenceNode*> children;
+	glm::mat4 global = glm::mat4(1.0f);
+
+	void SetParent(ReferenceNode* newParent)
+	{
+		if (parent != nullptr)
+			parent->children.erase(std::find(parent->children.begin(), parent->children.end(), this));
+
+		parent = newParent;
+
+		if (parent != nullptr)
+			parent->children.push_back(this);
+	}
+
+	glm::mat4 GetLocal() const
+	{
+		return glm::translate(pos) * glm::toMat4(glm::normalize(rotation)) * glm::scale(scale);
+	}
+
+	//The old DoFK, which recursed down from a root.
+	void DoFK()
+	{
+		global = parent != nullptr ? parent->global * GetLocal() : GetLocal();
+
+		for (ReferenceNode* child : children)
+			child->DoFK();
+	}
+
+	//The old RecomputeGlobal, which walked all the way up to the root.
+	const glm::mat4& RecomputeGlobal()
+	{
+		global = parent != nullptr ? parent->RecomputeGlobal() * GetLocal() : GetLocal();
+		return global;
+	}
+};
+
+//The largest difference between two matrices, relative to the size of
+//the values (so that large translations don't dominate).
+static float MatrixError(const glm::mat4& a, const glm::mat4& b)
+{
+	float error = 0.0f;
+
+	for (int col = 0; col < 4; ++col)
+	{
+		for (int row = 0; row < 4; ++row)
+			error = std::max(error, std::abs(a[col][row] - b[col][row]) / std::max(1.0f, std::abs(a[col][row])));
+	}
+
+	return error;
+}
+
+static double MillisecondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+//A random local transform, close enough to identity that long chains
+//don't run off to infinity.
+static void RandomizeNode(Transform& node, ReferenceNode& reference, std::mt19937& random)
+{
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	reference.pos = glm::vec3(unit(random), unit(random), unit(random));
+	reference.scale = glm::vec3(1.0f + 0.1f * unit(random));
+	reference.rotation = glm::normalize(glm::quat(1.0f, unit(random) * 0.3f, unit(random) * 0.3f, unit(random) * 0.3f));
+
+	node.m_pos = reference.pos;
+	node.m_scale = reference.scale;
+	node.m_rotation = reference.rotation;
+}
+
+//Checks reparenting, cycles, copies and destruction, then checks a random
+//tree where most parents are created after their children (so the hierarchy
+//has to reorder itself) and some interior nodes get destroyed.
+bool TestTransformHierarchy()
+{
+	{
+		TransformHierarchy hierarchy;
+		Transform a(hierarchy), b(hierarchy), c(hierarchy);
+		b.SetParent(&a);
+		c.SetParent(&b);
+		a.m_pos = glm::vec3(1.0f, 0.0f, 0.0f);
+		b.m_pos = glm::vec3(0.0f, 1.0f, 0.0f);
+		c.m_pos = glm::vec3(0.0f, 0.0f, 1.0f);
+
+		//a is c's grandparent, so this would make a cycle.
+		TEST_CHECK(!hierarchy.SetParent(a.GetHandle(), c.GetHandle()), "Parenting a node to its grandchild was allowed");
+		a.SetParent(&c);
+		TEST_CHECK(glm::vec3(c.RecomputeGlobal()[3]) == glm::vec3(1.0f, 1.0f, 1.0f), "A refused cycle changed the hierarchy");
+
+		{
+			Transform d(hierarchy);
+			d.m_pos = glm::vec3(5.0f, 0.0f, 0.0f);
+			a.SetParent(&d);
+			TEST_CHECK(glm::vec3(c.RecomputeGlobal()[3]) == glm::vec3(6.0f, 1.0f, 1.0f), "Reparenting the root didn't move its subtree");
+		}
+
+		//When d goes away, a becomes a root again, keeping its local transform.
+		TEST_CHECK(hierarchy.GetParent(a.GetHandle()) == TransformHierarchy::InvalidHandle, "The child of a destroyed node still has a parent");
+		TEST_CHECK(glm::vec3(c.RecomputeGlobal()[3]) == glm::vec3(1.0f, 1.0f, 1.0f), "Destroying a parent didn't move its subtree back");
+
+		//Copies get the same local transform and parent.
+		Transform copy = b;
+		TEST_CHECK(hierarchy.GetParent(copy.GetHandle()) == a.GetHandle(), "A copy didn't keep the parent");
+		TEST_CHECK(glm::vec3(copy.RecomputeGlobal()[3]) == glm::vec3(1.0f, 1.0f, 0.0f), "A copy didn't end up where the original is");
+		TEST_CHECK(hierarchy.GetCount() == 4, "Expected 4 nodes, have %zu", hierarchy.GetCount());
+	}
+
+	const int count = 5000;
+	TransformHierarchy hierarchy;
+	std::vector<std::unique_ptr<Transform>> nodes;
+	std::vector<ReferenceNode> reference(count);
+	std::vector<int> parents(count, -1);
+	std::mt19937 random(1);
+
+	for (int ix = 0; ix < count; ++ix)
+	{
+		nodes.push_back(std::make_unique<Transform>(hierarchy));
+		RandomizeNode(*nodes[ix], reference[ix], random);
+	}
+
+	//The parent of each node is one of the next 50 nodes, so almost every
+	//parent is created after its children.
+	for (int ix = 0; ix < count - 1; ++ix)
+	{
+		parents[ix] = ix + 1 + (int)(random() % std::min(50, count - 1 - ix));
+		nodes[ix]->SetParent(nodes[parents[ix]].get());
+	}
+
+	//Destroy some interior nodes, whose children should become roots.
+	for (int ix = 0; ix < 20; ++ix)
+		nodes[random() % (count - 1)].reset();
+
+	//Mirror the result in the reference, checking that every parent is what we expect.
+	for (int ix = 0; ix < count; ++ix)
+	{
+		if (!nodes[ix])
+			continue;
+
+		bool hasParent = parents[ix] >= 0 && nodes[parents[ix]];
+		uint32_t expected = hasParent ? nodes[parents[ix]]->GetHandle() : TransformHierarchy::InvalidHandle;
+		TEST_CHECK(hierarchy.GetParent(nodes[ix]->GetHandle()) == expected, "Node %d has the wrong parent", ix);
+		reference[ix].parent = hasParent ? &reference[parents[ix]] : nullptr;
+	}
+
+	hierarchy.Update();
+
+	float error = 0.0f;
+	size_t alive = 0;
+
+	for (int ix = 0; ix < count; ++ix)
+	{
+		if (!nodes[ix])
+			continue;
+
+		error = std::max(error, MatrixError(reference[ix].RecomputeGlobal(), nodes[ix]->GetGlobal()));
+		++alive;
+	}
+
+	printf("  %zu nodes after destroying interior nodes, max relative error %.2e\n", alive, error);
+	TEST_CHECK(hierarchy.GetCount() == alive, "The hierarchy has %zu nodes, expected %zu", hierarchy.GetCount(), alive);
+	TEST_CHECK(error <= 5e-5f, "Global matrices are off by up to %g", error);
+	return true;
+}
+
+//Times the old recursive update against the flat one on 100k nodes, split
+//into rigs that are chains of different depths. The flat hierarchy is timed
+//with every node changed, with 1% of nodes changed (like a few animated
+//joints), with every node asking for its global matrix (like the update loops
+//in the samples), and with nothing changed.
+bool BenchTransformHierarchy()
+{
+	const size_t count = 100000;
+	const int runs = 5;
+
+	printf("  %-6s | %12s %12s | %12s %12s %12s %12s\n", "depth", "old DoFK", "old Recomp", "new all", "new 1%", "new Recomp", "new clean");
+
+	for (size_t depth : { 1, 4, 16, 64, 256 })
+	{
+		TransformHierarchy hierarchy;
+		std::vector<std::unique_ptr<Transform>> nodes;
+		std::vector<ReferenceNode> reference(count);
+		std::mt19937 random(42);
+
+		for (size_t ix = 0; ix < count; ++ix)
+		{
+			nodes.push_back(std::make_unique<Transform>(hierarchy));
+			RandomizeNode(*nodes[ix], reference[ix], random);
+
+			//Each rig is a root followed by a chain of depth - 1 children.
+			if (ix % depth != 0)
+			{
+				nodes[ix]->SetParent(nodes[ix - 1].get());
+				reference[ix].SetParent(&reference[ix - 1]);
+			}
+		}
+
+		double oldFK = 1e9, oldRecompute = 1e9, newAll = 1e9, newSome = 1e9, newRecompute = 1e9, newClean = 1e9;
+
+		for (int run = 0; run < runs; ++run)
+		{
+			auto start = Clock::now();
+			for (size_t ix = 0; ix < count; ix += depth)
+				reference[ix].DoFK();
+			oldFK = std::min(oldFK, MillisecondsSince(start));
+
+			//Walking up to the root from every node is quadratic in the depth,
+			//so we don't wait for it on the deepest rigs.
+			if (depth <= 64)
+			{
+				start = Clock::now();
+				for (size_t ix = 0; ix < count; ++ix)
+					reference[ix].RecomputeGlobal();
+				oldRecompute = std::min(oldRecompute, MillisecondsSince(start));
+			}
+
+			for (size_t ix = 0; ix < count; ++ix)
+				nodes[ix]->m_pos = nodes[ix]->m_pos.Get();
+
+			start = Clock::now();
+			nodes[0]->DoFK();
+			newAll = std::min(newAll, MillisecondsSince(start));
+
+			for (size_t ix = 0; ix < count; ix += 100)
+			{
+				nodes[ix]->m_rotation *= glm::angleAxis(0.01f, glm::vec3(0.0f, 1.0f, 0.0f));
+				reference[ix].rotation *= glm::angleAxis(0.01f, glm::vec3(0.0f, 1.0f, 0.0f));
+			}
+
+			start = Clock::now();
+			nodes[0]->DoFK();
+			newSome = std::min(newSome, MillisecondsSince(start));
+
+			nodes[5]->m_pos = nodes[5]->m_pos.Get();
+			start = Clock::now();
+			for (size_t ix = 0; ix < count; ++ix)
+				nodes[ix]->RecomputeGlobal();
+			newRecompute = std::min(newRecompute, MillisecondsSince(start));
+
+			start = Clock::now();
+			nodes[0]->DoFK();
+			newClean = std::min(newClean, MillisecondsSince(start));
+		}
+
+		for (size_t ix = 0; ix < count; ix += depth)
+			reference[ix].DoFK();
+
+		float error = 0.0f;
+		for (size_t ix = 0; ix < count; ++ix)
+			error = std::max(error, MatrixError(reference[ix].global, nodes[ix]->GetGlobal()));
+
+		printf("  %-6zu | %10.2fms %10.2fms | %10.2fms %10.2fms %10.2fms %10.4fms  error %.1e\n", depth, oldFK,
+			depth <= 64 ? oldRecompute : -1.0, newAll, newSome, newRecompute, newClean, error);
+		TEST_CHECK(error <= 1e-4f, "Global matrices at depth %zu are off by up to %g", depth, error);
+	}
+
+	return true;
+}
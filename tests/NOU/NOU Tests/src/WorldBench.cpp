@@ -0,0 +1,179 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+WorldBench.cpp
+Checks that worlds are isolated from each other, and times running a scene
+through World systems against updating each entity by hand.
+*/
+
+#include "Tests.h"
+
+#include "NOU/Entity.h"
+#include "NOU/World.h"
+#include "NOU/CCamera.h"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+using namespace nou;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//A gameplay component that spins its entity.
+struct CSpin
+{
+	Entity* owner;
+	float speed;
+
+	void Update(float deltaTime)
+	{
+		owner->transform.m_rotation *= glm::angleAxis(speed * deltaTime, glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+};
+
+//Does the same per-object work as CMeshRenderer::Draw, minus the OpenGL calls,
+//so that we don't need a window.
+struct CFakeRenderer
+{
+	Entity* owner;
+	float result;
+
+	void Draw(const glm::mat4& viewProj)
+	{
+		glm::mat4 mvp = viewProj * owner->transform.GetGlobal();
+		glm::mat3 normal = owner->transform.GetNormal();
+		result = mvp[3][0] + normal[1][1];
+	}
+};
+
+//Fills a world with a camera and a 100x100 grid of layers of objects, every
+//spinEvery-th of which is spinning.
+static std::vector<std::unique_ptr<Entity>> Populate(World& world, int count, int spinEvery)
+{
+	std::vector<std::unique_ptr<Entity>> entities;
+	entities.reserve(count + 1);
+
+	entities.emplace_back(new Entity(Entity::Create(world)));
+	entities[0]->Add<CCamera>(*entities[0]).Perspective(60.0f, 1.0f, 0.1f, 100.0f);
+
+	for (int ix = 0; ix < count; ++ix)
+	{
+		Entity* entity = new Entity(Entity::Create(world));
+		entities.emplace_back(entity);
+
+		entity->transform.m_pos = glm::vec3(ix % 100, (ix / 100) % 100, ix / 10000);
+		entity->transform.m_scale = glm::vec3(1.0f, 1.0f + (ix & 1), 1.0f);
+
+		if (ix % spinEvery == 0)
+			entity->Add<CSpin>(CSpin{ entity, 1.0f });
+
+		entity->Add<CFakeRenderer>(CFakeRenderer{ entity, 0.0f });
+	}
+
+	world.Transforms().Update();
+	return entities;
+}
+
+//Checks that moving things in one world doesn't touch another, and that
+//entities can't be parented across worlds.
+bool TestWorld()
+{
+	World a, b;
+	Entity inA = Entity::Create(a);
+	Entity inB = Entity::Create(b);
+
+	inB.transform.SetParent(&inA.transform);
+	TEST_CHECK(b.Transforms().GetParent(inB.transform.GetHandle()) == TransformHierarchy::InvalidHandle,
+		"An entity was parented to an entity in another world");
+
+	b.Update(0.0f);
+	inA.transform.m_pos = glm::vec3(1.0f, 2.0f, 3.0f);
+	TEST_CHECK(a.Transforms().IsDirty(), "Moving an entity didn't dirty its own world");
+	TEST_CHECK(!b.Transforms().IsDirty(), "Moving an entity dirtied another world");
+	TEST_CHECK(a.Registry().size() == 1 && b.Registry().size() == 1, "Expected one entity in each world, got %zu and %zu",
+		a.Registry().size(), b.Registry().size());
+	TEST_CHECK(a.Transforms().GetCount() == 1 && b.Transforms().GetCount() == 1, "Expected one transform in each world, got %zu and %zu",
+		a.Transforms().GetCount(), b.Transforms().GetCount());
+	return true;
+}
+
+//Times 100k entities, with all, 1/10 and 1/100 of them moving, updated by
+//hand (looking up each entity's components one at a time and recomputing
+//every transform) against the same work done by World systems. Both should
+//leave every entity in the same place.
+bool BenchWorldSystems()
+{
+	const int count = 100000, frames = 30, warmup = 3;
+	const float deltaTime = 0.016f;
+
+	for (int spinEvery : { 1, 10, 100 })
+	{
+		double byHandTime = 0.0, systemsTime = 0.0;
+
+		World byHand;
+		auto byHandEntities = Populate(byHand, count, spinEvery);
+
+		for (int frame = 0; frame < frames + warmup; ++frame)
+		{
+			auto start = Clock::now();
+
+			for (size_t ix = 1; ix < byHandEntities.size(); ++ix)
+			{
+				if (byHand.Registry().has<CSpin>(byHandEntities[ix]->GetID()))
+					byHandEntities[ix]->Get<CSpin>().Update(deltaTime);
+			}
+
+			byHandEntities[0]->Get<CCamera>().Update();
+
+			for (size_t ix = 1; ix < byHandEntities.size(); ++ix)
+				byHandEntities[ix]->transform.RecomputeGlobal();
+
+			const glm::mat4& viewProj = byHandEntities[0]->Get<CCamera>().GetVP();
+
+			for (size_t ix = 1; ix < byHandEntities.size(); ++ix)
+				byHandEntities[ix]->Get<CFakeRenderer>().Draw(viewProj);
+
+			if (frame >= warmup)
+				byHandTime += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		}
+
+		World systems;
+		auto systemsEntities = Populate(systems, count, spinEvery);
+
+		systems.AddSystem("Spin", [](World& world, float dt)
+		{
+			world.Registry().view<CSpin>().each([dt](CSpin& spin) { spin.Update(dt); });
+		});
+		systems.AddSystem("Transforms", &World::UpdateTransforms);
+		systems.AddSystem("Cameras", &World::UpdateCameras);
+		systems.AddSystem("Render", [](World& world, float)
+		{
+			const glm::mat4& viewProj = world.GetCamera()->Get<CCamera>().GetVP();
+			world.Registry().view<CFakeRenderer>().each([&viewProj](CFakeRenderer& renderer) { renderer.Draw(viewProj); });
+		});
+
+		for (int frame = 0; frame < frames + warmup; ++frame)
+		{
+			auto start = Clock::now();
+			systems.Update(deltaTime);
+
+			if (frame >= warmup)
+				systemsTime += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		}
+
+		size_t mismatched = 0;
+		for (size_t ix = 1; ix < byHandEntities.size(); ++ix)
+		{
+			if (byHandEntities[ix]->transform.GetGlobal() != systemsEntities[ix]->transform.GetGlobal() ||
+				byHandEntities[ix]->Get<CFakeRenderer>().result != systemsEntities[ix]->Get<CFakeRenderer>().result)
+				++mismatched;
+		}
+
+		printf("  %d entities, 1/%-3d moving: by hand %.2fms/frame, world systems %.2fms/frame (%.2fx)\n",
+			count, spinEvery, byHandTime / frames, systemsTime / frames, byHandTime / systemsTime);
+		TEST_CHECK(mismatched == 0, "%zu entities ended up somewhere else when updated by systems", mismatched);
+	}
+
+	return true;
+}
@@ -0,0 +1,302 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+WorldParallelBench.cpp
+Checks the job system and a world whose system throws, and times a world
+whose systems run in parallel on different numbers of threads.
+*/
+
+#include "Tests.h"
+
+#include "NOU/Entity.h"
+#include "NOU/World.h"
+#include "NOU/CCamera.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace nou;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//Moves an entity back and forth (like the duck from the week 2 tutorial).
+struct CLerp
+{
+	Entity* owner;
+	glm::vec3 from, to;
+	float t;
+};
+
+//Something that doesn't touch transforms at all, so it can run alongside
+//the systems that do.
+struct CParticle
+{
+	glm::vec3 pos, vel;
+};
+
+//A bounding sphere, and whether the camera can see it.
+struct CBounds
+{
+	Entity* owner;
+	float radius;
+	bool visible;
+};
+
+//Checks that ParallelFor covers every index exactly once, including when
+//jobs start and wait on more jobs from inside a job.
+bool TestJobSystem()
+{
+	for (unsigned threads : { 0u, 1u, 3u, 7u })
+	{
+		JobSystem jobs(threads);
+		const size_t count = 100000;
+		std::vector<std::atomic<int>> hits(count);
+
+		for (size_t grainSize : { 0, 1, 1000 })
+		{
+			for (auto& hit : hits)
+				hit = 0;
+
+			jobs.ParallelFor(count, [&hits](size_t begin, size_t end)
+			{
+				for (size_t ix = begin; ix < end; ++ix)
+					++hits[ix];
+			}, grainSize);
+
+			for (size_t ix = 0; ix < count; ++ix)
+				TEST_CHECK(hits[ix] == 1, "Index %zu was run %d times on %u threads with a grain size of %zu", ix, (int)hits[ix], threads, grainSize);
+		}
+
+		std::atomic<size_t> total(0);
+		jobs.ParallelFor(64, [&jobs, &total](size_t begin, size_t end)
+		{
+			for (size_t ix = begin; ix < end; ++ix)
+				jobs.ParallelFor(100, [&total](size_t innerBegin, size_t innerEnd) { total += innerEnd - innerBegin; });
+		}, 1);
+
+		TEST_CHECK(total == 6400, "Nested jobs ran %zu of 6400 iterations on %u threads", (size_t)total, threads);
+
+		//A chunk that throws shouldn't stop the others, and the exception
+		//should come back out of ParallelFor.
+		std::atomic<size_t> ran(0);
+		bool caught = false;
+		try
+		{
+			jobs.ParallelFor(64, [&ran](size_t begin, size_t end)
+			{
+				ran += end - begin;
+				if (begin <= 40 && 40 < end)
+					throw std::runtime_error("chunk 40");
+			}, 1);
+		}
+		catch (const std::runtime_error&)
+		{
+			caught = true;
+		}
+
+		TEST_CHECK(caught, "ParallelFor swallowed an exception on %u threads", threads);
+		TEST_CHECK(ran == 64, "Only %zu of 64 chunks ran after one threw on %u threads", (size_t)ran, threads);
+
+		//The same goes for single jobs, and the counter can be used again
+		//once Wait has handed the exception over.
+		JobSystem::Counter counter;
+		caught = false;
+		jobs.Run([]() { throw std::runtime_error("job"); }, counter);
+		try
+		{
+			jobs.Wait(counter);
+		}
+		catch (const std::runtime_error&)
+		{
+			caught = true;
+		}
+
+		TEST_CHECK(caught, "Wait didn't rethrow a job's exception on %u threads", threads);
+		jobs.Run([]() {}, counter);
+		jobs.Wait(counter);
+	}
+
+	return true;
+}
+
+//Checks that a system throwing comes back out of Update on any number of
+//threads, rather than hanging it, and that the systems waiting on it are
+//skipped.
+bool TestWorldException()
+{
+	for (unsigned threads : { 0u, 1u, 3u })
+	{
+		JobSystem jobs(threads);
+		World world;
+		world.SetJobSystem(&jobs);
+
+		bool shouldThrow = true;
+		std::atomic<int> afterRan(0), mainRan(0);
+
+		world.AddSystem("Throws", [&shouldThrow](World&, float)
+		{
+			if (shouldThrow)
+				throw std::runtime_error("system");
+		}, SystemAccess().Write<CLerp>());
+		world.AddSystem("After", [&afterRan](World&, float) { ++afterRan; }, SystemAccess().Write<CLerp>());
+		world.AddSystem("Main", [&mainRan](World&, float) { ++mainRan; }, SystemAccess().Read<CLerp>().MainThread());
+
+		bool caught = false;
+		try
+		{
+			world.Update(1.0f / 60.0f);
+		}
+		catch (const std::runtime_error&)
+		{
+			caught = true;
+		}
+
+		TEST_CHECK(caught, "Update didn't rethrow a system's exception on %u threads", threads);
+		TEST_CHECK(afterRan == 0 && mainRan == 0, "Systems after the one that threw still ran on %u threads", threads);
+
+		//The next frame should run normally.
+		shouldThrow = false;
+		world.Update(1.0f / 60.0f);
+		TEST_CHECK(afterRan == 1 && mainRan == 1, "The frame after an exception didn't run every system on %u threads", threads);
+	}
+
+	return true;
+}
+
+//Fills a world with 100k entities and the systems that animate, simulate
+//and cull them. Animate and Particles don't conflict, so they can run at
+//the same time, and each of them is split up with ParallelEach.
+static void Populate(World& world, std::vector<std::unique_ptr<Entity>>& entities, int count)
+{
+	entities.emplace_back(new Entity(Entity::Create(world)));
+	entities[0]->Add<CCamera>(*entities[0]).Perspective(60.0f, 1.0f, 0.1f, 500.0f);
+	entities[0]->transform.m_pos = glm::vec3(50.0f, 50.0f, 150.0f);
+
+	for (int ix = 0; ix < count; ++ix)
+	{
+		Entity* entity = new Entity(Entity::Create(world));
+		entities.emplace_back(entity);
+
+		glm::vec3 pos = glm::vec3(ix % 100, (ix / 100) % 100, -(ix / 10000) * 10.0f);
+		entity->transform.m_pos = pos;
+		entity->Add<CLerp>(CLerp{ entity, pos, pos + glm::vec3(0.0f, 0.0f, 40.0f), (ix % 97) / 97.0f });
+		entity->Add<CParticle>(CParticle{ pos, glm::vec3(1.0f, 0.5f, 0.0f) });
+		entity->Add<CBounds>(CBounds{ entity, 0.5f, false });
+	}
+
+	world.AddSystem("Animate", [](World& w, float dt)
+	{
+		w.ParallelEach<CLerp>([dt](CLerp& lerp)
+		{
+			lerp.t += dt * 0.5f;
+			if (lerp.t > 1.0f)
+				lerp.t -= 1.0f;
+
+			lerp.owner->transform.m_pos = glm::mix(lerp.from, lerp.to, lerp.t);
+			lerp.owner->transform.m_rotation = glm::angleAxis(lerp.t * 6.28f, glm::vec3(0.0f, 1.0f, 0.0f));
+		});
+	}, SystemAccess().Write<Transform, CLerp>());
+
+	world.AddSystem("Particles", [](World& w, float dt)
+	{
+		w.ParallelEach<CParticle>([dt](CParticle& particle)
+		{
+			for (int step = 0; step < 8; ++step)
+			{
+				particle.vel += glm::vec3(0.0f, -9.8f, 0.0f) * dt * 0.125f;
+				particle.pos += particle.vel * dt * 0.125f;
+
+				if (particle.pos.y < 0.0f)
+				{
+					particle.pos.y = -particle.pos.y;
+					particle.vel.y = -particle.vel.y * 0.9f;
+				}
+			}
+		});
+	}, SystemAccess().Write<CParticle>());
+
+	world.AddSystem("Transforms", &World::UpdateTransforms, SystemAccess().Write<Transform>());
+	world.AddSystem("Cameras", &World::UpdateCameras, SystemAccess().Write<Transform, CCamera>());
+
+	world.AddSystem("Cull", [](World& w, float)
+	{
+		glm::mat4 viewProj = w.GetCamera()->Get<CCamera>().GetVP();
+
+		w.ParallelEach<CBounds>([&viewProj](CBounds& bounds)
+		{
+			glm::vec4 clip = viewProj * bounds.owner->transform.GetGlobal()[3];
+			float reach = clip.w + bounds.radius;
+			bounds.visible = clip.x >= -reach && clip.x <= reach && clip.y >= -reach && clip.y <= reach && clip.z >= -reach && clip.z <= reach;
+		});
+	}, SystemAccess().Read<Transform, CCamera>().Write<CBounds>());
+}
+
+//Adds up where everything ended up, so that runs on different numbers of
+//threads can be compared.
+static double Checksum(World& world)
+{
+	double sum = 0.0;
+
+	world.Registry().view<CBounds>().each([&sum](CBounds& bounds)
+	{
+		sum += (bounds.visible ? 1.0 : 0.0) + bounds.owner->transform.GetGlobal()[3][2] * 1e-3;
+	});
+
+	world.Registry().view<CParticle>().each([&sum](CParticle& particle)
+	{
+		sum += particle.pos.y * 1e-3;
+	});
+
+	return sum;
+}
+
+//Times the world above with no worker threads (everything in order on the
+//main thread) and with 1, 3 and 7 workers. Every run should end up in
+//exactly the same state.
+bool BenchWorldParallel()
+{
+	const int count = 100000, frames = 40, warmup = 5;
+	double baseTime = 0.0, baseChecksum = 0.0;
+
+	printf("  (this machine has %u hardware threads)\n", std::thread::hardware_concurrency());
+
+	for (unsigned workers : { 0u, 1u, 3u, 7u })
+	{
+		JobSystem jobs(workers);
+		World world;
+		world.SetJobSystem(&jobs);
+
+		std::vector<std::unique_ptr<Entity>> entities;
+		Populate(world, entities, count);
+
+		double time = 0.0;
+
+		for (int frame = 0; frame < frames + warmup; ++frame)
+		{
+			auto start = Clock::now();
+			world.Update(1.0f / 60.0f);
+
+			if (frame >= warmup)
+				time += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		}
+
+		time /= frames;
+		double checksum = Checksum(world);
+
+		if (workers == 0)
+		{
+			baseTime = time;
+			baseChecksum = checksum;
+		}
+
+		printf("  %u workers%s: %.2fms/frame (%.2fx), checksum %.6f\n", workers, workers == 0 ? " (in order)" : "",
+			time, baseTime / time, checksum);
+		TEST_CHECK(checksum == baseChecksum, "Running on %u workers gave a different result", workers);
+	}
+
+	return true;
+}
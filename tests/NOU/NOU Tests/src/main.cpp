@@ -0,0 +1,83 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+
+main.cpp
+Runs every test, or only the ones named on the command line.
+The exit code is the number of failures.
+*/
+
+#include "Tests.h"
+
+#include <cstring>
+#include <exception>
+
+//A check or benchmark that can be picked by name on the command line.
+struct TestCase
+{
+	const char* name;
+	bool(*run)();
+};
+
+static const TestCase tests[] =
+{
+	{ "TransformHierarchy",      TestTransformHierarchy },
+	{ "TransformHierarchySpeed", BenchTransformHierarchy },
+	{ "TransformBatch",          TestTransformBatch },
+	{ "TransformBatchSpeed",     BenchTransformBatch },
+	{ "World",                   TestWorld },
+	{ "WorldSystemsSpeed",       BenchWorldSystems },
+	{ "JobSystem",               TestJobSystem },
+	{ "WorldException",          TestWorldException },
+	{ "WorldParallelSpeed",      BenchWorldParallel },
+	{ "Frustum",                 TestFrustum },
+	{ "FrustumCullSpeed",        BenchFrustumCull },
+	{ "ShaderCacheSpeed",        BenchShaderCache },
+};
+
+int main(int argc, char** argv)
+{
+	int failures = 0;
+
+	//A typo on the command line shouldn't look like a pass.
+	for (int ix = 1; ix < argc; ++ix)
+	{
+		bool found = false;
+		for (const TestCase& test : tests)
+			found |= strcmp(argv[ix], test.name) == 0;
+
+		if (!found)
+		{
+			printf("There is no test named \"%s\"\n", argv[ix]);
+			++failures;
+		}
+	}
+
+	for (const TestCase& test : tests)
+	{
+		bool selected = argc < 2;
+		for (int ix = 1; ix < argc && !selected; ++ix)
+			selected = strcmp(argv[ix], test.name) == 0;
+
+		if (!selected)
+			continue;
+
+		printf("Running %s\n", test.name);
+		bool passed = false;
+
+		try
+		{
+			passed = test.run();
+		}
+		catch (const std::exception& e)
+		{
+			printf("  %s threw: %s\n", test.name, e.what());
+		}
+
+		printf(passed ? "%s passed\n" : "%s FAILED\n", test.name);
+		if (!passed)
+			++failures;
+	}
+
+	printf("%d test(s) failed\n", failures);
+	return failures;
+}